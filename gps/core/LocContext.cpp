@@ -53,7 +53,7 @@ pthread_mutex_t LocContext::mGetLocContextMutex = PTHREAD_MUTEX_INITIALIZER;
 const MsgTask* LocContext::getMsgTask(const char* name)
 {
     if (NULL == mMsgTask) {
-        mMsgTask = new MsgTask(name);
+        mMsgTask = new MsgTask(name, MsgTask::QUEUE_MODE_RING, true);
     }
     return mMsgTask;
 }
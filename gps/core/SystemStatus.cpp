@@ -37,6 +37,7 @@
 #include <loc_pla.h>
 #include <log_util.h>
 #include <loc_nmea.h>
+#include <SystemStatusNmeaFields.h>
 #include <DataItemsFactoryProxy.h>
 #include <SystemStatus.h>
 #include <SystemStatusOsObserver.h>
@@ -50,44 +51,22 @@ namespace loc_core
 ******************************************************************************/
 class SystemStatusNmeaBase
 {
+public:
+    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
+    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
+
 protected:
-    std::vector<std::string> mField;
+    // as many fields as the longest sentence, PQWP7, has
+    static const uint32_t MAX_FIELDS = 2 + SV_ALL_NUM * 3;
+
+    SystemStatusNmeaFields<MAX_FIELDS> mField;
 
     SystemStatusNmeaBase(const char *str_in, uint32_t len_in)
     {
-        // check size and talker
-        if (!loc_nmea_is_debug(str_in, len_in)) {
-            return;
-        }
-
-        std::string parser(str_in);
-        std::string::size_type index = 0;
-
-        // verify checksum field
-        index = parser.find("*");
-        if (index == std::string::npos) {
-            return;
-        }
-        parser[index] = ',';
-
-        // tokenize parser
-        while (1) {
-            std::string str;
-            index = parser.find(",");
-            if (index == std::string::npos) {
-                break;
-            }
-            str = parser.substr(0, index);
-            parser = parser.substr(index + 1);
-            mField.push_back(str);
-        }
+        mField.split(str_in, len_in);
     }
 
     virtual ~SystemStatusNmeaBase() { }
-
-public:
-    static const uint32_t NMEA_MINSIZE = DEBUG_NMEA_MINSIZE;
-    static const uint32_t NMEA_MAXSIZE = DEBUG_NMEA_MAXSIZE;
 };
 
 /******************************************************************************
@@ -214,42 +193,42 @@ public:
             mM1.mTimeValid = 0;
             return;
         }
-        mM1.mGpsWeek = atoi(mField[eGpsWeek].c_str());
-        mM1.mGpsTowMs = atoi(mField[eGpsTowMs].c_str());
-        mM1.mTimeValid = atoi(mField[eTimeValid].c_str());
-        mM1.mTimeSource = atoi(mField[eTimeSource].c_str());
-        mM1.mTimeUnc = atoi(mField[eTimeUnc].c_str());
-        mM1.mClockFreqBias = atoi(mField[eClockFreqBias].c_str());
-        mM1.mClockFreqBiasUnc = atoi(mField[eClockFreqBiasUnc].c_str());
-        mM1.mXoState = atoi(mField[eXoState].c_str());
-        mM1.mPgaGain = atoi(mField[ePgaGain].c_str());
-        mM1.mGpsBpAmpI = atoi(mField[eGpsBpAmpI].c_str());
-        mM1.mGpsBpAmpQ = atoi(mField[eGpsBpAmpQ].c_str());
-        mM1.mAdcI = atoi(mField[eAdcI].c_str());
-        mM1.mAdcQ = atoi(mField[eAdcQ].c_str());
-        mM1.mJammerGps = atoi(mField[eJammerGps].c_str());
-        mM1.mJammerGlo = atoi(mField[eJammerGlo].c_str());
-        mM1.mJammerBds = atoi(mField[eJammerBds].c_str());
-        mM1.mJammerGal = atoi(mField[eJammerGal].c_str());
-        mM1.mRecErrorRecovery = atoi(mField[eRecErrorRecovery].c_str());
-        mM1.mAgcGps = atof(mField[eAgcGps].c_str());
-        mM1.mAgcGlo = atof(mField[eAgcGlo].c_str());
-        mM1.mAgcBds = atof(mField[eAgcBds].c_str());
-        mM1.mAgcGal = atof(mField[eAgcGal].c_str());
+        mM1.mGpsWeek = mField[eGpsWeek].toInt();
+        mM1.mGpsTowMs = mField[eGpsTowMs].toInt();
+        mM1.mTimeValid = mField[eTimeValid].toInt();
+        mM1.mTimeSource = mField[eTimeSource].toInt();
+        mM1.mTimeUnc = mField[eTimeUnc].toInt();
+        mM1.mClockFreqBias = mField[eClockFreqBias].toInt();
+        mM1.mClockFreqBiasUnc = mField[eClockFreqBiasUnc].toInt();
+        mM1.mXoState = mField[eXoState].toInt();
+        mM1.mPgaGain = mField[ePgaGain].toInt();
+        mM1.mGpsBpAmpI = mField[eGpsBpAmpI].toInt();
+        mM1.mGpsBpAmpQ = mField[eGpsBpAmpQ].toInt();
+        mM1.mAdcI = mField[eAdcI].toInt();
+        mM1.mAdcQ = mField[eAdcQ].toInt();
+        mM1.mJammerGps = mField[eJammerGps].toInt();
+        mM1.mJammerGlo = mField[eJammerGlo].toInt();
+        mM1.mJammerBds = mField[eJammerBds].toInt();
+        mM1.mJammerGal = mField[eJammerGal].toInt();
+        mM1.mRecErrorRecovery = mField[eRecErrorRecovery].toInt();
+        mM1.mAgcGps = mField[eAgcGps].toDouble();
+        mM1.mAgcGlo = mField[eAgcGlo].toDouble();
+        mM1.mAgcBds = mField[eAgcBds].toDouble();
+        mM1.mAgcGal = mField[eAgcGal].toDouble();
         if (mField.size() > eLeapSecUnc) {
-            mM1.mLeapSeconds = atoi(mField[eLeapSeconds].c_str());
-            mM1.mLeapSecUnc = atoi(mField[eLeapSecUnc].c_str());
+            mM1.mLeapSeconds = mField[eLeapSeconds].toInt();
+            mM1.mLeapSecUnc = mField[eLeapSecUnc].toInt();
         }
         if (mField.size() > eGalBpAmpQ) {
-            mM1.mGloBpAmpI = atoi(mField[eGloBpAmpI].c_str());
-            mM1.mGloBpAmpQ = atoi(mField[eGloBpAmpQ].c_str());
-            mM1.mBdsBpAmpI = atoi(mField[eBdsBpAmpI].c_str());
-            mM1.mBdsBpAmpQ = atoi(mField[eBdsBpAmpQ].c_str());
-            mM1.mGalBpAmpI = atoi(mField[eGalBpAmpI].c_str());
-            mM1.mGalBpAmpQ = atoi(mField[eGalBpAmpQ].c_str());
+            mM1.mGloBpAmpI = mField[eGloBpAmpI].toInt();
+            mM1.mGloBpAmpQ = mField[eGloBpAmpQ].toInt();
+            mM1.mBdsBpAmpI = mField[eBdsBpAmpI].toInt();
+            mM1.mBdsBpAmpQ = mField[eBdsBpAmpQ].toInt();
+            mM1.mGalBpAmpI = mField[eGalBpAmpI].toInt();
+            mM1.mGalBpAmpQ = mField[eGalBpAmpQ].toInt();
         }
         if (mField.size() > eTimeUncNs) {
-            mM1.mTimeUncNs = strtoull(mField[eTimeUncNs].c_str(), nullptr, 10);
+            mM1.mTimeUncNs = mField[eTimeUncNs].toUint64();
         }
     }
 
@@ -305,13 +284,13 @@ public:
             return;
         }
         memset(&mP1, 0, sizeof(mP1));
-        mP1.mEpiValidity = strtol(mField[eEpiValidity].c_str(), NULL, 16);
-        mP1.mEpiLat = atof(mField[eEpiLat].c_str());
-        mP1.mEpiLon = atof(mField[eEpiLon].c_str());
-        mP1.mEpiAlt = atof(mField[eEpiAlt].c_str());
-        mP1.mEpiHepe = atoi(mField[eEpiHepe].c_str());
-        mP1.mEpiAltUnc = atof(mField[eEpiAltUnc].c_str());
-        mP1.mEpiSrc = atoi(mField[eEpiSrc].c_str());
+        mP1.mEpiValidity = mField[eEpiValidity].toHex();
+        mP1.mEpiLat = mField[eEpiLat].toDouble();
+        mP1.mEpiLon = mField[eEpiLon].toDouble();
+        mP1.mEpiAlt = mField[eEpiAlt].toDouble();
+        mP1.mEpiHepe = mField[eEpiHepe].toInt();
+        mP1.mEpiAltUnc = mField[eEpiAltUnc].toDouble();
+        mP1.mEpiSrc = mField[eEpiSrc].toInt();
     }
 
     inline SystemStatusPQWP1& get() { return mP1;}
@@ -360,11 +339,11 @@ public:
             return;
         }
         memset(&mP2, 0, sizeof(mP2));
-        mP2.mBestLat = atof(mField[eBestLat].c_str());
-        mP2.mBestLon = atof(mField[eBestLon].c_str());
-        mP2.mBestAlt = atof(mField[eBestAlt].c_str());
-        mP2.mBestHepe = atof(mField[eBestHepe].c_str());
-        mP2.mBestAltUnc = atof(mField[eBestAltUnc].c_str());
+        mP2.mBestLat = mField[eBestLat].toDouble();
+        mP2.mBestLon = mField[eBestLon].toDouble();
+        mP2.mBestAlt = mField[eBestAlt].toDouble();
+        mP2.mBestHepe = mField[eBestHepe].toDouble();
+        mP2.mBestAltUnc = mField[eBestAltUnc].toDouble();
     }
 
     inline SystemStatusPQWP2& get() { return mP2;}
@@ -437,17 +416,17 @@ public:
         }
         memset(&mP3, 0, sizeof(mP3));
         // todo: update for navic once available
-        mP3.mXtraValidMask = strtol(mField[eXtraValidMask].c_str(), NULL, 16);
-        mP3.mGpsXtraAge = atoi(mField[eGpsXtraAge].c_str());
-        mP3.mGloXtraAge = atoi(mField[eGloXtraAge].c_str());
-        mP3.mBdsXtraAge = atoi(mField[eBdsXtraAge].c_str());
-        mP3.mGalXtraAge = atoi(mField[eGalXtraAge].c_str());
-        mP3.mQzssXtraAge = atoi(mField[eQzssXtraAge].c_str());
-        mP3.mGpsXtraValid = strtol(mField[eGpsXtraValid].c_str(), NULL, 16);
-        mP3.mGloXtraValid = strtol(mField[eGloXtraValid].c_str(), NULL, 16);
-        mP3.mBdsXtraValid = strtol(mField[eBdsXtraValid].c_str(), NULL, 16);
-        mP3.mGalXtraValid = strtol(mField[eGalXtraValid].c_str(), NULL, 16);
-        mP3.mQzssXtraValid = strtol(mField[eQzssXtraValid].c_str(), NULL, 16);
+        mP3.mXtraValidMask = mField[eXtraValidMask].toHex();
+        mP3.mGpsXtraAge = mField[eGpsXtraAge].toInt();
+        mP3.mGloXtraAge = mField[eGloXtraAge].toInt();
+        mP3.mBdsXtraAge = mField[eBdsXtraAge].toInt();
+        mP3.mGalXtraAge = mField[eGalXtraAge].toInt();
+        mP3.mQzssXtraAge = mField[eQzssXtraAge].toInt();
+        mP3.mGpsXtraValid = mField[eGpsXtraValid].toHex();
+        mP3.mGloXtraValid = mField[eGloXtraValid].toHex();
+        mP3.mBdsXtraValid = mField[eBdsXtraValid].toHex();
+        mP3.mGalXtraValid = mField[eGalXtraValid].toHex();
+        mP3.mQzssXtraValid = mField[eQzssXtraValid].toHex();
     }
 
     inline SystemStatusPQWP3& get() { return mP3;}
@@ -496,11 +475,11 @@ public:
             return;
         }
         memset(&mP4, 0, sizeof(mP4));
-        mP4.mGpsEpheValid = strtol(mField[eGpsEpheValid].c_str(), NULL, 16);
-        mP4.mGloEpheValid = strtol(mField[eGloEpheValid].c_str(), NULL, 16);
-        mP4.mBdsEpheValid = strtol(mField[eBdsEpheValid].c_str(), NULL, 16);
-        mP4.mGalEpheValid = strtol(mField[eGalEpheValid].c_str(), NULL, 16);
-        mP4.mQzssEpheValid = strtol(mField[eQzssEpheValid].c_str(), NULL, 16);
+        mP4.mGpsEpheValid = mField[eGpsEpheValid].toHex();
+        mP4.mGloEpheValid = mField[eGloEpheValid].toHex();
+        mP4.mBdsEpheValid = mField[eBdsEpheValid].toHex();
+        mP4.mGalEpheValid = mField[eGalEpheValid].toHex();
+        mP4.mQzssEpheValid = mField[eQzssEpheValid].toHex();
     }
 
     inline SystemStatusPQWP4& get() { return mP4;}
@@ -587,21 +566,21 @@ public:
         }
         memset(&mP5, 0, sizeof(mP5));
         // todo: update for navic once available
-        mP5.mGpsUnknownMask = strtol(mField[eGpsUnknownMask].c_str(), NULL, 16);
-        mP5.mGloUnknownMask = strtol(mField[eGloUnknownMask].c_str(), NULL, 16);
-        mP5.mBdsUnknownMask = strtol(mField[eBdsUnknownMask].c_str(), NULL, 16);
-        mP5.mGalUnknownMask = strtol(mField[eGalUnknownMask].c_str(), NULL, 16);
-        mP5.mQzssUnknownMask = strtol(mField[eQzssUnknownMask].c_str(), NULL, 16);
-        mP5.mGpsGoodMask = strtol(mField[eGpsGoodMask].c_str(), NULL, 16);
-        mP5.mGloGoodMask = strtol(mField[eGloGoodMask].c_str(), NULL, 16);
-        mP5.mBdsGoodMask = strtol(mField[eBdsGoodMask].c_str(), NULL, 16);
-        mP5.mGalGoodMask = strtol(mField[eGalGoodMask].c_str(), NULL, 16);
-        mP5.mQzssGoodMask = strtol(mField[eQzssGoodMask].c_str(), NULL, 16);
-        mP5.mGpsBadMask = strtol(mField[eGpsBadMask].c_str(), NULL, 16);
-        mP5.mGloBadMask = strtol(mField[eGloBadMask].c_str(), NULL, 16);
-        mP5.mBdsBadMask = strtol(mField[eBdsBadMask].c_str(), NULL, 16);
-        mP5.mGalBadMask = strtol(mField[eGalBadMask].c_str(), NULL, 16);
-        mP5.mQzssBadMask = strtol(mField[eQzssBadMask].c_str(), NULL, 16);
+        mP5.mGpsUnknownMask = mField[eGpsUnknownMask].toHex();
+        mP5.mGloUnknownMask = mField[eGloUnknownMask].toHex();
+        mP5.mBdsUnknownMask = mField[eBdsUnknownMask].toHex();
+        mP5.mGalUnknownMask = mField[eGalUnknownMask].toHex();
+        mP5.mQzssUnknownMask = mField[eQzssUnknownMask].toHex();
+        mP5.mGpsGoodMask = mField[eGpsGoodMask].toHex();
+        mP5.mGloGoodMask = mField[eGloGoodMask].toHex();
+        mP5.mBdsGoodMask = mField[eBdsGoodMask].toHex();
+        mP5.mGalGoodMask = mField[eGalGoodMask].toHex();
+        mP5.mQzssGoodMask = mField[eQzssGoodMask].toHex();
+        mP5.mGpsBadMask = mField[eGpsBadMask].toHex();
+        mP5.mGloBadMask = mField[eGloBadMask].toHex();
+        mP5.mBdsBadMask = mField[eBdsBadMask].toHex();
+        mP5.mGalBadMask = mField[eGalBadMask].toHex();
+        mP5.mQzssBadMask = mField[eQzssBadMask].toHex();
     }
 
     inline SystemStatusPQWP5& get() { return mP5;}
@@ -638,7 +617,7 @@ public:
             return;
         }
         memset(&mP6, 0, sizeof(mP6));
-        mP6.mFixInfoMask = strtol(mField[eFixInfoMask].c_str(), NULL, 16);
+        mP6.mFixInfoMask = mField[eFixInfoMask].toHex();
     }
 
     inline SystemStatusPQWP6& get() { return mP6;}
@@ -681,9 +660,9 @@ public:
 
         memset(mP7.mNav, 0, sizeof(mP7.mNav));
         for (uint32_t i=0; i<svLimit; i++) {
-            mP7.mNav[i].mType   = GnssEphemerisType(atoi(mField[i*3+2].c_str()));
-            mP7.mNav[i].mSource = GnssEphemerisSource(atoi(mField[i*3+3].c_str()));
-            mP7.mNav[i].mAgeSec = atoi(mField[i*3+4].c_str());
+            mP7.mNav[i].mType   = GnssEphemerisType(mField[i*3+2].toInt());
+            mP7.mNav[i].mSource = GnssEphemerisSource(mField[i*3+3].toInt());
+            mP7.mNav[i].mAgeSec = mField[i*3+4].toInt();
         }
     }
 
@@ -724,8 +703,8 @@ public:
             return;
         }
         memset(&mS1, 0, sizeof(mS1));
-        mS1.mFixInfoMask = atoi(mField[eFixInfoMask].c_str());
-        mS1.mHepeLimit = atoi(mField[eHepeLimit].c_str());
+        mS1.mFixInfoMask = mField[eFixInfoMask].toInt();
+        mS1.mHepeLimit = mField[eHepeLimit].toInt();
     }
 
     inline SystemStatusPQWS1& get() { return mS1;}
@@ -1290,8 +1269,9 @@ void SystemStatus::destroyInstance()
 void SystemStatus::resetNetworkInfo() {
     for (int i=0; i<mCache.mNetworkInfo.size(); ++i) {
         // Reset all the cached NetworkInfo Items as disconnected
+        string apn = mCache.mNetworkInfo[i].mApn;
         eventConnectionStatus(false, mCache.mNetworkInfo[i].mType, mCache.mNetworkInfo[i].mRoaming,
-                mCache.mNetworkInfo[i].mNetworkHandle, mCache.mNetworkInfo[i].mApn);
+                mCache.mNetworkInfo[i].mNetworkHandle, apn);
     }
 }
 
@@ -1357,17 +1337,17 @@ bool SystemStatus::setIteminReport(TYPE_REPORT& report, TYPE_ITEM&& s)
     if (s.ignore()) {
         return false;
     }
-    if (!report.empty() && report.back().equals(static_cast<TYPE_ITEM&>(s.collate(report.back())))) {
-        // there is no change - just update reported timestamp
-        report.back().mUtcReported = s.mUtcReported;
-        return false;
+    if (!report.empty()) {
+        typename TYPE_REPORT::value_type& latest = report.backForUpdate();
+        if (latest.equals(static_cast<TYPE_ITEM&>(s.collate(latest)))) {
+            // there is no change - just update reported timestamp
+            latest.mUtcReported = s.mUtcReported;
+            return false;
+        }
     }
 
-    // first event or updated
+    // first event or updated, the oldest item is dropped once the history is full
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
     return true;
 }
 
@@ -1375,18 +1355,16 @@ template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::setDefaultIteminReport(TYPE_REPORT& report, const TYPE_ITEM& s)
 {
     report.push_back(s);
-    if (report.size() > s.maxItem) {
-        report.erase(report.begin());
-    }
 }
 
 template <typename TYPE_REPORT, typename TYPE_ITEM>
 void SystemStatus::getIteminReport(TYPE_REPORT& reportout, const TYPE_ITEM& c) const
 {
-    reportout.clear();
-    if (c.size() >= 1) {
-        reportout.push_back(c.back());
-        reportout.back().dump();
+    // shares the latest item with the cache rather than copying it
+    reportout.assignLatest(c);
+    if (!reportout.empty()) {
+        // dump() only logs, it is just not declared const
+        const_cast<typename TYPE_REPORT::value_type&>(reportout.back()).dump();
     }
 }
 
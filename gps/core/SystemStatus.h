@@ -32,6 +32,7 @@
 #include <stdint.h>
 #include <sys/time.h>
 #include <vector>
+#include <memory>
 #include <algorithm>
 #include <iterator>
 #include <loc_pla.h>
@@ -823,6 +824,79 @@ public:
     }
 };
 
+/******************************************************************************
+ SystemStatusHistory
+
+ Fixed capacity history of one report type, oldest first. Adding to a full
+ history drops the oldest item in place instead of shifting the rest down.
+ Items are reference counted and shared between copies, so copying a
+ history (SystemStatus::getReport) copies pointers, not reports. Items
+ reached through a copy are therefore read only; the owner updates the
+ latest one through backForUpdate(), which detaches it first if a copy
+ still refers to it.
+******************************************************************************/
+template <typename TYPE_ITEM, uint32_t CAPACITY = SystemStatusItemBase::maxItem>
+class SystemStatusHistory
+{
+    std::shared_ptr<TYPE_ITEM> mItems[CAPACITY];
+    uint32_t mHead;     // slot of the oldest item
+    uint32_t mCount;
+
+    inline uint32_t slot(size_t index) const { return (mHead + index) % CAPACITY; }
+
+public:
+    typedef TYPE_ITEM value_type;
+
+    inline SystemStatusHistory() : mHead(0), mCount(0) {}
+
+    inline bool empty() const { return 0 == mCount; }
+    inline size_t size() const { return mCount; }
+    inline const TYPE_ITEM& operator[](size_t index) const { return *mItems[slot(index)]; }
+    inline const TYPE_ITEM& front() const { return *mItems[mHead]; }
+    inline const TYPE_ITEM& back() const { return *mItems[slot(mCount - 1)]; }
+
+    inline TYPE_ITEM& backForUpdate() {
+        std::shared_ptr<TYPE_ITEM>& item = mItems[slot(mCount - 1)];
+        if (item.use_count() > 1) {
+            item = std::make_shared<TYPE_ITEM>(*item);
+        }
+        return *item;
+    }
+
+    void push_back(const TYPE_ITEM& item) {
+        std::shared_ptr<TYPE_ITEM>* target;
+        if (mCount < CAPACITY) {
+            target = &mItems[slot(mCount++)];
+        } else {
+            target = &mItems[mHead];
+            mHead = (mHead + 1) % CAPACITY;
+        }
+        if (target->use_count() == 1) {
+            // not held by any copy of the history, reuse it
+            **target = item;
+        } else {
+            *target = std::make_shared<TYPE_ITEM>(item);
+        }
+    }
+
+    // share only the latest item of another history
+    void assignLatest(const SystemStatusHistory& other) {
+        clear();
+        if (!other.empty()) {
+            mItems[0] = other.mItems[other.slot(other.mCount - 1)];
+            mCount = 1;
+        }
+    }
+
+    void clear() {
+        for (auto& item : mItems) {
+            item.reset();
+        }
+        mHead = 0;
+        mCount = 0;
+    }
+};
+
 /******************************************************************************
  SystemStatusReports
 ******************************************************************************/
@@ -830,49 +904,49 @@ class SystemStatusReports
 {
 public:
     // from QMI_LOC indication
-    std::vector<SystemStatusLocation>         mLocation;
+    SystemStatusHistory<SystemStatusLocation>              mLocation;
 
     // from ME debug NMEA
-    std::vector<SystemStatusTimeAndClock>     mTimeAndClock;
-    std::vector<SystemStatusXoState>          mXoState;
-    std::vector<SystemStatusRfAndParams>      mRfAndParams;
-    std::vector<SystemStatusErrRecovery>      mErrRecovery;
+    SystemStatusHistory<SystemStatusTimeAndClock>          mTimeAndClock;
+    SystemStatusHistory<SystemStatusXoState>               mXoState;
+    SystemStatusHistory<SystemStatusRfAndParams>           mRfAndParams;
+    SystemStatusHistory<SystemStatusErrRecovery>           mErrRecovery;
 
     // from PE debug NMEA
-    std::vector<SystemStatusInjectedPosition> mInjectedPosition;
-    std::vector<SystemStatusBestPosition>     mBestPosition;
-    std::vector<SystemStatusXtra>             mXtra;
-    std::vector<SystemStatusEphemeris>        mEphemeris;
-    std::vector<SystemStatusSvHealth>         mSvHealth;
-    std::vector<SystemStatusPdr>              mPdr;
-    std::vector<SystemStatusNavData>          mNavData;
+    SystemStatusHistory<SystemStatusInjectedPosition>      mInjectedPosition;
+    SystemStatusHistory<SystemStatusBestPosition>          mBestPosition;
+    SystemStatusHistory<SystemStatusXtra>                  mXtra;
+    SystemStatusHistory<SystemStatusEphemeris>             mEphemeris;
+    SystemStatusHistory<SystemStatusSvHealth>              mSvHealth;
+    SystemStatusHistory<SystemStatusPdr>                   mPdr;
+    SystemStatusHistory<SystemStatusNavData>               mNavData;
 
     // from SM debug NMEA
-    std::vector<SystemStatusPositionFailure>  mPositionFailure;
+    SystemStatusHistory<SystemStatusPositionFailure>       mPositionFailure;
 
     // from dataitems observer
-    std::vector<SystemStatusAirplaneMode>     mAirplaneMode;
-    std::vector<SystemStatusENH>              mENH;
-    std::vector<SystemStatusGpsState>         mGPSState;
-    std::vector<SystemStatusNLPStatus>        mNLPStatus;
-    std::vector<SystemStatusWifiHardwareState> mWifiHardwareState;
-    std::vector<SystemStatusNetworkInfo>      mNetworkInfo;
-    std::vector<SystemStatusServiceInfo>      mRilServiceInfo;
-    std::vector<SystemStatusRilCellInfo>      mRilCellInfo;
-    std::vector<SystemStatusServiceStatus>    mServiceStatus;
-    std::vector<SystemStatusModel>            mModel;
-    std::vector<SystemStatusManufacturer>     mManufacturer;
-    std::vector<SystemStatusAssistedGps>      mAssistedGps;
-    std::vector<SystemStatusScreenState>      mScreenState;
-    std::vector<SystemStatusPowerConnectState> mPowerConnectState;
-    std::vector<SystemStatusTimeZoneChange>   mTimeZoneChange;
-    std::vector<SystemStatusTimeChange>       mTimeChange;
-    std::vector<SystemStatusWifiSupplicantStatus> mWifiSupplicantStatus;
-    std::vector<SystemStatusShutdownState>    mShutdownState;
-    std::vector<SystemStatusTac>              mTac;
-    std::vector<SystemStatusMccMnc>           mMccMnc;
-    std::vector<SystemStatusBtDeviceScanDetail> mBtDeviceScanDetail;
-    std::vector<SystemStatusBtleDeviceScanDetail> mBtLeDeviceScanDetail;
+    SystemStatusHistory<SystemStatusAirplaneMode>          mAirplaneMode;
+    SystemStatusHistory<SystemStatusENH>                   mENH;
+    SystemStatusHistory<SystemStatusGpsState>              mGPSState;
+    SystemStatusHistory<SystemStatusNLPStatus>             mNLPStatus;
+    SystemStatusHistory<SystemStatusWifiHardwareState>     mWifiHardwareState;
+    SystemStatusHistory<SystemStatusNetworkInfo>           mNetworkInfo;
+    SystemStatusHistory<SystemStatusServiceInfo>           mRilServiceInfo;
+    SystemStatusHistory<SystemStatusRilCellInfo>           mRilCellInfo;
+    SystemStatusHistory<SystemStatusServiceStatus>         mServiceStatus;
+    SystemStatusHistory<SystemStatusModel>                 mModel;
+    SystemStatusHistory<SystemStatusManufacturer>          mManufacturer;
+    SystemStatusHistory<SystemStatusAssistedGps>           mAssistedGps;
+    SystemStatusHistory<SystemStatusScreenState>           mScreenState;
+    SystemStatusHistory<SystemStatusPowerConnectState>     mPowerConnectState;
+    SystemStatusHistory<SystemStatusTimeZoneChange>        mTimeZoneChange;
+    SystemStatusHistory<SystemStatusTimeChange>            mTimeChange;
+    SystemStatusHistory<SystemStatusWifiSupplicantStatus>  mWifiSupplicantStatus;
+    SystemStatusHistory<SystemStatusShutdownState>         mShutdownState;
+    SystemStatusHistory<SystemStatusTac>                   mTac;
+    SystemStatusHistory<SystemStatusMccMnc>                mMccMnc;
+    SystemStatusHistory<SystemStatusBtDeviceScanDetail>    mBtDeviceScanDetail;
+    SystemStatusHistory<SystemStatusBtleDeviceScanDetail>  mBtLeDeviceScanDetail;
 };
 
 /******************************************************************************
@@ -0,0 +1,168 @@
+/* Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __SYSTEM_STATUS_NMEA_FIELDS__
+#define __SYSTEM_STATUS_NMEA_FIELDS__
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <loc_pla.h>
+#include <loc_nmea.h>
+
+namespace loc_core
+{
+
+/******************************************************************************
+ SystemStatusNmeaField - one field of a debug NMEA sentence
+
+ It points into the sentence copy of SystemStatusNmeaFields, where the
+ delimiter after it has been replaced by a NUL, so nothing is allocated per
+ field. The conversions return exactly what atoi / atof / strtol(16) /
+ strtoull(10) return for the field; plain digit strings are converted
+ inline, anything else is left to libc.
+******************************************************************************/
+class SystemStatusNmeaField
+{
+    const char* mStr;
+    uint32_t mLen;
+
+    // value of an all-digit field of up to maxDigits digits
+    inline bool digits(uint32_t base, uint32_t start, uint32_t maxDigits,
+                       uint64_t& value) const {
+        if (mLen - start > maxDigits) {
+            return false;
+        }
+        value = 0;
+        for (uint32_t i = start; i < mLen; i++) {
+            uint32_t digit;
+            char c = mStr[i];
+            if (c >= '0' && c <= '9') {
+                digit = c - '0';
+            } else if (16 == base && c >= 'a' && c <= 'f') {
+                digit = c - 'a' + 10;
+            } else if (16 == base && c >= 'A' && c <= 'F') {
+                digit = c - 'A' + 10;
+            } else {
+                return false;
+            }
+            value = value * base + digit;
+        }
+        return true;
+    }
+
+public:
+    inline SystemStatusNmeaField(const char* str, uint32_t len) : mStr(str), mLen(len) {}
+    inline const char* c_str() const { return mStr; }
+    inline uint32_t size() const { return mLen; }
+
+    inline int toInt() const {
+        uint64_t value;
+        bool negative = (mLen > 0 && '-' == mStr[0]);
+        if (digits(10, negative ? 1 : 0, 9, value)) {
+            return negative ? -(int)value : (int)value;
+        }
+        return atoi(mStr);
+    }
+    inline double toDouble() const {
+        return atof(mStr);
+    }
+    inline long toHex() const {
+        uint64_t value;
+        // stay below the digit count at which strtol would clamp
+        if (digits(16, 0, sizeof(long) * 2 - 1, value)) {
+            return (long)value;
+        }
+        return strtol(mStr, NULL, 16);
+    }
+    inline unsigned long long toUint64() const {
+        uint64_t value;
+        if (digits(10, 0, 19, value)) {
+            return value;
+        }
+        return strtoull(mStr, nullptr, 10);
+    }
+};
+
+/******************************************************************************
+ SystemStatusNmeaFields - the fields of a debug NMEA sentence, in order
+
+ The first '*' is a delimiter too, and text after the last delimiter (the
+ checksum value) is not a field. Only the first MAX_FIELDS fields are kept,
+ which is the most any parser reads; size() stops there as well.
+******************************************************************************/
+template <uint32_t MAX_FIELDS>
+class SystemStatusNmeaFields
+{
+    char mSentence[DEBUG_NMEA_MAXSIZE + 1];
+    // field i spans mStart[i] up to the NUL at mStart[i + 1] - 1
+    uint16_t mStart[MAX_FIELDS + 1];
+    uint32_t mCount;
+
+public:
+    inline SystemStatusNmeaFields() : mCount(0) {}
+    inline size_t size() const { return mCount; }
+    inline SystemStatusNmeaField operator[](size_t index) const {
+        return SystemStatusNmeaField(mSentence + mStart[index],
+                                     mStart[index + 1] - mStart[index] - 1);
+    }
+
+    // leaves no fields unless str_in is a debug NMEA sentence with a checksum
+    void split(const char* str_in, uint32_t len_in) {
+        mCount = 0;
+        // check size and talker
+        if (!loc_nmea_is_debug(str_in, len_in)) {
+            return;
+        }
+
+        char* sentence = mSentence;
+        snprintf(sentence, sizeof(mSentence), "%s", str_in);
+
+        // verify checksum field
+        char* checksum = strchr(sentence, '*');
+        if (nullptr == checksum) {
+            return;
+        }
+        *checksum = ',';
+
+        // split in place
+        char* start = sentence;
+        for (char* comma = strchr(start, ','); nullptr != comma && mCount < MAX_FIELDS;
+             comma = strchr(start, ',')) {
+            *comma = '\0';
+            mStart[mCount++] = start - sentence;
+            start = comma + 1;
+        }
+        mStart[mCount] = start - sentence;
+    }
+};
+
+} // namespace loc_core
+
+#endif // __SYSTEM_STATUS_NMEA_FIELDS__
@@ -383,6 +383,17 @@ public:
             RilServiceInfoDataItemBase() {
         peer.setPeerData(*this);
     }
+    // mData is owned, so it is handed over by the peer as on copy, never shared
+    inline RilServiceInfoDataItemBase& operator=(const RilServiceInfoDataItemBase& peer) {
+        if (this != &peer) {
+            if (nullptr != mData) {
+                free(mData);
+                mData = nullptr;
+            }
+            peer.setPeerData(*this);
+        }
+        return *this;
+    }
     inline virtual bool operator==(const RilServiceInfoDataItemBase& other) const {
         return other.mData == mData;
     }
@@ -404,6 +415,17 @@ public:
             RilCellInfoDataItemBase() {
         peer.setPeerData(*this);
     }
+    // mData is owned, so it is handed over by the peer as on copy, never shared
+    inline RilCellInfoDataItemBase& operator=(const RilCellInfoDataItemBase& peer) {
+        if (this != &peer) {
+            if (nullptr != mData) {
+                free(mData);
+                mData = nullptr;
+            }
+            peer.setPeerData(*this);
+        }
+        return *this;
+    }
     inline virtual bool operator==(const RilCellInfoDataItemBase& other) const {
         return other.mData == mData;
     }
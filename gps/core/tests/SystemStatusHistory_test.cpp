@@ -0,0 +1,136 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <SystemStatus.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace loc_core;
+
+namespace {
+
+struct Item {
+    int mValue;
+    explicit Item(int value = 0) : mValue(value) {}
+};
+
+const uint32_t kCapacity = 4;
+typedef SystemStatusHistory<Item, kCapacity> History;
+
+// a RIL item whose data is handed over on copy, as the vendor items do it
+class RilItem : public RilServiceInfoDataItemBase {
+public:
+    explicit RilItem(int value = 0) {
+        mData = malloc(sizeof(int));
+        memcpy(mData, &value, sizeof(value));
+    }
+    RilItem(const RilItem& peer) : RilServiceInfoDataItemBase(peer) {}
+    void setPeerData(RilServiceInfoDataItemBase& peer) const override {
+        peer.mData = malloc(sizeof(int));
+        memcpy(peer.mData, mData, sizeof(int));
+    }
+    int value() const { return *(int*)mData; }
+};
+
+} // namespace
+
+TEST(SystemStatusHistoryTest, KeepsTheLatestInOrder) {
+    History history;
+    for (int i = 0; i < 10; i++) {
+        history.push_back(Item(i));
+    }
+    ASSERT_EQ(kCapacity, history.size());
+    for (uint32_t i = 0; i < kCapacity; i++) {
+        EXPECT_EQ((int)(10 - kCapacity + i), history[i].mValue);
+    }
+    EXPECT_EQ(6, history.front().mValue);
+    EXPECT_EQ(9, history.back().mValue);
+}
+
+TEST(SystemStatusHistoryTest, ReusesItemNotHeldByACopy) {
+    History history;
+    for (uint32_t i = 0; i < kCapacity; i++) {
+        history.push_back(Item(i));
+    }
+    const Item* oldest = &history.front();
+    history.push_back(Item(100));
+    // the oldest item was overwritten where it was
+    EXPECT_EQ(oldest, &history.back());
+    EXPECT_EQ(100, history.back().mValue);
+}
+
+TEST(SystemStatusHistoryTest, CopyKeepsItsItems) {
+    History history;
+    for (uint32_t i = 0; i < kCapacity; i++) {
+        history.push_back(Item(i));
+    }
+    History copy = history;
+    const Item* oldest = &copy.front();
+    for (int i = 0; i < 10; i++) {
+        history.push_back(Item(100 + i));
+    }
+    EXPECT_NE(oldest, &history.back());
+    for (uint32_t i = 0; i < kCapacity; i++) {
+        EXPECT_EQ((int)i, copy[i].mValue);
+    }
+
+    // once the copy is gone, its items are free to reuse again
+    copy.clear();
+    const Item* reusable = &history.front();
+    history.push_back(Item(200));
+    EXPECT_EQ(reusable, &history.back());
+}
+
+TEST(SystemStatusHistoryTest, BackForUpdateDetachesFromCopy) {
+    History history;
+    history.push_back(Item(1));
+    History copy;
+    copy.assignLatest(history);
+    history.backForUpdate().mValue = 2;
+    EXPECT_EQ(2, history.back().mValue);
+    EXPECT_EQ(1, copy.back().mValue);
+}
+
+// the RIL items own their data, reusing one must not share or leak it
+TEST(SystemStatusHistoryTest, ReusesRilItems) {
+    SystemStatusHistory<RilItem, kCapacity> history;
+    for (int i = 0; i < 20; i++) {
+        history.push_back(RilItem(i));
+    }
+    ASSERT_EQ(kCapacity, history.size());
+    for (uint32_t i = 0; i < kCapacity; i++) {
+        EXPECT_EQ((int)(20 - kCapacity + i), history[i].value());
+    }
+
+    RilItem item(7);
+    RilItem other(8);
+    other = item;
+    EXPECT_NE(item.mData, other.mData);
+    EXPECT_EQ(7, other.value());
+}
@@ -0,0 +1,184 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <SystemStatusNmeaFields.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace loc_core;
+
+namespace {
+
+// the std::string tokenizer that SystemStatusNmeaBase used before
+std::vector<std::string> oldTokenize(const char* str_in, uint32_t len_in) {
+    std::vector<std::string> fields;
+    if (!loc_nmea_is_debug(str_in, len_in)) {
+        return fields;
+    }
+    std::string parser(str_in);
+    std::string::size_type index = parser.find("*");
+    if (index == std::string::npos) {
+        return fields;
+    }
+    parser[index] = ',';
+    while (1) {
+        index = parser.find(",");
+        if (index == std::string::npos) {
+            break;
+        }
+        fields.push_back(parser.substr(0, index));
+        parser = parser.substr(index + 1);
+    }
+    return fields;
+}
+
+const uint32_t kMaxFields = 446;
+
+template <uint32_t MAX_FIELDS>
+void expectSameFields(const std::string& sentence) {
+    std::vector<std::string> expected = oldTokenize(sentence.c_str(), sentence.size());
+    std::unique_ptr<SystemStatusNmeaFields<MAX_FIELDS>> fields(
+            new SystemStatusNmeaFields<MAX_FIELDS>());
+    fields->split(sentence.c_str(), sentence.size());
+
+    ASSERT_EQ(std::min<size_t>(expected.size(), MAX_FIELDS), fields->size()) << sentence;
+    for (size_t i = 0; i < fields->size(); i++) {
+        const std::string& old = expected[i];
+        SystemStatusNmeaField field = (*fields)[i];
+        ASSERT_EQ(old, std::string(field.c_str(), field.size())) << sentence;
+        ASSERT_EQ(old.size(), strlen(field.c_str()));
+        EXPECT_EQ(atoi(old.c_str()), field.toInt()) << old;
+        EXPECT_EQ(strtol(old.c_str(), NULL, 16), field.toHex()) << old;
+        EXPECT_EQ(strtoull(old.c_str(), nullptr, 10), field.toUint64()) << old;
+        double oldDouble = atof(old.c_str());
+        double newDouble = field.toDouble();
+        EXPECT_EQ(0, memcmp(&oldDouble, &newDouble, sizeof(double))) << old;
+    }
+}
+
+class SentenceGenerator {
+    std::mt19937 mRand;
+
+    uint32_t below(uint32_t n) { return mRand() % n; }
+
+    std::string digits(uint32_t count, const char* alphabet) {
+        std::string text;
+        uint32_t size = strlen(alphabet);
+        for (uint32_t i = 0; i < count; i++) {
+            text += alphabet[below(size)];
+        }
+        return text;
+    }
+
+public:
+    SentenceGenerator() : mRand(4097) {}
+
+    std::string field() {
+        switch (below(12)) {
+        case 0: return "";
+        case 1: return digits(1 + below(9), "0123456789");
+        case 2: return "-" + digits(1 + below(10), "0123456789");
+        case 3: return digits(1 + below(22), "0123456789");  // overflows
+        case 4: return digits(1 + below(17), "0123456789abcdefABCDEF");
+        case 5: return "-" + digits(1 + below(8), "0123456789abcdef");
+        case 6: return digits(1 + below(6), "0123456789") + "." + digits(below(8), "0123456789");
+        case 7: return "-" + digits(below(4), "0123456789") + "." + digits(1 + below(4), "0123456789");
+        case 8: return " " + digits(1 + below(5), "0123456789");
+        case 9: return "0x" + digits(1 + below(8), "0123456789abcdef");
+        case 10: return digits(1 + below(3), "0123456789") + "e" + digits(1, "0123456789");
+        default: return digits(1 + below(6), "0123456789-+.xX ge$Q");
+        }
+    }
+
+    std::string sentence() {
+        static const char* const kTalkers[] = {
+            "$PQWM1", "$PQWP1", "$PQWP2", "$PQWP3", "$PQWP4", "$PQWP5", "$PQWP6", "$PQWP7",
+            "$PQWS1", "$PQWX9", "$GPGGA", "$PQ"
+        };
+        std::string text = kTalkers[below(sizeof(kTalkers) / sizeof(kTalkers[0]))];
+        // field counts around the parser limits, up to PQWP7's and beyond
+        uint32_t count;
+        switch (below(4)) {
+        case 0: count = below(40); break;
+        case 1: count = kMaxFields - 5 + below(10); break;
+        default: count = below(kMaxFields + 200); break;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            text += "," + field();
+        }
+        switch (below(5)) {
+        case 0: break;                                  // no checksum
+        case 1: text += "*"; break;
+        case 2: text += "*" + digits(2, "0123456789ABCDEF") + "\r\n"; break;
+        default: text += "*" + digits(2, "0123456789ABCDEF"); break;
+        }
+        if (0 == below(20)) {
+            text += ",*,trailing";
+        }
+        return text.substr(0, DEBUG_NMEA_MAXSIZE + below(3));
+    }
+};
+
+} // namespace
+
+TEST(SystemStatusNmeaFields, KnownSentences) {
+    expectSameFields<kMaxFields>("$PQWM1,2,3*7F");
+    expectSameFields<kMaxFields>("$PQWP1,,,,*");
+    expectSameFields<kMaxFields>("$PQWS1,1,2,3");
+    expectSameFields<kMaxFields>("$PQWP5,-12,0x1f,ffffffffffffffff,1.5e3,,*12\r\n");
+    expectSameFields<kMaxFields>("$GPGGA,1,2*00");
+    expectSameFields<kMaxFields>("$PQW");
+    expectSameFields<kMaxFields>(std::string("$PQWP7,") + std::string(4000, ',') + "*00");
+}
+
+TEST(SystemStatusNmeaFields, KeepsOnlyMaxFields) {
+    std::string sentence("$PQWP7");
+    for (int i = 0; i < 20; i++) {
+        sentence += "," + std::to_string(i);
+    }
+    sentence += "*00";
+    expectSameFields<8>(sentence);
+    expectSameFields<20>(sentence);
+    expectSameFields<21>(sentence);
+    expectSameFields<22>(sentence);
+}
+
+TEST(SystemStatusNmeaFields, FuzzAgainstOldTokenizer) {
+    SentenceGenerator generator;
+    for (int i = 0; i < 10000; i++) {
+        std::string sentence = generator.sentence();
+        expectSameFields<kMaxFields>(sentence);
+        if (HasFatalFailure()) {
+            return;
+        }
+    }
+}
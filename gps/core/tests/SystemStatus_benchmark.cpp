@@ -0,0 +1,136 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <SystemStatus.h>
+#include <MsgTask.h>
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+// SystemStatus fed as by a live engine at 10 Hz: each epoch brings PQWM1,
+// PQWP1 to PQWP7 and a position, with values that change every epoch; a
+// debug report is taken once a second.
+
+using namespace loc_core;
+
+namespace {
+
+const int kSentences = 8;
+
+void addChecksum(char* s, size_t size) {
+    uint8_t sum = 0;
+    for (char* p = s + 1; *p; p++) {
+        sum ^= *p;
+    }
+    size_t len = strlen(s);
+    snprintf(s + len, size - len, "*%02X", sum);
+}
+
+class Epochs {
+public:
+    char mSentences[kSentences][300];
+    void make(int i) {
+        const size_t n = sizeof(mSentences[0]);
+        snprintf(mSentences[0], n, "$PQWM1,%d,%d,1,2,%d,3,4,5,6,7,8,9,10,11,12,13,14,"
+                 "1.5,2.5,3.5,4.5,18,1,20,21,22,23,24,25,%d", 2200, 100 * i, i % 50, i);
+        snprintf(mSentences[1], n, "$PQWP1,%d,1,37.123,-122.%d,10.5,1.2,3.4,5.6,7.8,1.0,2.0",
+                 100 * i, i % 1000);
+        snprintf(mSentences[2], n, "$PQWP2,%d,1,37.%d,-122.1,12.0,1,2,3,4", 100 * i, i % 1000);
+        snprintf(mSentences[3], n, "$PQWP3,%d,1,%d,3,4,5,6,7,8,9,10,11,12", 100 * i, i / 100);
+        snprintf(mSentences[4], n, "$PQWP4,%d,%x,%x,%x,%x,%x,%x,%x", 100 * i,
+                 i, i, i, i, i, i, i);
+        snprintf(mSentences[5], n, "$PQWP5,%d,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,"
+                 "%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x,%x", 100 * i,
+                 i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i, i);
+        snprintf(mSentences[6], n, "$PQWP6,%d,%d,%d,%d", 100 * i, i % 7, i % 3, i % 5);
+        snprintf(mSentences[7], n, "$PQWP7,%d,%d,1,2,3,4,5,6,7,8,9", 100 * i, i % 2);
+        for (auto& sentence : mSentences) {
+            addChecksum(sentence, n);
+        }
+    }
+};
+
+SystemStatus* getSystemStatus() {
+    static SystemStatus* sSystemStatus = SystemStatus::getInstance(new MsgTask("ssbench"));
+    return sSystemStatus;
+}
+
+void feed(SystemStatus* systemStatus, Epochs& epochs, int i) {
+    for (auto& sentence : epochs.mSentences) {
+        systemStatus->setNmeaString(sentence, strlen(sentence));
+    }
+    UlpLocation location = {};
+    GpsLocationExtended locationEx = {};
+    location.gpsLocation.latitude = 37 + i * 1e-6;
+    location.gpsLocation.timestamp = 100 * i;
+    systemStatus->eventPosition(location, locationEx);
+}
+
+// one epoch, sentences prepared beforehand
+void BM_SystemStatusEpoch(benchmark::State& state) {
+    SystemStatus* systemStatus = getSystemStatus();
+    const int kPrepared = 100;
+    std::vector<Epochs> epochs(kPrepared);
+    for (int i = 0; i < kPrepared; i++) {
+        epochs[i].make(i);
+    }
+    int i = 0;
+    for (auto _ : state) {
+        feed(systemStatus, epochs[i % kPrepared], i);
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+// one second: ten epochs, then the reports a debug dump takes
+void BM_SystemStatusSecondWithReport(benchmark::State& state) {
+    SystemStatus* systemStatus = getSystemStatus();
+    const bool latestOnly = state.range(0);
+    std::vector<Epochs> epochs(10);
+    for (int i = 0; i < 10; i++) {
+        epochs[i].make(i);
+    }
+    int i = 0;
+    for (auto _ : state) {
+        for (auto& epoch : epochs) {
+            feed(systemStatus, epoch, i++);
+        }
+        SystemStatusReports reports = {};
+        systemStatus->getReport(reports, latestOnly);
+        benchmark::DoNotOptimize(reports.mLocation.size());
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_SystemStatusEpoch);
+BENCHMARK(BM_SystemStatusSecondWithReport)->Arg(0)->Arg(1);
+
+BENCHMARK_MAIN();
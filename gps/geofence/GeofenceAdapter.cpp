@@ -75,7 +75,8 @@ using namespace loc_core;
 GeofenceAdapter::GeofenceAdapter() :
     LocAdapterBase(0,
                    LocContext::getLocContext(LocContext::mLocationHalName),
-                   true /*isMaster*/, nullptr, true)
+                   true /*isMaster*/, nullptr, true),
+    mEngineGeofenceAvailable(true)
 {
     LOC_LOGD("%s]: Constructor", __func__);
 
@@ -102,6 +103,7 @@ GeofenceAdapter::stopClientSessions(LocationAPI* client)
                     auto it2 = mGeofences.find(hwId);
                     if (it2 != mGeofences.end()) {
                         mGeofences.erase(it2);
+                        mBreachEvaluator.removeGeofence(hwId);
                     } else {
                         LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
                     }
@@ -222,6 +224,7 @@ GeofenceAdapter::restartGeofences()
     GeofencesMap oldGeofences(mGeofences);
     mGeofences.clear();
     mGeofenceIds.clear();
+    mBreachEvaluator.clear();
 
     for (auto it = oldGeofences.begin(); it != oldGeofences.end(); it++) {
         GeofenceObject object = it->second;
@@ -734,6 +737,7 @@ GeofenceAdapter::saveGeofenceItem(LocationAPI* client, uint32_t clientId, uint32
                              false};
     mGeofences[hwId] = object;
     mGeofenceIds[key] = hwId;
+    mBreachEvaluator.addGeofence(hwId, options, info);
     dump();
 }
 
@@ -752,6 +756,7 @@ GeofenceAdapter::removeGeofenceItem(uint32_t hwId)
             auto it2 = mGeofences.find(hwId);
             if (it2 != mGeofences.end()) {
                 mGeofences.erase(it2);
+                mBreachEvaluator.removeGeofence(hwId);
                 dump();
             } else {
                 LOC_LOGE("%s]:geofence item to erase not found. hwId %u", __func__, hwId);
@@ -768,6 +773,7 @@ GeofenceAdapter::pauseGeofenceItem(uint32_t hwId)
     auto it = mGeofences.find(hwId);
     if (it != mGeofences.end()) {
         it->second.paused = true;
+        mBreachEvaluator.pauseGeofence(hwId);
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to pause not found. hwId %u", __func__, hwId);
@@ -780,6 +786,7 @@ GeofenceAdapter::resumeGeofenceItem(uint32_t hwId)
     auto it = mGeofences.find(hwId);
     if (it != mGeofences.end()) {
         it->second.paused = false;
+        mBreachEvaluator.resumeGeofence(hwId);
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to resume not found. hwId %u", __func__, hwId);
@@ -794,6 +801,7 @@ GeofenceAdapter::modifyGeofenceItem(uint32_t hwId, const GeofenceOption& options
         it->second.breachMask = options.breachTypeMask;
         it->second.responsiveness = options.responsiveness;
         it->second.dwellTime = options.dwellTime;
+        mBreachEvaluator.modifyGeofence(hwId, options);
         dump();
     } else {
         LOC_LOGE("%s]: geofence item to modify not found. hwId %u", __func__, hwId);
@@ -894,6 +902,81 @@ GeofenceAdapter::geofenceBreach(size_t count, uint32_t* hwIds, const Location& l
     }
 }
 
+void
+GeofenceAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
+                                     const GpsLocationExtended& /*locationExtended*/,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask /*techMask*/,
+                                     GnssDataNotification* /*pDataNotify*/,
+                                     int /*msInWeek*/)
+{
+    if (LOC_SESS_SUCCESS != status ||
+            !(ulpLocation.gpsLocation.flags & LOC_GPS_LOCATION_HAS_LAT_LONG)) {
+        return;
+    }
+
+    struct MsgReportPosition : public LocMsg {
+        GeofenceAdapter& mAdapter;
+        Location mLocation;
+        inline MsgReportPosition(GeofenceAdapter& adapter, const UlpLocation& ulpLocation) :
+            LocMsg(),
+            mAdapter(adapter)
+        {
+            memset(&mLocation, 0, sizeof(mLocation));
+            mLocation.size = sizeof(Location);
+            mLocation.flags = LOCATION_HAS_LAT_LONG_BIT;
+            mLocation.timestamp = ulpLocation.gpsLocation.timestamp;
+            mLocation.latitude = ulpLocation.gpsLocation.latitude;
+            mLocation.longitude = ulpLocation.gpsLocation.longitude;
+            if (ulpLocation.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ACCURACY) {
+                mLocation.flags |= LOCATION_HAS_ACCURACY_BIT;
+                mLocation.accuracy = ulpLocation.gpsLocation.accuracy;
+            }
+        }
+        inline virtual void proc() const {
+            mAdapter.evaluateBreaches(mLocation);
+        }
+    };
+
+    sendMsg(new MsgReportPosition(*this, ulpLocation));
+}
+
+void
+GeofenceAdapter::evaluateBreaches(const Location& location)
+{
+    if (mEngineGeofenceAvailable || mGeofences.empty()) {
+        return;
+    }
+
+    mBreaches.clear();
+    mBreachEvaluator.evaluate(location, mBreaches);
+    if (mBreaches.empty()) {
+        return;
+    }
+
+    // one report per breach type, as the engine does
+    static const GeofenceBreachType breachTypes[] = {
+        GEOFENCE_BREACH_ENTER,
+        GEOFENCE_BREACH_EXIT,
+        GEOFENCE_BREACH_DWELL_IN,
+        GEOFENCE_BREACH_DWELL_OUT,
+    };
+    std::vector<uint32_t> hwIds;
+    for (GeofenceBreachType breachType : breachTypes) {
+        hwIds.clear();
+        for (const GeofenceBreach& breach : mBreaches) {
+            if (breachType == breach.type) {
+                hwIds.push_back(breach.hwId);
+            }
+        }
+        if (!hwIds.empty()) {
+            LOC_LOGD("%s]: breachType %u count %zu", __func__, breachType, hwIds.size());
+            geofenceBreach(hwIds.size(), hwIds.data(), location, breachType,
+                           location.timestamp);
+        }
+    }
+}
+
 void
 GeofenceAdapter::geofenceStatusEvent(GeofenceStatusAvailable available)
 {
@@ -918,6 +1001,13 @@ GeofenceAdapter::geofenceStatusEvent(GeofenceStatusAvailable available)
 void
 GeofenceAdapter::geofenceStatus(GeofenceStatusAvailable available)
 {
+    bool engineGeofenceAvailable = (GEOFENCE_STATUS_AVAILABILE_YES == available);
+    if (!engineGeofenceAvailable && mEngineGeofenceAvailable) {
+        // breaches are evaluated on the AP until the engine is back
+        mBreachEvaluator.restart();
+    }
+    mEngineGeofenceAvailable = engineGeofenceAvailable;
+
     for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
         if (it->second.geofenceStatusCb != nullptr) {
             GeofenceStatusNotification notify = {sizeof(GeofenceStatusNotification),
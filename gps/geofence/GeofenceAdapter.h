@@ -69,6 +69,7 @@ IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include <LocAdapterBase.h>
 #include <LocContext.h>
 #include <LocationAPI.h>
+#include <GeofenceIndex.h>
 #include <map>
 
 using namespace loc_core;
@@ -116,6 +117,10 @@ class GeofenceAdapter : public LocAdapterBase {
     /* ==== GEOFENCES ====================================================================== */
     GeofencesMap mGeofences; //map hwId to GeofenceObject
     GeofenceIdMap mGeofenceIds; //map of GeofenceKey to hwId
+    /* ==== BREACHES ON THE AP (while the engine reports geofencing unavailable) ========= */
+    GeofenceBreachEvaluator mBreachEvaluator; //mirrors mGeofences
+    bool mEngineGeofenceAvailable;
+    std::vector<GeofenceBreach> mBreaches;
 
 protected:
 
@@ -165,10 +170,17 @@ public:
     void geofenceBreachEvent(size_t count, uint32_t* hwIds, Location& location,
                              GeofenceBreachType breachType, uint64_t timestamp);
     void geofenceStatusEvent(GeofenceStatusAvailable available);
+    virtual void reportPositionEvent(const UlpLocation& ulpLocation,
+                                     const GpsLocationExtended& locationExtended,
+                                     enum loc_sess_status status,
+                                     LocPosTechMask techMask,
+                                     GnssDataNotification* pDataNotify = nullptr,
+                                     int msInWeek = -1);
     /* ======== UTILITIES ================================================================== */
     void geofenceBreach(size_t count, uint32_t* hwIds, const Location& location,
                         GeofenceBreachType breachType, uint64_t timestamp);
     void geofenceStatus(GeofenceStatusAvailable available);
+    void evaluateBreaches(const Location& location);
 };
 
 #endif /* GEOFENCE_ADAPTER_H */
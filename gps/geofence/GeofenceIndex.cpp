@@ -0,0 +1,430 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_TAG "LocSvc_GeofenceIndex"
+
+#include <GeofenceIndex.h>
+#include <log_util.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+const double GeofenceIndex::EARTH_RADIUS_M = 6371008.8;
+
+#define DEG_TO_RAD (M_PI / 180.0)
+#define RAD_TO_DEG (180.0 / M_PI)
+// widens the bounding boxes against rounding, in degrees
+#define BOX_MARGIN_DEG 1e-9
+
+GeofenceIndex::GeofenceIndex()
+{
+    memset(mLevelCount, 0, sizeof(mLevelCount));
+    memset(mBandCount, 0, sizeof(mBandCount));
+}
+
+uint64_t GeofenceIndex::cellKey(int level, uint32_t x, uint32_t y)
+{
+    return ((uint64_t)level << 48) | ((uint64_t)y << 24) | x;
+}
+
+uint64_t GeofenceIndex::bandKey(int level, uint32_t y)
+{
+    return cellKey(level, 0, y) | (1ULL << 56);
+}
+
+void GeofenceIndex::cellOf(int level, double latitude, double longitude,
+                           uint32_t& x, uint32_t& y)
+{
+    uint32_t n = 1u << level;
+    double lon = fmod(longitude + 180.0, 360.0);
+    if (lon < 0.0) {
+        lon += 360.0;
+    }
+    double lat = std::min(std::max(latitude + 90.0, 0.0), 180.0);
+    x = std::min((uint32_t)(lon / 360.0 * n), n - 1);
+    y = std::min((uint32_t)(lat / 180.0 * n), n - 1);
+}
+
+void GeofenceIndex::link(uint32_t hwId, Entry& entry)
+{
+    double dr = std::max(entry.mRadius, 0.0) / EARTH_RADIUS_M;
+    double dLat = dr * RAD_TO_DEG + BOX_MARGIN_DEG;
+    double south = entry.mLatitude - dLat;
+    double north = entry.mLatitude + dLat;
+    double dLon = 180.0;
+    if (south > -90.0 && north < 90.0) {
+        // longitude extent of a spherical cap, which is wider than dLat/cos(lat)
+        double s = sin(dr) / cos(entry.mLatitude * DEG_TO_RAD);
+        if (s < 1.0) {
+            dLon = asin(s) * RAD_TO_DEG + BOX_MARGIN_DEG;
+        }
+    }
+    double height = std::min(north, 90.0) - std::max(south, -90.0);
+    double width = 2.0 * dLon;
+
+    int bandLevel = MAX_LEVEL;
+    while (bandLevel > 0 && 180.0 / (1u << bandLevel) < height) {
+        bandLevel--;
+    }
+    int level = bandLevel;
+    while (level > 0 && 360.0 / (1u << level) < width) {
+        level--;
+    }
+
+    uint32_t x[2], y[2];
+    entry.mCellCount = 0;
+    if (bandLevel > 2 * level) {
+        // Close to the poles the box gets much wider than it is tall; a row
+        // of cells spanning all longitudes is then smaller than a cell large
+        // enough for the box.
+        cellOf(bandLevel, south, entry.mLongitude, x[0], y[0]);
+        cellOf(bandLevel, north, entry.mLongitude, x[1], y[1]);
+        entry.mLevel = bandLevel;
+        entry.mBand = true;
+        for (int j = 0; j < ((y[0] == y[1]) ? 1 : 2); j++) {
+            uint64_t key = bandKey(bandLevel, y[j]);
+            entry.mCells[entry.mCellCount++] = key;
+            mCells[key].push_back(hwId);
+        }
+        mBandCount[bandLevel]++;
+        return;
+    }
+
+    // the box is no larger than a cell, so it spans at most 2 cells on each axis
+    cellOf(level, south, entry.mLongitude - dLon, x[0], y[0]);
+    cellOf(level, north, entry.mLongitude + dLon, x[1], y[1]);
+    int xCount = (x[0] == x[1]) ? 1 : 2;
+    int yCount = (y[0] == y[1]) ? 1 : 2;
+
+    entry.mLevel = level;
+    entry.mBand = false;
+    for (int i = 0; i < xCount; i++) {
+        for (int j = 0; j < yCount; j++) {
+            uint64_t key = cellKey(level, x[i], y[j]);
+            entry.mCells[entry.mCellCount++] = key;
+            mCells[key].push_back(hwId);
+        }
+    }
+    mLevelCount[level]++;
+}
+
+void GeofenceIndex::unlink(uint32_t hwId, Entry& entry)
+{
+    for (int i = 0; i < entry.mCellCount; i++) {
+        auto it = mCells.find(entry.mCells[i]);
+        if (it == mCells.end()) {
+            continue;
+        }
+        std::vector<uint32_t>& hwIds = it->second;
+        auto pos = std::find(hwIds.begin(), hwIds.end(), hwId);
+        if (pos != hwIds.end()) {
+            *pos = hwIds.back();
+            hwIds.pop_back();
+        }
+        if (hwIds.empty()) {
+            mCells.erase(it);
+        }
+    }
+    entry.mCellCount = 0;
+    if (entry.mBand) {
+        mBandCount[entry.mLevel]--;
+    } else {
+        mLevelCount[entry.mLevel]--;
+    }
+}
+
+void GeofenceIndex::add(uint32_t hwId, double latitude, double longitude, double radius)
+{
+    auto it = mEntries.find(hwId);
+    if (it != mEntries.end()) {
+        unlink(hwId, it->second);
+    } else {
+        it = mEntries.emplace(hwId, Entry()).first;
+    }
+    Entry& entry = it->second;
+    entry.mLatitude = latitude;
+    entry.mLongitude = longitude;
+    entry.mRadius = radius;
+    link(hwId, entry);
+}
+
+void GeofenceIndex::remove(uint32_t hwId)
+{
+    auto it = mEntries.find(hwId);
+    if (it != mEntries.end()) {
+        unlink(hwId, it->second);
+        mEntries.erase(it);
+    }
+}
+
+void GeofenceIndex::clear()
+{
+    mEntries.clear();
+    mCells.clear();
+    memset(mLevelCount, 0, sizeof(mLevelCount));
+    memset(mBandCount, 0, sizeof(mBandCount));
+}
+
+void GeofenceIndex::getCandidates(double latitude, double longitude,
+                                  std::vector<uint32_t>& hwIds) const
+{
+    for (int level = 0; level <= MAX_LEVEL; level++) {
+        if (0 == mLevelCount[level] && 0 == mBandCount[level]) {
+            continue;
+        }
+        uint32_t x, y;
+        cellOf(level, latitude, longitude, x, y);
+        if (0 != mLevelCount[level]) {
+            auto it = mCells.find(cellKey(level, x, y));
+            if (it != mCells.end()) {
+                hwIds.insert(hwIds.end(), it->second.begin(), it->second.end());
+            }
+        }
+        if (0 != mBandCount[level]) {
+            auto it = mCells.find(bandKey(level, y));
+            if (it != mCells.end()) {
+                hwIds.insert(hwIds.end(), it->second.begin(), it->second.end());
+            }
+        }
+    }
+}
+
+void GeofenceIndex::getContaining(double latitude, double longitude,
+                                  std::vector<uint32_t>& hwIds) const
+{
+    size_t start = hwIds.size();
+    getCandidates(latitude, longitude, hwIds);
+    auto end = std::remove_if(hwIds.begin() + start, hwIds.end(),
+            [this, latitude, longitude] (uint32_t hwId) {
+        return !contains(hwId, latitude, longitude);
+    });
+    hwIds.erase(end, hwIds.end());
+}
+
+bool GeofenceIndex::contains(uint32_t hwId, double latitude, double longitude) const
+{
+    auto it = mEntries.find(hwId);
+    return it != mEntries.end() &&
+            distance(it->second.mLatitude, it->second.mLongitude, latitude, longitude) <=
+            it->second.mRadius;
+}
+
+double GeofenceIndex::distance(double lat1, double lon1, double lat2, double lon2)
+{
+    double sinLat = sin((lat2 - lat1) * DEG_TO_RAD / 2.0);
+    double sinLon = sin((lon2 - lon1) * DEG_TO_RAD / 2.0);
+    double a = sinLat * sinLat +
+            cos(lat1 * DEG_TO_RAD) * cos(lat2 * DEG_TO_RAD) * sinLon * sinLon;
+    return 2.0 * EARTH_RADIUS_M * asin(std::min(1.0, sqrt(a)));
+}
+
+GeofenceBreachEvaluator::GeofenceBreachEvaluator() :
+    mEpoch(0)
+{
+}
+
+void GeofenceBreachEvaluator::erase(std::vector<uint32_t>& hwIds, uint32_t hwId)
+{
+    auto pos = std::find(hwIds.begin(), hwIds.end(), hwId);
+    if (pos != hwIds.end()) {
+        *pos = hwIds.back();
+        hwIds.pop_back();
+    }
+}
+
+void GeofenceBreachEvaluator::reset(uint32_t hwId, Fence& fence)
+{
+    if (STATE_INSIDE == fence.mState) {
+        erase(mInside, hwId);
+    } else if (STATE_OUTSIDE == fence.mState) {
+        erase(mDwellingOut, hwId);
+    }
+    fence.mState = STATE_UNKNOWN;
+    fence.mDwellReported = false;
+    fence.mSince = 0;
+    fence.mSeen = 0;
+}
+
+void GeofenceBreachEvaluator::addGeofence(uint32_t hwId, const GeofenceOption& options,
+                                          const GeofenceInfo& info)
+{
+    auto it = mFences.find(hwId);
+    if (it != mFences.end()) {
+        reset(hwId, it->second);
+    }
+    Fence& fence = mFences[hwId];
+    fence.mBreachMask = options.breachTypeMask;
+    fence.mDwellTime = options.dwellTime;
+    fence.mPaused = false;
+    fence.mState = STATE_UNKNOWN;
+    fence.mDwellReported = false;
+    fence.mSince = 0;
+    fence.mSeen = 0;
+    mIndex.add(hwId, info.latitude, info.longitude, info.radius);
+}
+
+void GeofenceBreachEvaluator::removeGeofence(uint32_t hwId)
+{
+    auto it = mFences.find(hwId);
+    if (it != mFences.end()) {
+        reset(hwId, it->second);
+        mFences.erase(it);
+        mIndex.remove(hwId);
+    } else {
+        LOC_LOGE("%s]: geofence item to erase not found. hwId %u", __func__, hwId);
+    }
+}
+
+void GeofenceBreachEvaluator::pauseGeofence(uint32_t hwId)
+{
+    auto it = mFences.find(hwId);
+    if (it != mFences.end()) {
+        reset(hwId, it->second);
+        it->second.mPaused = true;
+    } else {
+        LOC_LOGE("%s]: geofence item to pause not found. hwId %u", __func__, hwId);
+    }
+}
+
+void GeofenceBreachEvaluator::resumeGeofence(uint32_t hwId)
+{
+    auto it = mFences.find(hwId);
+    if (it != mFences.end()) {
+        it->second.mPaused = false;
+    } else {
+        LOC_LOGE("%s]: geofence item to resume not found. hwId %u", __func__, hwId);
+    }
+}
+
+void GeofenceBreachEvaluator::modifyGeofence(uint32_t hwId, const GeofenceOption& options)
+{
+    auto it = mFences.find(hwId);
+    if (it != mFences.end()) {
+        Fence& fence = it->second;
+        fence.mBreachMask = options.breachTypeMask;
+        fence.mDwellTime = options.dwellTime;
+        if (STATE_OUTSIDE == fence.mState && !fence.mDwellReported &&
+                (fence.mBreachMask & GEOFENCE_BREACH_DWELL_OUT_BIT) &&
+                std::find(mDwellingOut.begin(), mDwellingOut.end(), hwId) ==
+                mDwellingOut.end()) {
+            mDwellingOut.push_back(hwId);
+        }
+    } else {
+        LOC_LOGE("%s]: geofence item to modify not found. hwId %u", __func__, hwId);
+    }
+}
+
+void GeofenceBreachEvaluator::restart()
+{
+    for (auto it = mFences.begin(); it != mFences.end(); ++it) {
+        Fence& fence = it->second;
+        fence.mState = STATE_UNKNOWN;
+        fence.mDwellReported = false;
+        fence.mSince = 0;
+        fence.mSeen = 0;
+    }
+    mInside.clear();
+    mDwellingOut.clear();
+}
+
+void GeofenceBreachEvaluator::clear()
+{
+    mFences.clear();
+    mIndex.clear();
+    mInside.clear();
+    mDwellingOut.clear();
+}
+
+void GeofenceBreachEvaluator::evaluate(const Location& location,
+                                       std::vector<GeofenceBreach>& breaches)
+{
+    uint64_t now = location.timestamp;
+    mEpoch++;
+
+    // mScratch ends up holding the unpaused fences the location is in
+    mScratch.clear();
+    mIndex.getContaining(location.latitude, location.longitude, mScratch);
+    size_t insideCount = 0;
+    for (uint32_t hwId : mScratch) {
+        Fence& fence = mFences[hwId];
+        if (fence.mPaused) {
+            continue;
+        }
+        mScratch[insideCount++] = hwId;
+        fence.mSeen = mEpoch;
+        if (STATE_INSIDE != fence.mState) {
+            if (STATE_OUTSIDE == fence.mState) {
+                erase(mDwellingOut, hwId);
+            }
+            fence.mState = STATE_INSIDE;
+            fence.mSince = now;
+            fence.mDwellReported = false;
+            if (fence.mBreachMask & GEOFENCE_BREACH_ENTER_BIT) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_ENTER});
+            }
+        }
+        if (!fence.mDwellReported && (fence.mBreachMask & GEOFENCE_BREACH_DWELL_IN_BIT) &&
+                now >= fence.mSince + fence.mDwellTime * 1000ULL) {
+            fence.mDwellReported = true;
+            breaches.push_back({hwId, GEOFENCE_BREACH_DWELL_IN});
+        }
+    }
+    mScratch.resize(insideCount);
+
+    for (uint32_t hwId : mInside) {
+        Fence& fence = mFences[hwId];
+        if (fence.mSeen == mEpoch) {
+            continue;
+        }
+        fence.mState = STATE_OUTSIDE;
+        fence.mSince = now;
+        fence.mDwellReported = false;
+        if (fence.mBreachMask & GEOFENCE_BREACH_EXIT_BIT) {
+            breaches.push_back({hwId, GEOFENCE_BREACH_EXIT});
+        }
+        if (fence.mBreachMask & GEOFENCE_BREACH_DWELL_OUT_BIT) {
+            mDwellingOut.push_back(hwId);
+        }
+    }
+    mInside.swap(mScratch);
+
+    for (size_t i = 0; i < mDwellingOut.size();) {
+        uint32_t hwId = mDwellingOut[i];
+        Fence& fence = mFences[hwId];
+        if (now >= fence.mSince + fence.mDwellTime * 1000ULL) {
+            fence.mDwellReported = true;
+            if (fence.mBreachMask & GEOFENCE_BREACH_DWELL_OUT_BIT) {
+                breaches.push_back({hwId, GEOFENCE_BREACH_DWELL_OUT});
+            }
+            mDwellingOut[i] = mDwellingOut.back();
+            mDwellingOut.pop_back();
+            continue;
+        }
+        ++i;
+    }
+}
@@ -0,0 +1,157 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef GEOFENCE_INDEX_H
+#define GEOFENCE_INDEX_H
+
+#include <LocationDataTypes.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <unordered_map>
+#include <vector>
+
+// A spatial index of circular geofences, keyed by hwId.
+// The globe is split into a quadtree of lat/lon cells (a geohash with
+// one bit per axis per level). A fence is hashed into the deepest level
+// whose cells are still at least as large as the fence's bounding box,
+// so it overlaps at most 2x2 cells there. A lookup then only needs the
+// one cell that holds the location on each non-empty level, which is
+// O(levels), i.e. logarithmic in the ratio of the earth to the smallest
+// fence, no matter how many fences there are. Fences near the poles,
+// whose boxes span most longitudes, go into a row of cells instead.
+// The index is not thread safe; GeofenceAdapter only uses it in the
+// context of its MsgTask.
+class GeofenceIndex {
+public:
+    // 180 / 2^24 degrees, about 1.2m of latitude at the deepest level
+    static const int MAX_LEVEL = 24;
+    static const double EARTH_RADIUS_M;
+private:
+    struct Entry {
+        double mLatitude;
+        double mLongitude;
+        double mRadius;
+        uint64_t mCells[4];
+        uint8_t mCellCount;
+        int8_t mLevel;
+        // hashed into rows of cells at mLevel instead
+        bool mBand;
+    };
+    std::unordered_map<uint32_t, Entry> mEntries;
+    std::unordered_map<uint64_t, std::vector<uint32_t>> mCells;
+    uint32_t mLevelCount[MAX_LEVEL + 1];
+    uint32_t mBandCount[MAX_LEVEL + 1];
+
+    static uint64_t cellKey(int level, uint32_t x, uint32_t y);
+    static uint64_t bandKey(int level, uint32_t y);
+    static void cellOf(int level, double latitude, double longitude, uint32_t& x, uint32_t& y);
+    void link(uint32_t hwId, Entry& entry);
+    void unlink(uint32_t hwId, Entry& entry);
+public:
+    GeofenceIndex();
+
+    // Adds the fence, or moves it if hwId is already in the index.
+    void add(uint32_t hwId, double latitude, double longitude, double radius);
+    // no op if hwId is not in the index
+    void remove(uint32_t hwId);
+    void clear();
+    // Appends to hwIds every fence whose bounding box may hold the
+    // location. This is a superset of the fences that contain it; use
+    // contains() to filter.
+    void getCandidates(double latitude, double longitude, std::vector<uint32_t>& hwIds) const;
+    // Appends to hwIds the fences that contain the location.
+    void getContaining(double latitude, double longitude, std::vector<uint32_t>& hwIds) const;
+    bool contains(uint32_t hwId, double latitude, double longitude) const;
+    inline size_t size() const { return mEntries.size(); }
+
+    // great circle distance in meters
+    static double distance(double lat1, double lon1, double lat2, double lon2);
+};
+
+typedef struct {
+    uint32_t hwId;
+    GeofenceBreachType type;
+} GeofenceBreach;
+
+// Evaluates ENTER/EXIT/DWELL_IN/DWELL_OUT breaches of the geofences on
+// the AP from a stream of locations, the way the engine does it on the
+// modem. A fence starts out in an unknown state and reports ENTER the
+// first time a location falls in it; EXIT needs a prior ENTER. DWELL_IN
+// and DWELL_OUT go off once the location has stayed in, or out, for the
+// fence's dwellTime. Paused fences report nothing and start over from
+// the unknown state when resumed.
+// Each evaluate() costs one index lookup plus the fences that the
+// location is in, or was in the last time, so it scales to tens of
+// thousands of fences.
+class GeofenceBreachEvaluator {
+    enum State {
+        STATE_UNKNOWN = 0,
+        STATE_INSIDE,
+        STATE_OUTSIDE,
+    };
+    struct Fence {
+        GeofenceBreachTypeMask mBreachMask;
+        uint32_t mDwellTime;
+        bool mPaused;
+        bool mDwellReported;
+        State mState;
+        // timestamp of the last ENTER or EXIT
+        uint64_t mSince;
+        // the last evaluate() that found the location in the fence
+        uint64_t mSeen;
+    };
+    GeofenceIndex mIndex;
+    std::unordered_map<uint32_t, Fence> mFences;
+    // fences the location was in at the last evaluate()
+    std::vector<uint32_t> mInside;
+    // fences that have gone out and still wait for DWELL_OUT
+    std::vector<uint32_t> mDwellingOut;
+    std::vector<uint32_t> mScratch;
+    uint64_t mEpoch;
+
+    static void erase(std::vector<uint32_t>& hwIds, uint32_t hwId);
+    void reset(uint32_t hwId, Fence& fence);
+public:
+    GeofenceBreachEvaluator();
+
+    void addGeofence(uint32_t hwId, const GeofenceOption& options, const GeofenceInfo& info);
+    void removeGeofence(uint32_t hwId);
+    void pauseGeofence(uint32_t hwId);
+    void resumeGeofence(uint32_t hwId);
+    void modifyGeofence(uint32_t hwId, const GeofenceOption& options);
+    // Puts every fence back in the unknown state, as after addGeofence().
+    void restart();
+    void clear();
+    // Appends the breaches caused by location to breaches. Locations
+    // must come in timestamp order.
+    void evaluate(const Location& location, std::vector<GeofenceBreach>& breaches);
+    inline size_t size() const { return mFences.size(); }
+    inline const GeofenceIndex& getIndex() const { return mIndex; }
+};
+
+#endif /* GEOFENCE_INDEX_H */
@@ -0,0 +1,136 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <GeofenceIndex.h>
+#include <benchmark/benchmark.h>
+#include <string.h>
+#include <random>
+#include <vector>
+
+// Lookups and evaluate() against the brute force scan they replace, at
+// 10k to 100k fences.
+
+namespace {
+
+struct Fences {
+    std::vector<GeofenceInfo> mInfo;
+    std::vector<std::pair<double, double>> mLocations;
+
+    explicit Fences(size_t count) {
+        std::mt19937 rand(count);
+        auto range = [&rand] (double lo, double hi) {
+            return lo + (hi - lo) * (rand() / 4294967296.0);
+        };
+        // fences of 50m to 2km, spread over a 2x2 degree area, like a city
+        for (size_t i = 0; i < count; i++) {
+            GeofenceInfo info;
+            memset(&info, 0, sizeof(info));
+            info.size = sizeof(info);
+            info.latitude = 37.0 + range(-1, 1);
+            info.longitude = -122.0 + range(-1, 1);
+            info.radius = range(50, 2000);
+            mInfo.push_back(info);
+        }
+        for (int i = 0; i < 1024; i++) {
+            mLocations.push_back({37.0 + range(-1, 1), -122.0 + range(-1, 1)});
+        }
+    }
+};
+
+void BM_IndexLookup(benchmark::State& state) {
+    Fences fences(state.range(0));
+    GeofenceIndex index;
+    for (size_t i = 0; i < fences.mInfo.size(); i++) {
+        index.add(i, fences.mInfo[i].latitude, fences.mInfo[i].longitude, fences.mInfo[i].radius);
+    }
+    std::vector<uint32_t> hwIds;
+    size_t i = 0;
+    for (auto _ : state) {
+        auto& location = fences.mLocations[i++ % fences.mLocations.size()];
+        hwIds.clear();
+        index.getContaining(location.first, location.second, hwIds);
+        benchmark::DoNotOptimize(hwIds.data());
+    }
+}
+BENCHMARK(BM_IndexLookup)->Arg(10000)->Arg(30000)->Arg(100000);
+
+void BM_BruteForceLookup(benchmark::State& state) {
+    Fences fences(state.range(0));
+    std::vector<uint32_t> hwIds;
+    size_t i = 0;
+    for (auto _ : state) {
+        auto& location = fences.mLocations[i++ % fences.mLocations.size()];
+        hwIds.clear();
+        for (size_t j = 0; j < fences.mInfo.size(); j++) {
+            const GeofenceInfo& info = fences.mInfo[j];
+            if (GeofenceIndex::distance(info.latitude, info.longitude,
+                                        location.first, location.second) <= info.radius) {
+                hwIds.push_back(j);
+            }
+        }
+        benchmark::DoNotOptimize(hwIds.data());
+    }
+}
+BENCHMARK(BM_BruteForceLookup)->Arg(10000)->Arg(30000)->Arg(100000);
+
+// a walk at 10 m/s with a fix every second, through all the fences
+void BM_Evaluate(benchmark::State& state) {
+    Fences fences(state.range(0));
+    GeofenceBreachEvaluator evaluator;
+    GeofenceOption options;
+    memset(&options, 0, sizeof(options));
+    options.size = sizeof(options);
+    options.breachTypeMask = GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT |
+            GEOFENCE_BREACH_DWELL_IN_BIT | GEOFENCE_BREACH_DWELL_OUT_BIT;
+    options.dwellTime = 60;
+    for (size_t i = 0; i < fences.mInfo.size(); i++) {
+        evaluator.addGeofence(i, options, fences.mInfo[i]);
+    }
+    Location location;
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT;
+    location.latitude = 36.0;
+    location.longitude = -122.5;
+    std::vector<GeofenceBreach> breaches;
+    for (auto _ : state) {
+        location.timestamp += 1000;
+        location.latitude += 0.00009;
+        if (location.latitude > 38.0) {
+            location.latitude = 36.0;
+        }
+        breaches.clear();
+        evaluator.evaluate(location, breaches);
+        benchmark::DoNotOptimize(breaches.data());
+    }
+}
+BENCHMARK(BM_Evaluate)->Arg(10000)->Arg(30000)->Arg(100000);
+
+} // namespace
+
+BENCHMARK_MAIN();
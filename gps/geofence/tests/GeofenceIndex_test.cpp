@@ -0,0 +1,363 @@
+/* Copyright (c) 2021 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <GeofenceIndex.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct TestFence {
+    uint32_t hwId;
+    double latitude;
+    double longitude;
+    double radius;
+};
+
+class FenceGenerator {
+    std::mt19937 mRand;
+public:
+    explicit FenceGenerator(uint32_t seed) : mRand(seed) {}
+    double range(double lo, double hi) {
+        return lo + (hi - lo) * (mRand() / 4294967296.0);
+    }
+    // mostly small fences around a few cities, plus some anywhere, some
+    // huge ones, and some across the dateline and near the poles
+    TestFence fence(uint32_t hwId) {
+        static const double kCities[][2] = {
+            {37.77, -122.42}, {51.51, -0.13}, {35.68, 139.69}, {-33.87, 151.21},
+            {64.15, -21.94}, {-17.8, 179.9},
+        };
+        TestFence f = {hwId, 0, 0, 0};
+        uint32_t kind = mRand() % 10;
+        if (kind < 6) {
+            const double* city = kCities[mRand() % 6];
+            f.latitude = city[0] + range(-0.5, 0.5);
+            f.longitude = city[1] + range(-0.5, 0.5);
+            f.radius = range(50, 2000);
+        } else if (kind < 8) {
+            f.latitude = range(-90, 90);
+            f.longitude = range(-180, 180);
+            f.radius = range(100, 50000);
+        } else if (kind < 9) {
+            f.latitude = range(-89.9, 89.9);
+            f.longitude = (mRand() % 2) ? range(179, 180) : range(-180, -179);
+            f.radius = range(1000, 200000);
+        } else {
+            f.latitude = (mRand() % 2) ? range(85, 90) : range(-90, -85);
+            f.longitude = range(-180, 180);
+            f.radius = range(1000, 500000);
+        }
+        if (f.longitude >= 180) {
+            f.longitude -= 360;
+        }
+        return f;
+    }
+    void location(const std::vector<TestFence>& fences, double& latitude, double& longitude) {
+        if (!fences.empty() && mRand() % 2) {
+            // near a fence, in or just out of it
+            const TestFence& f = fences[mRand() % fences.size()];
+            double offset = f.radius * range(0, 1.3) / GeofenceIndex::EARTH_RADIUS_M * 57.29577951;
+            latitude = std::max(-90.0, std::min(90.0, f.latitude + range(-offset, offset)));
+            longitude = f.longitude + range(-offset, offset);
+            while (longitude >= 180) longitude -= 360;
+            while (longitude < -180) longitude += 360;
+        } else {
+            latitude = range(-90, 90);
+            longitude = range(-180, 180);
+        }
+    }
+};
+
+std::vector<uint32_t> bruteForce(const std::vector<TestFence>& fences,
+                                 double latitude, double longitude) {
+    std::vector<uint32_t> hwIds;
+    for (const TestFence& f : fences) {
+        if (GeofenceIndex::distance(f.latitude, f.longitude, latitude, longitude) <= f.radius) {
+            hwIds.push_back(f.hwId);
+        }
+    }
+    std::sort(hwIds.begin(), hwIds.end());
+    return hwIds;
+}
+
+std::vector<uint32_t> lookup(const GeofenceIndex& index, double latitude, double longitude) {
+    std::vector<uint32_t> hwIds;
+    index.getContaining(latitude, longitude, hwIds);
+    std::sort(hwIds.begin(), hwIds.end());
+    return hwIds;
+}
+
+GeofenceOption option(GeofenceBreachTypeMask mask, uint32_t dwellTime = 0) {
+    GeofenceOption options;
+    memset(&options, 0, sizeof(options));
+    options.size = sizeof(options);
+    options.breachTypeMask = mask;
+    options.responsiveness = 1000;
+    options.dwellTime = dwellTime;
+    return options;
+}
+
+GeofenceInfo info(double latitude, double longitude, double radius) {
+    GeofenceInfo fence;
+    memset(&fence, 0, sizeof(fence));
+    fence.size = sizeof(fence);
+    fence.latitude = latitude;
+    fence.longitude = longitude;
+    fence.radius = radius;
+    return fence;
+}
+
+Location at(double latitude, double longitude, uint64_t timestamp) {
+    Location location;
+    memset(&location, 0, sizeof(location));
+    location.size = sizeof(location);
+    location.flags = LOCATION_HAS_LAT_LONG_BIT;
+    location.latitude = latitude;
+    location.longitude = longitude;
+    location.timestamp = timestamp;
+    return location;
+}
+
+std::vector<GeofenceBreach> evaluate(GeofenceBreachEvaluator& evaluator, const Location& location) {
+    std::vector<GeofenceBreach> breaches;
+    evaluator.evaluate(location, breaches);
+    std::sort(breaches.begin(), breaches.end(), [] (const GeofenceBreach& a, const GeofenceBreach& b) {
+        return a.type < b.type || (a.type == b.type && a.hwId < b.hwId);
+    });
+    return breaches;
+}
+
+::testing::AssertionResult breachesAre(const std::vector<GeofenceBreach>& breaches,
+                                       std::vector<GeofenceBreach> expected) {
+    std::sort(expected.begin(), expected.end(), [] (const GeofenceBreach& a, const GeofenceBreach& b) {
+        return a.type < b.type || (a.type == b.type && a.hwId < b.hwId);
+    });
+    bool same = breaches.size() == expected.size();
+    for (size_t i = 0; same && i < breaches.size(); i++) {
+        same = breaches[i].hwId == expected[i].hwId && breaches[i].type == expected[i].type;
+    }
+    if (same) {
+        return ::testing::AssertionSuccess();
+    }
+    ::testing::AssertionResult result = ::testing::AssertionFailure();
+    result << "got";
+    for (auto& breach : breaches) {
+        result << " " << breach.hwId << "/" << breach.type;
+    }
+    result << ", expected";
+    for (auto& breach : expected) {
+        result << " " << breach.hwId << "/" << breach.type;
+    }
+    return result;
+}
+
+const GeofenceBreachTypeMask kAll = GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT |
+        GEOFENCE_BREACH_DWELL_IN_BIT | GEOFENCE_BREACH_DWELL_OUT_BIT;
+
+} // namespace
+
+TEST(GeofenceIndex, MatchesBruteForce) {
+    FenceGenerator generator(1);
+    std::vector<TestFence> fences;
+    GeofenceIndex index;
+    for (uint32_t hwId = 0; hwId < 10000; hwId++) {
+        fences.push_back(generator.fence(hwId));
+        index.add(hwId, fences.back().latitude, fences.back().longitude, fences.back().radius);
+    }
+    ASSERT_EQ(fences.size(), index.size());
+    for (int i = 0; i < 2000; i++) {
+        double latitude, longitude;
+        generator.location(fences, latitude, longitude);
+        ASSERT_EQ(bruteForce(fences, latitude, longitude), lookup(index, latitude, longitude))
+                << latitude << "," << longitude;
+    }
+}
+
+TEST(GeofenceIndex, RemovesAndMoves) {
+    FenceGenerator generator(2);
+    std::vector<TestFence> fences;
+    GeofenceIndex index;
+    for (uint32_t hwId = 0; hwId < 2000; hwId++) {
+        fences.push_back(generator.fence(hwId));
+        index.add(hwId, fences.back().latitude, fences.back().longitude, fences.back().radius);
+    }
+    // remove every third fence and move every fifth
+    std::vector<TestFence> left;
+    for (TestFence& f : fences) {
+        if (0 == f.hwId % 3) {
+            index.remove(f.hwId);
+            continue;
+        }
+        if (0 == f.hwId % 5) {
+            TestFence moved = generator.fence(f.hwId);
+            f = moved;
+            index.add(f.hwId, f.latitude, f.longitude, f.radius);
+        }
+        left.push_back(f);
+    }
+    index.remove(100000);
+    ASSERT_EQ(left.size(), index.size());
+    for (int i = 0; i < 2000; i++) {
+        double latitude, longitude;
+        generator.location(fences, latitude, longitude);
+        ASSERT_EQ(bruteForce(left, latitude, longitude), lookup(index, latitude, longitude))
+                << latitude << "," << longitude;
+    }
+    index.clear();
+    EXPECT_EQ(0u, index.size());
+    EXPECT_TRUE(lookup(index, fences[1].latitude, fences[1].longitude).empty());
+}
+
+TEST(GeofenceIndex, DatelineAndPoles) {
+    GeofenceIndex index;
+    index.add(1, 0.0, 179.999, 1000);
+    index.add(2, 89.999, 0.0, 5000);
+    index.add(3, -89.99, 90.0, 2000);
+    EXPECT_EQ(std::vector<uint32_t>({1}), lookup(index, 0.0, -179.999));
+    EXPECT_EQ(std::vector<uint32_t>({1}), lookup(index, 0.0, 179.995));
+    EXPECT_EQ(std::vector<uint32_t>({2}), lookup(index, 89.99, 180.0));
+    EXPECT_EQ(std::vector<uint32_t>({2}), lookup(index, 90.0, -45.0));
+    EXPECT_EQ(std::vector<uint32_t>({3}), lookup(index, -90.0, 0.0));
+    EXPECT_TRUE(lookup(index, 0.0, 0.0).empty());
+}
+
+TEST(GeofenceBreachEvaluator, EnterExit) {
+    GeofenceBreachEvaluator evaluator;
+    evaluator.addGeofence(1, option(GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT),
+                          info(37.0, -122.0, 100));
+    evaluator.addGeofence(2, option(GEOFENCE_BREACH_EXIT_BIT), info(37.0, -122.0, 1000));
+
+    // no EXIT before an ENTER
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(38.0, -122.0, 1000)), {}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(37.0, -122.0, 2000)),
+                            {{1, GEOFENCE_BREACH_ENTER}}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(37.0, -122.0, 3000)), {}));
+    // out of 1 only
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(37.005, -122.0, 4000)),
+                            {{1, GEOFENCE_BREACH_EXIT}}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(37.5, -122.0, 5000)),
+                            {{2, GEOFENCE_BREACH_EXIT}}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(37.5, -122.0, 6000)), {}));
+}
+
+TEST(GeofenceBreachEvaluator, Dwell) {
+    GeofenceBreachEvaluator evaluator;
+    evaluator.addGeofence(7, option(kAll, 10), info(10.0, 10.0, 500));
+
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(10.0, 10.0, 0)),
+                            {{7, GEOFENCE_BREACH_ENTER}}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(10.0, 10.0, 9999)), {}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(10.0, 10.0, 10000)),
+                            {{7, GEOFENCE_BREACH_DWELL_IN}}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(10.0, 10.0, 20000)), {}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(11.0, 10.0, 21000)),
+                            {{7, GEOFENCE_BREACH_EXIT}}));
+    // back in before the dwell time: no DWELL_OUT
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(10.0, 10.0, 25000)),
+                            {{7, GEOFENCE_BREACH_ENTER}}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(11.0, 10.0, 26000)),
+                            {{7, GEOFENCE_BREACH_EXIT}}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(11.0, 10.0, 36000)),
+                            {{7, GEOFENCE_BREACH_DWELL_OUT}}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(11.0, 10.0, 50000)), {}));
+}
+
+TEST(GeofenceBreachEvaluator, PauseResumeModify) {
+    GeofenceBreachEvaluator evaluator;
+    evaluator.addGeofence(1, option(GEOFENCE_BREACH_ENTER_BIT), info(0.0, 0.0, 1000));
+    evaluator.addGeofence(2, option(GEOFENCE_BREACH_ENTER_BIT), info(0.0, 0.0, 1000));
+
+    evaluator.pauseGeofence(2);
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(0.0, 0.0, 1000)),
+                            {{1, GEOFENCE_BREACH_ENTER}}));
+    // starts over from the unknown state
+    evaluator.resumeGeofence(2);
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(0.0, 0.0, 2000)),
+                            {{2, GEOFENCE_BREACH_ENTER}}));
+
+    evaluator.modifyGeofence(1, option(GEOFENCE_BREACH_EXIT_BIT));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(1.0, 0.0, 3000)),
+                            {{1, GEOFENCE_BREACH_EXIT}}));
+
+    evaluator.removeGeofence(2);
+    EXPECT_EQ(1u, evaluator.size());
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(0.0, 0.0, 4000)), {}));
+}
+
+TEST(GeofenceBreachEvaluator, Restart) {
+    GeofenceBreachEvaluator evaluator;
+    evaluator.addGeofence(1, option(kAll, 5), info(0.0, 0.0, 1000));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(0.0, 0.0, 1000)),
+                            {{1, GEOFENCE_BREACH_ENTER}}));
+    evaluator.restart();
+    // neither an EXIT nor a DWELL_IN from before the restart
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(1.0, 0.0, 10000)), {}));
+    EXPECT_TRUE(breachesAre(evaluate(evaluator, at(0.0, 0.0, 11000)),
+                            {{1, GEOFENCE_BREACH_ENTER}}));
+}
+
+// the evaluator against a brute force replay of the same rules
+TEST(GeofenceBreachEvaluator, RandomWalkMatchesBruteForce) {
+    FenceGenerator generator(3);
+    std::vector<TestFence> fences;
+    GeofenceBreachEvaluator evaluator;
+    for (uint32_t hwId = 0; hwId < 3000; hwId++) {
+        fences.push_back(generator.fence(hwId));
+        evaluator.addGeofence(hwId, option(GEOFENCE_BREACH_ENTER_BIT | GEOFENCE_BREACH_EXIT_BIT),
+                              info(fences.back().latitude, fences.back().longitude,
+                                   fences.back().radius));
+    }
+    std::vector<bool> inside(fences.size(), false);
+    uint64_t timestamp = 0;
+    for (int i = 0; i < 1000; i++) {
+        double latitude, longitude;
+        generator.location(fences, latitude, longitude);
+        timestamp += 1000;
+        std::vector<GeofenceBreach> expected;
+        std::vector<uint32_t> now = bruteForce(fences, latitude, longitude);
+        std::vector<bool> nowInside(fences.size(), false);
+        for (uint32_t hwId : now) {
+            nowInside[hwId] = true;
+            if (!inside[hwId]) {
+                expected.push_back({hwId, GEOFENCE_BREACH_ENTER});
+            }
+        }
+        for (uint32_t hwId = 0; hwId < fences.size(); hwId++) {
+            if (inside[hwId] && !nowInside[hwId]) {
+                expected.push_back({hwId, GEOFENCE_BREACH_EXIT});
+            }
+        }
+        inside.swap(nowInside);
+        ASSERT_TRUE(breachesAre(evaluate(evaluator, at(latitude, longitude, timestamp)),
+                                expected));
+    }
+}
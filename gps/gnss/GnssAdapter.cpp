@@ -48,6 +48,7 @@
 #include <vector>
 #include <loc_misc_utils.h>
 #include <gps_extended_c.h>
+#include <LocReport.h>
 
 #define RAD2DEG    (180.0 / M_PI)
 #define DEG2RAD    (M_PI / 180.0)
@@ -62,6 +63,11 @@
 
 using namespace loc_core;
 
+// allocation and copy counters of the reports fanned out to the clients
+static LocReportStats sSvReportStats("GnssSvNotification");
+static LocReportStats sDataReportStats("GnssDataNotification");
+static LocReportStats sMeasurementsReportStats("GnssMeasurementsNotification");
+
 static int loadEngHubForExternalEngine = 0;
 static loc_param_s_type izatConfParamTable[] = {
     {"LOAD_ENGHUB_FOR_EXTERNAL_ENGINE", &loadEngHubForExternalEngine, nullptr,'n'}
@@ -3773,7 +3779,7 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
                                     const GpsLocationExtended& locationExtended,
                                     enum loc_sess_status status,
                                     LocPosTechMask techMask,
-                                    GnssDataNotification dataNotify,
+                                    const GnssDataNotification* pDataNotify,
                                     int msInWeek) :
             LocMsg(),
             mAdapter(adapter),
@@ -3781,8 +3787,20 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
             mLocationExtended(locationExtended),
             mStatus(status),
             mTechMask(techMask),
-            mDataNotify(dataNotify),
-            mMsInWeek(msInWeek) {}
+            mDataNotify(),
+            mMsInWeek(msInWeek) {
+            if (nullptr != pDataNotify) {
+                mDataNotify = *pDataNotify;
+                mDataNotify.size = sizeof(mDataNotify);
+                sDataReportStats.onCopy();
+            }
+        }
+        // only the newest pending intermediate fix is delivered if the msg
+        // task falls behind; final and unpropagated fixes are never dropped
+        inline virtual uintptr_t coalesceKey() const {
+            return (LOC_SESS_INTERMEDIATE == mStatus && !mUlpLocation.unpropagatedPosition) ?
+                    mAdapter.coalesceKey(COALESCE_INTERMEDIATE_FIX) : 0;
+        }
         inline virtual void proc() const {
             if (mAdapter.mTimeBasedTrackingSessions.empty() &&
                 mAdapter.mDistanceBasedTrackingSessions.empty()) {
@@ -3835,13 +3853,8 @@ GnssAdapter::reportPositionEvent(const UlpLocation& ulpLocation,
     };
 
     if (mContext != NULL) {
-        GnssDataNotification dataNotifyCopy = {};
-        if (pDataNotify) {
-            dataNotifyCopy = *pDataNotify;
-            dataNotifyCopy.size = sizeof(dataNotifyCopy);
-        }
         sendMsg(new MsgReportSPEPosition(*this, ulpLocation, locationExtended,
-                                          status, techMask, dataNotifyCopy, msInWeek));
+                                          status, techMask, pDataNotify, msInWeek));
     }
 }
 
@@ -4188,20 +4201,14 @@ GnssAdapter::reportSvEvent(const GnssSvNotification& svNotify,
         }
     }
 
-    struct MsgReportSv : public LocMsg {
-        GnssAdapter& mAdapter;
-        const GnssSvNotification mSvNotify;
-        inline MsgReportSv(GnssAdapter& adapter,
-                           const GnssSvNotification& svNotify) :
-            LocMsg(),
-            mAdapter(adapter),
-            mSvNotify(svNotify) {}
-        inline virtual void proc() const {
-            mAdapter.reportSv((GnssSvNotification&)mSvNotify);
-        }
-    };
-
-    sendMsg(new MsgReportSv(*this, svNotify));
+    // pooled msg slot, saves a heap round trip per SV report; only the
+    // newest pending SV report is delivered if the msg task falls behind.
+    // The report itself is copied once, into its envelope, which is moved
+    // into the msg so that reportSv() can fill it in place.
+    LocReport<GnssSvNotification> report(svNotify, sSvReportStats);
+    mMsgTask->sendMsg([this, report = std::move(report)]() mutable {
+        reportSv(report.edit());
+    }, coalesceKey(COALESCE_SV_REPORT));
 }
 
 void
@@ -4346,6 +4353,7 @@ GnssAdapter::reportSv(GnssSvNotification& svNotify)
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.gnssSvCb) {
             it->second.gnssSvCb(svNotify);
+            sSvReportStats.onDeliver(1);
         }
     }
 
@@ -4443,22 +4451,22 @@ GnssAdapter::reportDataEvent(const GnssDataNotification& dataNotify,
 {
     struct MsgReportData : public LocMsg {
         GnssAdapter& mAdapter;
-        GnssDataNotification mDataNotify;
+        mutable LocReport<GnssDataNotification> mDataNotify;
         int mMsInWeek;
         inline MsgReportData(GnssAdapter& adapter,
                              const GnssDataNotification& dataNotify,
                              int msInWeek) :
             LocMsg(),
             mAdapter(adapter),
-            mDataNotify(dataNotify),
+            mDataNotify(dataNotify, sDataReportStats),
             mMsInWeek(msInWeek) {
         }
         inline virtual void proc() const {
+            GnssDataNotification& dataNotify = mDataNotify.edit();
             if (mMsInWeek >= 0) {
-                mAdapter.getDataInformation((GnssDataNotification&)mDataNotify,
-                                            mMsInWeek);
+                mAdapter.getDataInformation(dataNotify, mMsInWeek);
             }
-            mAdapter.reportData((GnssDataNotification&)mDataNotify);
+            mAdapter.reportData(dataNotify);
         }
     };
 
@@ -4481,6 +4489,7 @@ GnssAdapter::reportData(GnssDataNotification& dataNotify)
     for (auto it = mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.gnssDataCb) {
             it->second.gnssDataCb(dataNotify);
+            sDataReportStats.onDeliver(1);
         }
     }
 }
@@ -4771,26 +4780,16 @@ GnssAdapter::reportGnssMeasurementsEvent(const GnssMeasurements& gnssMeasurement
     LOC_LOGD("%s]: msInWeek=%d", __func__, msInWeek);
 
     if (0 != gnssMeasurements.gnssMeasNotification.count) {
-        struct MsgReportGnssMeasurementData : public LocMsg {
-            GnssAdapter& mAdapter;
-            GnssMeasurements mGnssMeasurements;
-            GnssMeasurementsNotification mMeasurementsNotify;
-            inline MsgReportGnssMeasurementData(GnssAdapter& adapter,
-                                                const GnssMeasurements& gnssMeasurements,
-                                                int msInWeek) :
-                    LocMsg(),
-                    mAdapter(adapter),
-                    mMeasurementsNotify(gnssMeasurements.gnssMeasNotification) {
-                if (-1 != msInWeek) {
-                    mAdapter.getAgcInformation(mMeasurementsNotify, msInWeek);
-                }
-            }
-            inline virtual void proc() const {
-                mAdapter.reportGnssMeasurementData(mMeasurementsNotify);
-            }
-        };
-
-        sendMsg(new MsgReportGnssMeasurementData(*this, gnssMeasurements, msInWeek));
+        // the only copy of the report, shared by the msg and all the clients
+        LocReport<GnssMeasurementsNotification> report(gnssMeasurements.gnssMeasNotification,
+                                                       sMeasurementsReportStats);
+        if (-1 != msInWeek) {
+            getAgcInformation(report.edit(), msInWeek);
+        }
+        // pooled msg slot, saves a heap round trip per measurement report
+        mMsgTask->sendMsg([this, report = std::move(report)]() {
+            reportGnssMeasurementData(*report);
+        });
     }
     mEngHubProxy->gnssReportSvMeasurement(gnssMeasurements.gnssSvMeasurementSet);
     if (mDGnssNeedReport) {
@@ -4804,6 +4803,7 @@ GnssAdapter::reportGnssMeasurementData(const GnssMeasurementsNotification& measu
     for (auto it=mClientData.begin(); it != mClientData.end(); ++it) {
         if (nullptr != it->second.gnssMeasurementsCb) {
             it->second.gnssMeasurementsCb(measurements);
+            sMeasurementsReportStats.onDeliver(1);
         }
     }
 }
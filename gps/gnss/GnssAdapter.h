@@ -340,6 +340,12 @@ class GnssAdapter : public LocAdapterBase {
     inline void initOdcpi(const OdcpiRequestCallback& callback, OdcpiPrioritytype priority);
     inline void injectOdcpi(const Location& location);
     static bool isFlpClient(LocationCallbacks& locationCallbacks);
+    // see LocMsg::coalesceKey(); the key is taken from the adapter instance,
+    // so msgs of different adapters sharing a msg task never supersede each other
+    enum CoalesceTag { COALESCE_SV_REPORT = 1, COALESCE_INTERMEDIATE_FIX };
+    inline uintptr_t coalesceKey(CoalesceTag tag) const {
+        return (uintptr_t)this + tag;
+    }
 
     /*==== DGnss Ntrip Source ==========================================================*/
     StartDgnssNtripParams   mStartDgnssNtripParams;
@@ -29,13 +29,22 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <poll.h>
+#include <fcntl.h>
 #include <errno.h>
 #include <netinet/in.h>
 #include <netdb.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <loc_misc_utils.h>
 #include <log_util.h>
 #include <LocIpc.h>
 #include <algorithm>
+#include <atomic>
+#include <vector>
 
 using namespace std;
 
@@ -66,6 +75,45 @@ ssize_t Sock::send(const void *buf, uint32_t len, int flags, const struct sockad
     SOCK_OP_AND_LOG(buf, len, isValid(), rtv, sendto(buf, len, flags, destAddr, addrlen));
     return rtv;
 }
+// Msgs up to mMaxTxSize go out SOCK_BATCH_SIZE at a time with sendmmsg();
+// a longer one is sent on its own, as send() would.
+uint32_t Sock::sendBatch(const struct iovec msgs[], uint32_t count, int flags,
+                         const struct sockaddr *destAddr, socklen_t addrlen) const {
+    static const uint32_t SOCK_BATCH_SIZE = 64;
+    struct mmsghdr hdrs[SOCK_BATCH_SIZE];
+    uint32_t sent = 0;
+    while (sent < count && isValid()) {
+        if (nullptr == msgs[sent].iov_base || 0 == msgs[sent].iov_len) {
+            LOC_LOGe("Invalid inputs: msg %u - %p, length - %zu", sent,
+                     msgs[sent].iov_base, msgs[sent].iov_len);
+            break;
+        }
+        if (msgs[sent].iov_len > mMaxTxSize) {
+            if (send(msgs[sent].iov_base, msgs[sent].iov_len, flags, destAddr, addrlen) <= 0) {
+                break;
+            }
+            sent++;
+            continue;
+        }
+
+        uint32_t n = 0;
+        memset(hdrs, 0, sizeof(hdrs));
+        for (; n < SOCK_BATCH_SIZE && sent + n < count && nullptr != msgs[sent + n].iov_base &&
+                 0 != msgs[sent + n].iov_len && msgs[sent + n].iov_len <= mMaxTxSize; n++) {
+            hdrs[n].msg_hdr.msg_name = (void*)destAddr;
+            hdrs[n].msg_hdr.msg_namelen = addrlen;
+            hdrs[n].msg_hdr.msg_iov = (struct iovec*)&msgs[sent + n];
+            hdrs[n].msg_hdr.msg_iovlen = 1;
+        }
+        int rtv = ::sendmmsg(mSid, hdrs, n, flags);
+        if (rtv <= 0) {
+            LOC_LOGw("failed reason: %s", strerror(errno));
+            break;
+        }
+        sent += rtv;
+    }
+    return sent;
+}
 ssize_t Sock::recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                    struct sockaddr *srcAddr, socklen_t *addrlen, int sid) const {
     ssize_t rtv = -1;
@@ -137,6 +185,10 @@ protected:
     inline virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
+    inline virtual uint32_t sendBatch(const struct iovec msgs[], uint32_t count,
+                                      int32_t /* msgId */) const override {
+        return mSock->sendBatch(msgs, count, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    }
 public:
     inline LocIpcLocalSender(const char* name) : LocIpcSender(),
             mSock(nullptr),
@@ -189,6 +241,457 @@ public:
     }
 };
 
+/* Control block at the beginning of the shared memory of a LocIpcShmSender,
+   followed by the ring of mCapacity bytes. mHead and mTail are running byte
+   counts, written only by the recver and the sender respectively; neither
+   side reads back what the other may have scribbled over its own. Each
+   message is an 8 byte aligned ShmRecord; a record never wraps around the
+   end of the ring, instead a SHM_RECORD_WRAP record pads out the rest of
+   the ring and the message starts over at offset 0. */
+struct ShmRingHeader {
+    uint32_t mMagic;
+    uint32_t mCapacity;
+    atomic<uint64_t> mHead;
+    atomic<uint64_t> mTail;
+    // set by either side before it goes to sleep on its eventfd
+    atomic<uint32_t> mRecverWaiting;
+    atomic<uint32_t> mSenderWaiting;
+};
+
+struct ShmRecord {
+    uint32_t mLength;
+    uint32_t mFlags;
+};
+
+#define SHM_RING_MAGIC 0x4c495253 // "LIRS"
+#define SHM_RECORD_WRAP 0x1
+#define SHM_RING_DEFAULT_SIZE (1 << 20)
+#define SHM_RING_MIN_SIZE (1 << 12)
+#define SHM_RING_MAX_SIZE (1 << 28)
+#define SHM_SEND_TIMEOUT_MS 2000
+// rings a recver takes at most, from all its senders
+#define SHM_MAX_RINGS 32
+// 64 bit, so that it cannot wrap around for any len on 32 bit targets
+#define SHM_RECORD_SIZE(len) (((uint64_t)sizeof(ShmRecord) + (len) + 7) & ~(uint64_t)7)
+
+static const char SHM_MSG_HELLO[] = "LocIpc::Shm::HELLO";
+static const char SHM_MSG_ABORT[] = "LocIpc::Shm::ABORT";
+
+// The shared memory and the eventfds of one sender, on either side.
+class ShmRing {
+public:
+    // memfd, the eventfds to wake up the recver and the sender, then the
+    // read end of a pipe, which hangs up once the sender drops the ring
+    enum { FD_MEM, FD_DATA, FD_SPACE, FD_ALIVE, FD_TOTAL };
+    int mFds[FD_TOTAL];
+    // write end of the FD_ALIVE pipe, only on the sender side
+    int mAliveFd;
+    ShmRingHeader* mHeader;
+    uint8_t* mData;
+    size_t mMapSize;
+    // copies of what is in the shared memory, which the other side may change
+    uint32_t mCapacity;
+    // on the recver side, where it has read up to; only ever published to mHeader->mHead
+    uint64_t mHead;
+
+    inline ShmRing() : mAliveFd(-1), mHeader(nullptr), mData(nullptr), mMapSize(0),
+            mCapacity(0), mHead(0) {
+        for (auto& fd : mFds) {
+            fd = -1;
+        }
+    }
+    inline ~ShmRing() {
+        if (nullptr != mHeader) {
+            munmap(mHeader, mMapSize);
+        }
+        for (auto fd : mFds) {
+            if (-1 != fd) {
+                ::close(fd);
+            }
+        }
+        if (-1 != mAliveFd) {
+            ::close(mAliveFd);
+        }
+    }
+    inline bool isValid() const { return nullptr != mHeader; }
+    inline uint32_t capacity() const { return mCapacity; }
+
+    static inline size_t headerSize() {
+        return (sizeof(ShmRingHeader) + 63) & ~(size_t)63;
+    }
+
+    // on the sender side
+    bool create(uint32_t capacity) {
+        mMapSize = headerSize() + capacity;
+        mFds[FD_MEM] = syscall(__NR_memfd_create, "LocIpcShm", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+        mFds[FD_DATA] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        mFds[FD_SPACE] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        int alive[2] = {-1, -1};
+        if (0 == pipe2(alive, O_CLOEXEC)) {
+            mFds[FD_ALIVE] = alive[0];
+            mAliveFd = alive[1];
+        }
+        if (mFds[FD_MEM] < 0 || mFds[FD_DATA] < 0 || mFds[FD_SPACE] < 0 ||
+                mFds[FD_ALIVE] < 0 || ftruncate(mFds[FD_MEM], mMapSize) < 0) {
+            LOC_LOGe("failed to create shared memory ring: %s", strerror(errno));
+            return false;
+        }
+        // the recver relies on the size not to change under its mapping
+        fcntl(mFds[FD_MEM], F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL);
+        if (!map()) {
+            return false;
+        }
+        mCapacity = capacity;
+        mHeader->mMagic = SHM_RING_MAGIC;
+        mHeader->mCapacity = capacity;
+        mHeader->mHead.store(0);
+        mHeader->mTail.store(0);
+        mHeader->mRecverWaiting.store(0);
+        mHeader->mSenderWaiting.store(0);
+        return true;
+    }
+
+    // on the recver side, with the fds received from the sender in mFds
+    bool attach() {
+        struct stat st;
+        if (fstat(mFds[FD_MEM], &st) < 0 || st.st_size <= (off_t)headerSize()) {
+            return false;
+        }
+        mMapSize = st.st_size;
+        if (!map()) {
+            return false;
+        }
+        uint32_t capacity = mHeader->mCapacity;
+        // the sender is not to be trusted with the layout
+        if (SHM_RING_MAGIC != mHeader->mMagic || capacity < SHM_RING_MIN_SIZE ||
+                (capacity & (capacity - 1)) || headerSize() + capacity != mMapSize) {
+            LOC_LOGe("invalid shared memory ring, size %zu", mMapSize);
+            munmap(mHeader, mMapSize);
+            mHeader = nullptr;
+            return false;
+        }
+        mCapacity = capacity;
+        mHead = mHeader->mHead.load();
+        return true;
+    }
+
+    static inline void signal(int fd) {
+        uint64_t one = 1;
+        ::write(fd, &one, sizeof(one));
+    }
+    static inline void clear(int fd) {
+        uint64_t count;
+        ::read(fd, &count, sizeof(count));
+    }
+
+private:
+    bool map() {
+        void* addr = mmap(nullptr, mMapSize, PROT_READ | PROT_WRITE, MAP_SHARED, mFds[FD_MEM], 0);
+        if (MAP_FAILED == addr) {
+            LOC_LOGe("failed to map shared memory ring: %s", strerror(errno));
+            return false;
+        }
+        mHeader = (ShmRingHeader*)addr;
+        mData = (uint8_t*)addr + headerSize();
+        return true;
+    }
+};
+
+class LocIpcShmSender : public LocIpcLocalSender {
+    const uint32_t mRingSize;
+    mutable mutex mMutex;
+    mutable unique_ptr<ShmRing> mRing;
+    // whether the recver has got the ring
+    mutable bool mConnected;
+
+    // hands the fds of the ring over to the recver
+    bool connect() const {
+        if (nullptr == mRing) {
+            mRing.reset(new ShmRing());
+            if (!mRing->create(mRingSize)) {
+                mRing.reset();
+                return false;
+            }
+        }
+
+        struct iovec iov = {(void*)SHM_MSG_HELLO, sizeof(SHM_MSG_HELLO)};
+        union {
+            char buf[CMSG_SPACE(sizeof(mRing->mFds))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_name = (void*)&mAddr;
+        msg.msg_namelen = sizeof(mAddr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(mRing->mFds));
+        memcpy(CMSG_DATA(cmsg), mRing->mFds, sizeof(mRing->mFds));
+
+        mConnected = (::sendmsg(mSock->mSid, &msg, 0) > 0);
+        if (!mConnected) {
+            LOC_LOGw("failed to hand over ring to %s: %s", mAddr.sun_path, strerror(errno));
+        }
+        return mConnected;
+    }
+
+    // waits until the recver frees up space for a message, or times out
+    bool waitForSpace(uint64_t tail, uint64_t total) const {
+        ShmRingHeader* header = mRing->mHeader;
+        int timeout = SHM_SEND_TIMEOUT_MS;
+        while (mRing->capacity() - (tail - header->mHead.load(std::memory_order_acquire)) < total) {
+            if (timeout <= 0) {
+                return false;
+            }
+            header->mSenderWaiting.store(1);
+            if (mRing->capacity() - (tail - header->mHead.load()) >= total) {
+                break;
+            }
+            // the recver may be waiting for the msgs written so far
+            wakeUpRecver();
+            struct pollfd pfd = {mRing->mFds[ShmRing::FD_SPACE], POLLIN, 0};
+            ::poll(&pfd, 1, 100);
+            ShmRing::clear(mRing->mFds[ShmRing::FD_SPACE]);
+            timeout -= 100;
+        }
+        return true;
+    }
+
+    inline void wakeUpRecver() const {
+        if (nullptr != mRing && mRing->mHeader->mRecverWaiting.exchange(0)) {
+            ShmRing::signal(mRing->mFds[ShmRing::FD_DATA]);
+        }
+    }
+
+    // writes and publishes one msg, without waking up the recver
+    ssize_t writeLocked(const uint8_t data[], uint32_t length) const {
+        if (nullptr == data || 0 == length) {
+            LOC_LOGe("Invalid inputs: buf - %p, length - %u", data, length);
+            return -1;
+        }
+        if (!mConnected && !connect()) {
+            return -1;
+        }
+
+        const uint32_t capacity = mRing->capacity();
+        const uint64_t need = SHM_RECORD_SIZE(length);
+        if (need > capacity / 2) {
+            LOC_LOGe("message of %u bytes too big for ring of %u bytes", length, capacity);
+            return -1;
+        }
+        ShmRingHeader* header = mRing->mHeader;
+        uint64_t tail = header->mTail.load(std::memory_order_relaxed);
+        size_t offset = tail & (capacity - 1);
+        size_t contiguous = capacity - offset;
+        uint64_t total = need + ((need > contiguous) ? contiguous : 0);
+        if (!waitForSpace(tail, total)) {
+            // the recver is gone or stuck, start over with a new ring
+            // next time, in case it was restarted
+            LOC_LOGw("timed out sending to %s", mAddr.sun_path);
+            mRing.reset();
+            mConnected = false;
+            return -1;
+        }
+
+        if (need > contiguous) {
+            ShmRecord* pad = (ShmRecord*)(mRing->mData + offset);
+            pad->mLength = contiguous - sizeof(ShmRecord);
+            pad->mFlags = SHM_RECORD_WRAP;
+            tail += contiguous;
+            offset = 0;
+        }
+        ShmRecord* record = (ShmRecord*)(mRing->mData + offset);
+        record->mLength = length;
+        record->mFlags = 0;
+        memcpy(record + 1, data, length);
+        header->mTail.store(tail + need);
+        return length;
+    }
+
+protected:
+    virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const override {
+        lock_guard<mutex> lock(mMutex);
+        ssize_t rtv = writeLocked(data, length);
+        wakeUpRecver();
+        return rtv;
+    }
+    // all the msgs get one wake up of the recver
+    virtual uint32_t sendBatch(const struct iovec msgs[], uint32_t count,
+                               int32_t /* msgId */) const override {
+        lock_guard<mutex> lock(mMutex);
+        uint32_t sent = 0;
+        while (sent < count &&
+               writeLocked((const uint8_t*)msgs[sent].iov_base, msgs[sent].iov_len) > 0) {
+            sent++;
+        }
+        wakeUpRecver();
+        return sent;
+    }
+public:
+    inline LocIpcShmSender(const char* name, uint32_t ringSize) : LocIpcLocalSender(name),
+            mRingSize(ringSize), mConnected(false) {}
+};
+
+class LocIpcShmRecver : public LocIpcLocalRecver {
+    mutable vector<unique_ptr<ShmRing>> mRings;
+
+    // takes a ring handed over by a sender on the socket; returns false on abort
+    bool recvCtrlMsg() const {
+        char buf[sizeof(SHM_MSG_HELLO)] = {};
+        struct iovec iov = {buf, sizeof(buf)};
+        union {
+            char buf[CMSG_SPACE(sizeof(int) * ShmRing::FD_TOTAL)];
+            struct cmsghdr align;
+        } control;
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        ssize_t nBytes = ::recvmsg(mSock->mSid, &msg, MSG_CMSG_CLOEXEC);
+        if (nBytes <= 0) {
+            return errno == EINTR;
+        }
+
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        if (nullptr != cmsg && SOL_SOCKET == cmsg->cmsg_level && SCM_RIGHTS == cmsg->cmsg_type) {
+            // the ring owns the fds from here on, and closes them if invalid
+            unique_ptr<ShmRing> ring(new ShmRing());
+            size_t fdsLen = cmsg->cmsg_len - CMSG_LEN(0);
+            memcpy(ring->mFds, CMSG_DATA(cmsg), std::min(fdsLen, sizeof(ring->mFds)));
+            if (mRings.size() >= SHM_MAX_RINGS) {
+                LOC_LOGw("dropped shared memory ring, %zu rings taken already", mRings.size());
+            } else if (0 == strncmp(buf, SHM_MSG_HELLO, sizeof(buf)) &&
+                    sizeof(ring->mFds) == fdsLen && ring->attach()) {
+                mRings.push_back(std::move(ring));
+            } else {
+                LOC_LOGw("dropped invalid shared memory ring");
+            }
+        } else if (0 == strncmp(buf, SHM_MSG_ABORT, sizeof(buf))) {
+            LOC_LOGi("recvd abort msg.data %s", buf);
+            return false;
+        }
+        return true;
+    }
+
+    // hands all the msgs in ring to the listener, in place
+    ssize_t drain(ShmRing& ring) const {
+        ShmRingHeader* header = ring.mHeader;
+        const uint32_t capacity = ring.capacity();
+        uint64_t head = ring.mHead;
+        uint64_t tail = header->mTail.load(std::memory_order_acquire);
+        ssize_t nBytes = 0;
+        // the sender is not to be trusted with the records either
+        if (tail - head > capacity) {
+            LOC_LOGe("corrupted shared memory ring, head %" PRIu64 " tail %" PRIu64, head, tail);
+            ring.mHead = tail;
+            header->mHead.store(tail);
+            return 0;
+        }
+        while (head != tail) {
+            size_t offset = head & (capacity - 1);
+            // head is off after skipping to a corrupted tail, so check before
+            // anything of the record is read
+            if ((offset & 7) || offset + sizeof(ShmRecord) > capacity) {
+                LOC_LOGe("corrupted shared memory ring, head %" PRIu64, head);
+                head = tail;
+                break;
+            }
+            ShmRecord* record = (ShmRecord*)(ring.mData + offset);
+            // read only once, the sender may change the record under us
+            const uint32_t length = *(volatile uint32_t*)&record->mLength;
+            const uint32_t flags = *(volatile uint32_t*)&record->mFlags;
+            if (length > capacity - offset - sizeof(ShmRecord) ||
+                    SHM_RECORD_SIZE(length) > tail - head) {
+                LOC_LOGe("corrupted shared memory record of %u bytes", length);
+                head = tail;
+                break;
+            }
+            if (!(flags & SHM_RECORD_WRAP)) {
+                mDataCb->onReceive((const char*)(record + 1), length, this);
+                nBytes += length;
+            }
+            head += SHM_RECORD_SIZE(length);
+            // release the space as soon as the listener is done with it
+            ring.mHead = head;
+            header->mHead.store(head, std::memory_order_release);
+        }
+        ring.mHead = head;
+        header->mHead.store(head);
+        if (header->mSenderWaiting.exchange(0)) {
+            ShmRing::signal(ring.mFds[ShmRing::FD_SPACE]);
+        }
+        return nBytes;
+    }
+
+protected:
+    // blocks until there are msgs in any of the rings, and returns the number
+    // of bytes received; or 0 on abort
+    inline virtual ssize_t recv() const override {
+        // rings whose sender is gone, dropped once drained
+        vector<bool> gone(mRings.size(), false);
+        while (mSock->isValid()) {
+            ssize_t nBytes = 0;
+            for (auto& ring : mRings) {
+                nBytes += drain(*ring);
+            }
+            for (size_t i = mRings.size(); i-- > 0;) {
+                if (i < gone.size() && gone[i]) {
+                    mRings.erase(mRings.begin() + i);
+                }
+            }
+            gone.assign(mRings.size(), false);
+            if (nBytes > 0) {
+                return nBytes;
+            }
+
+            // ask for a wake up, then check once more for what came in between
+            vector<struct pollfd> pfds(1, {mSock->mSid, POLLIN, 0});
+            bool pending = false;
+            for (auto& ring : mRings) {
+                ring->mHeader->mRecverWaiting.store(1);
+                pending = pending || ring->mHeader->mTail.load() != ring->mHead;
+                pfds.push_back({ring->mFds[ShmRing::FD_DATA], POLLIN, 0});
+                // only POLLHUP, which is always reported
+                pfds.push_back({ring->mFds[ShmRing::FD_ALIVE], 0, 0});
+            }
+            if (pending) {
+                continue;
+            }
+            if (::poll(pfds.data(), pfds.size(), -1) < 0 && errno != EINTR) {
+                LOC_LOGe("poll failed: %s", strerror(errno));
+                return -1;
+            }
+            for (size_t i = 0; i < mRings.size(); i++) {
+                if (pfds[1 + 2 * i].revents & POLLIN) {
+                    ShmRing::clear(pfds[1 + 2 * i].fd);
+                }
+                gone[i] = (0 != (pfds[2 + 2 * i].revents & (POLLHUP | POLLERR)));
+            }
+            if ((pfds[0].revents & POLLIN) && !recvCtrlMsg()) {
+                return 0;
+            }
+        }
+        return -1;
+    }
+public:
+    inline LocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener, const char* name) :
+            LocIpcLocalRecver(listener, name) {}
+    inline virtual void abort() const override {
+        if (isSendable()) {
+            mSock->send(SHM_MSG_ABORT, sizeof(SHM_MSG_ABORT), 0,
+                        (struct sockaddr*)&mAddr, sizeof(mAddr));
+        }
+    }
+};
+
 class LocIpcInetSender : public LocIpcSender {
 protected:
     int mSockType;
@@ -199,6 +702,10 @@ protected:
     virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t /* msgId */) const {
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
+    virtual uint32_t sendBatch(const struct iovec msgs[], uint32_t count,
+                               int32_t /* msgId */) const override {
+        return mSock->sendBatch(msgs, count, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
+    }
 public:
     inline LocIpcInetSender(const LocIpcInetSender& sender) :
             mSockType(sender.mSockType), mSock(sender.mSock),
@@ -234,6 +741,67 @@ protected:
         }
         return mSock->send(data, length, 0, (struct sockaddr*)&mAddr, sizeof(mAddr));
     }
+    // the msgs are a byte stream on TCP anyway, so they go out with writev()
+    virtual uint32_t sendBatch(const struct iovec msgs[], uint32_t count,
+                               int32_t msgId) const override {
+        if (mFirstTime) {
+            mFirstTime = false;
+            ::connect(mSock->mSid, (const struct sockaddr*)&mAddr, sizeof(mAddr));
+        }
+        uint32_t sent = 0;
+        while (sent < count && mSock->isValid()) {
+            // the run of msgs that writev() takes in one go
+            uint32_t n = 0;
+            while (n < IOV_MAX && sent + n < count && nullptr != msgs[sent + n].iov_base &&
+                   0 != msgs[sent + n].iov_len && msgs[sent + n].iov_len <= mSock->getMaxTxSize()) {
+                n++;
+            }
+            if (0 == n) {
+                // long msg, or invalid one that send() logs
+                if (send((const uint8_t*)msgs[sent].iov_base, msgs[sent].iov_len, msgId) <= 0) {
+                    break;
+                }
+                sent++;
+                continue;
+            }
+            ssize_t rtv = ::writev(mSock->mSid, &msgs[sent], n);
+            if (rtv < 0) {
+                if (EINTR == errno) {
+                    continue;
+                }
+                LOC_LOGw("failed reason: %s", strerror(errno));
+                break;
+            }
+            // skip the msgs fully written, and finish the one writev() cut
+            // short, e.g. by a signal; the rest of the run goes out next round
+            size_t done = rtv;
+            for (; n > 0 && done >= msgs[sent].iov_len; sent++, n--) {
+                done -= msgs[sent].iov_len;
+            }
+            if (n > 0 && done > 0) {
+                if (!sendAll((const uint8_t*)msgs[sent].iov_base + done,
+                             msgs[sent].iov_len - done)) {
+                    break;
+                }
+                sent++;
+            }
+        }
+        return sent;
+    }
+
+    bool sendAll(const uint8_t* data, size_t length) const {
+        while (length > 0) {
+            ssize_t rtv = ::send(mSock->mSid, data, length, 0);
+            if (rtv < 0 && EINTR != errno) {
+                LOC_LOGw("failed reason: %s", strerror(errno));
+                return false;
+            } else if (rtv > 0) {
+                data += rtv;
+                length -= rtv;
+            }
+        }
+        return true;
+    }
 
 public:
     inline LocIpcInetTcpSender(const char* name, int32_t port) :
@@ -368,6 +936,11 @@ bool LocIpc::send(LocIpcSender& sender, const uint8_t data[], uint32_t length, i
     return sender.sendData(data, length, msgId);
 }
 
+uint32_t LocIpc::send(LocIpcSender& sender, const struct iovec msgs[], uint32_t count,
+                      int32_t msgId) {
+    return sender.sendData(msgs, count, msgId);
+}
+
 shared_ptr<LocIpcSender> LocIpc::getLocIpcLocalSender(const char* localSockName) {
     return make_shared<LocIpcLocalSender>(localSockName);
 }
@@ -375,6 +948,21 @@ unique_ptr<LocIpcRecver> LocIpc::getLocIpcLocalRecver(const shared_ptr<ILocIpcLi
                                                       const char* localSockName) {
     return make_unique<LocIpcLocalRecver>(listener, localSockName);
 }
+shared_ptr<LocIpcSender> LocIpc::getLocIpcShmSender(const char* localSockName,
+                                                    uint32_t ringSize) {
+    uint32_t capacity = SHM_RING_MIN_SIZE;
+    if (0 == ringSize) {
+        ringSize = SHM_RING_DEFAULT_SIZE;
+    }
+    while (capacity < ringSize && capacity < SHM_RING_MAX_SIZE) {
+        capacity <<= 1;
+    }
+    return make_shared<LocIpcShmSender>(localSockName, capacity);
+}
+unique_ptr<LocIpcRecver> LocIpc::getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                                                    const char* localSockName) {
+    return make_unique<LocIpcShmRecver>(listener, localSockName);
+}
 static void* sLibQrtrHandle = nullptr;
 static const char* sLibQrtrName = "libloc_socket.so";
 shared_ptr<LocIpcSender> LocIpc::getLocIpcQrtrSender(int service, int instance) {
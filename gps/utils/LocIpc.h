@@ -35,6 +35,7 @@
 #include <unistd.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <sys/uio.h>
 #include <unordered_set>
 #include <mutex>
 #include <LocThread.h>
@@ -101,10 +102,20 @@ public:
             getLocIpcInetTcpSender(const char* serverName, int32_t port);
     static shared_ptr<LocIpcSender>
             getLocIpcQrtrSender(int service, int instance);
+    // Messages go through a ring buffer in shared memory, that the sender
+    // creates and hands over to the recver bound to localSockName. The
+    // recver's listener gets the data in place in the shared memory, valid
+    // only during onReceive(). ringSize is rounded up to a power of 2; 0 for
+    // the default. A message may take up to half of the ring.
+    static shared_ptr<LocIpcSender>
+            getLocIpcShmSender(const char* localSockName, uint32_t ringSize = 0);
 
     static unique_ptr<LocIpcRecver>
             getLocIpcLocalRecver(const shared_ptr<ILocIpcListener>& listener,
                                  const char* localSockName);
+    static unique_ptr<LocIpcRecver>
+            getLocIpcShmRecver(const shared_ptr<ILocIpcListener>& listener,
+                               const char* localSockName);
     static unique_ptr<LocIpcRecver>
             getLocIpcInetUdpRecver(const shared_ptr<ILocIpcListener>& listener,
                                  const char* serverName, int32_t port);
@@ -147,6 +158,10 @@ public:
     // The function will return true on success, and false on failure.
     static bool send(LocIpcSender& sender, const uint8_t data[],
                      uint32_t length, int32_t msgId = -1);
+    // Send out count messages, each in one of msgs, in as few system calls as
+    // the sender can. Returns the number of messages sent, in order.
+    static uint32_t send(LocIpcSender& sender, const struct iovec msgs[],
+                         uint32_t count, int32_t msgId = -1);
 
 private:
     LocThread mThread;
@@ -160,12 +175,25 @@ protected:
     LocIpcSender() = default;
     virtual bool isOperable() const = 0;
     virtual ssize_t send(const uint8_t data[], uint32_t length, int32_t msgId) const = 0;
+    // returns the number of msgs sent; senders that can send several msgs
+    // in one go override this.
+    virtual uint32_t sendBatch(const struct iovec msgs[], uint32_t count, int32_t msgId) const {
+        uint32_t sent = 0;
+        while (sent < count &&
+               send((const uint8_t*)msgs[sent].iov_base, msgs[sent].iov_len, msgId) > 0) {
+            sent++;
+        }
+        return sent;
+    }
 public:
     virtual ~LocIpcSender() = default;
     inline bool isSendable() const { return isOperable(); }
     inline bool sendData(const uint8_t data[], uint32_t length, int32_t msgId) const {
         return isSendable() && (send(data, length, msgId) > 0);
     }
+    inline uint32_t sendData(const struct iovec msgs[], uint32_t count, int32_t msgId) const {
+        return isSendable() ? sendBatch(msgs, count, msgId) : 0;
+    }
     virtual unique_ptr<LocIpcRecver> getRecver(const shared_ptr<ILocIpcListener>& listener) {
         return nullptr;
     }
@@ -206,8 +234,12 @@ public:
     inline Sock(int sid, const uint32_t maxTxSize = 8192) : mMaxTxSize(maxTxSize), mSid(sid) {}
     inline ~Sock() { close(); }
     inline bool isValid() const { return -1 != mSid; }
+    inline uint32_t getMaxTxSize() const { return mMaxTxSize; }
     ssize_t send(const void *buf, uint32_t len, int flags, const struct sockaddr *destAddr,
                  socklen_t addrlen) const;
+    // returns the number of msgs sent
+    uint32_t sendBatch(const struct iovec msgs[], uint32_t count, int flags,
+                       const struct sockaddr *destAddr, socklen_t addrlen) const;
     ssize_t recv(const LocIpcRecver& recver, const shared_ptr<ILocIpcListener>& dataCb, int flags,
                  struct sockaddr *srcAddr, socklen_t *addrlen, int sid = -1) const;
     ssize_t sendAbort(int flags, const struct sockaddr *destAddr, socklen_t addrlen);
@@ -0,0 +1,107 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_REPORT__
+#define __LOC_REPORT__
+
+#include <stdint.h>
+#include <atomic>
+#include <memory>
+#include <sstream>
+#include <functional>
+
+namespace loc_util {
+
+// Envelope allocation, report copy and client delivery counters of one
+// report type. They are appended to the LogBuffer dumps, so an instance
+// must live as long as the process, e.g. as a static.
+class LocReportStats {
+    const char* const mName;
+    std::atomic<bool> mRegistered;
+    std::atomic<uint64_t> mAllocs;
+    std::atomic<uint64_t> mCopies;
+    std::atomic<uint64_t> mDeliveries;
+
+    void registerDump();
+public:
+    constexpr LocReportStats(const char* name) :
+        mName(name), mRegistered(false), mAllocs(0), mCopies(0), mDeliveries(0) {}
+
+    inline void onAlloc() {
+        if (!mRegistered.load(std::memory_order_relaxed)) {
+            registerDump();
+        }
+        mAllocs.fetch_add(1, std::memory_order_relaxed);
+        mCopies.fetch_add(1, std::memory_order_relaxed);
+    }
+    // a copy of the report made outside of an envelope
+    inline void onCopy() { mCopies.fetch_add(1, std::memory_order_relaxed); }
+    // the report has been handed to count client callbacks
+    inline void onDeliver(uint32_t count) {
+        mDeliveries.fetch_add(count, std::memory_order_relaxed);
+    }
+    inline uint64_t getAllocs() const { return mAllocs.load(std::memory_order_relaxed); }
+    inline uint64_t getCopies() const { return mCopies.load(std::memory_order_relaxed); }
+    inline uint64_t getDeliveries() const {
+        return mDeliveries.load(std::memory_order_relaxed);
+    }
+    void dump(std::function<void(std::stringstream&)>& log) const;
+};
+
+// A ref-counted envelope of a report, so one copy of a large report can
+// cross the msg hop and be handed to all the clients, instead of being
+// copied into each msg, closure and intermediate. Copying the envelope
+// only copies the reference.
+// A report is not to be changed once it is shared. edit() gives the
+// only holder, typically the msg proc() finishing the report before
+// handing it out, the report to change in place, and copies it first if
+// it is not the only holder.
+template <typename T>
+class LocReport {
+    std::shared_ptr<T> mReport;
+    LocReportStats* mStats;
+public:
+    inline LocReport(const T& report, LocReportStats& stats) :
+        mReport(std::make_shared<T>(report)), mStats(&stats) {
+        stats.onAlloc();
+    }
+    inline const T& operator*() const { return *mReport; }
+    inline const T* operator->() const { return mReport.get(); }
+    inline T& edit() {
+        if (1 != mReport.use_count()) {
+            mReport = std::make_shared<T>(*mReport);
+            mStats->onAlloc();
+        }
+        return *mReport;
+    }
+    inline LocReportStats& getStats() const { return *mStats; }
+};
+
+} // namespace loc_util
+
+#endif //__LOC_REPORT__
@@ -41,6 +41,10 @@
 #include <LocThread.h>
 #include <LocSharedLock.h>
 #include <MsgTask.h>
+#ifdef USE_LOC_TIMER_WHEEL
+#include <LocTimerWheel.h>
+#include <vector>
+#endif
 
 #ifdef __HOST_UNIT_TEST__
 #define EPOLLWAKEUP 0
@@ -81,6 +85,11 @@ LocTimerPollTask - is a class that wraps timerfd and epoll POXIS APIs. It also
 LocTimerWrapper - a LocTimer client itself, to implement the existing C API with
                   APIs, loc_timer_start() and loc_timer_stop().
 
+When built with USE_LOC_TIMER_WHEEL, LocTimerContainer keeps the timers in a
+LocTimerWheel instead of the heap, so that start / stop are O(1), and all the
+timers that go off in the same tick are expired in one MsgTimerExpire. The
+timer fd is then armed for the next tick the wheel needs service at.
+
 */
 
 class LocTimerPollTask;
@@ -93,7 +102,11 @@ class LocTimerPollTask;
 //   for alarms (or mHwTimers);
 // * provides a polling thread;
 // * provides a MsgTask thread for synchronized add / remove / timer client callback.
+#ifdef USE_LOC_TIMER_WHEEL
+class LocTimerContainer {
+#else
 class LocTimerContainer : public LocHeap {
+#endif
     // mutex to synchronize getters of static members
     static pthread_mutex_t mMutex;
     // Container of timers
@@ -104,6 +117,8 @@ class LocTimerContainer : public LocHeap {
     static MsgTask* mMsgTask;
     // Poll task to provide epoll call and threading to poll.
     static LocTimerPollTask* mPollTask;
+    // clock the timer fd counts on
+    clockid_t mClockId;
     // timer / alarm fd
     int mDevFd;
     // ctor
@@ -112,16 +127,30 @@ class LocTimerContainer : public LocHeap {
     ~LocTimerContainer();
     static MsgTask* getMsgTaskLocked();
     static LocTimerPollTask* getPollTaskLocked();
+#ifdef USE_LOC_TIMER_WHEEL
+    LocTimerWheel mWheel;
+    // timers gone off in the last advance, kept around to reuse the storage
+    std::vector<LocTimerWheelNode*> mExpired;
+    // time the timer fd is armed for, 0 if disarmed
+    uint64_t mArmedNs;
+    // rearm the timer POSIX calls if the next service time of the wheel changed
+    void updateNextTime();
+    // time on mClockId of a CLOCK_BOOTTIME timer deadline
+    uint64_t toClockNs(const struct timespec& bootTime);
+#else
     // extend LocHeap and pop if the top outRanks input
     LocTimerDelegate* popIfOutRanks(LocTimerDelegate& timer);
     // update the timer POSIX calls with updated soonest timer spec
     void updateSoonestTime(LocTimerDelegate* priorTop);
+#endif
 
 public:
     // factory method to control the creation of mSwTimers / mHwTimers
     static LocTimerContainer* get(bool wakeOnExpire);
 
+#ifndef USE_LOC_TIMER_WHEEL
     LocTimerDelegate* getSoonestTimer();
+#endif
     int getTimerFd();
     // add a timer / alarm obj into the container
     void add(LocTimerDelegate& timer);
@@ -185,7 +214,11 @@ public:
 // and gets deleted when client calls LocTimer::stop() or when the it expire()'s.
 // This class implements LocRankable::ranks() so that when an obj is added into
 // the container (of LocHeap), it gets placed in sorted order.
+#ifdef USE_LOC_TIMER_WHEEL
+class LocTimerDelegate : public LocRankable, public LocTimerWheelNode {
+#else
 class LocTimerDelegate : public LocRankable {
+#endif
     friend class LocTimerContainer;
     friend class LocTimer;
     LocTimer* mClient;
@@ -218,17 +251,40 @@ LocTimerContainer* LocTimerContainer::mHwTimers = NULL;
 MsgTask* LocTimerContainer::mMsgTask = NULL;
 LocTimerPollTask* LocTimerContainer::mPollTask = NULL;
 
-// ctor - initialize timer heaps
-// A container for swTimer (timer) is created, when wakeOnExpire is true; or
-// HwTimer (alarm), when wakeOnExpire is false.
-LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
-    mDevFd(timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0)) {
+static inline uint64_t timespecToNs(const struct timespec& ts) {
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
 
-    if ((-1 == mDevFd) && (errno == EINVAL)) {
+static inline uint64_t nowNs(clockid_t clockId) {
+    struct timespec now;
+    clock_gettime(clockId, &now);
+    return timespecToNs(now);
+}
+
+// creates the timer fd, on CLOCK_MONOTONIC if the boot time clocks are not
+// supported, and sets clockId to the clock it counts on.
+static int createTimerFd(bool wakeOnExpire, clockid_t& clockId) {
+    clockId = CLOCK_BOOTTIME;
+    int fd = timerfd_create(wakeOnExpire ? CLOCK_BOOTTIME_ALARM : CLOCK_BOOTTIME, 0);
+    if ((-1 == fd) && (errno == EINVAL)) {
         LOC_LOGW("%s: timerfd_create failure, fallback to CLOCK_MONOTONIC - %s",
             __FUNCTION__, strerror(errno));
-        mDevFd = timerfd_create(CLOCK_MONOTONIC, 0);
+        clockId = CLOCK_MONOTONIC;
+        fd = timerfd_create(CLOCK_MONOTONIC, 0);
     }
+    return fd;
+}
+
+// ctor - initialize timer heaps
+// A container for swTimer (timer) is created, when wakeOnExpire is true; or
+// HwTimer (alarm), when wakeOnExpire is false.
+LocTimerContainer::LocTimerContainer(bool wakeOnExpire) :
+    mClockId(CLOCK_BOOTTIME),
+    mDevFd(createTimerFd(wakeOnExpire, mClockId))
+#ifdef USE_LOC_TIMER_WHEEL
+    , mWheel(nowNs(mClockId)), mArmedNs(0)
+#endif
+    {
 
     if (-1 != mDevFd) {
         // ensure we have the necessary resources created
@@ -283,13 +339,117 @@ LocTimerPollTask* LocTimerContainer::getPollTaskLocked() {
 }
 
 inline
-LocTimerDelegate* LocTimerContainer::getSoonestTimer() {
-    return (LocTimerDelegate*)(peek());
+int LocTimerContainer::getTimerFd() {
+    return mDevFd;
+}
+
+#ifdef USE_LOC_TIMER_WHEEL
+
+uint64_t LocTimerContainer::toClockNs(const struct timespec& bootTime) {
+    uint64_t ns = timespecToNs(bootTime);
+    if (CLOCK_BOOTTIME != mClockId) {
+        // the clocks only drift apart by the time spent in suspend
+        uint64_t offsetNs = nowNs(CLOCK_BOOTTIME) - nowNs(mClockId);
+        ns = (ns > offsetNs) ? ns - offsetNs : 0;
+    }
+    return ns;
 }
 
+void LocTimerContainer::updateNextTime() {
+    uint64_t nextNs = 0;
+    if (!mWheel.getNextTime(nextNs)) {
+        nextNs = 0;
+    }
+
+    if (nextNs != mArmedNs) {
+        struct itimerspec delay;
+        memset(&delay, 0, sizeof(struct itimerspec));
+        if (0 == nextNs) {
+            // wheel is empty now, we remove poll and disarm timer
+            mPollTask->removePoll(*this);
+        } else {
+            // do this first to avoid race condition, in case settime is called
+            // with too small an interval
+            mPollTask->addPoll(*this);
+            delay.it_value.tv_sec = nextNs / 1000000000ULL;
+            delay.it_value.tv_nsec = nextNs % 1000000000ULL;
+        }
+        timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+        mArmedNs = nextNs;
+    }
+}
+
+// all the wheel management is done in the MsgTask context.
+void LocTimerContainer::add(LocTimerDelegate& timer) {
+    struct MsgTimerPush : public LocMsg {
+        LocTimerContainer* mTimerContainer;
+        LocTimerDelegate* mTimer;
+        inline MsgTimerPush(LocTimerContainer& container, LocTimerDelegate& timer) :
+            LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
+        inline virtual void proc() const {
+            mTimerContainer->mWheel.add(*mTimer,
+                                        mTimerContainer->toClockNs(mTimer->getFutureTime()));
+            mTimerContainer->updateNextTime();
+        }
+    };
+
+    mMsgTask->sendMsg(new MsgTimerPush(*this, timer));
+}
+
+// all the wheel management is done in the MsgTask context.
+void LocTimerContainer::remove(LocTimerDelegate& timer) {
+    struct MsgTimerRemove : public LocMsg {
+        LocTimerContainer* mTimerContainer;
+        LocTimerDelegate* mTimer;
+        inline MsgTimerRemove(LocTimerContainer& container, LocTimerDelegate& timer) :
+            LocMsg(), mTimerContainer(&container), mTimer(&timer) {}
+        inline virtual void proc() const {
+            // no op if mTimer has already gone off
+            mTimerContainer->mWheel.remove(*mTimer);
+            // all timers are deleted here, and only here.
+            delete mTimer;
+            mTimerContainer->updateNextTime();
+        }
+    };
+
+    mMsgTask->sendMsg(new MsgTimerRemove(*this, timer));
+}
+
+// all the wheel management is done in the MsgTask context.
+// Upon expire, the wheel is advanced to now, and every timer that went
+// off on the way is expired in this one msg.
+void LocTimerContainer::expire() {
+    struct MsgTimerExpire : public LocMsg {
+        LocTimerContainer* mTimerContainer;
+        inline MsgTimerExpire(LocTimerContainer& container) :
+            LocMsg(), mTimerContainer(&container) {}
+        inline virtual void proc() const {
+            // the poll thread has disarmed the timer fd
+            mTimerContainer->mArmedNs = 0;
+            std::vector<LocTimerWheelNode*>& expired = mTimerContainer->mExpired;
+            expired.clear();
+            mTimerContainer->mWheel.advance(nowNs(mTimerContainer->mClockId), expired);
+            for (auto node : expired) {
+                // the timer delegate obj will be deleted by the MsgTimerRemove
+                // that its expire() sends
+                static_cast<LocTimerDelegate*>(node)->expire();
+            }
+            mTimerContainer->updateNextTime();
+        }
+    };
+
+    struct itimerspec delay;
+    memset(&delay, 0, sizeof(struct itimerspec));
+    timerfd_settime(getTimerFd(), TFD_TIMER_ABSTIME, &delay, NULL);
+    mPollTask->removePoll(*this);
+    mMsgTask->sendMsg(new MsgTimerExpire(*this));
+}
+
+#else
+
 inline
-int LocTimerContainer::getTimerFd() {
-    return mDevFd;
+LocTimerDelegate* LocTimerContainer::getSoonestTimer() {
+    return (LocTimerDelegate*)(peek());
 }
 
 void LocTimerContainer::updateSoonestTime(LocTimerDelegate* priorTop) {
@@ -404,6 +564,8 @@ LocTimerDelegate* LocTimerContainer::popIfOutRanks(LocTimerDelegate& timer) {
     return poppedNode;
 }
 
+#endif // USE_LOC_TIMER_WHEEL
+
 
 /***************************LocTimerPollTask methods***************************/
 
@@ -0,0 +1,188 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocTimerWheel.h>
+#include <string.h>
+#include <algorithm>
+
+namespace loc_util {
+
+LocTimerWheel::LocTimerWheel(uint64_t nowNs) :
+    mNowTick(nowNs / TICK_NS), mSize(0) {
+    memset(mLevels, 0, sizeof(mLevels));
+}
+
+// hashes the node into the lowest level that reaches its expiry tick
+void LocTimerWheel::link(LocTimerWheelNode& node) {
+    // an already due timer goes into the current slot of level 0
+    uint64_t tick = std::max(node.mExpiryTick, mNowTick);
+    int level = 0;
+    while (level < TOTAL_LEVELS - 1 &&
+           (tick >> (LEVEL_BITS * level)) - (mNowTick >> (LEVEL_BITS * level)) >=
+           (uint64_t)SLOTS_PER_LEVEL) {
+        level++;
+    }
+    uint64_t slot = tick >> (LEVEL_BITS * level);
+    uint64_t topSlot = (mNowTick >> (LEVEL_BITS * level)) + SLOTS_PER_LEVEL - 1;
+    if (slot > topSlot) {
+        // beyond the span of the top level, park it in the farthest slot
+        slot = topSlot;
+    }
+    int index = slot & (SLOTS_PER_LEVEL - 1);
+
+    Level& l = mLevels[level];
+    node.mLevel = level;
+    node.mSlot = index;
+    node.mPrev = NULL;
+    node.mNext = l.mSlots[index];
+    if (node.mNext) {
+        node.mNext->mPrev = &node;
+    }
+    l.mSlots[index] = &node;
+    l.mOccupied |= (1ULL << index);
+}
+
+void LocTimerWheel::unlink(LocTimerWheelNode& node) {
+    Level& l = mLevels[node.mLevel];
+    if (node.mPrev) {
+        node.mPrev->mNext = node.mNext;
+    } else {
+        l.mSlots[node.mSlot] = node.mNext;
+        if (!node.mNext) {
+            l.mOccupied &= ~(1ULL << node.mSlot);
+        }
+    }
+    if (node.mNext) {
+        node.mNext->mPrev = node.mPrev;
+    }
+    node.mPrev = node.mNext = NULL;
+    node.mLevel = node.mSlot = -1;
+}
+
+void LocTimerWheel::add(LocTimerWheelNode& node, uint64_t expiryNs) {
+    if (node.isLinked()) {
+        unlink(node);
+        mSize--;
+    }
+    // rounded up, so that it never goes off early
+    node.mExpiryTick = (expiryNs + TICK_NS - 1) / TICK_NS;
+    link(node);
+    mSize++;
+}
+
+void LocTimerWheel::remove(LocTimerWheelNode& node) {
+    if (node.isLinked()) {
+        unlink(node);
+        mSize--;
+    }
+}
+
+// Every slot that the wheel passes over between mNowTick and nowTick, on
+// every level, is emptied. Its timers either have gone off, or get hashed
+// again, into a lower level, relative to the new time.
+void LocTimerWheel::advance(uint64_t nowNs, std::vector<LocTimerWheelNode*>& expired) {
+    uint64_t nowTick = nowNs / TICK_NS;
+    if (nowTick < mNowTick) {
+        return;
+    }
+
+    LocTimerWheelNode* pending = NULL;
+    for (int level = 0; level < TOTAL_LEVELS; level++) {
+        Level& l = mLevels[level];
+        uint64_t from = mNowTick >> (LEVEL_BITS * level);
+        uint64_t to = nowTick >> (LEVEL_BITS * level);
+        uint64_t passed;
+        if (to - from >= (uint64_t)SLOTS_PER_LEVEL - 1) {
+            passed = ~0ULL;
+        } else {
+            // slots from..to, rotated into place
+            uint64_t span = (2ULL << (to - from)) - 1;
+            int shift = from & (SLOTS_PER_LEVEL - 1);
+            passed = (span << shift) | (shift ? span >> (SLOTS_PER_LEVEL - shift) : 0);
+        }
+        uint64_t slots = l.mOccupied & passed;
+        while (slots) {
+            int index = __builtin_ctzll(slots);
+            slots &= slots - 1;
+            LocTimerWheelNode* node = l.mSlots[index];
+            l.mSlots[index] = NULL;
+            while (node) {
+                LocTimerWheelNode* next = node->mNext;
+                node->mNext = pending;
+                pending = node;
+                node = next;
+            }
+        }
+        l.mOccupied &= ~passed;
+    }
+
+    mNowTick = nowTick;
+    size_t first = expired.size();
+    while (pending) {
+        LocTimerWheelNode* node = pending;
+        pending = node->mNext;
+        node->mPrev = node->mNext = NULL;
+        node->mLevel = node->mSlot = -1;
+        if (node->mExpiryTick <= nowTick) {
+            expired.push_back(node);
+            mSize--;
+        } else {
+            link(*node);
+        }
+    }
+    std::stable_sort(expired.begin() + first, expired.end(),
+                     [](LocTimerWheelNode* a, LocTimerWheelNode* b) {
+                         return a->mExpiryTick < b->mExpiryTick;
+                     });
+}
+
+bool LocTimerWheel::getNextTime(uint64_t& nextNs) const {
+    bool found = false;
+    uint64_t nextTick = ~0ULL;
+    for (int level = 0; level < TOTAL_LEVELS; level++) {
+        const Level& l = mLevels[level];
+        if (l.mOccupied) {
+            uint64_t now = mNowTick >> (LEVEL_BITS * level);
+            int shift = now & (SLOTS_PER_LEVEL - 1);
+            // bitmap rotated such that bit 0 is the current slot
+            uint64_t rotated = shift ?
+                    (l.mOccupied >> shift) | (l.mOccupied << (SLOTS_PER_LEVEL - shift)) :
+                    l.mOccupied;
+            // the slot is due once the wheel gets into it
+            uint64_t tick = (now + __builtin_ctzll(rotated)) << (LEVEL_BITS * level);
+            nextTick = std::min(nextTick, std::max(tick, mNowTick));
+            found = true;
+        }
+    }
+    if (found) {
+        nextNs = nextTick * TICK_NS;
+    }
+    return found;
+}
+
+} // namespace loc_util
@@ -0,0 +1,100 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __LOC_TIMER_WHEEL__
+#define __LOC_TIMER_WHEEL__
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace loc_util {
+
+// Intrusive link of a timer in LocTimerWheel, to be extended by the timer obj.
+class LocTimerWheelNode {
+    friend class LocTimerWheel;
+    LocTimerWheelNode* mPrev;
+    LocTimerWheelNode* mNext;
+    uint64_t mExpiryTick;
+    int16_t mLevel;
+    int16_t mSlot;
+public:
+    inline LocTimerWheelNode() :
+        mPrev(NULL), mNext(NULL), mExpiryTick(0), mLevel(-1), mSlot(-1) {}
+    inline bool isLinked() const { return mLevel >= 0; }
+};
+
+// A hierarchical timing wheel. Level 0 has one slot per tick; every level
+// above has slots TICKS_PER_SLOT times as wide as the level below. A timer
+// is hashed into the lowest level whose span still reaches its expiry, and
+// is moved down as the wheel advances, so add() and remove() are O(1).
+// Each level keeps a bitmap of its non-empty slots, which makes finding
+// the next tick that needs service O(levels).
+// The wheel is not thread safe; LocTimerContainer only uses it in the
+// context of its MsgTask.
+class LocTimerWheel {
+public:
+    static const int LEVEL_BITS = 6;
+    static const int SLOTS_PER_LEVEL = 1 << LEVEL_BITS;
+    // 64^5 ms, about 12 days; timers beyond that are hashed again when
+    // the last slot of the top level is reached.
+    static const int TOTAL_LEVELS = 5;
+    static const uint64_t TICK_NS = 1000000;
+private:
+    struct Level {
+        uint64_t mOccupied;
+        LocTimerWheelNode* mSlots[SLOTS_PER_LEVEL];
+    };
+    Level mLevels[TOTAL_LEVELS];
+    // the last tick the wheel has been advanced to
+    uint64_t mNowTick;
+    size_t mSize;
+
+    void link(LocTimerWheelNode& node);
+    void unlink(LocTimerWheelNode& node);
+public:
+    LocTimerWheel(uint64_t nowNs);
+
+    // expiryNs is the time the timer should go off, in the same clock as
+    // the nowNs given to advance(). The timer never goes off early, but
+    // may go off up to a tick late.
+    void add(LocTimerWheelNode& node, uint64_t expiryNs);
+    // no op if node is not in the wheel
+    void remove(LocTimerWheelNode& node);
+    // Advances the wheel to nowNs and moves all the timers that have gone
+    // off into expired, in expiry order.
+    void advance(uint64_t nowNs, std::vector<LocTimerWheelNode*>& expired);
+    // Returns false if the wheel is empty, otherwise the time at which
+    // advance() should be called next in nextNs.
+    bool getNextTime(uint64_t& nextNs) const;
+    inline size_t size() const { return mSize; }
+};
+
+} // namespace loc_util
+
+#endif //__LOC_TIMER_WHEEL__
@@ -28,6 +28,8 @@
  */
 
 #include "LogBuffer.h"
+#include <sys/syscall.h>
+#include <unistd.h>
 #ifdef USE_GLIB
 #include <execinfo.h>
 #endif
@@ -44,6 +46,8 @@ struct sigaction LogBuffer::mOriSigAction[NSIG];
 struct sigaction LogBuffer::mNewSigAction;
 mutex LogBuffer::sLock;
 
+static thread_local int32_t sTid = 0;
+
 LogBuffer* LogBuffer::getInstance() {
     if (mInstance == nullptr) {
         lock_guard<mutex> guard(sLock);
@@ -54,7 +58,7 @@ LogBuffer* LogBuffer::getInstance() {
     return mInstance;
 }
 
-LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
+LogBuffer::LogBuffer():
         mConfigVec(TOTAL_LOG_LEVELS, ConfigsInLevel(TIME_DEPTH_THRESHOLD_MINIMAL_IN_SEC,
                     MAXIMUM_NUM_IN_LIST, 0)) {
     loc_param_s_type log_buff_config_table[] =
@@ -72,47 +76,225 @@ LogBuffer::LogBuffer(): mLogList(TOTAL_LOG_LEVELS),
     };
     loc_read_conf(LOC_PATH_GPS_CONF_STR, log_buff_config_table,
             sizeof(log_buff_config_table)/sizeof(log_buff_config_table[0]));
+    for (int lvl = 0; lvl < TOTAL_LOG_LEVELS; lvl++) {
+        LogLevelRing& ring = mRings[lvl];
+        ring.mCapacity = std::min(mConfigVec[lvl].mMaxNumThres, (uint32_t)MAXIMUM_NUM_IN_LEVEL);
+        ring.mSlots = (ring.mCapacity > 0) ? new LogLevelRing::Slot[ring.mCapacity] : nullptr;
+        for (uint32_t i = 0; i < ring.mCapacity; i++) {
+            ring.mSlots[i].mSeq.store(0, std::memory_order_relaxed);
+        }
+        ring.mNext.store(0, std::memory_order_relaxed);
+        ring.mFlushed.store(0, std::memory_order_relaxed);
+    }
     registerSignalHandler();
 }
 
+// Returns the record to fill in, or NULL if the level keeps no records or a
+// newer record took the slot meanwhile. The slot stays locked until endRecord().
+LogRecord* LogBuffer::beginRecord(int level, uint64_t timestampNs, uint64_t& serial) {
+    LogLevelRing& ring = mRings[level];
+    if (0 == ring.mCapacity) {
+        return nullptr;
+    }
+    serial = ring.mNext.fetch_add(1, std::memory_order_relaxed);
+    LogLevelRing::Slot& slot = ring.mSlots[serial % ring.mCapacity];
+    uint64_t seq = slot.mSeq.load(std::memory_order_relaxed);
+    for (;;) {
+        if (seq & 1) {
+            // the writer of the record one lap ahead still holds the slot
+            std::this_thread::yield();
+            seq = slot.mSeq.load(std::memory_order_relaxed);
+        } else if (seq > 2 * serial) {
+            // lapped, the slot already holds a newer record
+            return nullptr;
+        } else if (slot.mSeq.compare_exchange_weak(seq, 2 * serial + 1,
+                std::memory_order_acquire, std::memory_order_relaxed)) {
+            break;
+        }
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    if (0 == sTid) {
+        sTid = (int32_t)syscall(SYS_gettid);
+    }
+    LogRecord& record = slot.mRecord;
+    record.mTimestampNs = timestampNs;
+    record.mTid = sTid;
+    record.mLevel = level;
+    return &record;
+}
+
+void LogBuffer::endRecord(int level, uint64_t serial) {
+    LogLevelRing& ring = mRings[level];
+    ring.mSlots[serial % ring.mCapacity].mSeq.store(2 * (serial + 1), std::memory_order_release);
+}
+
+void LogBuffer::appendv(int level, const char* tag, const char* format, va_list args) {
+    if (level < 0 || level >= TOTAL_LOG_LEVELS || nullptr == format) {
+        return;
+    }
+    timespec ts;
+    clock_gettime(CLOCK_BOOTTIME, &ts);
+    uint64_t serial;
+    LogRecord* record = beginRecord(level,
+            (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec, serial);
+    if (nullptr == record) {
+        return;
+    }
+    record->mPrefixed = 1;
+    snprintf(record->mTag, sizeof(record->mTag), "%s", (nullptr != tag) ? tag : "");
+    va_list argsCopy;
+    va_copy(argsCopy, args);
+    int len = vsnprintf(record->mText, sizeof(record->mText), format, argsCopy);
+    va_end(argsCopy);
+    if (len < 0) {
+        record->mText[0] = '\0';
+    }
+    record->mTruncated = (len >= (int)sizeof(record->mText));
+    endRecord(level, serial);
+}
+
+// data is kept as is, it is not a formatted LOC_LOG* line
 void LogBuffer::append(string& data, int level, uint64_t timestamp) {
-    lock_guard<mutex> guard(mLock);
-    pair<uint64_t, string> item(timestamp, data);
-    mLogList.append(item, level);
-    mConfigVec[level].mCurrentSize++;
+    if (level < 0 || level >= TOTAL_LOG_LEVELS) {
+        return;
+    }
+    uint64_t serial;
+    LogRecord* record = beginRecord(level, timestamp * 1000000000ULL, serial);
+    if (nullptr == record) {
+        return;
+    }
+    record->mPrefixed = 0;
+    record->mTag[0] = '\0';
+    int len = snprintf(record->mText, sizeof(record->mText), "%s", data.c_str());
+    record->mTruncated = (len >= (int)sizeof(record->mText));
+    endRecord(level, serial);
+}
 
-    while ((timestamp - mLogList.front(level).first) > mConfigVec[level].mTimeDepthThres ||
-            mConfigVec[level].mCurrentSize > mConfigVec[level].mMaxNumThres) {
-        mLogList.pop(level);
-        mConfigVec[level].mCurrentSize--;
+// Takes a consistent copy of the unflushed records of all the levels.
+void LogBuffer::collect(vector<LogRecord>& records) {
+    for (auto& ring : mRings) {
+        uint64_t next = ring.mNext.load(std::memory_order_acquire);
+        uint64_t first = ring.mFlushed.load(std::memory_order_relaxed);
+        if (next > ring.mCapacity && first < next - ring.mCapacity) {
+            first = next - ring.mCapacity;
+        }
+        for (uint64_t serial = first; serial < next; serial++) {
+            LogLevelRing::Slot& slot = ring.mSlots[serial % ring.mCapacity];
+            uint64_t seq = slot.mSeq.load(std::memory_order_acquire);
+            // still being written, or overwritten by a newer record
+            if (seq != 2 * (serial + 1)) {
+                continue;
+            }
+            LogRecord record;
+            memcpy(&record, &slot.mRecord, sizeof(record));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            // skip the records overwritten while being copied
+            if (seq == slot.mSeq.load(std::memory_order_relaxed)) {
+                records.push_back(record);
+            }
+        }
     }
+    stable_sort(records.begin(), records.end(), [](const LogRecord& a, const LogRecord& b) {
+        return a.mTimestampNs < b.mTimestampNs;
+    });
 }
 
 //Dump the log buffer of specific level, level = -1 to dump all the levels in log buffer.
+//The sections of the registered dump callbacks follow.
 void LogBuffer::dump(std::function<void(stringstream&)> log, int level) {
-    lock_guard<mutex> guard(mLock);
-    list<pair<pair<uint64_t, string>, int>> li;
-    if (-1 == level) {
-        li = mLogList.dump();
-    } else {
-        li = mLogList.dump(level);
+    dumpLogList(log, level);
+
+    // the callbacks may log, so they must not run under mLock
+    vector<DumpCb> dumpCbs;
+    {
+        lock_guard<mutex> guard(mDumpCbLock);
+        dumpCbs = mDumpCbs;
+    }
+    if (log != nullptr) {
+        for (auto& cb : dumpCbs) {
+            cb(log);
+        }
     }
-    ALOGE("Begining of dump, buffer size: %d", (int)li.size());
+}
+
+void LogBuffer::dumpLogList(std::function<void(stringstream&)>& log, int level) {
+    vector<LogRecord> records;
+    collect(records);
+
+    // apply the per level time depth and capacity, the same way as if the
+    // records had been appended to the list one by one
+    vector<size_t> capacities;
+    for (auto& ring : mRings) {
+        capacities.push_back(ring.mCapacity);
+    }
+    SkipList<pair<uint64_t, const LogRecord*>> logList(capacities);
+    for (auto& record : records) {
+        int lvl = record.mLevel;
+        uint64_t timestamp = record.mTimestampNs / 1000000000ULL;
+        pair<uint64_t, const LogRecord*> item(timestamp, &record);
+        logList.append(item, lvl);
+        while (logList.size(lvl) > 0 &&
+                (timestamp - logList.front(lvl).first) > mConfigVec[lvl].mTimeDepthThres) {
+            logList.pop(lvl);
+        }
+    }
+
+    size_t size = (-1 == level) ? logList.size() : logList.size(level);
+    ALOGE("Begining of dump, buffer size: %d", (int)size);
     stringstream ln;
-    ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << li.size() << endl;
+    ln << "dump log buffer, level[" << level << "]" << ", buffer size: " << size << endl;
     log(ln);
-    for_each (li.begin(), li.end(), [&, this](const pair<pair<uint64_t, string>, int> &item){
+
+    // wall clock of the records, as the LOC_LOG* lines show it
+    timespec bootNow, realNow;
+    clock_gettime(CLOCK_BOOTTIME, &bootNow);
+    clock_gettime(CLOCK_REALTIME, &realNow);
+    int64_t bootToRealNs = ((int64_t)realNow.tv_sec - bootNow.tv_sec) * 1000000000LL +
+            (realNow.tv_nsec - bootNow.tv_nsec);
+    pid_t pid = getpid();
+
+    auto dumpItem = [&, this](const pair<uint64_t, const LogRecord*>& item, int lvl) {
+        const LogRecord& record = *item.second;
+        string data;
+        if (record.mPrefixed) {
+            int64_t realNs = (int64_t)record.mTimestampNs + bootToRealNs;
+            time_t sec = realNs / 1000000000LL;
+            char prefix[128];
+            snprintf(prefix, sizeof(prefix), "%02d:%02d:%02d.%06ld %d %d %s :",
+                    (int)(sec/3600%24), (int)((sec%3600)/60), (int)(sec%60),
+                    (long)(realNs % 1000000000LL / 1000), pid, record.mTid, record.mTag);
+            data = prefix;
+        }
+        data.append(record.mText);
+        if (record.mTruncated) {
+            data.append("...");
+        }
+        if (record.mPrefixed) {
+            data.push_back('\n');
+        }
+
         stringstream line;
-        line << "["<<item.first.first << "] ";
-        line << "Level " << mLevelMap[item.second] << ": ";
-        line << item.first.second << endl;
+        line << "["<<item.first << "] ";
+        line << "Level " << mLevelMap[lvl] << ": ";
+        line << data << endl;
         if (log != nullptr) {
             log(line);
         }
-    });
+    };
+    if (-1 == level) {
+        logList.forEach(dumpItem);
+    } else {
+        logList.forEach(level, dumpItem);
+    }
     ALOGE("End of dump");
 }
 
+void LogBuffer::registerDumpCb(DumpCb cb) {
+    lock_guard<mutex> guard(mDumpCbLock);
+    mDumpCbs.push_back(cb);
+}
+
 void LogBuffer::dumpToAdbLogcat() {
     dump([](stringstream& line){
         ALOGE("%s", line.str().c_str());
@@ -130,7 +312,10 @@ void LogBuffer::dumpToLogFile(string filePath) {
 }
 
 void LogBuffer::flush() {
-    mLogList.flush();
+    for (auto& ring : mRings) {
+        ring.mFlushed.store(ring.mNext.load(std::memory_order_acquire),
+                std::memory_order_relaxed);
+    }
 }
 
 void LogBuffer::registerSignalHandler() {
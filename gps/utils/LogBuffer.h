@@ -40,7 +40,9 @@
 #include <fstream>
 #include <time.h>
 #include <mutex>
+#include <atomic>
 #include <signal.h>
+#include <stdarg.h>
 #include <thread>
 #include <functional>
 
@@ -50,6 +52,10 @@
 #define MAXIMUM_NUM_IN_LIST 50
 //file path of dumped log buffer
 #define LOG_BUFFER_FILE_PATH "/data/vendor/location/"
+//size of the tag copy in a log record
+#define LOG_RECORD_TAG_SIZE 32
+//upper bound of the per level MAX_CAPACITY
+#define MAXIMUM_NUM_IN_LEVEL 4096
 
 namespace loc_util {
 
@@ -63,6 +69,43 @@ public:
         mTimeDepthThres(time), mMaxNumThres(num), mCurrentSize(size) {}
 };
 
+// A log line as it is recorded. It is formatted at log time and the tag is
+// copied, so that a record never refers to memory of the caller.
+struct LogRecord {
+    // CLOCK_BOOTTIME
+    uint64_t mTimestampNs;
+    int32_t mTid;
+    uint8_t mLevel;
+    // a LOC_LOG* line, dumped with the time / pid / tid / tag prefix
+    uint8_t mPrefixed;
+    // the line did not fit into mText, its tail is dropped
+    uint8_t mTruncated;
+    char mTag[LOG_RECORD_TAG_SIZE];
+    char mText[LOGGING_BUFFER_MAX_LEN];
+};
+
+// Ring of the most recent records of one log level, sized from the
+// MAX_CAPACITY of the level in gps.conf. Writers claim a record with a
+// fetch_add and publish it through the sequence number of its slot, so a
+// dump can read the records while writers keep logging.
+struct LogLevelRing {
+    struct Slot {
+        // 2 * (serial + 1) of the record held, odd while it is being written
+        std::atomic<uint64_t> mSeq;
+        LogRecord mRecord;
+    };
+    // number of records claimed
+    std::atomic<uint64_t> mNext;
+    // records numbered below this have been flushed
+    std::atomic<uint64_t> mFlushed;
+    uint32_t mCapacity;
+    Slot* mSlots;
+};
+
+// Log buffer of the LOC_LOG* lines. Each level logs into its own preallocated
+// LogLevelRing without locking or allocating, so that the lines of a chatty
+// level never push out those of another. The time depth of each level is
+// applied when the records are collected for a dump.
 class LogBuffer {
 private:
     static LogBuffer* mInstance;
@@ -70,24 +113,33 @@ private:
     static struct sigaction mNewSigAction;
     static mutex sLock;
 
-    SkipList<pair<uint64_t, string>> mLogList;
     vector<ConfigsInLevel> mConfigVec;
-    mutex mLock;
+    LogLevelRing mRings[TOTAL_LOG_LEVELS];
 
     const vector<string> mLevelMap {"E", "W", "I", "D", "V"};
 
+    // extra sections written at the end of each dump, e.g. MsgTask stats
+    typedef std::function<void(std::function<void(stringstream&)>&)> DumpCb;
+    vector<DumpCb> mDumpCbs;
+    mutex mDumpCbLock;
+
 public:
     static LogBuffer* getInstance();
     void append(string& data, int level, uint64_t timestamp);
+    void appendv(int level, const char* tag, const char* format, va_list args);
     void dump(std::function<void(stringstream&)> log, int level = -1);
+    void registerDumpCb(DumpCb cb);
     void dumpToAdbLogcat();
     void dumpToLogFile(string filePath);
     void flush();
 private:
     LogBuffer();
+    LogRecord* beginRecord(int level, uint64_t timestampNs, uint64_t& serial);
+    void endRecord(int level, uint64_t serial);
+    void collect(vector<LogRecord>& records);
+    void dumpLogList(std::function<void(stringstream&)>& log, int level);
     void registerSignalHandler();
     static void signalHandler(const int code, siginfo_t *const si, void *const sc);
-
 };
 
 }
@@ -0,0 +1,213 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_MsgRing"
+
+#include <MsgRing.h>
+#include <MsgTask.h>
+#include <log_util.h>
+#include <thread>
+
+namespace loc_util {
+
+static uint32_t roundUpPow2(uint32_t n) {
+    uint32_t size = 2;
+    while (size < n && size < (1u << 30)) {
+        size <<= 1;
+    }
+    return size;
+}
+
+MsgRing::MsgRing(uint32_t capacity) :
+    mMask(roundUpPow2(capacity) - 1), mSlots(new Slot[mMask + 1]),
+    mTail(0), mHead(0), mOverflowed(false), mPendingTail(0), mSleeping(false),
+    mUnblocked(false) {
+    for (uint32_t i = 0; i <= mMask; i++) {
+        mSlots[i].mSeq.store(i, std::memory_order_relaxed);
+        mSlots[i].mMsg = nullptr;
+    }
+}
+
+MsgRing::~MsgRing() {
+    flush();
+    delete[] mSlots;
+}
+
+bool MsgRing::push(LocMsg* msg) {
+    Slot* slot;
+    uint32_t pos = mTail.load(std::memory_order_relaxed);
+    for (;;) {
+        slot = &mSlots[pos & mMask];
+        uint32_t seq = slot->mSeq.load(std::memory_order_acquire);
+        int32_t diff = (int32_t)(seq - pos);
+        if (0 == diff) {
+            // seq_cst, so that a claim the consumer counts in mPendingTail
+            // was made by a sender that had not seen mOverflowed cleared yet
+            if (mTail.compare_exchange_weak(pos, pos + 1, std::memory_order_seq_cst)) {
+                break;
+            }
+        } else if (diff < 0) {
+            // ring is full
+            return false;
+        } else {
+            pos = mTail.load(std::memory_order_relaxed);
+        }
+    }
+    slot->mMsg = msg;
+    slot->mSeq.store(pos + 1, std::memory_order_release);
+    return true;
+}
+
+LocMsg* MsgRing::pop() {
+    Slot* slot = &mSlots[mHead & mMask];
+    while (slot->mSeq.load(std::memory_order_acquire) != mHead + 1) {
+        if (mTail.load(std::memory_order_acquire) == mHead) {
+            // empty
+            return nullptr;
+        }
+        // a producer claimed the slot but has not published yet. Its msg is
+        // older than anything behind it, so wait for it rather than going on
+        // to the overflow list.
+        std::this_thread::yield();
+    }
+    LocMsg* msg = slot->mMsg;
+    slot->mMsg = nullptr;
+    slot->mSeq.store(mHead + mMask + 1, std::memory_order_release);
+    mHead++;
+    return msg;
+}
+
+bool MsgRing::hasMsg() {
+    return !mPending.empty() ||
+            mSlots[mHead & mMask].mSeq.load(std::memory_order_seq_cst) == mHead + 1 ||
+            mOverflowed.load(std::memory_order_seq_cst);
+}
+
+void MsgRing::wakeUp() {
+    // pairs with the store of mSleeping in rcv(), so that either the consumer
+    // sees the new msg before it waits, or we see it sleeping here
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (mSleeping.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> guard(mWaitLock);
+        mWaitCond.notify_one();
+    }
+}
+
+bool MsgRing::snd(LocMsg* msg) {
+    if (mUnblocked.load(std::memory_order_relaxed)) {
+        LOC_LOGE("%s: Message ring has been unblocked.", __func__);
+        return false;
+    }
+
+    if (mOverflowed.load(std::memory_order_seq_cst) || !push(msg)) {
+        std::lock_guard<std::mutex> guard(mOverflowLock);
+        mOverflow.push_back(msg);
+        mOverflowed.store(true, std::memory_order_release);
+        LOC_LOGV("%s: ring full, %zu msgs in overflow", __func__, mOverflow.size());
+    }
+
+    wakeUp();
+    return true;
+}
+
+LocMsg* MsgRing::tryRcv() {
+    for (;;) {
+        if (!mPending.empty()) {
+            if (mHead == mPendingTail) {
+                LocMsg* msg = mPending.front();
+                mPending.pop_front();
+                return msg;
+            }
+            // slots claimed before the overflow list was taken come first,
+            // pop() waits for them as they are all claimed
+            return pop();
+        }
+
+        LocMsg* msg = pop();
+        if (nullptr != msg || !mOverflowed.load(std::memory_order_acquire)) {
+            return msg;
+        }
+
+        // the ring is empty, now take whatever spilled over. The ring slots
+        // claimed up to now are older than the overflow msgs of their
+        // sender, the ones claimed after mOverflowed is cleared are newer.
+        std::lock_guard<std::mutex> guard(mOverflowLock);
+        mPending.swap(mOverflow);
+        mPendingTail = mTail.load(std::memory_order_seq_cst);
+        mOverflowed.store(false, std::memory_order_seq_cst);
+    }
+}
+
+LocMsg* MsgRing::rcv() {
+    for (;;) {
+        if (mUnblocked.load(std::memory_order_relaxed)) {
+            return nullptr;
+        }
+
+        LocMsg* msg = tryRcv();
+        if (nullptr != msg) {
+            return msg;
+        }
+
+        std::unique_lock<std::mutex> lock(mWaitLock);
+        mSleeping.store(true, std::memory_order_seq_cst);
+        mWaitCond.wait(lock, [this] {
+            return mUnblocked.load(std::memory_order_relaxed) || hasMsg();
+        });
+        mSleeping.store(false, std::memory_order_relaxed);
+    }
+}
+
+void MsgRing::flush() {
+    LocMsg* msg;
+    while (nullptr != (msg = pop())) {
+        delete msg;
+    }
+    for (auto pending : mPending) {
+        delete pending;
+    }
+    mPending.clear();
+    mPendingTail = mHead;
+
+    std::lock_guard<std::mutex> guard(mOverflowLock);
+    for (auto overflow : mOverflow) {
+        delete overflow;
+    }
+    mOverflow.clear();
+    mOverflowed.store(false, std::memory_order_release);
+}
+
+void MsgRing::unblock() {
+    LOC_LOGD("%s: Unblocking Message Ring", __func__);
+    mUnblocked.store(true, std::memory_order_seq_cst);
+    std::lock_guard<std::mutex> guard(mWaitLock);
+    mWaitCond.notify_all();
+}
+
+} // namespace loc_util
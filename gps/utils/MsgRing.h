@@ -0,0 +1,108 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __MSG_RING__
+#define __MSG_RING__
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+
+namespace loc_util {
+
+struct LocMsg;
+
+// A bounded multi-producer / single-consumer queue of LocMsg pointers.
+// Producers claim a slot with a CAS on the tail and publish the msg by
+// bumping the slot sequence number, so the send path takes no lock and
+// does no allocation. The consumer only blocks, on a condition variable,
+// when the ring is empty; producers signal it only if it is parked.
+// If the ring is full, msgs spill into an overflow list under a mutex;
+// while the overflow list is non-empty, all senders use it. The consumer
+// only takes the overflow list once the ring is empty, and receives it
+// after the ring slots claimed before that point, so that the msgs from
+// any one sender are still received in the order sent.
+class MsgRing {
+    struct Slot {
+        std::atomic<uint32_t> mSeq;
+        LocMsg* mMsg;
+    };
+
+    const uint32_t mMask;
+    Slot* const mSlots;
+    // claimed by producers
+    std::atomic<uint32_t> mTail;
+    // only touched by the consumer
+    uint32_t mHead;
+
+    std::atomic<bool> mOverflowed;
+    std::mutex mOverflowLock;
+    std::deque<LocMsg*> mOverflow;
+    // overflow msgs taken by the consumer, received once mHead reaches
+    // mPendingTail, i.e. after the ring slots claimed before they were taken
+    std::deque<LocMsg*> mPending;
+    uint32_t mPendingTail;
+
+    std::atomic<bool> mSleeping;
+    std::atomic<bool> mUnblocked;
+    std::mutex mWaitLock;
+    std::condition_variable mWaitCond;
+
+    bool push(LocMsg* msg);
+    LocMsg* pop();
+    bool hasMsg();
+    void wakeUp();
+public:
+    // capacity is rounded up to the next power of 2
+    MsgRing(uint32_t capacity = 256);
+    ~MsgRing();
+
+    // Sends msg into the queue. Returns false if the queue has been
+    // unblocked, in which case the msg is not taken.
+    bool snd(LocMsg* msg);
+
+    // Receives the oldest msg, blocking while the queue is empty.
+    // Returns NULL once the queue has been unblocked.
+    LocMsg* rcv();
+
+    // Same as rcv(), but returns NULL right away if the queue is empty.
+    LocMsg* tryRcv();
+
+    // Deletes all the msgs still in the queue. Only to be called from the
+    // consumer context, or once the consumer thread has stopped.
+    void flush();
+
+    // Wakes up the consumer and stops the use of the queue.
+    void unblock();
+};
+
+} // namespace loc_util
+
+#endif //__MSG_RING__
@@ -30,8 +30,13 @@
 #define LOG_TAG "LocSvc_MsgTask"
 
 #include <unistd.h>
+#include <algorithm>
+#include <vector>
 #include <MsgTask.h>
+#include <MsgRing.h>
+#include <MsgTaskStats.h>
 #include <msg_q.h>
+#include <linked_list.h>
 #include <log_util.h>
 #include <loc_log.h>
 #include <loc_pla.h>
@@ -40,8 +45,31 @@ namespace loc_util {
 
 class MTRunnable : public LocRunnable {
     const void* mQ;
+    MsgRing* mRing;
+    // pooled msgs still in the queue are released into this on flush
+    std::shared_ptr<MsgPool> mPool;
+    std::shared_ptr<MsgTaskStats> mStats;
+    const bool mBatchDrain;
+    // empty list swapped with the msg_q list in batch drain mode
+    void* mBatchList;
+    std::vector<LocMsg*> mBatch;
+    std::vector<uintptr_t> mBatchKeys;
+
+    // upper bound of msgs taken from a MsgRing per batch
+    static const size_t MAX_RING_BATCH_SIZE = 256;
+
+    bool rcvBatch();
+    bool runBatch();
+    void procMsg(LocMsg* msg);
 public:
-    inline MTRunnable(const void* q) : mQ(q) {}
+    inline MTRunnable(const void* q, MsgRing* ring, std::shared_ptr<MsgPool> pool,
+                      std::shared_ptr<MsgTaskStats> stats, bool batchDrain) :
+        mQ(q), mRing(ring), mPool(pool), mStats(stats), mBatchDrain(batchDrain),
+        mBatchList(NULL) {
+        if (mBatchDrain && NULL == mRing) {
+            linked_list_init(&mBatchList);
+        }
+    }
     virtual ~MTRunnable();
     // Overrides of LocRunnable methods
     // This method will be repeated called until it returns false; or
@@ -60,14 +88,25 @@ static void LocMsgDestroy(void* msg) {
     delete (LocMsg*)msg;
 }
 
-MsgTask::MsgTask(const char* threadName) :
-    mQ(msg_q_init2()), mThread() {
-    mThread.start(threadName, std::make_shared<MTRunnable>(mQ));
+MsgTask::MsgTask(const char* threadName, QueueMode mode, bool batchDrain) :
+    mQ(QUEUE_MODE_RING == mode ? NULL : msg_q_init2()),
+    mRing(QUEUE_MODE_RING == mode ? new MsgRing() : NULL),
+    mPool(std::make_shared<MsgPool>()), mStats(std::make_shared<MsgTaskStats>(threadName)),
+    mThread() {
+    mThread.start(threadName,
+                  std::make_shared<MTRunnable>(mQ, mRing, mPool, mStats, batchDrain));
 }
 
 void MsgTask::sendMsg(const LocMsg* msg) const {
     if (msg && this) {
-        msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        if (MsgTaskStats::isEnabled()) {
+            mStats->onSend(msg);
+        }
+        if (NULL != mRing) {
+            mRing->snd((LocMsg*)msg);
+        } else {
+            msg_q_snd((void*)mQ, (void*)msg, LocMsgDestroy);
+        }
     } else {
         LOC_LOGE("%s: msg is %p and this is %p",
                  __func__, msg, this);
@@ -75,18 +114,99 @@ void MsgTask::sendMsg(const LocMsg* msg) const {
 }
 
 void MsgTask::sendMsg(const std::function<void()> runnable) const {
-    struct RunMsg : public LocMsg {
-        const std::function<void()> mRunnable;
-    public:
-        inline RunMsg(const std::function<void()> runnable) : mRunnable(runnable) {}
-        ~RunMsg() = default;
-        inline virtual void proc() const override { mRunnable(); }
-    };
-    sendMsg(new RunMsg(runnable));
+    sendMsg(new (*mPool) PooledRunMsg<std::function<void()>>(runnable));
+}
+
+MsgPool::MsgPool() : mStats{0, 0, 0} {
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
+        mFreeList[i] = NULL;
+        mFreeCount[i] = 0;
+    }
+}
+
+MsgPool::~MsgPool() {
+    for (int i = 0; i < NUM_SIZE_CLASSES; i++) {
+        while (NULL != mFreeList[i]) {
+            SlotHeader* slot = mFreeList[i];
+            mFreeList[i] = slot->mNext;
+            free(slot);
+        }
+    }
+}
+
+void* MsgPool::alloc(size_t size) {
+    int sizeClass = 0;
+    size_t slotSize = MIN_SLOT_SIZE;
+    while (slotSize < size && sizeClass < NUM_SIZE_CLASSES) {
+        slotSize <<= 1;
+        sizeClass++;
+    }
+
+    SlotHeader* slot = NULL;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        if (sizeClass >= NUM_SIZE_CLASSES) {
+            mStats.mOverflows++;
+            sizeClass = -1;
+            slotSize = size;
+        } else if (NULL != mFreeList[sizeClass]) {
+            mStats.mHits++;
+            slot = mFreeList[sizeClass];
+            mFreeList[sizeClass] = slot->mNext;
+            mFreeCount[sizeClass]--;
+        } else {
+            mStats.mMisses++;
+        }
+    }
+
+    if (NULL == slot) {
+        slot = (SlotHeader*)malloc(sizeof(SlotHeader) + slotSize);
+        if (NULL == slot) {
+            LOC_LOGE("%s: failed to allocate %zu bytes", __func__, slotSize);
+            abort();
+        }
+    }
+    slot->mPool = this;
+    slot->mSizeClass = sizeClass;
+    return slot + 1;
+}
+
+void MsgPool::release(void* p) {
+    if (NULL != p) {
+        SlotHeader* slot = (SlotHeader*)p - 1;
+        if (slot->mSizeClass < 0) {
+            free(slot);
+        } else {
+            slot->mPool->recycle(slot);
+        }
+    }
+}
+
+void MsgPool::recycle(SlotHeader* slot) {
+    int sizeClass = slot->mSizeClass;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        if (mFreeCount[sizeClass] < MAX_FREE_SLOTS) {
+            slot->mNext = mFreeList[sizeClass];
+            mFreeList[sizeClass] = slot;
+            mFreeCount[sizeClass]++;
+            slot = NULL;
+        }
+    }
+    free(slot);
+}
+
+MsgPool::Stats MsgPool::getStats() {
+    std::lock_guard<std::mutex> guard(mLock);
+    return mStats;
 }
 
 void MTRunnable::interrupt() {
-    msg_q_unblock((void*)mQ);
+    if (NULL != mRing) {
+        mRing->unblock();
+    } else {
+        msg_q_unblock((void*)mQ);
+    }
 }
 
 void MTRunnable::prerun() {
@@ -94,27 +214,117 @@ void MTRunnable::prerun() {
      set_sched_policy(gettid(), SP_FOREGROUND);
 }
 
+bool MTRunnable::rcvBatch() {
+    LocMsg* msg;
+    if (NULL != mRing) {
+        msg = mRing->rcv();
+        if (NULL == msg) {
+            return false;
+        }
+        mBatch.push_back(msg);
+        while (mBatch.size() < MAX_RING_BATCH_SIZE && NULL != (msg = mRing->tryRcv())) {
+            mBatch.push_back(msg);
+        }
+    } else {
+        msq_q_err_type result = msg_q_rcv_all((void*)mQ, &mBatchList);
+        if (eMSG_Q_SUCCESS != result) {
+            LOC_LOGE("%s:%d] fail receiving msgs: %s\n", __func__, __LINE__,
+                     loc_get_msg_q_status(result));
+            return false;
+        }
+        while (eLINKED_LIST_SUCCESS == linked_list_remove(mBatchList, (void**)&msg)) {
+            mBatch.push_back(msg);
+        }
+    }
+    return true;
+}
+
+bool MTRunnable::runBatch() {
+    if (!rcvBatch()) {
+        return false;
+    }
+    for (auto msg : mBatch) {
+        mStats->onRcv(msg);
+    }
+
+    // walk from the newest, the first msg seen with a key is the one to keep
+    size_t coalesced = 0;
+    mBatchKeys.clear();
+    for (auto it = mBatch.rbegin(); it != mBatch.rend(); ++it) {
+        uintptr_t key = (*it)->coalesceKey();
+        if (0 != key) {
+            if (std::find(mBatchKeys.begin(), mBatchKeys.end(), key) != mBatchKeys.end()) {
+                delete *it;
+                *it = NULL;
+                coalesced++;
+            } else {
+                mBatchKeys.push_back(key);
+            }
+        }
+    }
+    if (coalesced > 0) {
+        LOC_LOGV("%s: %zu of %zu msgs superseded", __func__, coalesced, mBatch.size());
+    }
+
+    for (auto msg : mBatch) {
+        if (NULL != msg) {
+            procMsg(msg);
+        }
+    }
+    mBatch.clear();
+
+    return true;
+}
+
 bool MTRunnable::run() {
+    if (mBatchDrain) {
+        return runBatch();
+    }
+
     LocMsg* msg;
-    msq_q_err_type result = msg_q_rcv((void*)mQ, (void **)&msg);
+    msq_q_err_type result;
+    if (NULL != mRing) {
+        msg = mRing->rcv();
+        result = (NULL != msg) ? eMSG_Q_SUCCESS : eMSG_Q_UNAVAILABLE_RESOURCE;
+    } else {
+        result = msg_q_rcv((void*)mQ, (void **)&msg);
+    }
     if (eMSG_Q_SUCCESS != result) {
         LOC_LOGE("%s:%d] fail receiving msg: %s\n", __func__, __LINE__,
                  loc_get_msg_q_status(result));
         return false;
     }
 
+    mStats->onRcv(msg);
+    procMsg(msg);
+
+    return true;
+}
+
+void MTRunnable::procMsg(LocMsg* msg) {
     msg->log();
     // there is where each individual msg handling is invoked
-    msg->proc();
+    if (0 != msg->mSendTimeNs) {
+        uint64_t procStartNs = MsgTaskStats::getTimeNs();
+        msg->proc();
+        mStats->onProc(msg, procStartNs, MsgTaskStats::getTimeNs());
+    } else {
+        msg->proc();
+    }
 
     delete msg;
-
-    return true;
 }
 
 MTRunnable::~MTRunnable() {
-    msg_q_flush((void*)mQ);
-    msg_q_destroy((void**)&mQ);
+    if (NULL != mBatchList) {
+        linked_list_destroy(&mBatchList);
+    }
+    if (NULL != mRing) {
+        delete mRing;
+    } else {
+        msg_q_flush((void*)mQ);
+        msg_q_destroy((void**)&mQ);
+    }
 }
 
 } // namespace loc_util
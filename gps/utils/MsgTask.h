@@ -29,26 +29,127 @@
 #ifndef __MSG_TASK__
 #define __MSG_TASK__
 
+#include <stdint.h>
+#include <cstddef>
 #include <functional>
+#include <mutex>
+#include <memory>
+#include <type_traits>
+#include <utility>
 #include <LocThread.h>
 
 namespace loc_util {
 
 struct LocMsg {
-    inline LocMsg() {}
+    // set by MsgTask::sendMsg() only when MsgTaskStats are enabled
+    mutable uint64_t mSendTimeNs;
+    inline LocMsg() : mSendTimeNs(0) {}
     inline virtual ~LocMsg() {}
     virtual void proc() const = 0;
     inline virtual void log() const {}
+    // Msgs returning the same non-zero key supersede one another when the
+    // MsgTask drains in batches: of those pending, only the newest is proc()'ed.
+    inline virtual uintptr_t coalesceKey() const { return 0; }
 };
 
+// Storage for the msgs created by the templated MsgTask::sendMsg(). Slots
+// come in power of 2 size classes and are recycled through per class
+// freelists, rather than going back to the heap after each proc().
+class MsgPool {
+public:
+    struct Stats {
+        // slot reused from a freelist
+        uint64_t mHits;
+        // freelist empty, new slot allocated
+        uint64_t mMisses;
+        // msg larger than MAX_SLOT_SIZE, plain heap allocation
+        uint64_t mOverflows;
+    };
+
+    static const size_t MIN_SLOT_SIZE = 128;
+    static const size_t MAX_SLOT_SIZE = 32768;
+    static const int NUM_SIZE_CLASSES = 9;
+    // slots kept in the freelist of each size class
+    static const uint32_t MAX_FREE_SLOTS = 4;
+
+    MsgPool();
+    ~MsgPool();
+    // never returns NULL; falls back to the heap if no slot fits size
+    void* alloc(size_t size);
+    // p must come from alloc() of any MsgPool
+    static void release(void* p);
+    Stats getStats();
+private:
+    struct alignas(alignof(std::max_align_t)) SlotHeader {
+        union {
+            MsgPool* mPool;
+            SlotHeader* mNext;
+        };
+        // size class index, or -1 if heap allocated
+        int mSizeClass;
+    };
+    std::mutex mLock;
+    SlotHeader* mFreeList[NUM_SIZE_CLASSES];
+    uint32_t mFreeCount[NUM_SIZE_CLASSES];
+    Stats mStats;
+    void recycle(SlotHeader* slot);
+};
+
+// msg wrapping a callable moved into a MsgPool slot
+template <typename F>
+struct PooledRunMsg : public LocMsg {
+    mutable F mRunnable;
+    const uintptr_t mCoalesceKey;
+    inline PooledRunMsg(F&& runnable, uintptr_t coalesceKey = 0) :
+        mRunnable(std::move(runnable)), mCoalesceKey(coalesceKey) {}
+    inline PooledRunMsg(const F& runnable, uintptr_t coalesceKey = 0) :
+        mRunnable(runnable), mCoalesceKey(coalesceKey) {}
+    ~PooledRunMsg() = default;
+    inline virtual void proc() const override { mRunnable(); }
+    inline virtual uintptr_t coalesceKey() const override { return mCoalesceKey; }
+    inline static void* operator new(size_t size, MsgPool& pool) { return pool.alloc(size); }
+    inline static void operator delete(void* p, MsgPool&) { MsgPool::release(p); }
+    inline static void operator delete(void* p) { MsgPool::release(p); }
+};
+
+class MsgRing;
+class MsgTaskStats;
+
 class MsgTask {
+public:
+    enum QueueMode {
+        // mutex protected linked list, see msg_q.h
+        QUEUE_MODE_LIST = 0,
+        // bounded lock free ring, see MsgRing.h
+        QUEUE_MODE_RING
+    };
+private:
     const void* mQ;
+    MsgRing* mRing;
+    std::shared_ptr<MsgPool> mPool;
+    std::shared_ptr<MsgTaskStats> mStats;
     LocThread mThread;
 public:
     ~MsgTask() = default;
-    MsgTask(const char* threadName = NULL);
+    // batchDrain: take all the pending msgs off the queue at once, and proc()
+    //             them outside of the queue lock; also enables coalescing
+    //             of msgs, see LocMsg::coalesceKey().
+    MsgTask(const char* threadName = NULL, QueueMode mode = QUEUE_MODE_LIST,
+            bool batchDrain = false);
     void sendMsg(const LocMsg* msg) const;
     void sendMsg(const std::function<void()> runnable) const;
+
+    // Moves the callable into a pooled msg slot, which saves the heap
+    // round trips of the std::function version for large captures.
+    // coalesceKey: see LocMsg::coalesceKey()
+    template <typename F, typename = typename std::enable_if<
+            !std::is_convertible<F, const LocMsg*>::value>::type>
+    inline void sendMsg(F&& runnable, uintptr_t coalesceKey = 0) const {
+        typedef PooledRunMsg<typename std::decay<F>::type> RunMsg;
+        sendMsg(new (*mPool) RunMsg(std::forward<F>(runnable), coalesceKey));
+    }
+
+    inline MsgPool::Stats getPoolStats() const { return mPool->getStats(); }
 };
 
 } //
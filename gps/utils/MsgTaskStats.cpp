@@ -0,0 +1,180 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#define LOG_NDEBUG 0
+#define LOG_TAG "LocSvc_MsgTaskStats"
+
+#include <time.h>
+#include <dlfcn.h>
+#include <cxxabi.h>
+#include <string.h>
+#include <MsgTask.h>
+#include <MsgTaskStats.h>
+#include <LogBuffer.h>
+#include <loc_cfg.h>
+#include <log_util.h>
+
+namespace loc_util {
+
+MsgTaskStats::MsgTaskStats(const char* taskName) :
+    mTaskName(nullptr != taskName ? taskName : "MsgTask"),
+    mRegistered(false), mDepth(0), mHighWater(0) {
+}
+
+bool MsgTaskStats::isEnabled() {
+    return isMsgTaskStatsEnabled();
+}
+
+uint64_t MsgTaskStats::getTimeNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+void MsgTaskStats::onSend(const LocMsg* msg) {
+    if (!mRegistered.exchange(true)) {
+        registerDump();
+    }
+    msg->mSendTimeNs = getTimeNs();
+
+    uint32_t depth = mDepth.fetch_add(1, std::memory_order_relaxed) + 1;
+    uint32_t highWater = mHighWater.load(std::memory_order_relaxed);
+    while (depth > highWater &&
+           !mHighWater.compare_exchange_weak(highWater, depth, std::memory_order_relaxed)) {
+    }
+}
+
+void MsgTaskStats::onRcv(const LocMsg* msg) {
+    // msgs sent before the stats got enabled are not counted in the depth
+    if (0 != msg->mSendTimeNs && mDepth.load(std::memory_order_relaxed) > 0) {
+        mDepth.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void MsgTaskStats::onProc(const LocMsg* msg, uint64_t procStartNs, uint64_t procEndNs) {
+    if (0 == msg->mSendTimeNs) {
+        return;
+    }
+    const void* type = getType(msg);
+    std::lock_guard<std::mutex> guard(mLock);
+    TypeStats& stats = mTypeStats[type];
+    stats.mWait.add((procStartNs - msg->mSendTimeNs) / 1000);
+    stats.mProc.add((procEndNs - procStartNs) / 1000);
+}
+
+void MsgTaskStats::Histogram::add(uint64_t us) {
+    int bucket = 0;
+    while (bucket < NUM_BUCKETS - 1 && us >= (1ULL << bucket)) {
+        bucket++;
+    }
+    mBuckets[bucket]++;
+    mCount++;
+    mTotalUs += us;
+    if (us > mMaxUs) {
+        mMaxUs = us;
+    }
+}
+
+void MsgTaskStats::Histogram::dump(std::stringstream& ss) const {
+    ss << "avg " << (mCount > 0 ? mTotalUs / mCount : 0) << "us max " << mMaxUs << "us [";
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        ss << (i > 0 ? " " : "") << mBuckets[i];
+    }
+    ss << "]";
+}
+
+// Itanium ABI: an object starts with a pointer into the vtable of its
+// dynamic type, which is distinct for each msg type.
+const void* MsgTaskStats::getType(const LocMsg* msg) {
+    const void* vptr;
+    memcpy(&vptr, msg, sizeof(vptr));
+    return vptr;
+}
+
+std::string MsgTaskStats::getTypeName(const void* type) {
+    Dl_info info = {};
+    char name[256];
+    if (0 == dladdr(type, &info) || nullptr == info.dli_fname) {
+        snprintf(name, sizeof(name), "%p", type);
+        return name;
+    }
+    if (nullptr != info.dli_sname) {
+        int status = -1;
+        char* demangled = abi::__cxa_demangle(info.dli_sname, nullptr, nullptr, &status);
+        if (0 == status && nullptr != demangled) {
+            std::string typeName(demangled);
+            free(demangled);
+            static const char vtablePrefix[] = "vtable for ";
+            if (0 == typeName.compare(0, sizeof(vtablePrefix) - 1, vtablePrefix)) {
+                typeName.erase(0, sizeof(vtablePrefix) - 1);
+            }
+            return typeName;
+        }
+    }
+    // vtables of function local msg types are not exported
+    const char* lib = strrchr(info.dli_fname, '/');
+    snprintf(name, sizeof(name), "%s+%#zx", nullptr != lib ? lib + 1 : info.dli_fname,
+             (size_t)((const char*)type - (const char*)info.dli_fbase));
+    return name;
+}
+
+void MsgTaskStats::dump(std::function<void(std::stringstream&)>& log) {
+    std::stringstream header;
+    header << "MsgTask " << mTaskName << ": depth " << mDepth.load()
+           << ", high water " << mHighWater.load() << std::endl;
+    log(header);
+
+    std::unordered_map<const void*, TypeStats> typeStats;
+    {
+        std::lock_guard<std::mutex> guard(mLock);
+        typeStats = mTypeStats;
+    }
+    for (auto& item : typeStats) {
+        std::stringstream line;
+        line << "  " << getTypeName(item.first) << ": count " << item.second.mWait.mCount
+             << std::endl << "    wait ";
+        item.second.mWait.dump(line);
+        line << std::endl << "    proc ";
+        item.second.mProc.dump(line);
+        line << std::endl;
+        log(line);
+    }
+}
+
+void MsgTaskStats::registerDump() {
+    std::weak_ptr<MsgTaskStats> stats(shared_from_this());
+    LogBuffer::getInstance()->registerDumpCb(
+            [stats] (std::function<void(std::stringstream&)>& log) {
+        std::shared_ptr<MsgTaskStats> sp = stats.lock();
+        if (nullptr != sp) {
+            sp->dump(log);
+        }
+    });
+}
+
+} // namespace loc_util
@@ -0,0 +1,98 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef __MSG_TASK_STATS__
+#define __MSG_TASK_STATS__
+
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <sstream>
+#include <memory>
+#include <functional>
+#include <unordered_map>
+
+namespace loc_util {
+
+struct LocMsg;
+
+// Queue depth, queue wait and proc() time statistics of a MsgTask, kept per
+// msg type when MSG_TASK_STATS_ENABLED is set in gps.conf. The stats are
+// appended to the LogBuffer dumps.
+// Vendor modules are built without RTTI, so msg types are told apart by
+// their vtable, and named through dladdr() at dump time.
+class MsgTaskStats : public std::enable_shared_from_this<MsgTaskStats> {
+public:
+    // log2 buckets of microseconds, i.e. [0, 1), [1, 2), [2, 4) ... [2^18, inf)
+    static const int NUM_BUCKETS = 20;
+
+    MsgTaskStats(const char* taskName);
+    ~MsgTaskStats() = default;
+
+    static bool isEnabled();
+    static uint64_t getTimeNs();
+
+    // stamps msg with the send time and counts it in the queue depth
+    void onSend(const LocMsg* msg);
+    // msg taken off the queue
+    void onRcv(const LocMsg* msg);
+    // msg proc()'ed from procStartNs to procEndNs
+    void onProc(const LocMsg* msg, uint64_t procStartNs, uint64_t procEndNs);
+
+    void dump(std::function<void(std::stringstream&)>& log);
+
+private:
+    struct Histogram {
+        uint64_t mCount;
+        uint64_t mTotalUs;
+        uint64_t mMaxUs;
+        uint32_t mBuckets[NUM_BUCKETS];
+        void add(uint64_t us);
+        void dump(std::stringstream& ss) const;
+    };
+    struct TypeStats {
+        Histogram mWait;
+        Histogram mProc;
+    };
+
+    const std::string mTaskName;
+    std::atomic<bool> mRegistered;
+    std::atomic<uint32_t> mDepth;
+    std::atomic<uint32_t> mHighWater;
+    std::mutex mLock;
+    std::unordered_map<const void*, TypeStats> mTypeStats;
+
+    void registerDump();
+    static const void* getType(const LocMsg* msg);
+    static std::string getTypeName(const void* type);
+};
+
+} // namespace loc_util
+
+#endif //__MSG_TASK_STATS__
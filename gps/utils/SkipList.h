@@ -31,6 +31,7 @@
 #define LOC_SKIP_LIST_H
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <list>
 #include <vector>
 #include <iostream>
@@ -40,104 +41,169 @@ using namespace std;
 
 namespace loc_util {
 
-template <typename T,
-         template<typename elem, typename Allocator = std::allocator<elem>> class container = list>
-class SkipNode {
-public:
-    typedef typename container<SkipNode<T, container>>::iterator NodeIterator;
-
-    int mLevel;
-    T mData;
-    NodeIterator mNextInLevel;
-
-    SkipNode(int level, T& data): mLevel(level), mData(data) {}
-};
-
+/* Entries of all the levels in the order they were appended, kept in one
+   circular array per level. Appending and popping touch only the ends of
+   the level's array, and the levels are merged by append order on dump.
+   The arrays are preallocated from the per level size limits; appending to
+   a full level evicts its oldest entry, so the list never allocates. */
 template <typename T>
 class SkipList {
-    using NodeIterator = typename SkipNode<T>::NodeIterator;
-private:
-    list<SkipNode<T>> mMainList;
-    vector<NodeIterator> mHeadVec;
-    vector<NodeIterator> mTailVec;
+    struct SkipNode {
+        uint64_t mSerial;
+        T mData;
+    };
+    struct LevelRing {
+        vector<SkipNode> mNodes;
+        size_t mHead;
+        size_t mSize;
+        inline SkipNode& at(size_t i) { return mNodes[(mHead + i) % mNodes.size()]; }
+        inline const SkipNode& at(size_t i) const { return mNodes[(mHead + i) % mNodes.size()]; }
+    };
+    vector<LevelRing> mLevels;
+    uint64_t mNextSerial;
+    int mSize;
+
+    int oldestLevel(const vector<size_t>& cursors) const;
 public:
-    SkipList(int totalLevels);
+    SkipList(int totalLevels, size_t capacityPerLevel);
+    // capacities: the maximum number of entries of each level
+    SkipList(const vector<size_t>& capacities);
+    // evicts the oldest entry of level if it is full
     void append(T& data, int level);
     void pop(int level);
     void pop();
     T front(int level);
     int size();
+    int size(int level);
     void flush();
     list<pair<T, int>> dump();
     list<pair<T, int>> dump(int level);
+    // Visit the entries in place, fn(const T& data, int level)
+    template <typename F> void forEach(F fn) const;
+    template <typename F> void forEach(int level, F fn) const;
 };
 
 template <typename T>
-SkipList<T>::SkipList(int totalLevels): mHeadVec(totalLevels, mMainList.end()),
-        mTailVec(totalLevels, mMainList.end()) {}
+SkipList<T>::SkipList(int totalLevels, size_t capacityPerLevel):
+        SkipList(vector<size_t>(totalLevels, capacityPerLevel)) {
+}
+
+template <typename T>
+SkipList<T>::SkipList(const vector<size_t>& capacities):
+        mLevels(capacities.size()), mNextSerial(0), mSize(0) {
+    for (size_t i = 0; i < capacities.size(); i++) {
+        mLevels[i].mNodes.resize(capacities[i]);
+        mLevels[i].mHead = 0;
+        mLevels[i].mSize = 0;
+    }
+}
 
 template <typename T>
 void SkipList<T>::append(T& data, int level) {
-    if ( level < 0 || level >= mHeadVec.size()) {
+    if ( level < 0 || level >= (int)mLevels.size() || mLevels[level].mNodes.empty()) {
         return;
     }
 
-    SkipNode<T> node(level, data);
-    node.mNextInLevel = mMainList.end();
-    mMainList.push_back(node);
-    auto iter = --mMainList.end();
-    if (mHeadVec[level] == mMainList.end()) {
-        mHeadVec[level] = iter;
-    } else {
-        (*mTailVec[level]).mNextInLevel = iter;
+    LevelRing& ring = mLevels[level];
+    if (ring.mSize == ring.mNodes.size()) {
+        pop(level);
     }
-    mTailVec[level] = iter;
+    SkipNode& node = ring.at(ring.mSize++);
+    node.mSerial = mNextSerial++;
+    node.mData = data;
+    mSize++;
 }
 
 template <typename T>
 void SkipList<T>::pop(int level) {
-    if (mHeadVec[level] == mMainList.end()) {
+    if (level < 0 || level >= (int)mLevels.size() || 0 == mLevels[level].mSize) {
         return;
     }
 
-    if ((*mHeadVec[level]).mNextInLevel == mMainList.end()) {
-        mTailVec[level] = mMainList.end();
-    }
+    LevelRing& ring = mLevels[level];
+    // release what the entry holds, the slot itself is reused
+    ring.at(0).mData = T();
+    ring.mHead = (ring.mHead + 1) % ring.mNodes.size();
+    ring.mSize--;
+    mSize--;
+}
 
-    auto tmp_iter = (*mHeadVec[level]).mNextInLevel;
-    mMainList.erase(mHeadVec[level]);
-    mHeadVec[level] = tmp_iter;
+template <typename T>
+int SkipList<T>::oldestLevel(const vector<size_t>& cursors) const {
+    int oldest = -1;
+    for (int i = 0; i < (int)mLevels.size(); i++) {
+        if (cursors[i] < mLevels[i].mSize && (-1 == oldest ||
+                mLevels[i].at(cursors[i]).mSerial < mLevels[oldest].at(cursors[oldest]).mSerial)) {
+            oldest = i;
+        }
+    }
+    return oldest;
 }
 
 template <typename T>
 void SkipList<T>::pop() {
-    pop(mMainList.front().mLevel);
+    pop(oldestLevel(vector<size_t>(mLevels.size(), 0)));
 }
 
 template <typename T>
 T SkipList<T>::front(int level) {
-    return (*mHeadVec[level]).mData;
+    if (level < 0 || level >= (int)mLevels.size() || 0 == mLevels[level].mSize) {
+        return T();
+    }
+    return mLevels[level].at(0).mData;
 }
 
 template <typename T>
 int SkipList<T>::size() {
-    return mMainList.size();
+    return mSize;
+}
+
+template <typename T>
+int SkipList<T>::size(int level) {
+    if (level < 0 || level >= (int)mLevels.size()) {
+        return 0;
+    }
+    return mLevels[level].mSize;
 }
 
 template <typename T>
 void SkipList<T>::flush() {
-    mMainList.clear();
-    for (int i = 0; i < mHeadVec.size(); i++) {
-        mHeadVec[i] = mMainList.end();
-        mTailVec[i] = mMainList.end();
+    for (auto& ring : mLevels) {
+        while (ring.mSize > 0) {
+            ring.at(--ring.mSize).mData = T();
+        }
+        ring.mHead = 0;
+    }
+    mSize = 0;
+}
+
+template <typename T>
+template <typename F>
+void SkipList<T>::forEach(F fn) const {
+    vector<size_t> cursors(mLevels.size(), 0);
+    int level;
+    while (-1 != (level = oldestLevel(cursors))) {
+        fn(mLevels[level].at(cursors[level]++).mData, level);
+    }
+}
+
+template <typename T>
+template <typename F>
+void SkipList<T>::forEach(int level, F fn) const {
+    if (level < 0 || level >= (int)mLevels.size()) {
+        return;
+    }
+    const LevelRing& ring = mLevels[level];
+    for (size_t i = 0; i < ring.mSize; i++) {
+        fn(ring.at(i).mData, level);
     }
 }
 
 template <typename T>
 list<pair<T, int>> SkipList<T>::dump() {
     list<pair<T, int>> li;
-    for_each(mMainList.begin(), mMainList.end(), [&](SkipNode<T> &item) {
-        li.push_back(make_pair(item.mData, item.mLevel));
+    forEach([&](const T& data, int level) {
+        li.push_back(make_pair(data, level));
     });
     return li;
 }
@@ -145,11 +211,9 @@ list<pair<T, int>> SkipList<T>::dump() {
 template <typename T>
 list<pair<T, int>> SkipList<T>::dump(int level) {
     list<pair<T, int>> li;
-    auto head = mHeadVec[level];
-    while (head != mMainList.end()) {
-        li.push_back(make_pair((*head).mData, (*head).mLevel));
-        head = (*head).mNextInLevel;
-    }
+    forEach(level, [&](const T& data, int level) {
+        li.push_back(make_pair(data, level));
+    });
     return li;
 }
 
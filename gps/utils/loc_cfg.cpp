@@ -39,6 +39,13 @@
 #include <time.h>
 #include <grp.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
 #include <loc_cfg.h>
 #include <loc_pla.h>
 #include <loc_target.h>
@@ -60,6 +67,7 @@ static uint32_t TIMESTAMP = 0;
 static uint32_t DATUM_TYPE = 0;
 static bool sVendorEnhanced = true;
 static uint32_t sLogBufferEnabled = 0;
+static uint32_t sMsgTaskStatsEnabled = 0;
 
 /* Parameter spec table */
 static const loc_param_s_type loc_param_table[] =
@@ -68,6 +76,7 @@ static const loc_param_s_type loc_param_table[] =
     {"TIMESTAMP",               &TIMESTAMP,          NULL, 'n'},
     {"DATUM_TYPE",              &DATUM_TYPE,         NULL, 'n'},
     {"LOG_BUFFER_ENABLED",      &sLogBufferEnabled,  NULL, 'n'},
+    {"MSG_TASK_STATS_ENABLED",  &sMsgTaskStatsEnabled, NULL, 'n'},
 };
 static const int loc_param_num = sizeof(loc_param_table) / sizeof(loc_param_s_type);
 
@@ -99,6 +108,9 @@ bool isVendorEnhanced() {
 void setVendorEnhanced(bool vendorEnhanced) {
     sVendorEnhanced = vendorEnhanced;
 }
+bool isMsgTaskStatsEnabled() {
+    return 0 != sMsgTaskStatsEnabled;
+}
 
 bool isXtraDaemonEnabled() {
     bool enabled = property_get_bool("persist.sys.xtra-daemon.enabled", true);
@@ -218,6 +230,63 @@ int loc_set_config_entry(const loc_param_s_type* config_entry,
     return ret;
 }
 
+/*===========================================================================
+FUNCTION loc_parse_conf_item
+
+DESCRIPTION
+   Splits a line of configuration item into its name and value, and parses
+   the value as a number.
+
+PARAMETERS:
+   input_buf : buffer contanis config item, tokenized in place
+   config_value: parsed name and values, pointing into input_buf
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   true if input_buf holds a name and a value
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static bool loc_parse_conf_item(char* input_buf, loc_param_v_type* config_value)
+{
+    char *lasts;
+    memset(config_value, 0, sizeof(*config_value));
+
+    /* Separate variable and value */
+    config_value->param_name = strtok_r(input_buf, "=", &lasts);
+    /* skip lines that do not contain "=" */
+    if (NULL == config_value->param_name) {
+        return false;
+    }
+    config_value->param_str_value = strtok_r(NULL, "\0", &lasts);
+    /* skip lines that do not contain two operands */
+    if (NULL == config_value->param_str_value) {
+        return false;
+    }
+
+    /* Trim leading and trailing spaces */
+    loc_util_trim_space(config_value->param_name);
+    loc_util_trim_space(config_value->param_str_value);
+
+    /* Parse numerical value */
+    if ((strlen(config_value->param_str_value) >=3) &&
+        (config_value->param_str_value[0] == '0') &&
+        (tolower(config_value->param_str_value[1]) == 'x'))
+    {
+        /* hex */
+        config_value->param_int_value = (int) strtol(&config_value->param_str_value[2],
+                                                     (char**) NULL, 16);
+    }
+    else {
+        config_value->param_double_value = (double) atof(config_value->param_str_value); /* float */
+        config_value->param_int_value = atoi(config_value->param_str_value); /* dec */
+    }
+    return true;
+}
+
 /*===========================================================================
 FUNCTION loc_fill_conf_item
 
@@ -247,41 +316,12 @@ int loc_fill_conf_item(char* input_buf,
     int ret = 0;
 
     if (input_buf && config_table) {
-        char *lasts;
         loc_param_v_type config_value;
-        memset(&config_value, 0, sizeof(config_value));
-
-        /* Separate variable and value */
-        config_value.param_name = strtok_r(input_buf, "=", &lasts);
-        /* skip lines that do not contain "=" */
-        if (config_value.param_name) {
-            config_value.param_str_value = strtok_r(NULL, "\0", &lasts);
-
-            /* skip lines that do not contain two operands */
-            if (config_value.param_str_value) {
-                /* Trim leading and trailing spaces */
-                loc_util_trim_space(config_value.param_name);
-                loc_util_trim_space(config_value.param_str_value);
-
-                /* Parse numerical value */
-                if ((strlen(config_value.param_str_value) >=3) &&
-                    (config_value.param_str_value[0] == '0') &&
-                    (tolower(config_value.param_str_value[1]) == 'x'))
-                {
-                    /* hex */
-                    config_value.param_int_value = (int) strtol(&config_value.param_str_value[2],
-                                                                (char**) NULL, 16);
-                }
-                else {
-                    config_value.param_double_value = (double) atof(config_value.param_str_value); /* float */
-                    config_value.param_int_value = atoi(config_value.param_str_value); /* dec */
-                }
-
-                for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
-                {
-                    if(!loc_set_config_entry(&config_table[i], &config_value, string_len)) {
-                        ret += 1;
-                    }
+        if (loc_parse_conf_item(input_buf, &config_value)) {
+            for(uint32_t i = 0; NULL != config_table && i < table_length; i++)
+            {
+                if(!loc_set_config_entry(&config_table[i], &config_value, string_len)) {
+                    ret += 1;
                 }
             }
         }
@@ -418,6 +458,220 @@ int loc_update_conf_long(const char* conf_data, int32_t length,
     return ret;
 }
 
+/*=============================================================================
+ *
+ *   Cache of the parsed configuration files
+ *
+ *============================================================================*/
+typedef struct {
+    std::string str_value;
+    int int_value;
+    double double_value;
+} loc_conf_value;
+
+typedef struct {
+    dev_t dev;
+    ino_t ino;
+    off_t size;
+    struct timespec mtime;
+    struct timespec ctime;
+    std::unordered_map<std::string, loc_conf_value> values;
+} loc_conf_file;
+
+typedef std::unordered_map<std::string, std::shared_ptr<const loc_conf_file>> loc_conf_cache;
+
+/* only guards sConfCache; nothing that may log, and so read a configuration
+   file again to set up LogBuffer, is to be called with it held */
+static std::mutex sConfCacheLock;
+/* never freed, loc_read_conf_long() may be called from static destructors */
+static loc_conf_cache* sConfCache = new loc_conf_cache();
+
+static inline bool loc_conf_same_time(const struct timespec& left, const struct timespec& right)
+{
+    return left.tv_sec == right.tv_sec && left.tv_nsec == right.tv_nsec;
+}
+
+static inline bool loc_conf_same_file(const loc_conf_file& conf, const struct stat& st)
+{
+    return conf.dev == st.st_dev && conf.ino == st.st_ino && conf.size == st.st_size &&
+           loc_conf_same_time(conf.mtime, st.st_mtim) &&
+           loc_conf_same_time(conf.ctime, st.st_ctim);
+}
+
+/*===========================================================================
+FUNCTION loc_conf_parse
+
+DESCRIPTION
+   mmaps a configuration file and parses it into a hashed name to value
+   index. Lines are parsed the way loc_fill_conf_item() does, and the last
+   one of the lines with the same name wins.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   parsed file, or NULL if it could not be read
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static std::shared_ptr<const loc_conf_file> loc_conf_parse(const char* conf_file_name)
+{
+    struct stat st;
+    int fd = open(conf_file_name, O_RDONLY | O_CLOEXEC);
+    if (fd < 0 || 0 != fstat(fd, &st)) {
+        LOC_LOGE("%s: failed to open %s, errno %d", __FUNCTION__, conf_file_name, errno);
+        if (fd >= 0) {
+            close(fd);
+        }
+        return NULL;
+    }
+
+    std::shared_ptr<loc_conf_file> conf = std::make_shared<loc_conf_file>();
+    conf->dev = st.st_dev;
+    conf->ino = st.st_ino;
+    conf->size = st.st_size;
+    conf->mtime = st.st_mtim;
+    conf->ctime = st.st_ctim;
+    if (st.st_size > 0) {
+        void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (MAP_FAILED == data) {
+            LOC_LOGE("%s: failed to mmap %s, errno %d", __FUNCTION__, conf_file_name, errno);
+            close(fd);
+            return NULL;
+        }
+        const char* line = (const char*)data;
+        const char* end = line + st.st_size;
+        std::string input_buf;
+        loc_param_v_type config_value;
+        while (line < end) {
+            const char* eol = (const char*)memchr(line, '\n', end - line);
+            eol = (NULL == eol) ? end : eol + 1;
+            // with the newline, as fgets() gives it, so "NAME=" is an empty value
+            input_buf.assign(line, eol - line);
+            if (loc_parse_conf_item(&input_buf[0], &config_value)) {
+                loc_conf_value& value = conf->values[config_value.param_name];
+                value.str_value = config_value.param_str_value;
+                value.int_value = config_value.param_int_value;
+                value.double_value = config_value.param_double_value;
+            }
+            line = eol;
+        }
+        munmap(data, st.st_size);
+    }
+    close(fd);
+    return conf;
+}
+
+/*===========================================================================
+FUNCTION loc_conf_cache_load
+
+DESCRIPTION
+   Gets the parsed content of a configuration file from the cache. The file
+   is parsed the first time, and again whenever it has been modified since,
+   as told by its mtime, ctime, size and inode.
+   sConfCacheLock is only held to look up and to store the parsed file; the
+   returned reference keeps it alive after it is replaced in the cache.
+
+PARAMETERS:
+   conf_file_name: configuration file to read
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   parsed file, or NULL if it could not be read
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static std::shared_ptr<const loc_conf_file> loc_conf_cache_load(const char* conf_file_name)
+{
+    struct stat st;
+    std::string name(conf_file_name);
+
+    if (0 != stat(conf_file_name, &st)) {
+        std::lock_guard<std::mutex> guard(sConfCacheLock);
+        sConfCache->erase(name);
+        return NULL;
+    }
+    {
+        std::lock_guard<std::mutex> guard(sConfCacheLock);
+        auto it = sConfCache->find(name);
+        if (it != sConfCache->end() && loc_conf_same_file(*it->second, st)) {
+            return it->second;
+        }
+    }
+
+    /* threads missing the cache at once each parse the file, the last one is kept */
+    std::shared_ptr<const loc_conf_file> conf = loc_conf_parse(conf_file_name);
+    std::lock_guard<std::mutex> guard(sConfCacheLock);
+    if (NULL == conf) {
+        sConfCache->erase(name);
+    } else {
+        (*sConfCache)[name] = conf;
+    }
+    return conf;
+}
+
+/*===========================================================================
+FUNCTION loc_fill_conf_table
+
+DESCRIPTION
+   Sets the values of the passed in configuration table from a parsed
+   configuration file, with a hash lookup per table entry.
+
+PARAMETERS:
+   conf: parsed configuration file
+   config_table: table definition of strings to places to store information
+   table_length: length of the configuration table
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Number of records in the config_table filled
+
+SIDE EFFECTS
+   N/A
+===========================================================================*/
+static int loc_fill_conf_table(const loc_conf_file* conf, const loc_param_s_type* config_table,
+                               uint32_t table_length, uint16_t string_len)
+{
+    int ret = 0;
+
+    /* Clear all validity bits */
+    for(uint32_t i = 0; i < table_length; i++)
+    {
+        if(NULL != config_table[i].param_set)
+        {
+            *(config_table[i].param_set) = 0;
+        }
+    }
+
+    for(uint32_t i = 0; i < table_length; i++)
+    {
+        if (NULL == config_table[i].param_name) {
+            continue;
+        }
+        auto it = conf->values.find(config_table[i].param_name);
+        if (it != conf->values.end()) {
+            loc_param_v_type config_value;
+            config_value.param_name = (char*)it->first.c_str();
+            config_value.param_str_value = (char*)it->second.str_value.c_str();
+            config_value.param_int_value = it->second.int_value;
+            config_value.param_double_value = it->second.double_value;
+            if (!loc_set_config_entry(&config_table[i], &config_value, string_len)) {
+                ret += 1;
+            }
+        }
+    }
+    return ret;
+}
+
 /*===========================================================================
 FUNCTION loc_read_conf_long
 
@@ -443,18 +697,18 @@ SIDE EFFECTS
 void loc_read_conf_long(const char* conf_file_name, const loc_param_s_type* config_table,
                         uint32_t table_length, uint16_t string_len)
 {
-    FILE *conf_fp = NULL;
-
     log_buffer_init(false);
-    if((conf_fp = fopen(conf_file_name, "r")) != NULL)
+    if (NULL != conf_file_name)
     {
-        LOC_LOGD("%s: using %s", __FUNCTION__, conf_file_name);
-        if(table_length && config_table) {
-            loc_read_conf_r_long(conf_fp, config_table, table_length, string_len);
-            rewind(conf_fp);
+        std::shared_ptr<const loc_conf_file> conf = loc_conf_cache_load(conf_file_name);
+        if (NULL != conf)
+        {
+            LOC_LOGD("%s: using %s", __FUNCTION__, conf_file_name);
+            if(table_length && config_table) {
+                loc_fill_conf_table(conf.get(), config_table, table_length, string_len);
+            }
+            loc_fill_conf_table(conf.get(), loc_param_table, loc_param_num, string_len);
         }
-        loc_read_conf_r_long(conf_fp, loc_param_table, loc_param_num, string_len);
-        fclose(conf_fp);
     }
     /* Initialize logging mechanism with parsed data */
     loc_logger_init(DEBUG_LEVEL, TIMESTAMP);
@@ -119,6 +119,7 @@ extern "C" {
  *============================================================================*/
 bool isVendorEnhanced();
 void setVendorEnhanced(bool vendorEnhanced);
+bool isMsgTaskStatsEnabled();
 void loc_read_conf_long(const char* conf_file_name,
                         const loc_param_s_type* config_table,
                         uint32_t table_length, uint16_t string_len);
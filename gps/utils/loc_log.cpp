@@ -229,6 +229,26 @@ void log_buffer_insert(char *str, unsigned long buf_size, int level)
     loc_util::LogBuffer::getInstance()->append(ss, level, elapsedTime);
 }
 
+/*===========================================================================
+
+FUNCTION log_buffer_insertf
+
+DESCRIPTION
+   Insert a log with specific level to the log buffer, the line is formatted
+   right away, its time / pid / tid / tag prefix only on dump.
+
+RETURN VALUE
+   N/A
+
+===========================================================================*/
+void log_buffer_insertf(int level, const char* tag, const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    loc_util::LogBuffer::getInstance()->appendv(level, tag, format, args);
+    va_end(args);
+}
+
 void log_tag_level_map_init()
 {
     if (tag_map_inited) {
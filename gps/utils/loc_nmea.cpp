@@ -34,6 +34,8 @@
 #include <log_util.h>
 #include <loc_pla.h>
 #include <loc_cfg.h>
+#include <stdio.h>
+#include <string.h>
 
 #define GLONASS_SV_ID_OFFSET 64
 #define SBAS_SV_ID_OFFSET    (87)
@@ -152,6 +154,163 @@ typedef struct loc_sv_cache_info_s
     float vdop;
 } loc_sv_cache_info;
 
+/*===========================================================================
+CLASS    LocNmeaWriter
+
+DESCRIPTION
+   Appends NMEA fields to a sentence buffer without going through snprintf.
+   Numbers are formatted in integer / fixed point arithmetic, producing the
+   same text printf would for the conversions NMEA uses (%d, %0Nd, %X,
+   %.Nf, %0W.Nf). Like snprintf, it never writes past the buffer, keeps it
+   NUL terminated, and length() returns the length the text would have had,
+   so callers keep their existing overflow checks.
+
+===========================================================================*/
+class LocNmeaWriter
+{
+    char* const mBuf;
+    const int mSize;
+    const int mCapacity;    // chars that fit, excluding the NUL
+    int mLength;
+
+    inline void put(char c)
+    {
+        if (mLength < mCapacity) {
+            mBuf[mLength] = c;
+        }
+        mLength++;
+    }
+
+    // digits of value, zero padded to at least minDigits
+    inline void putDigits(uint64_t value, int minDigits)
+    {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = '0' + value % 10;
+            value /= 10;
+        } while (value > 0);
+        for (; minDigits > n; minDigits--) {
+            put('0');
+        }
+        while (n > 0) {
+            put(digits[--n]);
+        }
+    }
+
+    LocNmeaWriter& printfFixed(double value, int decimals, int width)
+    {
+        char buf[400];
+        snprintf(buf, sizeof(buf), "%0*.*f", width, decimals, value);
+        return str(buf);
+    }
+
+public:
+    inline LocNmeaWriter(char* buf, int size) :
+        mBuf(buf), mSize(size), mCapacity(size > 0 ? size - 1 : 0), mLength(0)
+    {
+        if (size > 0) {
+            *mBuf = '\0';
+        }
+    }
+
+    // length of the text appended, as snprintf would return it
+    inline int length()
+    {
+        if (mSize > 0) {
+            mBuf[mLength < mCapacity ? mLength : mCapacity] = '\0';
+        }
+        return mLength;
+    }
+
+    inline LocNmeaWriter& chr(char c)
+    {
+        put(c);
+        return *this;
+    }
+
+    inline LocNmeaWriter& str(const char* text)
+    {
+        while (*text) {
+            put(*text++);
+        }
+        return *this;
+    }
+
+    // %0<minDigits>d
+    inline LocNmeaWriter& dec(int64_t value, int minDigits = 1)
+    {
+        if (value < 0) {
+            put('-');
+            // printf counts the sign in the field width
+            putDigits(-(uint64_t)value, minDigits - 1);
+        } else {
+            putDigits(value, minDigits);
+        }
+        return *this;
+    }
+
+    // %0<minDigits>X
+    inline LocNmeaWriter& hex(uint32_t value, int minDigits = 1)
+    {
+        static const char hexDigits[] = "0123456789ABCDEF";
+        char digits[8];
+        int n = 0;
+        do {
+            digits[n++] = hexDigits[value & 0xF];
+            value >>= 4;
+        } while (value > 0);
+        for (; minDigits > n; minDigits--) {
+            put('0');
+        }
+        while (n > 0) {
+            put(digits[--n]);
+        }
+        return *this;
+    }
+
+    // %.<decimals>f, or %0<width>.<decimals>f if width is given
+    LocNmeaWriter& fixed(double value, int decimals, int width = 0)
+    {
+        static const double scales[] = {1, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+        if (!isfinite(value) || decimals < 0 || decimals > 9) {
+            return printfFixed(value, decimals, width);
+        }
+        bool negative = signbit(value);
+        double scaled = fabs(value) * scales[decimals];
+        // printf rounds the exact binary value half to even. The product
+        // above is within half an ulp of the exact one, so away from a
+        // tie it rounds the same way; close to one, or out of the range
+        // of exact integers, leave it to printf.
+        if (scaled >= 4503599627370496.0) { // 2^52
+            return printfFixed(value, decimals, width);
+        }
+        double whole = floor(scaled);
+        double fraction = scaled - whole;
+        if (fabs(fraction - 0.5) <= scaled * 2.3e-16 + 1e-300) {
+            return printfFixed(value, decimals, width);
+        }
+        uint64_t rounded = (uint64_t)whole + (fraction > 0.5 ? 1 : 0);
+        uint64_t scale = (uint64_t)scales[decimals];
+        uint64_t integer = rounded / scale;
+
+        int integerDigits = 1;
+        for (uint64_t v = integer; v >= 10; v /= 10) {
+            integerDigits++;
+        }
+        int textLength = (negative ? 1 : 0) + integerDigits + (decimals > 0 ? decimals + 1 : 0);
+        if (negative) {
+            put('-');
+        }
+        putDigits(integer, integerDigits + (width > textLength ? width - textLength : 0));
+        if (decimals > 0) {
+            put('.');
+            putDigits(rounded % scale, decimals);
+        }
+        return *this;
+    }
+};
+
 /*===========================================================================
 FUNCTION    convert_Lla_to_Ecef
 
@@ -569,29 +728,115 @@ SIDE EFFECTS
 ===========================================================================*/
 static int loc_nmea_put_checksum(char *pNmea, int maxSize, bool isTagBlock)
 {
+    uint64_t checksum64 = 0;
     uint8_t checksum = 0;
     int length = 0;
-    int checksumLength = 0;
+    int i = 0;
     if(NULL == pNmea)
         return 0;
 
     pNmea++; //skip the $ or / for Tag Block
-    while (*pNmea != '\0')
+    length = strlen(pNmea);
+    // XOR is lane independent, so fold the sentence a word at a time
+    // and then fold the bytes of the word together
+    for (; i + (int)sizeof(checksum64) <= length; i += sizeof(checksum64))
+    {
+        uint64_t chunk;
+        memcpy(&chunk, pNmea + i, sizeof(chunk));
+        checksum64 ^= chunk;
+    }
+    checksum64 ^= checksum64 >> 32;
+    checksum64 ^= checksum64 >> 16;
+    checksum64 ^= checksum64 >> 8;
+    checksum = (uint8_t)checksum64;
+    for (; i < length; i++)
     {
-        checksum ^= *pNmea++;
-        length++;
+        checksum ^= pNmea[i];
     }
+    pNmea += length;
 
+    LocNmeaWriter writer(pNmea, maxSize - length - 1);
     if (isTagBlock) {
         // length now contains tag block sentence string length not including / sign.
-        checksumLength = snprintf(pNmea, (maxSize-length-1), "*%02X\\", checksum);
+        writer.chr('*').hex(checksum, 2).chr('\\');
     } else {
         // length now contains nmea sentence string length not including $ sign.
-        checksumLength = snprintf(pNmea, (maxSize-length-1), "*%02X\r\n", checksum);
+        writer.chr('*').hex(checksum, 2).str("\r\n");
     }
     // total length of nmea sentence is length of nmea sentence inc $ sign plus
     // length of checksum (+1 is to cover the $ character in the length).
-    return (length + checksumLength + 1);
+    return (length + writer.length() + 1);
+}
+
+/*===========================================================================
+   GSA and GSV sentences only change when the SVs in use / in view do, which
+   at 1-10 Hz is far less often than once per epoch. Each generator keeps the
+   inputs its last sentences were built from, per constellation and signal,
+   and hands out the same strings while they are unchanged. The caches are
+   per thread, like the sentence buffers the callers pass in.
+===========================================================================*/
+typedef struct loc_nmea_gsa_cache_s
+{
+    uint32_t svTypeMask;
+    uint32_t systemId;
+    char talker[3];
+    char fixType;
+    bool hasDop;
+    float pdop;
+    float hdop;
+    float vdop;
+    uint32_t svUsedCount;
+    uint32_t svUsedList[MAX_SATELLITES_IN_USE];
+    std::string sentence;
+} loc_nmea_gsa_cache;
+
+typedef struct loc_nmea_gsv_row_s
+{
+    int32_t svId;       // after the constellation offset is taken off
+    int32_t elevation;
+    int32_t azimuth;
+    int32_t cN0;
+    bool hasSvId;       // false for GLONASS SVs with an unknown slot
+    bool hasCN0;
+
+    inline bool operator==(const loc_nmea_gsv_row_s& other) const
+    {
+        return svId == other.svId && elevation == other.elevation &&
+                azimuth == other.azimuth && cN0 == other.cN0 &&
+                hasSvId == other.hasSvId && hasCN0 == other.hasCN0;
+    }
+} loc_nmea_gsv_row;
+
+typedef struct loc_nmea_gsv_cache_s
+{
+    uint32_t svTypeMask;
+    uint32_t signalId;
+    char talker[3];
+    int svCount;
+    std::vector<loc_nmea_gsv_row> rows;
+    std::vector<std::string> sentences;
+} loc_nmea_gsv_cache;
+
+static thread_local std::vector<loc_nmea_gsa_cache> sGsaCache;
+static thread_local std::vector<loc_nmea_gsv_cache> sGsvCache;
+static thread_local std::vector<loc_nmea_gsv_row> sGsvRows;
+
+/* Forget all that a cache entry was built from, but its key, when its
+   sentences could not be built; an empty talker matches no input. */
+static void loc_nmea_reset_gsa_cache(loc_nmea_gsa_cache& cache)
+{
+    loc_nmea_gsa_cache empty = {};
+    empty.svTypeMask = cache.svTypeMask;
+    empty.systemId = cache.systemId;
+    cache = std::move(empty);
+}
+
+static void loc_nmea_reset_gsv_cache(loc_nmea_gsv_cache& cache)
+{
+    loc_nmea_gsv_cache empty = {};
+    empty.svTypeMask = cache.svTypeMask;
+    empty.signalId = cache.signalId;
+    cache = std::move(empty);
 }
 
 /*===========================================================================
@@ -641,6 +886,8 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
     static uint32_t code = 1;
 
     char fixType = '\0';
+    bool hasDop = (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP);
+    loc_nmea_gsa_cache* cache = nullptr;
 
     const char* talker = sv_meta_p->talker;
     uint32_t svIdOffset = sv_meta_p->svIdOffset;
@@ -664,12 +911,60 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         sentenceCount = svUsedCount / 12 + (svUsedCount % 12 != 0);
         svNumber = 1;
     }
+
+    if (sv_meta_p->totalSvUsedCount == 0)
+        fixType = '1'; // no fix
+    else if (sv_meta_p->totalSvUsedCount <= 3)
+        fixType = '2'; // 2D fix
+    else
+        fixType = '3'; // 3D fix
+
+    // Tag block groups carry a running group code, so only a single
+    // sentence (12 SVs or fewer, or no grouping) can be reused as is
+    if (svUsedCount <= 12 || !isTagBlockGroupingEnabled) {
+        uint32_t listedCount = (svUsedCount < 12) ? svUsedCount : 12;
+        for (auto& entry : sGsaCache) {
+            if (entry.svTypeMask == sv_meta_p->svTypeMask &&
+                    entry.systemId == sv_meta_p->systemId) {
+                cache = &entry;
+                break;
+            }
+        }
+        if (nullptr == cache) {
+            sGsaCache.emplace_back();
+            cache = &sGsaCache.back();
+            cache->svTypeMask = sv_meta_p->svTypeMask;
+            cache->systemId = sv_meta_p->systemId;
+        } else if (0 == strncmp(cache->talker, talker, sizeof(cache->talker)) &&
+                cache->fixType == fixType &&
+                cache->svUsedCount == listedCount &&
+                0 == memcmp(cache->svUsedList, svUsedList, listedCount * sizeof(uint32_t)) &&
+                cache->hasDop == hasDop &&
+                (!hasDop || (cache->pdop == locationExtended.pdop &&
+                             cache->hdop == locationExtended.hdop &&
+                             cache->vdop == locationExtended.vdop)) &&
+                (int)cache->sentence.size() < bufSize) {
+            nmeaArraystr.push_back(cache->sentence);
+            return svUsedCount;
+        }
+        // filled in once the sentence is complete
+        cache->sentence.clear();
+        strlcpy(cache->talker, talker, sizeof(cache->talker));
+        cache->fixType = fixType;
+        cache->svUsedCount = listedCount;
+        memcpy(cache->svUsedList, svUsedList, listedCount * sizeof(uint32_t));
+        cache->hasDop = hasDop;
+        cache->pdop = locationExtended.pdop;
+        cache->hdop = locationExtended.hdop;
+        cache->vdop = locationExtended.vdop;
+    }
+
     while (sentenceNumber <= sentenceCount) {
         pMarker = sentence;
         lengthRemaining = bufSize;
         if (svUsedCount > 12 && isTagBlockGroupingEnabled) {
-            lengthTagBlock = snprintf(pMarker, lengthRemaining, "\\g:%d-%d-%d", sentenceNumber,
-                     sentenceCount, code);
+            lengthTagBlock = LocNmeaWriter(pMarker, lengthRemaining).str("\\g:")
+                    .dec(sentenceNumber).chr('-').dec(sentenceCount).chr('-').dec(code).length();
             if (MAX_TAG_BLOCK_GROUP_CODE == code) {
                 code = 1;
             }
@@ -677,12 +972,6 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
             pMarker += lengthTagBlock;
             lengthRemaining -= lengthTagBlock;
         }
-        if (sv_meta_p->totalSvUsedCount == 0)
-            fixType = '1'; // no fix
-        else if (sv_meta_p->totalSvUsedCount <= 3)
-            fixType = '2'; // 2D fix
-        else
-            fixType = '3'; // 3D fix
 
         // Start printing the sentence
         // Format: $--GSA,a,x,xx,xx,xx,xx,xx,xx,xx,xx,xx,xx,xx,xx,p.p,h.h,v.v,s*cc
@@ -694,53 +983,48 @@ static uint32_t loc_nmea_generate_GSA(const GpsLocationExtended &locationExtende
         // v.v : Vertical DOP
         // s : GNSS System Id
         // cc : Checksum value
-        length = snprintf(pMarker, lengthRemaining, "$%sGSA,A,%c,", talker, fixType);
-        if (length < 0 || length >= lengthRemaining) {
-            LOC_LOGE("NMEA Error in string formatting");
-            return 0;
-        }
-        pMarker += length;
-        lengthRemaining -= length;
+        LocNmeaWriter writer(pMarker, lengthRemaining);
+        writer.chr('$').str(talker).str("GSA,A,").chr(fixType).chr(',');
 
         // Add 12 satellite IDs
         for (uint8_t i = 0; i < 12; i++, svNumber++)
         {
             if (svNumber <= svUsedCount)
-                length = snprintf(pMarker, lengthRemaining, "%02d,", svUsedList[svNumber - 1]);
+                writer.dec((int)svUsedList[svNumber - 1], 2).chr(',');
             else
-                length = snprintf(pMarker, lengthRemaining, ",");
-
-            if (length < 0 || length >= lengthRemaining) {
-                LOC_LOGE("NMEA Error in string formatting");
-                return 0;
-            }
-            pMarker += length;
-            lengthRemaining -= length;
+                writer.chr(',');
         }
 
         // Add the position/horizontal/vertical DOP values
-        if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
+        if (hasDop)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,%.1f,%.1f,",
-                    locationExtended.pdop,
-                    locationExtended.hdop,
-                    locationExtended.vdop);
+            writer.fixed(locationExtended.pdop, 1).chr(',')
+                    .fixed(locationExtended.hdop, 1).chr(',')
+                    .fixed(locationExtended.vdop, 1).chr(',');
         }
         else
         {   // no dop
-            length = snprintf(pMarker, lengthRemaining, ",,,");
+            writer.str(",,,");
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
         // system id
-        length = snprintf(pMarker, lengthRemaining, "%d", sv_meta_p->systemId);
-        pMarker += length;
-        lengthRemaining -= length;
+        writer.dec(sv_meta_p->systemId);
+
+        length = writer.length();
+        if (length < 0 || length >= lengthRemaining) {
+            LOC_LOGE("NMEA Error in string formatting");
+            if (nullptr != cache) {
+                loc_nmea_reset_gsa_cache(*cache);
+            }
+            return 0;
+        }
 
         /* Sentence is ready, add checksum and broadcast */
         length = loc_nmea_put_checksum(sentence + lengthTagBlock, bufSize - lengthTagBlock, false);
         nmeaArraystr.push_back(sentence);
+        if (nullptr != cache) {
+            cache->sentence = sentence;
+        }
         sentenceNumber++;
         if (!isTagBlockGroupingEnabled) {
             break;
@@ -784,12 +1068,12 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
         return;
     }
 
-    char* pMarker = sentence;
-    int lengthRemaining = bufSize;
     int length = 0;
     int sentenceCount = 0;
     int sentenceNumber = 1;
     size_t svNumber = 1;
+    std::vector<loc_nmea_gsv_row>& rows = sGsvRows;
+    loc_nmea_gsv_cache* cache = nullptr;
 
     const char* talker = sv_meta_p->talker;
     uint32_t svIdOffset = sv_meta_p->svIdOffset;
@@ -807,108 +1091,121 @@ static void loc_nmea_generate_GSV(const GnssSvNotification &svNotify,
     sentenceNumber = 1;
     sentenceCount = svCount / 4 + (svCount % 4 != 0);
 
-    while (sentenceNumber <= sentenceCount)
+    // Pick out the SVs of this constellation and signal, 4 per sentence
+    size_t maxRows = (size_t)sentenceCount * 4;
+    rows.clear();
+    for (; (svNumber <= svNotify.count) && (rows.size() < maxRows); svNumber++)
     {
-        pMarker = sentence;
-        lengthRemaining = bufSize;
-
-        length = snprintf(pMarker, lengthRemaining, "$%sGSV,%d,%d,%02d",
-                talker, sentenceCount, sentenceNumber, svCount);
-
-        if (length < 0 || length >= lengthRemaining)
-        {
-            LOC_LOGE("NMEA Error in string formatting");
-            return;
+        const GnssSv& gnssSv = svNotify.gnssSvs[svNumber - 1];
+        GnssSignalTypeMask signalType = gnssSv.gnssSignalTypeMask;
+        if (0 == signalType) {
+            // If no signal type in report, it means default L1,G1,E1,B1I
+            switch (gnssSv.type)
+            {
+                case GNSS_SV_TYPE_GPS:
+                    signalType = GNSS_SIGNAL_GPS_L1CA;
+                    break;
+                case GNSS_SV_TYPE_GLONASS:
+                    signalType = GNSS_SIGNAL_GLONASS_G1;
+                    break;
+                case GNSS_SV_TYPE_GALILEO:
+                    signalType = GNSS_SIGNAL_GALILEO_E1;
+                    break;
+                case GNSS_SV_TYPE_QZSS:
+                    signalType = GNSS_SIGNAL_QZSS_L1CA;
+                    break;
+                case GNSS_SV_TYPE_BEIDOU:
+                    signalType = GNSS_SIGNAL_BEIDOU_B1I;
+                    break;
+                case GNSS_SV_TYPE_SBAS:
+                    signalType = GNSS_SIGNAL_SBAS_L1;
+                    break;
+                case GNSS_SV_TYPE_NAVIC:
+                    signalType = GNSS_SIGNAL_NAVIC_L5;
+                    break;
+                default:
+                    LOC_LOGE("NMEA Error unknow constellation type: %d", gnssSv.type);
+                    continue;
+            }
         }
-        pMarker += length;
-        lengthRemaining -= length;
 
-        for (int i=0; (svNumber <= svNotify.count) && (i < 4);  svNumber++)
+        if ((sv_meta_p->svTypeMask & (1 << gnssSv.type)) &&
+                sv_meta_p->signalId == convert_signalType_to_signalId(signalType))
         {
-            GnssSignalTypeMask signalType = svNotify.gnssSvs[svNumber-1].gnssSignalTypeMask;
-            if (0 == signalType) {
-                // If no signal type in report, it means default L1,G1,E1,B1I
-                switch (svNotify.gnssSvs[svNumber - 1].type)
-                {
-                    case GNSS_SV_TYPE_GPS:
-                        signalType = GNSS_SIGNAL_GPS_L1CA;
-                        break;
-                    case GNSS_SV_TYPE_GLONASS:
-                        signalType = GNSS_SIGNAL_GLONASS_G1;
-                        break;
-                    case GNSS_SV_TYPE_GALILEO:
-                        signalType = GNSS_SIGNAL_GALILEO_E1;
-                        break;
-                    case GNSS_SV_TYPE_QZSS:
-                        signalType = GNSS_SIGNAL_QZSS_L1CA;
-                        break;
-                    case GNSS_SV_TYPE_BEIDOU:
-                        signalType = GNSS_SIGNAL_BEIDOU_B1I;
-                        break;
-                    case GNSS_SV_TYPE_SBAS:
-                        signalType = GNSS_SIGNAL_SBAS_L1;
-                        break;
-                    case GNSS_SV_TYPE_NAVIC:
-                        signalType = GNSS_SIGNAL_NAVIC_L5;
-                        break;
-                    default:
-                        LOC_LOGE("NMEA Error unknow constellation type: %d",
-                                svNotify.gnssSvs[svNumber - 1].type);
-                        continue;
-                }
+            loc_nmea_gsv_row row;
+            if (GNSS_SV_TYPE_SBAS == gnssSv.type) {
+                svIdOffset = SBAS_SV_ID_OFFSET;
             }
+            row.hasSvId = !(GNSS_SV_TYPE_GLONASS == gnssSv.type &&
+                    GLO_SV_PRN_SLOT_UNKNOWN == gnssSv.svId);
+            row.svId = row.hasSvId ? (int32_t)(gnssSv.svId - svIdOffset) : 0;
+            row.elevation = (int)(0.5 + gnssSv.elevation); //float to int
+            row.azimuth = (int)(0.5 + gnssSv.azimuth); //float to int
+            row.hasCN0 = (gnssSv.cN0Dbhz > 0);
+            row.cN0 = row.hasCN0 ? (int)(0.5 + gnssSv.cN0Dbhz) : 0; //float to int
+            rows.push_back(row);
+        }
+    }
 
-            if ((sv_meta_p->svTypeMask & (1 << svNotify.gnssSvs[svNumber - 1].type)) &&
-                    sv_meta_p->signalId == convert_signalType_to_signalId(signalType))
-            {
-                if (GNSS_SV_TYPE_SBAS == svNotify.gnssSvs[svNumber - 1].type) {
-                    svIdOffset = SBAS_SV_ID_OFFSET;
-                }
-                if (GNSS_SV_TYPE_GLONASS == svNotify.gnssSvs[svNumber - 1].type &&
-                    GLO_SV_PRN_SLOT_UNKNOWN == svNotify.gnssSvs[svNumber - 1].svId) {
-                    length = snprintf(pMarker, lengthRemaining, ",,%02d,%03d,",
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
-                } else {
-                    length = snprintf(pMarker, lengthRemaining, ",%02d,%02d,%03d,",
-                        svNotify.gnssSvs[svNumber - 1].svId - svIdOffset,
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].elevation), //float to int
-                        (int)(0.5 + svNotify.gnssSvs[svNumber - 1].azimuth)); //float to int
-                }
-                if (length < 0 || length >= lengthRemaining)
-                {
-                    LOC_LOGE("NMEA Error in string formatting");
-                    return;
-                }
-                pMarker += length;
-                lengthRemaining -= length;
-
-                if (svNotify.gnssSvs[svNumber - 1].cN0Dbhz > 0)
-                {
-                    length = snprintf(pMarker, lengthRemaining,"%02d",
-                            (int)(0.5 + svNotify.gnssSvs[svNumber - 1].cN0Dbhz)); //float to int
-
-                    if (length < 0 || length >= lengthRemaining)
-                    {
-                        LOC_LOGE("NMEA Error in string formatting");
-                        return;
-                    }
-                    pMarker += length;
-                    lengthRemaining -= length;
-                }
+    for (auto& entry : sGsvCache) {
+        if (entry.svTypeMask == sv_meta_p->svTypeMask && entry.signalId == sv_meta_p->signalId) {
+            cache = &entry;
+            break;
+        }
+    }
+    if (nullptr == cache) {
+        sGsvCache.emplace_back();
+        cache = &sGsvCache.back();
+        cache->svTypeMask = sv_meta_p->svTypeMask;
+        cache->signalId = sv_meta_p->signalId;
+    } else if (0 == strncmp(cache->talker, talker, sizeof(cache->talker)) &&
+            cache->svCount == svCount &&
+            cache->rows == rows) {
+        for (const auto& cachedSentence : cache->sentences) {
+            nmeaArraystr.push_back(cachedSentence);
+        }
+        return;
+    }
+    strlcpy(cache->talker, talker, sizeof(cache->talker));
+    cache->svCount = svCount;
+    // hand the old rows back as scratch space for the next call
+    cache->rows.swap(rows);
+    cache->sentences.clear();
 
-                i++;
-            }
+    size_t rowNumber = 0;
+    while (sentenceNumber <= sentenceCount)
+    {
+        LocNmeaWriter writer(sentence, bufSize);
+        writer.chr('$').str(talker).str("GSV,").dec(sentenceCount).chr(',')
+                .dec(sentenceNumber).chr(',').dec(svCount, 2);
 
+        for (int i = 0; (rowNumber < cache->rows.size()) && (i < 4); rowNumber++, i++)
+        {
+            const loc_nmea_gsv_row& row = cache->rows[rowNumber];
+            writer.chr(',');
+            if (row.hasSvId) {
+                writer.dec(row.svId, 2);
+            }
+            writer.chr(',').dec(row.elevation, 2).chr(',').dec(row.azimuth, 3).chr(',');
+            if (row.hasCN0) {
+                writer.dec(row.cN0, 2);
+            }
         }
 
         // append signalId
-        length = snprintf(pMarker, lengthRemaining,",%X",sv_meta_p->signalId);
-        pMarker += length;
-        lengthRemaining -= length;
+        writer.chr(',').hex(sv_meta_p->signalId);
+
+        length = writer.length();
+        if (length < 0 || length >= bufSize)
+        {
+            LOC_LOGE("NMEA Error in string formatting");
+            loc_nmea_reset_gsv_cache(*cache);
+            return;
+        }
 
         length = loc_nmea_put_checksum(sentence, bufSize, false);
         nmeaArraystr.push_back(sentence);
+        cache->sentences.push_back(sentence);
         sentenceNumber++;
 
     }  //while
@@ -969,7 +1266,8 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         default:
             break;
     }
-    length = snprintf(pMarker , lengthRemaining , "$%sDTM,%s,," , talker, local_datum);
+    length = LocNmeaWriter(pMarker, lengthRemaining).chr('$').str(talker).str("DTM,")
+            .str(local_datum).str(",,").length();
     if (length < 0 || length >= lengthRemaining) {
         LOC_LOGE("NMEA Error in string formatting");
         return;
@@ -999,16 +1297,17 @@ static void loc_nmea_generate_DTM(const LocLla &ref_lla,
         longHem = 'E';
     }
     longMins = fmod(lla_offset[1] * 60.0, 60.0);
-    length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,%.3lf,",
-                     (uint8_t)floor(lla_offset[0]), latMins, latHem,
-                     (uint8_t)floor(lla_offset[1]), longMins, longHem, lla_offset[2]);
+    length = LocNmeaWriter(pMarker, lengthRemaining).dec((uint8_t)floor(lla_offset[0]), 2)
+            .fixed(latMins, 6, 9).chr(',').chr(latHem).chr(',')
+            .dec((uint8_t)floor(lla_offset[1]), 3).fixed(longMins, 6, 9).chr(',').chr(longHem)
+            .chr(',').fixed(lla_offset[2], 3).chr(',').length();
     if (length < 0 || length >= lengthRemaining) {
         LOC_LOGE("NMEA Error in string formatting");
         return;
     }
     pMarker += length;
     lengthRemaining -= length;
-    length = snprintf(pMarker , lengthRemaining , "%s" , ref_datum);
+    length = LocNmeaWriter(pMarker, lengthRemaining).str(ref_datum).length();
     if (length < 0 || length >= lengthRemaining) {
         LOC_LOGE("NMEA Error in string formatting");
         return;
@@ -1511,11 +1810,14 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                     magTrack -= 360.0;
             }
 
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,%.1lf,T,%.1lf,M,", talker, location.gpsLocation.bearing, magTrack);
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr('$').str(talker).str("VTG,")
+                    .fixed(location.gpsLocation.bearing, 1).str(",T,").fixed(magTrack, 1)
+                    .str(",M,").length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, "$%sVTG,,T,,M,", talker);
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr('$').str(talker)
+                    .str("VTG,,T,,M,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1531,11 +1833,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
             float speedKmPerHour = location.gpsLocation.speed * 3.6;
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,N,%.1lf,K,", speedKnots, speedKmPerHour);
+            length = LocNmeaWriter(pMarker, lengthRemaining).fixed(speedKnots, 1).str(",N,")
+                    .fixed(speedKmPerHour, 1).str(",K,").length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",N,,K,");
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(",N,,K,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1546,7 +1849,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker += length;
         lengthRemaining -= length;
 
-        length = snprintf(pMarker, lengthRemaining, "%c", vtgModeIndicator);
+        length = LocNmeaWriter(pMarker, lengthRemaining).chr(vtgModeIndicator).length();
 
         length = loc_nmea_put_checksum(sentence, sizeof(sentence), false);
         nmeaArraystr.push_back(sentence);
@@ -1605,11 +1908,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 (0 != sv_cache_info.bds_used_mask));
 
         if (validFix) {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,A,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr('$').str(talker).str("RMC,")
+                    .dec(utcHours, 2).dec(utcMinutes, 2).dec(utcSeconds, 2).chr('.')
+                    .dec(utcMSeconds/10, 2).str(",A,").length();
         } else {
-            length = snprintf(pMarker, lengthRemaining, "$%sRMC,%02d%02d%02d.%02d,V,",
-                              talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr('$').str(talker).str("RMC,")
+                    .dec(utcHours, 2).dec(utcMinutes, 2).dec(utcSeconds, 2).chr('.')
+                    .dec(utcMSeconds/10, 2).str(",V,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1652,13 +1957,14 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             latMinutes = fmod(latitude * 60.0 , 60.0);
             lonMinutes = fmod(longitude * 60.0 , 60.0);
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            length = LocNmeaWriter(pMarker, lengthRemaining).dec((uint8_t)floor(latitude), 2)
+                    .fixed(latMinutes, 6, 9).chr(',').chr(latHemisphere).chr(',')
+                    .dec((uint8_t)floor(longitude), 3).fixed(lonMinutes, 6, 9).chr(',')
+                    .chr(lonHemisphere).chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(",,,,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1672,11 +1978,11 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_SPEED)
         {
             float speedKnots = location.gpsLocation.speed * (3600.0/1852.0);
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", speedKnots);
+            length = LocNmeaWriter(pMarker, lengthRemaining).fixed(speedKnots, 1).chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr(',').length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1689,11 +1995,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_BEARING)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,", location.gpsLocation.bearing);
+            length = LocNmeaWriter(pMarker, lengthRemaining).fixed(location.gpsLocation.bearing, 1)
+                    .chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr(',').length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1704,8 +2011,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker += length;
         lengthRemaining -= length;
 
-        length = snprintf(pMarker, lengthRemaining, "%2.2d%2.2d%2.2d,",
-                          utcDay, utcMonth, utcYear);
+        length = LocNmeaWriter(pMarker, lengthRemaining).dec(utcDay, 2).dec(utcMonth, 2)
+                .dec(utcYear, 2).chr(',').length();
 
         if (length < 0 || length >= lengthRemaining)
         {
@@ -1729,12 +2036,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
                 direction = 'E';
             }
 
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,%c,",
-                              magneticVariation, direction);
+            length = LocNmeaWriter(pMarker, lengthRemaining).fixed(magneticVariation, 1).chr(',')
+                    .chr(direction).chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",,");
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(",,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1745,12 +2052,12 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker += length;
         lengthRemaining -= length;
 
-        length = snprintf(pMarker, lengthRemaining, "%c", rmcModeIndicator);
+        length = LocNmeaWriter(pMarker, lengthRemaining).chr(rmcModeIndicator).length();
         pMarker += length;
         lengthRemaining -= length;
 
         // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
+        length = LocNmeaWriter(pMarker, lengthRemaining).str(",V").length();
 
         length = loc_nmea_put_checksum(sentence_RMC, sizeof(sentence_RMC), false);
 
@@ -1761,8 +2068,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker = sentence_GNS;
         lengthRemaining = sizeof(sentence_GNS);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGNS,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+        length = LocNmeaWriter(pMarker, lengthRemaining).chr('$').str(talker).str("GNS,")
+                .dec(utcHours, 2).dec(utcMinutes, 2).dec(utcSeconds, 2).chr('.')
+                .dec(utcMSeconds/10, 2).chr(',').length();
 
         if (length < 0 || length >= lengthRemaining)
         {
@@ -1804,13 +2112,14 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             latMinutes = fmod(latitude * 60.0 , 60.0);
             lonMinutes = fmod(longitude * 60.0 , 60.0);
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            length = LocNmeaWriter(pMarker, lengthRemaining).dec((uint8_t)floor(latitude), 2)
+                    .fixed(latMinutes, 6, 9).chr(',').chr(latHemisphere).chr(',')
+                    .dec((uint8_t)floor(longitude), 3).fixed(lonMinutes, 6, 9).chr(',')
+                    .chr(lonHemisphere).chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(",,,,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1821,18 +2130,17 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker += length;
         lengthRemaining -= length;
 
-        length = snprintf(pMarker, lengthRemaining, "%s,", gnsModeIndicator);
+        length = LocNmeaWriter(pMarker, lengthRemaining).str(gnsModeIndicator).chr(',').length();
 
         pMarker += length;
         lengthRemaining -= length;
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP) {
-            length = snprintf(pMarker, lengthRemaining, "%02d,%.1f,",
-                              svUsedCount, locationExtended.hdop);
+            length = LocNmeaWriter(pMarker, lengthRemaining).dec(svUsedCount, 2).chr(',')
+                    .fixed(locationExtended.hdop, 1).chr(',').length();
         }
         else {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%02d,,",
-                              svUsedCount);
+            length = LocNmeaWriter(pMarker, lengthRemaining).dec(svUsedCount, 2).str(",,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1845,12 +2153,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              locationExtended.altitudeMeanSeaLevel);
+            length = LocNmeaWriter(pMarker, lengthRemaining)
+                    .fixed(locationExtended.altitudeMeanSeaLevel, 1)
+                    .chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",");
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr(',').length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1864,12 +2173,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            length = LocNmeaWriter(pMarker, lengthRemaining)
+                    .fixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1)
+                    .chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr(',').length();
         }
         if (length < 0 || length >= lengthRemaining)
         {
@@ -1881,12 +2191,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
+            length = LocNmeaWriter(pMarker, lengthRemaining)
+                    .fixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1)
+                    .chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr(',').length();
         }
         if (length < 0 || length >= lengthRemaining)
         {
@@ -1898,8 +2209,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
         {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
+            length = LocNmeaWriter(pMarker, lengthRemaining)
+                    .dec(locationExtended.dgnssRefStationId, 4).length();
             if (length < 0 || length >= lengthRemaining)
             {
                 LOC_LOGE("NMEA Error in string formatting");
@@ -1910,7 +2221,7 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         }
 
         // hardcode Navigation Status field to 'V'
-        length = snprintf(pMarker, lengthRemaining, ",%c", 'V');
+        length = LocNmeaWriter(pMarker, lengthRemaining).str(",V").length();
         pMarker += length;
         lengthRemaining -= length;
 
@@ -1923,8 +2234,9 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         pMarker = sentence_GGA;
         lengthRemaining = sizeof(sentence_GGA);
 
-        length = snprintf(pMarker, lengthRemaining, "$%sGGA,%02d%02d%02d.%02d," ,
-                          talker, utcHours, utcMinutes, utcSeconds, utcMSeconds/10);
+        length = LocNmeaWriter(pMarker, lengthRemaining).chr('$').str(talker).str("GGA,")
+                .dec(utcHours, 2).dec(utcMinutes, 2).dec(utcSeconds, 2).chr('.')
+                .dec(utcMSeconds/10, 2).chr(',').length();
 
         if (length < 0 || length >= lengthRemaining)
         {
@@ -1966,13 +2278,14 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             latMinutes = fmod(latitude * 60.0 , 60.0);
             lonMinutes = fmod(longitude * 60.0 , 60.0);
 
-            length = snprintf(pMarker, lengthRemaining, "%02d%09.6lf,%c,%03d%09.6lf,%c,",
-                              (uint8_t)floor(latitude), latMinutes, latHemisphere,
-                              (uint8_t)floor(longitude),lonMinutes, lonHemisphere);
+            length = LocNmeaWriter(pMarker, lengthRemaining).dec((uint8_t)floor(latitude), 2)
+                    .fixed(latMinutes, 6, 9).chr(',').chr(latHemisphere).chr(',')
+                    .dec((uint8_t)floor(longitude), 3).fixed(lonMinutes, 6, 9).chr(',')
+                    .chr(lonHemisphere).chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,,,");
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(",,,,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -1988,13 +2301,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
             svUsedCount = MAX_SATELLITES_IN_USE;
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DOP)
         {
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,%.1f,",
-                              ggaGpsQuality, svUsedCount, locationExtended.hdop);
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(ggaGpsQuality).chr(',')
+                    .dec(svUsedCount, 2).chr(',').fixed(locationExtended.hdop, 1).chr(',').length();
         }
         else
         {   // no hdop
-            length = snprintf(pMarker, lengthRemaining, "%s,%02d,,",
-                              ggaGpsQuality, svUsedCount);
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(ggaGpsQuality).chr(',')
+                    .dec(svUsedCount, 2).str(",,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -2007,12 +2320,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              locationExtended.altitudeMeanSeaLevel);
+            length = LocNmeaWriter(pMarker, lengthRemaining)
+                    .fixed(locationExtended.altitudeMeanSeaLevel, 1)
+                    .str(",M,").length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining,",,");
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(",,").length();
         }
 
         if (length < 0 || length >= lengthRemaining)
@@ -2026,12 +2340,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
         if ((location.gpsLocation.flags & LOC_GPS_LOCATION_HAS_ALTITUDE) &&
             (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_ALTITUDE_MEAN_SEA_LEVEL))
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1lf,M,",
-                              ref_lla.alt - locationExtended.altitudeMeanSeaLevel);
+            length = LocNmeaWriter(pMarker, lengthRemaining)
+                    .fixed(ref_lla.alt - locationExtended.altitudeMeanSeaLevel, 1)
+                    .str(",M,").length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",,");
+            length = LocNmeaWriter(pMarker, lengthRemaining).str(",,").length();
         }
         if (length < 0 || length >= lengthRemaining)
         {
@@ -2043,12 +2358,13 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_DATA_AGE)
         {
-            length = snprintf(pMarker, lengthRemaining, "%.1f,",
-                              (float)locationExtended.dgnssDataAgeMsec / 1000);
+            length = LocNmeaWriter(pMarker, lengthRemaining)
+                    .fixed((float)locationExtended.dgnssDataAgeMsec / 1000, 1)
+                    .chr(',').length();
         }
         else
         {
-            length = snprintf(pMarker, lengthRemaining, ",");
+            length = LocNmeaWriter(pMarker, lengthRemaining).chr(',').length();
         }
         if (length < 0 || length >= lengthRemaining)
         {
@@ -2060,8 +2376,8 @@ void loc_nmea_generate_pos(const UlpLocation &location,
 
         if (locationExtended.flags & GPS_LOCATION_EXTENDED_HAS_DGNSS_REF_STATION_ID)
         {
-            length = snprintf(pMarker, lengthRemaining, "%04d",
-                              locationExtended.dgnssRefStationId);
+            length = LocNmeaWriter(pMarker, lengthRemaining)
+                    .dec(locationExtended.dgnssRefStationId, 4).length();
             if (length < 0 || length >= lengthRemaining)
             {
                 LOC_LOGE("NMEA Error in string formatting");
@@ -163,6 +163,7 @@ extern void log_tag_level_map_init();
 extern int get_tag_log_level(const char* tag);
 extern char* get_timestamp(char* str, unsigned long buf_size);
 extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
+extern void log_buffer_insertf(int level, const char* tag, const char* format, ...);
 /*=============================================================================
  *
  *                          LOGGING BUFFER MACROS
@@ -174,16 +175,12 @@ extern void log_buffer_insert(char *str, unsigned long buf_size, int level);
 #define TOTAL_LOG_LEVELS 5
 #define LOGGING_BUFFER_MAX_LEN 1024
 #define IF_LOG_BUFFER_ENABLE if (loc_logger.LOG_BUFFER_ENABLE)
+/* The time / pid / tid / tag prefix of the line only gets formatted when dumped */
 #define INSERT_BUFFER(flag, level, format, x...)                                              \
 {                                                                                             \
     IF_LOG_BUFFER_ENABLE {                                                                    \
         if (flag == 0) {                                                                      \
-            char timestr[32];                                                                 \
-            get_timestamp(timestr, sizeof(timestr));                                          \
-            char log_str[LOGGING_BUFFER_MAX_LEN];                                             \
-            snprintf(log_str, LOGGING_BUFFER_MAX_LEN, "%s %d %ld %s :" format "\n",           \
-                    timestr, getpid(), syscall(SYS_gettid), LOG_TAG==NULL ? "": LOG_TAG, ##x);\
-            log_buffer_insert(log_str, sizeof(log_str), level);                               \
+            log_buffer_insertf(level, LOG_TAG, "" format, ##x);                               \
         }                                                                                     \
     }                                                                                         \
 }
@@ -269,6 +269,60 @@ msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj)
    return rv;
 }
 
+/*===========================================================================
+
+  FUNCTION:   msg_q_rcv_all
+
+  ===========================================================================*/
+msq_q_err_type msg_q_rcv_all(void* msg_q_data, void** msg_list)
+{
+   if( msg_q_data == NULL )
+   {
+      LOC_LOGE("%s: Invalid msg_q_data parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_HANDLE;
+   }
+
+   if( msg_list == NULL || *msg_list == NULL || !linked_list_empty(*msg_list) )
+   {
+      LOC_LOGE("%s: Invalid msg_list parameter!\n", __FUNCTION__);
+      return eMSG_Q_INVALID_PARAMETER;
+   }
+
+   msg_q* p_msg_q = (msg_q*)msg_q_data;
+
+   pthread_mutex_lock(&p_msg_q->list_mutex);
+
+   if( p_msg_q->unblocked )
+   {
+      LOC_LOGE("%s: Message queue has been unblocked.\n", __FUNCTION__);
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   /* Wait for data in the message queue */
+   while( linked_list_empty(p_msg_q->msg_list) && !p_msg_q->unblocked )
+   {
+      pthread_cond_wait(&p_msg_q->list_cond, &p_msg_q->list_mutex);
+   }
+
+   if( p_msg_q->unblocked )
+   {
+      pthread_mutex_unlock(&p_msg_q->list_mutex);
+      return eMSG_Q_UNAVAILABLE_RESOURCE;
+   }
+
+   /* Hand the whole list over, and keep the caller's empty one */
+   void* tmp = p_msg_q->msg_list;
+   p_msg_q->msg_list = *msg_list;
+   *msg_list = tmp;
+
+   pthread_mutex_unlock(&p_msg_q->list_mutex);
+
+   LOC_LOGV("%s: Received all messages\n", __FUNCTION__);
+
+   return eMSG_Q_SUCCESS;
+}
+
 /*===========================================================================
 
   FUNCTION:   msg_q_rmv
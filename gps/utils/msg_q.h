@@ -159,6 +159,31 @@ SIDE EFFECTS
 ===========================================================================*/
 msq_q_err_type msg_q_rcv(void* msg_q_data, void** msg_obj);
 
+/*===========================================================================
+FUNCTION    msg_q_rcv_all
+
+DESCRIPTION
+   Retrieves all the data from the message queue at once. Waits until the
+   message queue is not empty, then swaps its content with the empty linked
+   list passed in, all under one lock. The caller then takes the messages out
+   of msg_list with linked_list_remove(), oldest first.
+
+   msg_q_data: Message Queue to take the data from.
+   msg_list:   Pointer to an empty linked list handle (see linked_list.h),
+               which is replaced with the list holding the messages.
+
+DEPENDENCIES
+   N/A
+
+RETURN VALUE
+   Look at error codes above.
+
+SIDE EFFECTS
+   N/A
+
+===========================================================================*/
+msq_q_err_type msg_q_rcv_all(void* msg_q_data, void** msg_list);
+
 /*===========================================================================
 FUNCTION    msg_q_rmv
 
@@ -0,0 +1,346 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocIpc.h>
+#include <gtest/gtest.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <fcntl.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace loc_util;
+
+namespace {
+
+class ShmListener : public ILocIpcListener {
+    mutex mLock;
+    condition_variable mCond;
+public:
+    vector<string> mMsgs;
+    void onReceive(const char* data, uint32_t len, const LocIpcRecver*) override {
+        lock_guard<mutex> guard(mLock);
+        mMsgs.push_back(string(data, len));
+        mCond.notify_all();
+    }
+    bool waitFor(size_t count, int timeoutMs = 10000) {
+        unique_lock<mutex> guard(mLock);
+        return mCond.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                [&]() { return mMsgs.size() >= count; });
+    }
+};
+
+// Runs fn in a child process, which is the sender; returns its exit status
+int runSender(std::function<bool()> fn) {
+    pid_t pid = fork();
+    if (0 == pid) {
+        _exit(fn() ? 0 : 1);
+    }
+    int status = 0;
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+string makeMsg(uint32_t seqNo, uint32_t length) {
+    string msg(length, '\0');
+    for (uint32_t i = 0; i < length; i++) {
+        msg[i] = (char)(seqNo * 31 + i);
+    }
+    memcpy(&msg[0], &seqNo, std::min((uint32_t)sizeof(seqNo), length));
+    return msg;
+}
+
+class LocIpcShmTest : public ::testing::Test {
+protected:
+    string mName;
+    shared_ptr<ShmListener> mListener;
+    LocIpc mIpc;
+    void SetUp() override {
+        // a name of its own, the listener thread of the last test may still
+        // be about to unlink its socket
+        static int sTestNo = 0;
+        mName = "/tmp/LocIpcShm_test." + std::to_string(getpid()) + "." + std::to_string(sTestNo++);
+        mListener = make_shared<ShmListener>();
+        unique_ptr<LocIpcRecver> recver = LocIpc::getLocIpcShmRecver(mListener, mName.c_str());
+        ASSERT_TRUE(mIpc.startNonBlockingListening(recver));
+    }
+    void TearDown() override {
+        mIpc.stopNonBlockingListening();
+    }
+};
+
+// Hands a ring built by hand to the recver, the way a broken or hostile
+// sender could, with the layout LocIpc.cpp uses.
+class FakeSender {
+public:
+    struct RingHeader {
+        uint32_t mMagic;
+        uint32_t mCapacity;
+        std::atomic<uint64_t> mHead;
+        std::atomic<uint64_t> mTail;
+        std::atomic<uint32_t> mRecverWaiting;
+        std::atomic<uint32_t> mSenderWaiting;
+    };
+    static const size_t kHeaderSize = 64;
+    static const uint32_t kCapacity = 4096;
+
+    FakeSender() {
+        mFds[0] = syscall(__NR_memfd_create, "LocIpcShm_test", MFD_CLOEXEC);
+        mFds[1] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        mFds[2] = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        int alive[2] = {-1, -1};
+        pipe2(alive, O_CLOEXEC);
+        mFds[3] = alive[0];
+        mAliveFd = alive[1];
+        mSock = socket(AF_UNIX, SOCK_DGRAM, 0);
+        if (0 == ftruncate(mFds[0], kHeaderSize + kCapacity)) {
+            void* mem = mmap(nullptr, kHeaderSize + kCapacity, PROT_READ | PROT_WRITE,
+                             MAP_SHARED, mFds[0], 0);
+            mMem = (MAP_FAILED == mem) ? nullptr : (uint8_t*)mem;
+        }
+    }
+    ~FakeSender() {
+        if (nullptr != mMem) {
+            munmap(mMem, kHeaderSize + kCapacity);
+        }
+        for (auto fd : mFds) {
+            close(fd);
+        }
+        close(mAliveFd);
+        close(mSock);
+    }
+    RingHeader* header() { return (RingHeader*)mMem; }
+
+    // sets up an empty ring at head, and hands it over
+    bool connect(const string& name, uint64_t head) {
+        if (nullptr == mMem) {
+            return false;
+        }
+        header()->mMagic = 0x4c495253;
+        header()->mCapacity = kCapacity;
+        header()->mHead.store(head);
+        header()->mTail.store(head);
+        mTail = head;
+
+        struct sockaddr_un addr = {};
+        addr.sun_family = AF_UNIX;
+        snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", name.c_str());
+        char hello[] = "LocIpc::Shm::HELLO";
+        struct iovec iov = {hello, sizeof(hello)};
+        union {
+            char buf[CMSG_SPACE(sizeof(mFds))];
+            struct cmsghdr align;
+        } control;
+        memset(&control, 0, sizeof(control));
+        struct msghdr msg = {};
+        msg.msg_name = &addr;
+        msg.msg_namelen = sizeof(addr);
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.buf;
+        msg.msg_controllen = sizeof(control.buf);
+        struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(mFds));
+        memcpy(CMSG_DATA(cmsg), mFds, sizeof(mFds));
+        return sendmsg(mSock, &msg, 0) > 0;
+    }
+
+    // writes a record of the given length field at the tail, unpublished
+    void put(uint32_t length, uint32_t flags, const char* payload) {
+        uint8_t* record = mMem + kHeaderSize + (mTail & (kCapacity - 1));
+        memcpy(record, &length, sizeof(length));
+        memcpy(record + sizeof(length), &flags, sizeof(flags));
+        memcpy(record + 8, payload, strlen(payload));
+        mTail += (8 + strlen(payload) + 7) & ~(uint64_t)7;
+    }
+
+    // publishes the records put so far, or moves the tail to the given one,
+    // and wakes up the recver
+    void publish(uint64_t tail = ~0ULL) {
+        if (~0ULL != tail) {
+            mTail = tail;
+        }
+        header()->mTail.store(mTail);
+        uint64_t one = 1;
+        write(mFds[1], &one, sizeof(one));
+    }
+
+    bool waitForHead(uint64_t head) {
+        for (int i = 0; i < 200 && header()->mHead.load() != head; i++) {
+            usleep(10000);
+        }
+        return header()->mHead.load() == head;
+    }
+
+private:
+    int mFds[4];
+    int mAliveFd;
+    int mSock;
+    uint8_t* mMem = nullptr;
+    uint64_t mTail = 0;
+};
+
+} // namespace
+
+// Msgs of all sizes, through a small ring that wraps around many times,
+// arrive intact and in order in the recver process.
+TEST_F(LocIpcShmTest, TwoProcessesInOrder) {
+    const uint32_t kMsgs = 3000;
+    const uint32_t kBatch = 16;
+    string name = mName;
+    ASSERT_EQ(0, runSender([name, kMsgs, kBatch]() {
+        shared_ptr<LocIpcSender> sender = LocIpc::getLocIpcShmSender(name.c_str(), 4096);
+        uint32_t seqNo = 0;
+        while (seqNo < kMsgs) {
+            if (0 == seqNo % 100) {
+                // a batch, all of it written before the recver is woken up
+                vector<string> msgs;
+                vector<struct iovec> iovs;
+                for (uint32_t i = 0; i < kBatch; i++, seqNo++) {
+                    msgs.push_back(makeMsg(seqNo, 4 + seqNo % 200));
+                }
+                for (auto& msg : msgs) {
+                    iovs.push_back({&msg[0], msg.size()});
+                }
+                if (kBatch != LocIpc::send(*sender, iovs.data(), kBatch)) {
+                    return false;
+                }
+            } else {
+                string msg = makeMsg(seqNo, 1 + (seqNo * 37) % 2000);
+                if (!LocIpc::send(*sender, (const uint8_t*)msg.data(), msg.size())) {
+                    return false;
+                }
+                seqNo++;
+            }
+        }
+        // too big for the ring
+        string big(4096, 'x');
+        return !LocIpc::send(*sender, (const uint8_t*)big.data(), big.size());
+    }));
+
+    ASSERT_TRUE(mListener->waitFor(kMsgs));
+    ASSERT_EQ(kMsgs, mListener->mMsgs.size());
+    for (uint32_t seqNo = 0; seqNo < kMsgs; seqNo++) {
+        const string& msg = mListener->mMsgs[seqNo];
+        ASSERT_GE(msg.size(), 1u);
+        ASSERT_EQ(makeMsg(seqNo, msg.size()), msg) << "msg " << seqNo;
+    }
+}
+
+// The rings of the senders that are gone get dropped, so that more senders
+// than a recver takes rings from at once can come and go.
+TEST_F(LocIpcShmTest, SendersComeAndGo) {
+    const uint32_t kSenders = 80;
+    string name = mName;
+    for (uint32_t i = 0; i < kSenders; i++) {
+        ASSERT_EQ(0, runSender([name, i]() {
+            shared_ptr<LocIpcSender> sender = LocIpc::getLocIpcShmSender(name.c_str(), 4096);
+            string msg = makeMsg(i, 64);
+            return LocIpc::send(*sender, (const uint8_t*)msg.data(), msg.size());
+        }));
+        ASSERT_TRUE(mListener->waitFor(i + 1, 2000)) << "sender " << i;
+        EXPECT_EQ(makeMsg(i, 64), mListener->mMsgs[i]);
+    }
+}
+
+// A sender that writes a record length running past the end of the ring
+// gets the record dropped, and the recver carries on.
+TEST_F(LocIpcShmTest, CorruptedRecordLength) {
+    FakeSender sender;
+    // a record claiming nearly 4GB, the largest length that does not wrap
+    // around the record size on 64 bit, at the last record slot of the ring
+    ASSERT_TRUE(sender.connect(mName, FakeSender::kCapacity - 16));
+    sender.put(0xfffffff0, 0, "");
+    sender.publish(FakeSender::kCapacity);
+
+    // the corrupted record is skipped over
+    EXPECT_TRUE(sender.waitForHead(FakeSender::kCapacity));
+    EXPECT_EQ(0u, mListener->mMsgs.size());
+
+    // a good record after it still gets through
+    sender.put(5, 0, "hello");
+    sender.publish();
+    ASSERT_TRUE(mListener->waitFor(1, 2000));
+    EXPECT_EQ("hello", mListener->mMsgs[0]);
+}
+
+// A head in the last 8 bytes of the ring, or off the 8 byte grid, is
+// dropped before the record there is read.
+TEST_F(LocIpcShmTest, CorruptedHead) {
+    const uint64_t kHeads[] = {FakeSender::kCapacity - 4, FakeSender::kCapacity - 8 + 1, 12};
+    for (auto head : kHeads) {
+        FakeSender sender;
+        ASSERT_TRUE(sender.connect(mName, head));
+        // what the record would claim if it were read
+        sender.put(3, 0, "bad");
+        sender.publish(head + 16);
+        EXPECT_TRUE(sender.waitForHead(head + 16)) << "head " << head;
+    }
+    EXPECT_EQ(0u, mListener->mMsgs.size());
+}
+
+// A tail more than a ring ahead of the head is skipped to, unread.
+TEST_F(LocIpcShmTest, CorruptedTail) {
+    FakeSender sender;
+    ASSERT_TRUE(sender.connect(mName, 0));
+    sender.put(3, 0, "bad");
+    sender.publish(3 * FakeSender::kCapacity);
+    EXPECT_TRUE(sender.waitForHead(3 * FakeSender::kCapacity));
+    EXPECT_EQ(0u, mListener->mMsgs.size());
+}
+
+// The recver keeps its own head and capacity once it has taken the ring,
+// whatever the sender writes over them afterwards.
+TEST_F(LocIpcShmTest, HeaderChangedAfterAttach) {
+    FakeSender sender;
+    ASSERT_TRUE(sender.connect(mName, 0));
+    sender.put(3, 0, "one");
+    sender.publish();
+    ASSERT_TRUE(mListener->waitFor(1, 2000));
+    ASSERT_TRUE(sender.waitForHead(16));
+
+    // pointing the head at the last bytes of the ring, and claiming a
+    // ring far bigger than the mapping
+    sender.header()->mHead.store(FakeSender::kCapacity - 4);
+    sender.header()->mCapacity = 1u << 30;
+    sender.put(3, 0, "two");
+    sender.publish();
+    ASSERT_TRUE(mListener->waitFor(2, 2000));
+    EXPECT_EQ("two", mListener->mMsgs[1]);
+    EXPECT_TRUE(sender.waitForHead(32));
+}
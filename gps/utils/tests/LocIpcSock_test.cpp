@@ -0,0 +1,215 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocIpc.h>
+#include <gtest/gtest.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <condition_variable>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace loc_util;
+
+namespace {
+
+class MsgListener : public ILocIpcListener {
+    mutex mLock;
+    condition_variable mCond;
+public:
+    vector<string> mMsgs;
+    void onReceive(const char* data, uint32_t len, const LocIpcRecver*) override {
+        lock_guard<mutex> guard(mLock);
+        mMsgs.push_back(string(data, len));
+        mCond.notify_all();
+    }
+    bool waitFor(size_t count, int timeoutMs = 10000) {
+        unique_lock<mutex> guard(mLock);
+        return mCond.wait_for(guard, std::chrono::milliseconds(timeoutMs),
+                [&]() { return mMsgs.size() >= count; });
+    }
+};
+
+string makeMsg(uint32_t seqNo, uint32_t length) {
+    string msg(length, '\0');
+    for (uint32_t i = 0; i < length; i++) {
+        msg[i] = (char)(seqNo * 31 + i);
+    }
+    memcpy(&msg[0], &seqNo, std::min((uint32_t)sizeof(seqNo), length));
+    return msg;
+}
+
+vector<struct iovec> toIovs(vector<string>& msgs) {
+    vector<struct iovec> iovs;
+    for (auto& msg : msgs) {
+        iovs.push_back({&msg[0], msg.size()});
+    }
+    return iovs;
+}
+
+class LocIpcLocalBatchTest : public ::testing::Test {
+protected:
+    string mName;
+    shared_ptr<MsgListener> mListener;
+    LocIpc mIpc;
+    void SetUp() override {
+        // a name of its own, the listener thread of the last test may still
+        // be about to unlink its socket
+        static int sTestNo = 0;
+        mName = "/tmp/LocIpcSock_test." + std::to_string(getpid()) + "." + std::to_string(sTestNo++);
+        mListener = make_shared<MsgListener>();
+        unique_ptr<LocIpcRecver> recver = LocIpc::getLocIpcLocalRecver(mListener, mName.c_str());
+        ASSERT_TRUE(mIpc.startNonBlockingListening(recver));
+    }
+    void TearDown() override {
+        mIpc.stopNonBlockingListening();
+    }
+};
+
+void noop(int) {}
+
+} // namespace
+
+// More msgs than one sendmmsg() takes, each arriving as a msg of its own
+TEST_F(LocIpcLocalBatchTest, BatchKeepsMsgBoundaries) {
+    const uint32_t kMsgs = 300;
+    vector<string> msgs;
+    for (uint32_t i = 0; i < kMsgs; i++) {
+        msgs.push_back(makeMsg(i, 1 + (i * 37) % 1500));
+    }
+    vector<struct iovec> iovs = toIovs(msgs);
+    shared_ptr<LocIpcSender> sender = LocIpc::getLocIpcLocalSender(mName.c_str());
+    ASSERT_EQ(kMsgs, LocIpc::send(*sender, iovs.data(), kMsgs));
+
+    ASSERT_TRUE(mListener->waitFor(kMsgs));
+    ASSERT_EQ(msgs, mListener->mMsgs);
+}
+
+// A msg over the max tx size of the socket is sent on its own, in pieces
+// that the recver puts back together; the batch goes on after it.
+TEST_F(LocIpcLocalBatchTest, TooLargeMsgInBatch) {
+    vector<string> msgs;
+    msgs.push_back(makeMsg(0, 100));
+    msgs.push_back(makeMsg(1, 8192 * 3 + 5));
+    msgs.push_back(makeMsg(2, 8192));
+    msgs.push_back(makeMsg(3, 8193));
+    msgs.push_back(makeMsg(4, 7));
+    vector<struct iovec> iovs = toIovs(msgs);
+    shared_ptr<LocIpcSender> sender = LocIpc::getLocIpcLocalSender(mName.c_str());
+    ASSERT_EQ(msgs.size(), LocIpc::send(*sender, iovs.data(), msgs.size()));
+
+    ASSERT_TRUE(mListener->waitFor(msgs.size()));
+    ASSERT_EQ(msgs, mListener->mMsgs);
+}
+
+// The msgs before an invalid one are sent, and it and the rest are not
+TEST_F(LocIpcLocalBatchTest, StopsAtInvalidMsg) {
+    vector<string> msgs = {makeMsg(0, 10), makeMsg(1, 20), makeMsg(2, 30)};
+    vector<struct iovec> iovs = toIovs(msgs);
+    iovs[1].iov_len = 0;
+    shared_ptr<LocIpcSender> sender = LocIpc::getLocIpcLocalSender(mName.c_str());
+    ASSERT_EQ(1u, LocIpc::send(*sender, iovs.data(), iovs.size()));
+    ASSERT_TRUE(mListener->waitFor(1));
+    EXPECT_EQ(msgs[0], mListener->mMsgs[0]);
+}
+
+// On TCP the batch is one byte stream. A slow reader, and a signal going
+// off all the while, keep cutting writev() short mid msg; the stream still
+// has every msg, whole and in order.
+TEST(LocIpcTcpBatchTest, PartialWritesComplete) {
+    int server = socket(AF_INET, SOCK_STREAM, 0);
+    ASSERT_GE(server, 0);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    ASSERT_EQ(0, bind(server, (struct sockaddr*)&addr, sizeof(addr)));
+    ASSERT_EQ(0, listen(server, 1));
+    ASSERT_EQ(0, getsockname(server, (struct sockaddr*)&addr, &addrLen));
+
+    vector<string> msgs;
+    string expected;
+    for (uint32_t i = 0; i < 3000; i++) {
+        msgs.push_back(makeMsg(i, 1 + (i * 131) % 4000));
+        expected += msgs.back();
+    }
+    // a msg over the max tx size goes out with its length header
+    string big = makeMsg(3000, 20000);
+    msgs.push_back(big);
+    expected += "$MSGLEN$" + std::to_string(big.size()) + big;
+    vector<struct iovec> iovs = toIovs(msgs);
+
+    // only this thread gets the signal, the reader has it blocked
+    sigset_t alrm;
+    sigemptyset(&alrm);
+    sigaddset(&alrm, SIGALRM);
+    pthread_sigmask(SIG_BLOCK, &alrm, nullptr);
+    string received;
+    std::thread reader([&]() {
+        int conn = accept(server, nullptr, nullptr);
+        char buf[3000];
+        ssize_t n;
+        while ((n = read(conn, buf, sizeof(buf))) > 0) {
+            received.append(buf, n);
+            usleep(50);
+        }
+        close(conn);
+    });
+    pthread_sigmask(SIG_UNBLOCK, &alrm, nullptr);
+
+    struct sigaction sa = {}, oldSa;
+    sa.sa_handler = noop;
+    // no SA_RESTART, so that writev() and send() return early
+    sigaction(SIGALRM, &sa, &oldSa);
+    struct itimerval timer = {{0, 200}, {0, 200}};
+    setitimer(ITIMER_REAL, &timer, nullptr);
+
+    uint32_t sent;
+    {
+        shared_ptr<LocIpcSender> sender =
+                LocIpc::getLocIpcInetTcpSender("127.0.0.1", ntohs(addr.sin_port));
+        sent = LocIpc::send(*sender, iovs.data(), iovs.size());
+    }
+
+    struct itimerval off = {};
+    setitimer(ITIMER_REAL, &off, nullptr);
+    sigaction(SIGALRM, &oldSa, nullptr);
+    reader.join();
+    close(server);
+
+    ASSERT_EQ(msgs.size(), sent);
+    ASSERT_EQ(expected.size(), received.size());
+    EXPECT_TRUE(expected == received);
+}
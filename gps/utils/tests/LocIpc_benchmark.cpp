@@ -0,0 +1,111 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocIpc.h>
+#include <benchmark/benchmark.h>
+#include <sys/socket.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Msgs sent one Sock::send() each, as before LocIpc::send() took a batch,
+// and in one Sock::sendBatch(), over a unix datagram socket pair; a thread
+// on the other end drains them.
+
+using namespace loc_util;
+
+namespace {
+
+const uint32_t kBatch = 64;
+
+class SockPair {
+public:
+    Sock mSock;
+    std::thread mDrain;
+    SockPair(int type) : mSock(-1) {
+        int fds[2];
+        if (0 == socketpair(AF_UNIX, type, 0, fds)) {
+            mSock.mSid = fds[0];
+            mDrain = std::thread([fd = fds[1]]() {
+                std::vector<char> buf(65536);
+                while (::recv(fd, buf.data(), buf.size(), 0) > 0) {
+                }
+                ::close(fd);
+            });
+        }
+    }
+    ~SockPair() {
+        // an empty msg ends the drain, a datagram peer never sees a hang up
+        ::send(mSock.mSid, "", 0, 0);
+        mSock.close();
+        if (mDrain.joinable()) {
+            mDrain.join();
+        }
+    }
+};
+
+void makeBatch(size_t msgSize, std::vector<std::string>& msgs, std::vector<struct iovec>& iovs) {
+    msgs.assign(kBatch, std::string(msgSize, 'x'));
+    for (auto& msg : msgs) {
+        iovs.push_back({&msg[0], msg.size()});
+    }
+}
+
+void sendEach(benchmark::State& state, int type) {
+    SockPair pair(type);
+    std::vector<std::string> msgs;
+    std::vector<struct iovec> iovs;
+    makeBatch(state.range(0), msgs, iovs);
+    for (auto _ : state) {
+        for (auto& iov : iovs) {
+            pair.mSock.send(iov.iov_base, iov.iov_len, 0, nullptr, 0);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+    state.SetBytesProcessed(state.iterations() * kBatch * state.range(0));
+}
+
+void sendBatch(benchmark::State& state, int type) {
+    SockPair pair(type);
+    std::vector<std::string> msgs;
+    std::vector<struct iovec> iovs;
+    makeBatch(state.range(0), msgs, iovs);
+    for (auto _ : state) {
+        pair.mSock.sendBatch(iovs.data(), kBatch, 0, nullptr, 0);
+    }
+    state.SetItemsProcessed(state.iterations() * kBatch);
+    state.SetBytesProcessed(state.iterations() * kBatch * state.range(0));
+}
+
+void BM_DgramSendEach(benchmark::State& state) { sendEach(state, SOCK_DGRAM); }
+void BM_DgramSendBatch(benchmark::State& state) { sendBatch(state, SOCK_DGRAM); }
+
+} // namespace
+
+BENCHMARK(BM_DgramSendEach)->Arg(64)->Arg(1024)->UseRealTime();
+BENCHMARK(BM_DgramSendBatch)->Arg(64)->Arg(1024)->UseRealTime();
@@ -0,0 +1,149 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocHeap.h>
+#include <LocTimerWheel.h>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+// Start / stop / expire of 10k timers, in LocTimerWheel as --with-timer-wheel
+// builds LocTimerContainer, and in the LocHeap it uses otherwise. Expiries
+// are spread over 10 minutes; each start or stop is timed with the other
+// timers in place.
+
+using namespace loc_util;
+
+namespace {
+
+const uint64_t kMsNs = 1000000;
+const uint64_t kSpreadNs = 600000 * kMsNs;
+
+struct WheelTimer : public LocTimerWheelNode {
+    uint64_t mExpiryNs;
+};
+
+// ranked like LocTimerDelegate, the soonest on top; the index breaks ties so
+// that LocHeap::remove() finds the very node
+struct HeapTimer : public LocRankable {
+    uint64_t mExpiryNs;
+    size_t mIndex;
+    virtual int ranks(LocRankable& rankable) {
+        HeapTimer& other = static_cast<HeapTimer&>(rankable);
+        if (mExpiryNs != other.mExpiryNs) {
+            return mExpiryNs < other.mExpiryNs ? 1 : -1;
+        }
+        return mIndex < other.mIndex ? 1 : (mIndex > other.mIndex ? -1 : 0);
+    }
+};
+
+template <typename Timer>
+std::vector<Timer> makeTimers(size_t count) {
+    std::vector<Timer> timers(count);
+    std::mt19937_64 rng(count);
+    for (size_t i = 0; i < count; i++) {
+        timers[i].mExpiryNs = kMsNs + rng() % kSpreadNs;
+    }
+    return timers;
+}
+
+void BM_WheelStartStop(benchmark::State& state) {
+    std::vector<WheelTimer> timers = makeTimers<WheelTimer>(state.range(0));
+    LocTimerWheel wheel(0);
+    for (auto& timer : timers) {
+        wheel.add(timer, timer.mExpiryNs);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        WheelTimer& timer = timers[i++ % timers.size()];
+        wheel.remove(timer);
+        wheel.add(timer, timer.mExpiryNs);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+}
+
+void BM_HeapStartStop(benchmark::State& state) {
+    std::vector<HeapTimer> timers = makeTimers<HeapTimer>(state.range(0));
+    LocHeap heap;
+    for (size_t i = 0; i < timers.size(); i++) {
+        timers[i].mIndex = i;
+        heap.push(timers[i]);
+    }
+    size_t i = 0;
+    for (auto _ : state) {
+        HeapTimer& timer = timers[i++ % timers.size()];
+        heap.remove(timer);
+        heap.push(timer);
+    }
+    state.SetItemsProcessed(state.iterations() * 2);
+    while (heap.pop()) {
+    }
+}
+
+// starts all the timers, then expires them in 1 ms steps
+void BM_WheelExpireAll(benchmark::State& state) {
+    std::vector<WheelTimer> timers = makeTimers<WheelTimer>(state.range(0));
+    std::vector<LocTimerWheelNode*> expired;
+    for (auto _ : state) {
+        LocTimerWheel wheel(0);
+        for (auto& timer : timers) {
+            wheel.add(timer, timer.mExpiryNs);
+        }
+        uint64_t nextNs;
+        while (wheel.getNextTime(nextNs)) {
+            expired.clear();
+            wheel.advance(nextNs, expired);
+            benchmark::DoNotOptimize(expired.data());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * timers.size());
+}
+
+void BM_HeapExpireAll(benchmark::State& state) {
+    std::vector<HeapTimer> timers = makeTimers<HeapTimer>(state.range(0));
+    for (size_t i = 0; i < timers.size(); i++) {
+        timers[i].mIndex = i;
+    }
+    for (auto _ : state) {
+        LocHeap heap;
+        for (auto& timer : timers) {
+            heap.push(timer);
+        }
+        while (LocRankable* top = heap.pop()) {
+            benchmark::DoNotOptimize(top);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * timers.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_WheelStartStop)->Arg(100)->Arg(10000);
+BENCHMARK(BM_HeapStartStop)->Arg(100)->Arg(10000);
+BENCHMARK(BM_WheelExpireAll)->Arg(10000);
+BENCHMARK(BM_HeapExpireAll)->Arg(10000);
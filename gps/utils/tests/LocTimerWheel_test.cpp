@@ -0,0 +1,285 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocTimerWheel.h>
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <map>
+#include <random>
+#include <vector>
+
+// LocTimerWheel is built into the library whether or not LocTimer uses it
+// (--with-timer-wheel), so these run in every configuration.
+
+using namespace loc_util;
+
+namespace {
+
+const uint64_t kTickNs = LocTimerWheel::TICK_NS;
+// span of the wheel, 64^5 ticks
+const uint64_t kSpanTicks = 1ULL << (LocTimerWheel::LEVEL_BITS * LocTimerWheel::TOTAL_LEVELS);
+// arbitrary non zero start, not aligned to any slot
+const uint64_t kStartNs = 123456789ULL * kTickNs + 417;
+
+struct TestTimer : public LocTimerWheelNode {
+    uint64_t mExpiryNs = 0;
+    uint64_t mFiredNs = 0;
+    int mFired = 0;
+};
+
+class LocTimerWheelTest : public ::testing::Test {
+protected:
+    LocTimerWheel mWheel{kStartNs};
+    uint64_t mNowNs = kStartNs;
+    std::vector<LocTimerWheelNode*> mExpired;
+
+    void add(TestTimer& timer, uint64_t delayNs) {
+        timer.mExpiryNs = mNowNs + delayNs;
+        mWheel.add(timer, timer.mExpiryNs);
+    }
+
+    // advances to nowNs and records the firing on the timers that went off
+    std::vector<TestTimer*> advance(uint64_t nowNs) {
+        mNowNs = nowNs;
+        mExpired.clear();
+        mWheel.advance(nowNs, mExpired);
+        std::vector<TestTimer*> fired;
+        for (auto node : mExpired) {
+            TestTimer* timer = static_cast<TestTimer*>(node);
+            EXPECT_FALSE(timer->isLinked());
+            timer->mFiredNs = nowNs;
+            timer->mFired++;
+            fired.push_back(timer);
+        }
+        return fired;
+    }
+
+    // runs the wheel the way LocTimerContainer does, from one getNextTime()
+    // to the next, until it is empty; returns the number of advances
+    int runToEmpty() {
+        int steps = 0;
+        uint64_t nextNs;
+        while (mWheel.getNextTime(nextNs)) {
+            EXPECT_GE(nextNs + kTickNs, mNowNs);
+            advance(std::max(nextNs, mNowNs));
+            steps++;
+        }
+        return steps;
+    }
+
+    // never early, and at most a tick late
+    static void expectOnTime(const TestTimer& timer) {
+        EXPECT_EQ(1, timer.mFired);
+        EXPECT_GE(timer.mFiredNs, timer.mExpiryNs);
+        EXPECT_LT(timer.mFiredNs, timer.mExpiryNs + kTickNs);
+    }
+};
+
+TEST_F(LocTimerWheelTest, EmptyWheelHasNoNextTime) {
+    uint64_t nextNs = 0;
+    EXPECT_FALSE(mWheel.getNextTime(nextNs));
+    EXPECT_TRUE(advance(kStartNs + 1000 * kTickNs).empty());
+    EXPECT_EQ(0u, mWheel.size());
+}
+
+TEST_F(LocTimerWheelTest, ExpiresInOrderNeverEarly) {
+    TestTimer timers[4];
+    add(timers[0], 30 * kTickNs);
+    add(timers[1], 5 * kTickNs + 1);
+    add(timers[2], 0);
+    add(timers[3], 5 * kTickNs + 1);
+    EXPECT_EQ(4u, mWheel.size());
+
+    // one ns before the second timer is due
+    std::vector<TestTimer*> fired = advance(timers[1].mExpiryNs - 1);
+    ASSERT_EQ(1u, fired.size());
+    EXPECT_EQ(&timers[2], fired[0]);
+
+    fired = advance(timers[0].mExpiryNs + 10 * kTickNs);
+    ASSERT_EQ(3u, fired.size());
+    EXPECT_EQ(&timers[0], fired[2]);
+    EXPECT_EQ(0u, mWheel.size());
+}
+
+TEST_F(LocTimerWheelTest, CascadesDownTheLevels) {
+    // one timer on each level, each just past a slot boundary of its level
+    std::vector<TestTimer> timers(LocTimerWheel::TOTAL_LEVELS);
+    for (int level = 0; level < LocTimerWheel::TOTAL_LEVELS; level++) {
+        uint64_t ticks = (1ULL << (LocTimerWheel::LEVEL_BITS * level)) * 3 + 7;
+        add(timers[level], ticks * kTickNs);
+    }
+    int steps = runToEmpty();
+    for (auto& timer : timers) {
+        expectOnTime(timer);
+    }
+    // each timer only gets hashed again on the way down, no tick by tick walk
+    EXPECT_LT(steps, 64 * LocTimerWheel::TOTAL_LEVELS);
+    EXPECT_EQ(0u, mWheel.size());
+}
+
+TEST_F(LocTimerWheelTest, BeyondTopLevelIsParkedAndHashedAgain) {
+    TestTimer far, farther, near;
+    add(far, (kSpanTicks + 12345) * kTickNs);
+    add(farther, (3 * kSpanTicks + 99) * kTickNs);
+    add(near, kTickNs);
+
+    uint64_t nextNs;
+    ASSERT_TRUE(mWheel.getNextTime(nextNs));
+    EXPECT_LE(nextNs, near.mExpiryNs + kTickNs);
+
+    runToEmpty();
+    expectOnTime(near);
+    expectOnTime(far);
+    expectOnTime(farther);
+}
+
+TEST_F(LocTimerWheelTest, LateAdvanceExpiresEverythingDueInOrder) {
+    std::vector<TestTimer> timers(200);
+    std::mt19937_64 rng(7);
+    for (auto& timer : timers) {
+        add(timer, rng() % (64ULL * 64 * 64 * 64 * kTickNs));
+    }
+    TestTimer later;
+    add(later, 64ULL * 64 * 64 * 64 * kTickNs + 5 * kTickNs);
+
+    // one advance, late by days, over every level
+    std::vector<TestTimer*> fired = advance(kStartNs + 64ULL * 64 * 64 * 64 * kTickNs);
+    ASSERT_EQ(timers.size(), fired.size());
+    for (size_t i = 1; i < fired.size(); i++) {
+        EXPECT_LE((fired[i - 1]->mExpiryNs + kTickNs - 1) / kTickNs,
+                  (fired[i]->mExpiryNs + kTickNs - 1) / kTickNs);
+    }
+    EXPECT_EQ(1u, mWheel.size());
+    EXPECT_EQ(0, later.mFired);
+
+    // the timer left is hashed relative to the new time
+    runToEmpty();
+    expectOnTime(later);
+}
+
+TEST_F(LocTimerWheelTest, AdvanceBackwardsIsIgnored) {
+    TestTimer timer;
+    add(timer, 10 * kTickNs);
+    EXPECT_TRUE(advance(kStartNs - 100 * kTickNs).empty());
+    mNowNs = kStartNs;
+    runToEmpty();
+    expectOnTime(timer);
+}
+
+TEST_F(LocTimerWheelTest, CancelDuringExpiry) {
+    // timers that go off in the same advance, and one still pending
+    TestTimer a, b, c, pending;
+    add(a, 3 * kTickNs);
+    add(b, 4 * kTickNs);
+    add(c, 4 * kTickNs);
+    add(pending, 500 * kTickNs);
+
+    mExpired.clear();
+    mWheel.advance(kStartNs + 10 * kTickNs, mExpired);
+    ASSERT_EQ(3u, mExpired.size());
+    EXPECT_EQ(1u, mWheel.size());
+    // the callback of a stops b, which already went off, and the pending one
+    mWheel.remove(b);
+    mWheel.remove(pending);
+    EXPECT_EQ(0u, mWheel.size());
+    // and restarts c, which went off in the same advance too
+    mNowNs = kStartNs + 10 * kTickNs;
+    add(c, 20 * kTickNs);
+    EXPECT_EQ(1u, mWheel.size());
+    // stopping a twice is harmless
+    mWheel.remove(a);
+    mWheel.remove(a);
+    EXPECT_EQ(1u, mWheel.size());
+
+    runToEmpty();
+    expectOnTime(c);
+    EXPECT_EQ(0, pending.mFired);
+}
+
+TEST_F(LocTimerWheelTest, RestartMovesTimer) {
+    TestTimer timer;
+    add(timer, 5000 * kTickNs);
+    add(timer, 2 * kTickNs);
+    EXPECT_EQ(1u, mWheel.size());
+    runToEmpty();
+    expectOnTime(timer);
+}
+
+// random starts, stops and advances against a plain ordered map
+TEST_F(LocTimerWheelTest, MatchesReference) {
+    std::vector<TestTimer> timers(500);
+    std::multimap<uint64_t, TestTimer*> reference;
+    std::mt19937_64 rng(2021);
+
+    auto unref = [&reference](TestTimer* timer) {
+        for (auto it = reference.begin(); it != reference.end(); ++it) {
+            if (it->second == timer) {
+                reference.erase(it);
+                return;
+            }
+        }
+    };
+
+    for (int round = 0; round < 20000; round++) {
+        TestTimer& timer = timers[rng() % timers.size()];
+        switch (rng() % 4) {
+        case 0:
+        case 1: {
+            // mostly short, some up to a level 3 span
+            uint64_t delayNs = (rng() % 8) ? rng() % (100 * kTickNs) :
+                    rng() % (64ULL * 64 * 64 * kTickNs);
+            unref(&timer);
+            add(timer, delayNs);
+            reference.emplace((timer.mExpiryNs + kTickNs - 1) / kTickNs, &timer);
+            break;
+        }
+        case 2:
+            unref(&timer);
+            mWheel.remove(timer);
+            break;
+        default: {
+            uint64_t nowNs = mNowNs + rng() % (50 * kTickNs);
+            uint64_t nowTick = nowNs / kTickNs;
+            std::vector<TestTimer*> fired = advance(nowNs);
+            std::vector<TestTimer*> due;
+            while (!reference.empty() && reference.begin()->first <= nowTick) {
+                due.push_back(reference.begin()->second);
+                reference.erase(reference.begin());
+            }
+            auto byPtr = [](TestTimer* x, TestTimer* y) { return x < y; };
+            std::sort(fired.begin(), fired.end(), byPtr);
+            std::sort(due.begin(), due.end(), byPtr);
+            ASSERT_EQ(due, fired) << "round " << round;
+            break;
+        }
+        }
+        ASSERT_EQ(reference.size(), mWheel.size());
+    }
+}
+
+} // namespace
@@ -0,0 +1,137 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LocTimer.h>
+#include <gtest/gtest.h>
+#include <time.h>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace loc_util;
+
+namespace {
+
+static uint64_t bootTimeMs() {
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    return (uint64_t)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+class StressTimer : public LocTimer {
+public:
+    std::atomic<int> mFired;
+    std::atomic<uint64_t> mFiredMs;
+    uint64_t mDeadlineMs;
+    StressTimer() : mFired(0), mFiredMs(0), mDeadlineMs(0) {}
+    bool arm(uint32_t timeOutMs) {
+        mDeadlineMs = bootTimeMs() + timeOutMs;
+        return start(timeOutMs, false);
+    }
+    void timeOutCallback() override {
+        mFiredMs = bootTimeMs();
+        mFired++;
+    }
+};
+
+} // namespace
+
+// Many timers started, stopped and restarted from several threads at once;
+// each timer left running must go off exactly once and never early, and a
+// stopped timer must never go off.
+TEST(LocTimer, StartStopStress) {
+    const int kThreads = 4;
+    const int kTimersPerThread = 500;
+    const uint32_t kMaxTimeOutMs = 200;
+    std::vector<std::unique_ptr<StressTimer>> timers(kThreads * kTimersPerThread);
+    std::vector<bool> stopped(timers.size(), false);
+    for (auto& timer : timers) {
+        timer.reset(new StressTimer());
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; t++) {
+        threads.emplace_back([&, t]() {
+            std::mt19937 rand(t);
+            for (int i = 0; i < kTimersPerThread; i++) {
+                size_t idx = t * kTimersPerThread + i;
+                StressTimer& timer = *timers[idx];
+                ASSERT_TRUE(timer.arm(1 + rand() % kMaxTimeOutMs));
+                // the same timer can not be started twice
+                EXPECT_FALSE(timer.start(1, false));
+                switch (rand() % 4) {
+                case 0:
+                    // stopped for good
+                    stopped[idx] = timer.stop();
+                    break;
+                case 1:
+                    // restarted with another timeout
+                    if (timer.stop()) {
+                        ASSERT_TRUE(timer.arm(1 + rand() % kMaxTimeOutMs));
+                    }
+                    break;
+                default:
+                    break;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(kMaxTimeOutMs + 300));
+    for (size_t i = 0; i < timers.size(); i++) {
+        StressTimer& timer = *timers[i];
+        if (stopped[i]) {
+            EXPECT_EQ(0, timer.mFired) << "timer " << i;
+        } else {
+            ASSERT_EQ(1, timer.mFired) << "timer " << i;
+            EXPECT_GE(timer.mFiredMs, timer.mDeadlineMs) << "timer " << i;
+        }
+        // stop() fails once the timer went off
+        EXPECT_FALSE(timer.stop());
+    }
+}
+
+// Timers with the same timeout started together all go off together.
+TEST(LocTimer, SameTickTimers) {
+    std::vector<std::unique_ptr<StressTimer>> timers(100);
+    for (auto& timer : timers) {
+        timer.reset(new StressTimer());
+        ASSERT_TRUE(timer->arm(50));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    for (auto& timer : timers) {
+        EXPECT_EQ(1, timer->mFired);
+        EXPECT_GE(timer->mFiredMs, timer->mDeadlineMs);
+    }
+}
@@ -0,0 +1,148 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <LogBuffer.h>
+#include <gtest/gtest.h>
+#include <string.h>
+#include <thread>
+
+using namespace loc_util;
+
+namespace {
+
+static void logf(int level, const char* tag, const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    LogBuffer::getInstance()->appendv(level, tag, format, args);
+    va_end(args);
+}
+
+static vector<string> dumpLevel(int level) {
+    vector<string> lines;
+    LogBuffer::getInstance()->dump([&lines](stringstream& line) {
+        lines.push_back(line.str());
+    }, level);
+    // the first line is the dump header
+    lines.erase(lines.begin());
+    return lines;
+}
+
+class LogBufferTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        LogBuffer::getInstance()->flush();
+    }
+};
+
+} // namespace
+
+TEST_F(LogBufferTest, LevelsDoNotEvictEachOther) {
+    logf(0, "Tag", "error %d", 1);
+    logf(0, "Tag", "error %d", 2);
+    for (int i = 0; i < 10 * MAXIMUM_NUM_IN_LIST; i++) {
+        logf(4, "Tag", "verbose %d", i);
+    }
+    vector<string> errors = dumpLevel(0);
+    ASSERT_EQ(2u, errors.size());
+    EXPECT_NE(string::npos, errors[0].find("Level E:"));
+    EXPECT_NE(string::npos, errors[0].find("Tag :error 1\n"));
+    EXPECT_NE(string::npos, errors[1].find("Tag :error 2\n"));
+
+    // the default MAX_CAPACITY, with the most recent lines kept
+    vector<string> verbose = dumpLevel(4);
+    ASSERT_EQ((size_t)MAXIMUM_NUM_IN_LIST, verbose.size());
+    EXPECT_NE(string::npos, verbose.back().find(
+            ":verbose " + std::to_string(10 * MAXIMUM_NUM_IN_LIST - 1) + "\n"));
+}
+
+TEST_F(LogBufferTest, FormatsAtLogTime) {
+    char tag[16];
+    char arg[16];
+    strlcpy(tag, "LocSvc_Test", sizeof(tag));
+    strlcpy(arg, "abcdef", sizeof(arg));
+    logf(1, tag, "[%.3s] [%5.2s] [%-4d] [%.*s]", arg, arg, 7, 2, arg);
+    // neither the tag nor the args are referenced after the log call
+    memset(tag, 'x', sizeof(tag) - 1);
+    memset(arg, 'y', sizeof(arg) - 1);
+
+    vector<string> lines = dumpLevel(1);
+    ASSERT_EQ(1u, lines.size());
+    EXPECT_NE(string::npos, lines[0].find(" LocSvc_Test :[abc] [   ab] [7   ] [ab]\n"))
+            << lines[0];
+}
+
+TEST_F(LogBufferTest, LongLineIsCut) {
+    string longArg(2 * LOGGING_BUFFER_MAX_LEN, 'z');
+    logf(2, "Tag", "%s", longArg.c_str());
+    vector<string> lines = dumpLevel(2);
+    ASSERT_EQ(1u, lines.size());
+    EXPECT_NE(string::npos, lines[0].find(string(LOGGING_BUFFER_MAX_LEN - 1, 'z') + "...\n"));
+    EXPECT_LT(lines[0].size(), (size_t)LOGGING_BUFFER_MAX_LEN + 128);
+}
+
+TEST_F(LogBufferTest, LineOfMaxLenIsKept) {
+    string arg(LOGGING_BUFFER_MAX_LEN - 1, 'w');
+    logf(2, "Tag", "%s", arg.c_str());
+    vector<string> lines = dumpLevel(2);
+    ASSERT_EQ(1u, lines.size());
+    EXPECT_NE(string::npos, lines[0].find(" Tag :" + arg + "\n")) << lines[0];
+}
+
+TEST_F(LogBufferTest, RawAppendIsKeptAsIs) {
+    string data("raw line");
+    LogBuffer::getInstance()->append(data, 3, 100);
+    vector<string> lines = dumpLevel(3);
+    ASSERT_EQ(1u, lines.size());
+    EXPECT_EQ("[100] Level D: raw line\n", lines[0]);
+}
+
+TEST_F(LogBufferTest, FlushDropsRecords) {
+    logf(0, "Tag", "error");
+    LogBuffer::getInstance()->flush();
+    EXPECT_EQ(0u, dumpLevel(0).size());
+}
+
+TEST_F(LogBufferTest, ConcurrentWritersAndDump) {
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([t]() {
+            for (int i = 0; i < 20000; i++) {
+                logf(3, "Tag", "writer %d line %d", t, i);
+            }
+        });
+    }
+    for (int i = 0; i < 20; i++) {
+        for (auto& line : dumpLevel(3)) {
+            ASSERT_NE(string::npos, line.find("Tag :writer ")) << line;
+        }
+    }
+    for (auto& t : writers) {
+        t.join();
+    }
+    EXPECT_EQ((size_t)MAXIMUM_NUM_IN_LIST, dumpLevel(3).size());
+}
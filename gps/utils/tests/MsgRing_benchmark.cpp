@@ -0,0 +1,138 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <MsgRing.h>
+#include <MsgTask.h>
+#include <msg_q.h>
+#include <benchmark/benchmark.h>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Send throughput of msg_q vs MsgRing, and of the MsgTask queue modes, with
+// 1 to 8 concurrent senders and a single receiver. Each iteration sends
+// kMsgsPerIteration msgs in total and returns once all of them are received.
+
+using namespace loc_util;
+
+namespace {
+
+const int kMsgsPerIteration = 100000;
+
+struct BenchMsg : public LocMsg {
+    void proc() const override {}
+};
+
+void freeBenchMsg(void* msg) {
+    delete (BenchMsg*)msg;
+}
+
+template <typename SendFn>
+void runSenders(int senders, SendFn send) {
+    std::vector<std::thread> threads;
+    for (int s = 0; s < senders; s++) {
+        threads.emplace_back([send, senders]() {
+            for (int i = 0; i < kMsgsPerIteration / senders; i++) {
+                send();
+            }
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+}
+
+void BM_MsgQ(benchmark::State& state) {
+    const int senders = state.range(0);
+    const int total = kMsgsPerIteration / senders * senders;
+    void* q = nullptr;
+    msg_q_init(&q);
+    for (auto _ : state) {
+        std::thread receiver([q, total]() {
+            void* msg = nullptr;
+            for (int i = 0; i < total && eMSG_Q_SUCCESS == msg_q_rcv(q, &msg); i++) {
+                freeBenchMsg(msg);
+            }
+        });
+        runSenders(senders, [q]() { msg_q_snd(q, new BenchMsg, freeBenchMsg); });
+        receiver.join();
+    }
+    msg_q_unblock(q);
+    msg_q_destroy(&q);
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+void BM_MsgRing(benchmark::State& state) {
+    const int senders = state.range(0);
+    const int total = kMsgsPerIteration / senders * senders;
+    MsgRing ring(256);
+    for (auto _ : state) {
+        std::thread receiver([&ring, total]() {
+            for (int i = 0; i < total; i++) {
+                delete ring.rcv();
+            }
+        });
+        runSenders(senders, [&ring]() { ring.snd(new BenchMsg); });
+        receiver.join();
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+void BM_MsgTask(benchmark::State& state, MsgTask::QueueMode mode) {
+    const int senders = state.range(0);
+    const int total = kMsgsPerIteration / senders * senders;
+    MsgTask task("BM_MsgTask", mode);
+    std::mutex lock;
+    std::condition_variable done;
+    int received = 0;
+    for (auto _ : state) {
+        received = 0;
+        runSenders(senders, [&]() {
+            task.sendMsg([&]() {
+                std::lock_guard<std::mutex> guard(lock);
+                if (++received == total) {
+                    done.notify_one();
+                }
+            });
+        });
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [&]() { return received == total; });
+    }
+    state.SetItemsProcessed(state.iterations() * total);
+}
+
+} // namespace
+
+BENCHMARK(BM_MsgQ)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK(BM_MsgRing)->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_MsgTask, list, MsgTask::QUEUE_MODE_LIST)
+        ->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
+BENCHMARK_CAPTURE(BM_MsgTask, ring, MsgTask::QUEUE_MODE_RING)
+        ->RangeMultiplier(2)->Range(1, 8)->UseRealTime();
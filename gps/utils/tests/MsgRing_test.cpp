@@ -0,0 +1,154 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <MsgRing.h>
+#include <MsgTask.h>
+#include <gtest/gtest.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace loc_util;
+
+namespace {
+
+std::atomic<int> sLiveMsgs(0);
+
+struct TestMsg : public LocMsg {
+    uint32_t mSender;
+    uint32_t mSeqNo;
+    TestMsg(uint32_t sender, uint32_t seqNo) : mSender(sender), mSeqNo(seqNo) {
+        sLiveMsgs++;
+    }
+    ~TestMsg() { sLiveMsgs--; }
+    void proc() const override {}
+};
+
+} // namespace
+
+TEST(MsgRing, FifoThroughOverflow) {
+    MsgRing ring(4);
+    for (uint32_t i = 0; i < 100; i++) {
+        ASSERT_TRUE(ring.snd(new TestMsg(0, i)));
+    }
+    for (uint32_t i = 0; i < 100; i++) {
+        TestMsg* msg = static_cast<TestMsg*>(ring.tryRcv());
+        ASSERT_NE(nullptr, msg);
+        EXPECT_EQ(i, msg->mSeqNo);
+        delete msg;
+    }
+    EXPECT_EQ(nullptr, ring.tryRcv());
+}
+
+TEST(MsgRing, InterleavedSndRcvThroughOverflow) {
+    MsgRing ring(4);
+    uint32_t sent = 0, received = 0;
+    for (int round = 0; round < 50; round++) {
+        for (int i = 0; i < 7; i++) {
+            ASSERT_TRUE(ring.snd(new TestMsg(0, sent++)));
+        }
+        for (int i = 0; i < 5; i++) {
+            TestMsg* msg = static_cast<TestMsg*>(ring.tryRcv());
+            ASSERT_NE(nullptr, msg);
+            EXPECT_EQ(received++, msg->mSeqNo);
+            delete msg;
+        }
+    }
+    while (TestMsg* msg = static_cast<TestMsg*>(ring.tryRcv())) {
+        EXPECT_EQ(received++, msg->mSeqNo);
+        delete msg;
+    }
+    EXPECT_EQ(sent, received);
+}
+
+TEST(MsgRing, PerSenderOrderWithConcurrentSenders) {
+    const uint32_t kSenders = 4;
+    const uint32_t kMsgsPerSender = 200000;
+    // small ring, so that the overflow path is hit all the time
+    MsgRing ring(16);
+    std::vector<std::thread> senders;
+    for (uint32_t s = 0; s < kSenders; s++) {
+        senders.emplace_back([&ring, s, kMsgsPerSender]() {
+            for (uint32_t i = 0; i < kMsgsPerSender; i++) {
+                ring.snd(new TestMsg(s, i));
+            }
+        });
+    }
+
+    std::vector<uint32_t> next(kSenders, 0);
+    for (uint32_t n = 0; n < kSenders * kMsgsPerSender; n++) {
+        TestMsg* msg = static_cast<TestMsg*>(ring.rcv());
+        ASSERT_NE(nullptr, msg);
+        ASSERT_LT(msg->mSender, kSenders);
+        ASSERT_EQ(next[msg->mSender], msg->mSeqNo) << "sender " << msg->mSender;
+        next[msg->mSender]++;
+        delete msg;
+    }
+    for (auto& t : senders) {
+        t.join();
+    }
+    EXPECT_EQ(nullptr, ring.tryRcv());
+}
+
+TEST(MsgRing, UnblockWakesReceiverAndRejectsSnd) {
+    MsgRing ring(8);
+    std::atomic<bool> woken(false);
+    std::thread receiver([&]() {
+        EXPECT_EQ(nullptr, ring.rcv());
+        woken = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(woken);
+    ring.unblock();
+    receiver.join();
+    EXPECT_TRUE(woken);
+
+    TestMsg* msg = new TestMsg(0, 0);
+    EXPECT_FALSE(ring.snd(msg));
+    delete msg;
+}
+
+TEST(MsgRing, FlushDeletesQueuedMsgs) {
+    int live = sLiveMsgs;
+    {
+        MsgRing ring(4);
+        for (uint32_t i = 0; i < 10; i++) {
+            ring.snd(new TestMsg(0, i));
+        }
+        EXPECT_EQ(live + 10, sLiveMsgs);
+        ring.flush();
+        EXPECT_EQ(live, sLiveMsgs);
+        EXPECT_EQ(nullptr, ring.tryRcv());
+
+        // the destructor flushes as well
+        for (uint32_t i = 0; i < 10; i++) {
+            ring.snd(new TestMsg(0, i));
+        }
+    }
+    EXPECT_EQ(live, sLiveMsgs);
+}
@@ -0,0 +1,86 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <SkipList.h>
+#include <benchmark/benchmark.h>
+
+// SkipList as LogBuffer uses it on dump: entries of 5 levels replayed with
+// each level held at its size limit, then visited in append order.
+
+using namespace loc_util;
+
+namespace {
+
+const int kLevels = 5;
+
+void BM_SkipListAppendAtCapacity(benchmark::State& state) {
+    SkipList<pair<uint64_t, const void*>> skipList(kLevels, state.range(0));
+    uint64_t n = 0;
+    for (auto _ : state) {
+        pair<uint64_t, const void*> item(n, nullptr);
+        skipList.append(item, n++ % kLevels);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SkipListAppendWithTimeDepth(benchmark::State& state) {
+    SkipList<pair<uint64_t, const void*>> skipList(kLevels, state.range(0));
+    uint64_t n = 0;
+    for (auto _ : state) {
+        int level = n % kLevels;
+        pair<uint64_t, const void*> item(n / 16, nullptr);
+        skipList.append(item, level);
+        while (skipList.size(level) > 0 && n / 16 - skipList.front(level).first > 60) {
+            skipList.pop(level);
+        }
+        n++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_SkipListForEach(benchmark::State& state) {
+    SkipList<pair<uint64_t, const void*>> skipList(kLevels, state.range(0));
+    for (uint64_t n = 0; n < (uint64_t)state.range(0) * kLevels; n++) {
+        pair<uint64_t, const void*> item(n, nullptr);
+        skipList.append(item, n % kLevels);
+    }
+    for (auto _ : state) {
+        uint64_t sum = 0;
+        skipList.forEach([&sum](const pair<uint64_t, const void*>& item, int) {
+            sum += item.first;
+        });
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * skipList.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_SkipListAppendAtCapacity)->Arg(50)->Arg(1000)->Arg(4096);
+BENCHMARK(BM_SkipListAppendWithTimeDepth)->Arg(50)->Arg(1000)->Arg(4096);
+BENCHMARK(BM_SkipListForEach)->Arg(50)->Arg(1000)->Arg(4096);
@@ -0,0 +1,97 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <SkipList.h>
+#include <gtest/gtest.h>
+
+using namespace loc_util;
+
+TEST(SkipList, FullLevelEvictsItsOldest) {
+    SkipList<int> skipList(vector<size_t>{2, 3});
+    for (int i = 0; i < 5; i++) {
+        skipList.append(i, 0);
+    }
+    int v = 100;
+    skipList.append(v, 1);
+    EXPECT_EQ(3, skipList.size());
+    EXPECT_EQ(2, skipList.size(0));
+    EXPECT_EQ(1, skipList.size(1));
+    EXPECT_EQ(3, skipList.front(0));
+    EXPECT_EQ(100, skipList.front(1));
+}
+
+TEST(SkipList, ZeroCapacityLevelKeepsNothing) {
+    SkipList<int> skipList(vector<size_t>{0, 1});
+    int v = 1;
+    skipList.append(v, 0);
+    skipList.append(v, 1);
+    EXPECT_EQ(0, skipList.size(0));
+    EXPECT_EQ(1, skipList.size());
+}
+
+TEST(SkipList, DumpMergesLevelsInAppendOrder) {
+    SkipList<int> skipList(3, 4);
+    int levels[] = {2, 0, 1, 0, 2, 2, 1};
+    for (int i = 0; i < 7; i++) {
+        skipList.append(i, levels[i]);
+    }
+    list<pair<int, int>> all = skipList.dump();
+    ASSERT_EQ(7u, all.size());
+    int i = 0;
+    for (auto& entry : all) {
+        EXPECT_EQ(i, entry.first);
+        EXPECT_EQ(levels[i], entry.second);
+        i++;
+    }
+
+    skipList.pop();
+    skipList.pop(2);
+    list<pair<int, int>> level2 = skipList.dump(2);
+    ASSERT_EQ(1u, level2.size());
+    EXPECT_EQ(5, level2.front().first);
+    EXPECT_EQ(5, skipList.size());
+}
+
+TEST(SkipList, WrapsAroundAfterPops) {
+    SkipList<int> skipList(1, 3);
+    int next = 0;
+    for (int round = 0; round < 10; round++) {
+        skipList.append(next, 0);
+        next++;
+        skipList.append(next, 0);
+        next++;
+        skipList.pop(0);
+    }
+    // the level got full, evicted its oldest entries, then one was popped
+    list<pair<int, int>> entries = skipList.dump(0);
+    ASSERT_EQ(2u, entries.size());
+    EXPECT_EQ(next - 2, entries.front().first);
+    EXPECT_EQ(next - 1, entries.back().first);
+    skipList.flush();
+    EXPECT_EQ(0, skipList.size());
+}
@@ -0,0 +1,121 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <loc_cfg.h>
+#include <benchmark/benchmark.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// A conf file read the way the HAL reads them at startup: one table with
+// every name the file sets, read through the cache of parsed files, versus
+// reading it line by line as loc_read_conf() did before, once for the table
+// and once more for the logging parameters.
+
+using namespace std;
+
+namespace {
+
+static string srcPath(const char* relPath) {
+    const char* srcdir = getenv("srcdir");
+    return string((nullptr != srcdir) ? srcdir : ".") + "/" + relPath;
+}
+
+class ConfTable {
+    vector<string> mNames;
+    vector<array<char, LOC_MAX_PARAM_STRING>> mValues;
+public:
+    vector<loc_param_s_type> mTable;
+
+    ConfTable(const string& path) {
+        ifstream file(path);
+        string line;
+        while (getline(file, line)) {
+            size_t first = line.find_first_not_of(" \t");
+            size_t eq = line.find('=');
+            if (string::npos == first || '#' == line[first] || string::npos == eq ||
+                eq <= first) {
+                continue;
+            }
+            size_t last = line.find_last_not_of(" \t", eq - 1);
+            string name = line.substr(first, last + 1 - first);
+            if (mNames.end() == find(mNames.begin(), mNames.end(), name)) {
+                mNames.push_back(name);
+            }
+        }
+        mValues.resize(mNames.size());
+        for (size_t i = 0; i < mNames.size(); i++) {
+            mTable.push_back({mNames[i].c_str(), mValues[i].data(), NULL, 's'});
+        }
+    }
+};
+
+void BM_ReadConfCached(benchmark::State& state, const char* relPath) {
+    string path = srcPath(relPath);
+    ConfTable conf(path);
+    for (auto _ : state) {
+        loc_read_conf(path.c_str(), conf.mTable.data(), conf.mTable.size());
+    }
+    state.SetItemsProcessed(state.iterations() * conf.mTable.size());
+}
+
+void BM_ReadConfStream(benchmark::State& state, const char* relPath) {
+    string path = srcPath(relPath);
+    ConfTable conf(path);
+    uint32_t debugLevel, timestamp, datumType, logBufferEnabled, msgTaskStatsEnabled;
+    loc_param_s_type logTable[] = {
+        {"DEBUG_LEVEL",             &debugLevel,          NULL, 'n'},
+        {"TIMESTAMP",               &timestamp,           NULL, 'n'},
+        {"DATUM_TYPE",              &datumType,           NULL, 'n'},
+        {"LOG_BUFFER_ENABLED",      &logBufferEnabled,    NULL, 'n'},
+        {"MSG_TASK_STATS_ENABLED",  &msgTaskStatsEnabled, NULL, 'n'},
+    };
+    for (auto _ : state) {
+        FILE* fp = fopen(path.c_str(), "r");
+        if (nullptr == fp) {
+            state.SkipWithError("no conf file");
+            break;
+        }
+        loc_read_conf_r(fp, conf.mTable.data(), conf.mTable.size());
+        rewind(fp);
+        loc_read_conf_r(fp, logTable, sizeof(logTable) / sizeof(logTable[0]));
+        fclose(fp);
+    }
+    state.SetItemsProcessed(state.iterations() * conf.mTable.size());
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_ReadConfCached, gps_conf, "../etc/gps.conf");
+BENCHMARK_CAPTURE(BM_ReadConfStream, gps_conf, "../etc/gps.conf");
+BENCHMARK_CAPTURE(BM_ReadConfCached, flp_conf, "../etc/flp.conf");
+BENCHMARK_CAPTURE(BM_ReadConfStream, flp_conf, "../etc/flp.conf");
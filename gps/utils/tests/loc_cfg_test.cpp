@@ -0,0 +1,206 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <loc_cfg.h>
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// loc_read_conf() serves the tables from a cache of the parsed file, while
+// loc_read_conf_r() still reads them line by line from a FILE*, as
+// loc_read_conf() used to. The shipped conf files must read the same
+// either way.
+
+namespace {
+
+static string srcPath(const char* relPath) {
+    const char* srcdir = getenv("srcdir");
+    return string((nullptr != srcdir) ? srcdir : ".") + "/" + relPath;
+}
+
+static string tempPath(const char* name) {
+    const char* tmpdir = getenv("TMPDIR");
+    return string((nullptr != tmpdir) ? tmpdir : "/tmp") + "/" + name + "." +
+            to_string(getpid());
+}
+
+// the names set by the lines of the file, comments left out
+static vector<string> confNames(const string& path) {
+    vector<string> names;
+    ifstream file(path);
+    string line;
+    while (getline(file, line)) {
+        size_t first = line.find_first_not_of(" \t");
+        size_t eq = line.find('=');
+        if (string::npos == first || '#' == line[first] || string::npos == eq || eq <= first) {
+            continue;
+        }
+        size_t last = line.find_last_not_of(" \t", eq - 1);
+        string name = line.substr(first, last + 1 - first);
+        if (names.end() == find(names.begin(), names.end(), name)) {
+            names.push_back(name);
+        }
+    }
+    return names;
+}
+
+// one string, int and double table entry per name
+struct ConfValues {
+    vector<string> mNames;
+    vector<array<char, LOC_MAX_PARAM_STRING>> mStr;
+    vector<int> mInt;
+    vector<double> mDouble;
+    vector<uint8_t> mSet;
+    vector<loc_param_s_type> mTables[3];
+
+    ConfValues(const vector<string>& names) :
+            mNames(names), mStr(names.size()), mInt(names.size(), -1),
+            mDouble(names.size(), -1.0), mSet(names.size() * 3, 0xff) {
+        for (size_t i = 0; i < mNames.size(); i++) {
+            mStr[i].fill(0);
+            const char* name = mNames[i].c_str();
+            mTables[0].push_back({name, mStr[i].data(), &mSet[i * 3], 's'});
+            mTables[1].push_back({name, &mInt[i], &mSet[i * 3 + 1], 'n'});
+            mTables[2].push_back({name, &mDouble[i], &mSet[i * 3 + 2], 'f'});
+        }
+    }
+    void readCached(const string& path) {
+        for (auto& table : mTables) {
+            loc_read_conf(path.c_str(), table.data(), table.size());
+        }
+    }
+    void readStream(const string& path) {
+        for (auto& table : mTables) {
+            FILE* fp = fopen(path.c_str(), "r");
+            ASSERT_NE(nullptr, fp) << path;
+            loc_read_conf_r(fp, table.data(), table.size());
+            fclose(fp);
+        }
+    }
+};
+
+static void writeFile(const string& path, const char* content) {
+    FILE* fp = fopen(path.c_str(), "w");
+    ASSERT_NE(nullptr, fp) << path;
+    fputs(content, fp);
+    fclose(fp);
+}
+
+class LocCfgShippedConf : public ::testing::TestWithParam<const char*> {};
+
+} // namespace
+
+TEST_P(LocCfgShippedConf, CachedReadsAsStream) {
+    string path = srcPath(GetParam());
+    vector<string> names = confNames(path);
+    ASSERT_LT(0u, names.size()) << path;
+
+    ConfValues cached(names);
+    ConfValues stream(names);
+    cached.readCached(path);
+    // a second read is served from the cache
+    cached.readCached(path);
+    stream.readStream(path);
+
+    for (size_t i = 0; i < names.size(); i++) {
+        SCOPED_TRACE(names[i]);
+        EXPECT_STREQ(stream.mStr[i].data(), cached.mStr[i].data());
+        EXPECT_EQ(stream.mInt[i], cached.mInt[i]);
+        EXPECT_EQ(stream.mDouble[i], cached.mDouble[i]);
+        for (int t = 0; t < 3; t++) {
+            EXPECT_EQ(1, stream.mSet[i * 3 + t]);
+            EXPECT_EQ(stream.mSet[i * 3 + t], cached.mSet[i * 3 + t]);
+        }
+    }
+}
+
+INSTANTIATE_TEST_SUITE_P(Etc, LocCfgShippedConf,
+        ::testing::Values("../etc/gps.conf", "../etc/flp.conf",
+                          "../etc/gnss_antenna_info.conf"));
+
+TEST(LocCfg, RewrittenFileIsReadAgain) {
+    string path = tempPath("loc_cfg_test.conf");
+    int value = 0;
+    uint8_t set = 0;
+    loc_param_s_type table[] = {{"VALUE", &value, &set, 'n'}};
+
+    writeFile(path, "VALUE = 1\n");
+    loc_read_conf(path.c_str(), table, 1);
+    EXPECT_EQ(1, value);
+
+    // same size, the mtime alone may not tell within its granularity
+    unlink(path.c_str());
+    writeFile(path, "VALUE = 2\n");
+    loc_read_conf(path.c_str(), table, 1);
+    EXPECT_EQ(2, value);
+
+    // a removed file no longer sets anything
+    unlink(path.c_str());
+    value = 0;
+    loc_read_conf(path.c_str(), table, 1);
+    EXPECT_EQ(0, value);
+}
+
+// LogBuffer reads gps.conf when it is first used. Readers racing with one
+// another enable it while the others are still filling and logging, so a
+// reader must not hold the cache lock then. Only a process that has not
+// yet made LogBuffer can tell, hence the death test, which re-runs this
+// test alone in a new process.
+TEST(LocCfgDeathTest, LoggingReadersDoNotDeadlock) {
+    ::testing::GTEST_FLAG(death_test_style) = "threadsafe";
+    EXPECT_EXIT({
+        string path = tempPath("loc_cfg_log.conf");
+        writeFile(path, "DEBUG_LEVEL = 5\nLOG_BUFFER_ENABLED = 1\nVALUE = 1\n");
+        alarm(30);
+        vector<thread> readers;
+        for (int i = 0; i < 8; i++) {
+            readers.emplace_back([&path] {
+                int value = 0;
+                loc_param_s_type table[] = {{"VALUE", &value, NULL, 'n'}};
+                for (int j = 0; j < 200; j++) {
+                    loc_read_conf(path.c_str(), table, 1);
+                }
+            });
+        }
+        for (auto& reader : readers) {
+            reader.join();
+        }
+        unlink(path.c_str());
+        exit(0);
+    }, ::testing::ExitedWithCode(0), "");
+}
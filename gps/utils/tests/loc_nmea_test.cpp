@@ -0,0 +1,244 @@
+/* Copyright (c) 2020 The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation, nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <loc_nmea.h>
+#include <gtest/gtest.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Runs a corpus of position and SV reports through the NMEA generators and
+// compares the sentences byte for byte with data/nmea_golden.txt, which was
+// written by the snprintf() based generators. Successive epochs repeat or
+// slightly change their inputs, so that the GSA / GSV caches get hit too.
+// Set NMEA_GOLDEN_OUT to a path to write the output there instead.
+
+namespace {
+
+const int kEpochs = 60;
+
+class Corpus {
+    std::mt19937 mRand;
+public:
+    Corpus() : mRand(20201017) {}
+    // the raw mt19937 output only, as the distributions are implementation defined
+    uint32_t next() { return mRand(); }
+    uint32_t below(uint32_t n) { return next() % n; }
+    bool chance(uint32_t percent) { return below(100) < percent; }
+    double range(double lo, double hi, uint32_t steps = 1000000) {
+        return lo + (hi - lo) * below(steps + 1) / steps;
+    }
+    uint64_t mask64() { return ((uint64_t)next() << 32) | next(); }
+
+    void makePos(UlpLocation& location, GpsLocationExtended& extended,
+                 LocationSystemInfo& systemInfo) {
+        memset(&location, 0, sizeof(location));
+        memset(&extended, 0, sizeof(extended));
+        memset(&systemInfo, 0, sizeof(systemInfo));
+        location.size = sizeof(location);
+        location.gpsLocation.size = sizeof(location.gpsLocation);
+        location.gpsLocation.flags = next() & 0xffff;
+        location.gpsLocation.latitude = range(-90, 90);
+        location.gpsLocation.longitude = range(-180, 180);
+        location.gpsLocation.altitude = range(-500, 9000);
+        location.gpsLocation.speed = chance(20) ? 0 : range(0, 80);
+        location.gpsLocation.bearing = range(0, 360);
+        location.gpsLocation.accuracy = range(0, 200);
+        // 2020 to 2030, in ms
+        location.gpsLocation.timestamp = 1577836800000LL + (int64_t)below(315360000) * 1000 +
+                below(1000);
+
+        extended.size = sizeof(extended);
+        extended.flags = mask64();
+        extended.altitudeMeanSeaLevel = range(-500, 9000);
+        extended.pdop = range(0, 50, 5000);
+        extended.hdop = range(0, 50, 5000);
+        extended.vdop = range(0, 50, 5000);
+        extended.magneticDeviation = range(-30, 30);
+        extended.navSolutionMask = next();
+        extended.tech_mask = next() & 0x3ff;
+        extended.dgnssRefStationId = below(4096);
+        extended.dgnssDataAgeMsec = below(600000);
+        extended.gpsTime.gpsWeek = 2086 + below(520);
+        extended.gpsTime.gpsTimeOfWeekMs = below(604800000);
+        GnssSvUsedInPosition& used = extended.gnss_sv_used_ids;
+        used.gps_sv_used_ids_mask = chance(80) ? next() : 0;
+        used.glo_sv_used_ids_mask = chance(60) ? next() & 0xffffff : 0;
+        used.gal_sv_used_ids_mask = chance(60) ? mask64() & 0xfffffffff : 0;
+        used.bds_sv_used_ids_mask = chance(60) ? mask64() & 0x7fffffffffffffff : 0;
+        used.qzss_sv_used_ids_mask = chance(30) ? next() & 0x1f : 0;
+        used.navic_sv_used_ids_mask = chance(30) ? next() & 0x3fff : 0;
+
+        if (chance(20)) {
+            systemInfo.systemInfoMask = next() & 0xff;
+            LeapSecondSystemInfo& leap = systemInfo.leapSecondSysInfo;
+            leap.leapSecondInfoMask = next() & 0xff;
+            leap.leapSecondCurrent = 18;
+            leap.leapSecondChangeInfo.leapSecondsBeforeChange = 18;
+            leap.leapSecondChangeInfo.leapSecondsAfterChange = 19;
+            leap.leapSecondChangeInfo.gpsTimestampLsChange.systemWeek =
+                    extended.gpsTime.gpsWeek;
+            leap.leapSecondChangeInfo.gpsTimestampLsChange.systemMsec =
+                    extended.gpsTime.gpsTimeOfWeekMs + below(4000) - 2000;
+        }
+    }
+
+    // nudges a few of the inputs, as from one epoch to the next
+    void nudgePos(UlpLocation& location, GpsLocationExtended& extended) {
+        location.gpsLocation.timestamp += 1000;
+        location.gpsLocation.latitude += range(-0.001, 0.001);
+        if (chance(50)) {
+            extended.hdop = range(0, 50, 5000);
+        }
+        if (chance(30)) {
+            extended.gnss_sv_used_ids.gps_sv_used_ids_mask ^= 1u << below(32);
+        }
+    }
+
+    void makeSv(GnssSvNotification& svNotify) {
+        static const struct {
+            GnssSvType type;
+            uint16_t firstId;
+            uint16_t lastId;
+            GnssSignalTypeMask signals[3];
+        } kConstellations[] = {
+            {GNSS_SV_TYPE_GPS, 1, 32,
+                {GNSS_SIGNAL_GPS_L1CA, GNSS_SIGNAL_GPS_L5, GNSS_SIGNAL_GPS_L2}},
+            {GNSS_SV_TYPE_SBAS, 120, 158,
+                {GNSS_SIGNAL_SBAS_L1, GNSS_SIGNAL_SBAS_L1, GNSS_SIGNAL_SBAS_L1}},
+            {GNSS_SV_TYPE_GLONASS, 65, 96,
+                {GNSS_SIGNAL_GLONASS_G1, GNSS_SIGNAL_GLONASS_G2, GNSS_SIGNAL_GLONASS_G1}},
+            {GNSS_SV_TYPE_QZSS, 193, 197,
+                {GNSS_SIGNAL_QZSS_L1CA, GNSS_SIGNAL_QZSS_L5, GNSS_SIGNAL_QZSS_L2}},
+            {GNSS_SV_TYPE_BEIDOU, 201, 263,
+                {GNSS_SIGNAL_BEIDOU_B1I, GNSS_SIGNAL_BEIDOU_B2AI, GNSS_SIGNAL_BEIDOU_B1C}},
+            {GNSS_SV_TYPE_GALILEO, 301, 336,
+                {GNSS_SIGNAL_GALILEO_E1, GNSS_SIGNAL_GALILEO_E5A, GNSS_SIGNAL_GALILEO_E5B}},
+            {GNSS_SV_TYPE_NAVIC, 401, 414,
+                {GNSS_SIGNAL_NAVIC_L5, GNSS_SIGNAL_NAVIC_L5, GNSS_SIGNAL_NAVIC_L5}},
+        };
+        memset(&svNotify, 0, sizeof(svNotify));
+        svNotify.size = sizeof(svNotify);
+        svNotify.gnssSignalTypeMaskValid = chance(90);
+        svNotify.count = below(GNSS_SV_MAX + 1);
+        for (uint32_t i = 0; i < svNotify.count; i++) {
+            const auto& constellation =
+                    kConstellations[below(sizeof(kConstellations) / sizeof(kConstellations[0]))];
+            GnssSv& sv = svNotify.gnssSvs[i];
+            sv.size = sizeof(sv);
+            sv.type = constellation.type;
+            sv.svId = constellation.firstId + below(constellation.lastId - constellation.firstId + 1);
+            // GLONASS SVs with an unknown slot
+            if (GNSS_SV_TYPE_GLONASS == sv.type && chance(5)) {
+                sv.svId = 255;
+            }
+            sv.gnssSignalTypeMask = constellation.signals[below(3)];
+            sv.cN0Dbhz = chance(10) ? 0 : range(5, 55, 500);
+            sv.elevation = range(-5, 90, 950);
+            sv.azimuth = range(0, 360, 3600);
+            sv.gnssSvOptionsMask = next() & 0x1f;
+        }
+    }
+
+    void nudgeSv(GnssSvNotification& svNotify) {
+        for (uint32_t i = 0; i < svNotify.count; i++) {
+            if (chance(10)) {
+                svNotify.gnssSvs[i].cN0Dbhz = range(5, 55, 500);
+            }
+        }
+    }
+};
+
+std::string generateCorpus() {
+    Corpus corpus;
+    std::ostringstream out;
+    UlpLocation location;
+    GpsLocationExtended extended;
+    LocationSystemInfo systemInfo;
+    GnssSvNotification svNotify;
+    std::vector<std::string> sentences;
+    for (int epoch = 0; epoch < kEpochs; epoch++) {
+        uint32_t change = (0 == epoch) ? 0 : corpus.below(3);
+        if (0 == change) {
+            corpus.makePos(location, extended, systemInfo);
+            corpus.makeSv(svNotify);
+        } else if (1 == change) {
+            corpus.nudgePos(location, extended);
+            corpus.nudgeSv(svNotify);
+        }
+        // else the same inputs once more
+
+        bool customGgaFixQuality = corpus.chance(50);
+        bool tagBlockGrouping = corpus.chance(30);
+        int indexOfGGA = -1;
+        sentences.clear();
+        loc_nmea_generate_sv(svNotify, sentences);
+        out << "# epoch " << epoch << " sv\n";
+        for (auto& sentence : sentences) {
+            out << sentence << "\n";
+        }
+        sentences.clear();
+        loc_nmea_generate_pos(location, extended, systemInfo, 1, customGgaFixQuality,
+                              sentences, indexOfGGA, tagBlockGrouping);
+        out << "# epoch " << epoch << " pos, GGA at " << indexOfGGA << "\n";
+        for (auto& sentence : sentences) {
+            out << sentence << "\n";
+        }
+    }
+    return out.str();
+}
+
+} // namespace
+
+TEST(LocNmea, GoldenCorpus) {
+    std::string output = generateCorpus();
+    const char* goldenOut = getenv("NMEA_GOLDEN_OUT");
+    if (nullptr != goldenOut) {
+        std::ofstream(goldenOut) << output;
+        return;
+    }
+
+    const char* srcdir = getenv("srcdir");
+    std::string path = std::string((nullptr != srcdir) ? srcdir : ".") +
+            "/tests/data/nmea_golden.txt";
+    std::ifstream golden(path);
+    ASSERT_TRUE(golden.good()) << path;
+    std::istringstream generated(output);
+    std::string expected, actual;
+    int line = 1;
+    while (std::getline(golden, expected)) {
+        ASSERT_TRUE(std::getline(generated, actual)) << "missing line " << line;
+        ASSERT_EQ(expected, actual) << "line " << line;
+        line++;
+    }
+    EXPECT_FALSE(std::getline(generated, actual)) << "extra line " << line;
+}
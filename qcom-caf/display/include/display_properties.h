@@ -73,6 +73,7 @@
 #define DISABLE_SKIP_VALIDATE_PROP           DISPLAY_PROP("disable_skip_validate")
 #define HDMI_S3D_MODE_PROP                   DISPLAY_PROP("hdmi_s3d_mode")
 #define DISABLE_DESTINATION_SCALER_PROP      DISPLAY_PROP("disable_dest_scaler")
+#define DISABLE_STRATEGY_CACHE_PROP          DISPLAY_PROP("disable_strategy_cache")
 #define ENABLE_PARTIAL_UPDATE_PROP           DISPLAY_PROP("enable_partial_update")
 #define ENABLE_ROTATOR_SYNC_ALLOC            DISPLAY_PROP("rotator_sync_alloc")
 #define WRITEBACK_SUPPORTED                  DISPLAY_PROP("support_writeback")
@@ -30,19 +30,42 @@ LOCAL_CLANG                   := true
 
 ifeq ($(TARGET_USES_C2D_COMPOSITION),true)
     LOCAL_CFLAGS += -DCOPYBIT_Z180=1 -DC2D_SUPPORT_DISPLAY=1
-    LOCAL_SRC_FILES := copybit_c2d.cpp software_converter.cpp
+    LOCAL_SRC_FILES := copybit_c2d.cpp software_converter.cpp yuv_convert.cpp yuv_executor.cpp
     include $(BUILD_SHARED_LIBRARY)
 else
     ifneq ($(call is-chipset-in-board-platform,msm7630),true)
         ifeq ($(call is-board-platform-in-list,$(MSM7K_BOARD_PLATFORMS)),true)
             LOCAL_CFLAGS += -DCOPYBIT_MSM7K=1
-            LOCAL_SRC_FILES := software_converter.cpp copybit.cpp
+            LOCAL_SRC_FILES := software_converter.cpp yuv_convert.cpp yuv_executor.cpp copybit.cpp
             include $(BUILD_SHARED_LIBRARY)
         endif
         ifeq ($(call is-board-platform-in-list, msm8610 msm8909),true)
-            LOCAL_SRC_FILES := software_converter.cpp copybit.cpp
+            LOCAL_SRC_FILES := software_converter.cpp yuv_convert.cpp yuv_executor.cpp copybit.cpp
             include $(BUILD_SHARED_LIBRARY)
         endif
     endif
 endif
 endif
+
+# Host checks of the YUV converters against their scalar references
+include $(CLEAR_VARS)
+LOCAL_MODULE                  := copybit_yuv_convert_test
+LOCAL_SRC_FILES               := yuv_convert.cpp tests/yuv_convert_test.cpp
+LOCAL_CFLAGS                  := -Wno-sign-conversion
+include $(BUILD_HOST_NATIVE_TEST)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE                  := copybit_yuv_convert_benchmark
+LOCAL_SRC_FILES               := yuv_convert.cpp tests/yuv_convert_benchmark.cpp
+LOCAL_CFLAGS                  := -O2 -Wno-sign-conversion
+LOCAL_STATIC_LIBRARIES        := libgoogle-benchmark
+include $(BUILD_HOST_EXECUTABLE)
+
+include $(CLEAR_VARS)
+LOCAL_MODULE                  := copybit_yuv_executor_benchmark
+LOCAL_SRC_FILES               := yuv_convert.cpp yuv_executor.cpp \
+                                 tests/yuv_executor_benchmark.cpp
+LOCAL_CFLAGS                  := -O2 -Wno-sign-conversion
+LOCAL_SHARED_LIBRARIES        := liblog libcutils
+LOCAL_STATIC_LIBRARIES        := libgoogle-benchmark
+include $(BUILD_HOST_EXECUTABLE)
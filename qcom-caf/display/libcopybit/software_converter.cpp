@@ -30,7 +30,10 @@
 #include <log/log.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <algorithm>
 #include "software_converter.h"
+#include "yuv_convert.h"
+#include "yuv_executor.h"
 
 /** Convert YV12 to YCrCb_420_SP */
 int convertYV12toYCrCb420SP(const copybit_image_t *src, private_handle_t *yv12_handle)
@@ -60,64 +63,15 @@ int convertYV12toYCrCb420SP(const copybit_image_t *src, private_handle_t *yv12_h
     unsigned char* oldChroma = (unsigned char*)(hnd->base + y_size);
     memcpy((char *)yv12_handle->base,(char *)hnd->base,y_size);
 
-#if defined(__ARM_HAVE_NEON) && !defined(__aarch64__)
-   /* interleave */
     if(!chromaPadding) {
-        unsigned char * t1 = newChroma;
-        unsigned char * t2 = oldChroma;
-        unsigned char * t3 = t2 + chromaSize/2;
-        for(unsigned int i=0; i < (chromaSize/2)>>3; i++) {
-            __asm__ __volatile__ (
-                                    "vld1.u8 d0, [%0]! \n"
-                                    "vld1.u8 d1, [%1]! \n"
-                                    "vst2.u8 {d0, d1}, [%2]! \n"
-                                    :"+r"(t2), "+r"(t3), "+r"(t1)
-                                    :
-                                    :"memory","d0","d1"
-                                 );
-
-        }
-    }
-#else  //__ARM_HAVE_NEON
-    if(!chromaPadding) {
-        for(unsigned int i = 0; i< chromaSize/2; i++) {
-            newChroma[i*2]   = oldChroma[i];
-            newChroma[i*2+1] = oldChroma[i+chromaSize/2];
-        }
-
-    }
-#endif
-    // If the image is not aligned to 16 pixels,
-    // convert using the C routine below
-    // r1 tracks the row of the source buffer
-    // r2 tracks the row of the destination buffer
-    // The width/2 checks are to avoid copying
-    // from the padding
-
-    if(chromaPadding) {
-        unsigned int r1 = 0, r2 = 0, i = 0, j = 0;
-        while(r1 < height/2) {
-            if(j == width) {
-                j = 0;
-                r2++;
-                continue;
-            }
-            if (j+1 == width) {
-                newChroma[r2*width + j] = oldChroma[r1*c_width+i];
-                r2++;
-                newChroma[r2*width] = oldChroma[r1*c_width+i+c_size];
-                j = 1;
-            } else {
-                newChroma[r2*width + j] = oldChroma[r1*c_width+i];
-                newChroma[r2*width + j + 1] = oldChroma[r1*c_width+i+c_size];
-                j+=2;
-            }
-            i++;
-            if (i == width/2 ) {
-                i = 0;
-                r1++;
-            }
-        }
+        yuv_interleave(newChroma, oldChroma, oldChroma + chromaSize/2,
+                       chromaSize/2);
+    } else {
+        // The destination chroma is packed: each source row gives
+        // width/2 VU pairs, written back to back without padding.
+        yuv_yv12_to_nv21_chroma(newChroma, (width/2)*2, oldChroma,
+                                oldChroma + c_size, c_width, width/2,
+                                height/2);
     }
 
   return 0;
@@ -145,28 +99,20 @@ static int copy_source_to_destination(const uintptr_t src_base,
          return COPYBIT_FAILURE;
     }
 
-    int width = info.width;
-    int height = info.height;
     unsigned char *src = (unsigned char*)src_base;
     unsigned char *dst = (unsigned char*)dst_base;
 
-    // Copy the luma
-    for (int i = 0; i < height; i++) {
-        memcpy(dst, src, width);
-        src += info.src_stride;
-        dst += info.dst_stride;
-    }
+    // Copy the luma, large planes are split in row stripes across threads
+    yuv_copy_plane_striped(dst, info.dst_stride, src, info.src_stride,
+                           info.width, info.height);
 
-    // Copy plane 1
+    // Copy plane 1, never more than a destination row so the last row
+    // does not run past the plane when the source stride is larger
     src = (unsigned char*)(src_base + info.src_plane1_offset);
     dst = (unsigned char*)(dst_base + info.dst_plane1_offset);
-    width = width/2;
-    height = height/2;
-    for (int i = 0; i < height; i++) {
-        memcpy(dst, src, info.src_stride);
-        src += info.src_stride;
-        dst += info.dst_stride;
-    }
+    yuv_copy_plane_striped(dst, info.dst_stride, src, info.src_stride,
+                           std::min(info.src_stride, info.dst_stride),
+                           info.height/2);
     return 0;
 }
 
@@ -0,0 +1,140 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "yuv_convert.h"
+
+// YV12 -> NV21 chroma of a frame, per SIMD path, against the byte loop
+// the software converter used before, and the NV12 <-> NV21 swap per path.
+
+namespace {
+
+const char *const kPaths[] = {"c", "neon", "sse2", "avx2"};
+
+struct Frame {
+    size_t pairs;
+    size_t rows;
+    size_t src_stride;
+    std::vector<uint8_t> cr;
+    std::vector<uint8_t> cb;
+    std::vector<uint8_t> dst;
+
+    Frame(size_t width, size_t height, size_t padding) :
+            pairs(width / 2), rows(height / 2),
+            src_stride(width / 2 + padding),
+            cr(src_stride * rows, 0x80), cb(src_stride * rows, 0x40),
+            dst(pairs * 2 * rows) {}
+};
+
+void BM_InterleavePath(benchmark::State& state, const char *path)
+{
+    yuv_interleave_fn interleave = yuv_interleave_for(path);
+    if (!interleave) {
+        state.SkipWithError("not available here");
+        return;
+    }
+    Frame frame(state.range(0), state.range(1), 0);
+    for (auto _ : state) {
+        interleave(frame.dst.data(), frame.cr.data(), frame.cb.data(),
+                   frame.pairs * frame.rows);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * frame.dst.size());
+}
+
+void BM_SwapUvPath(benchmark::State& state, const char *path)
+{
+    yuv_swap_uv_fn swap_uv = yuv_swap_uv_for(path);
+    if (!swap_uv) {
+        state.SkipWithError("not available here");
+        return;
+    }
+    Frame frame(state.range(0), state.range(1), 0);
+    std::vector<uint8_t> src(frame.dst.size(), 0x60);
+    for (auto _ : state) {
+        swap_uv(frame.dst.data(), src.data(), frame.pairs * frame.rows);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * frame.dst.size());
+}
+
+// the chroma loop of convertYV12toYCrCb420SP before the SIMD paths
+void BM_OldPaddedLoop(benchmark::State& state)
+{
+    Frame frame(state.range(0), state.range(1), 8);
+    for (auto _ : state) {
+        uint8_t *dst = frame.dst.data();
+        for (size_t r = 0; r < frame.rows; r++) {
+            const uint8_t *cr = frame.cr.data() + r * frame.src_stride;
+            const uint8_t *cb = frame.cb.data() + r * frame.src_stride;
+            for (size_t i = 0; i < frame.pairs; i++) {
+                *dst++ = cr[i];
+                *dst++ = cb[i];
+            }
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * frame.dst.size());
+}
+
+void BM_Yv12ToNv21Padded(benchmark::State& state)
+{
+    Frame frame(state.range(0), state.range(1), 8);
+    for (auto _ : state) {
+        yuv_yv12_to_nv21_chroma(frame.dst.data(), frame.pairs * 2,
+                                frame.cr.data(), frame.cb.data(),
+                                frame.src_stride, frame.pairs, frame.rows);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * frame.dst.size());
+    state.SetLabel(yuv_simd_path());
+}
+
+void FrameSizes(benchmark::internal::Benchmark *b)
+{
+    b->Args({640, 480})->Args({1280, 720})->Args({1920, 1080});
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(BM_InterleavePath, c, kPaths[0])->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_InterleavePath, neon, kPaths[1])->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_InterleavePath, sse2, kPaths[2])->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_InterleavePath, avx2, kPaths[3])->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_SwapUvPath, c, kPaths[0])->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_SwapUvPath, neon, kPaths[1])->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_SwapUvPath, sse2, kPaths[2])->Apply(FrameSizes);
+BENCHMARK_CAPTURE(BM_SwapUvPath, avx2, kPaths[3])->Apply(FrameSizes);
+BENCHMARK(BM_OldPaddedLoop)->Apply(FrameSizes);
+BENCHMARK(BM_Yv12ToNv21Padded)->Apply(FrameSizes);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <gtest/gtest.h>
+#include <string.h>
+#include <random>
+#include <vector>
+#include "yuv_convert.h"
+
+namespace {
+
+const char *const kPaths[] = {"c", "neon", "sse2", "avx2"};
+// bytes before and after every buffer that must not be written
+const size_t kGuard = 64;
+
+struct Buffer {
+    std::vector<uint8_t> bytes;
+    size_t offset;
+
+    Buffer(size_t size, size_t misalign, uint8_t seed) :
+            bytes(size + misalign + kGuard * 2), offset(kGuard + misalign) {
+        for (size_t i = 0; i < bytes.size(); i++)
+            bytes[i] = (uint8_t)(i * 131 + seed * 17 + (i >> 8));
+    }
+    uint8_t *data() { return bytes.data() + offset; }
+};
+
+void interleave_rows_c(uint8_t *dst, size_t dst_stride, const uint8_t *cr,
+                       const uint8_t *cb, size_t src_stride, size_t pairs,
+                       size_t rows)
+{
+    for (size_t r = 0; r < rows; r++)
+        yuv_interleave_c(dst + r * dst_stride, cr + r * src_stride,
+                         cb + r * src_stride, pairs);
+}
+
+void swap_rows_c(uint8_t *dst, size_t dst_stride, const uint8_t *src,
+                 size_t src_stride, size_t pairs, size_t rows)
+{
+    for (size_t r = 0; r < rows; r++)
+        yuv_swap_uv_c(dst + r * dst_stride, src + r * src_stride, pairs);
+}
+
+} // namespace
+
+TEST(YuvConvert, SelectedPathIsAvailable)
+{
+    ASSERT_NE(nullptr, yuv_interleave_for(yuv_simd_path()));
+    ASSERT_NE(nullptr, yuv_interleave_for("c"));
+    ASSERT_EQ(nullptr, yuv_interleave_for("mmx"));
+    ASSERT_NE(nullptr, yuv_swap_uv_for(yuv_simd_path()));
+    ASSERT_NE(nullptr, yuv_swap_uv_for("c"));
+    ASSERT_EQ(nullptr, yuv_swap_uv_for("mmx"));
+}
+
+// every length around the vector widths, at every alignment of every
+// pointer, against the scalar reference, and nothing outside of dst
+TEST(YuvConvert, InterleaveMatchesReference)
+{
+    for (const char *path : kPaths) {
+        yuv_interleave_fn interleave = yuv_interleave_for(path);
+        if (!interleave)
+            continue;
+        SCOPED_TRACE(path);
+        for (size_t count = 0; count < 300; count++) {
+            for (size_t misalign = 0; misalign < 32; misalign += 3) {
+                Buffer first(count, misalign, 1);
+                Buffer second(count, (misalign * 7) % 32, 2);
+                Buffer expected(count * 2, (misalign * 5) % 32, 3);
+                Buffer actual = expected;
+                yuv_interleave_c(expected.data(), first.data(),
+                                 second.data(), count);
+                interleave(actual.data(), first.data(), second.data(), count);
+                ASSERT_EQ(expected.bytes, actual.bytes)
+                        << "count " << count << " misalign " << misalign;
+            }
+        }
+    }
+}
+
+TEST(YuvConvert, SwapUvMatchesReference)
+{
+    for (const char *path : kPaths) {
+        yuv_swap_uv_fn swap_uv = yuv_swap_uv_for(path);
+        if (!swap_uv)
+            continue;
+        SCOPED_TRACE(path);
+        for (size_t count = 0; count < 300; count++) {
+            for (size_t misalign = 0; misalign < 32; misalign += 3) {
+                Buffer src(count * 2, misalign, 1);
+                Buffer expected(count * 2, (misalign * 5) % 32, 3);
+                Buffer actual = expected;
+                yuv_swap_uv_c(expected.data(), src.data(), count);
+                swap_uv(actual.data(), src.data(), count);
+                ASSERT_EQ(expected.bytes, actual.bytes)
+                        << "count " << count << " misalign " << misalign;
+            }
+        }
+    }
+}
+
+// NV12 <-> NV21 may convert in place, dst == src
+TEST(YuvConvert, SwapUvInPlace)
+{
+    for (const char *path : kPaths) {
+        yuv_swap_uv_fn swap_uv = yuv_swap_uv_for(path);
+        if (!swap_uv)
+            continue;
+        SCOPED_TRACE(path);
+        for (size_t count = 0; count < 300; count++) {
+            Buffer expected(count * 2, count % 32, 2);
+            Buffer actual = expected;
+            yuv_swap_uv_c(expected.data(), expected.data(), count);
+            swap_uv(actual.data(), actual.data(), count);
+            ASSERT_EQ(expected.bytes, actual.bytes) << "count " << count;
+        }
+    }
+}
+
+// odd widths and heights, unaligned and padded strides, packed and padded
+// destinations, through the path the device would use
+TEST(YuvConvert, Yv12ToNv21ChromaMatchesReference)
+{
+    for (size_t pairs = 1; pairs < 100; pairs++) {
+        for (size_t rows : {1, 2, 7, 16}) {
+            for (size_t src_pad : {0, 1, 5, 16, 17}) {
+                for (size_t dst_pad : {0, 3, 32}) {
+                    size_t src_stride = pairs + src_pad;
+                    size_t dst_stride = pairs * 2 + dst_pad;
+                    Buffer cr(src_stride * rows, pairs % 7, 4);
+                    Buffer cb(src_stride * rows, pairs % 5, 5);
+                    Buffer expected(dst_stride * rows, pairs % 3, 6);
+                    Buffer actual = expected;
+                    interleave_rows_c(expected.data(), dst_stride, cr.data(),
+                                      cb.data(), src_stride, pairs, rows);
+                    yuv_yv12_to_nv21_chroma(actual.data(), dst_stride,
+                                            cr.data(), cb.data(), src_stride,
+                                            pairs, rows);
+                    ASSERT_EQ(expected.bytes, actual.bytes)
+                            << "pairs " << pairs << " rows " << rows
+                            << " src_pad " << src_pad << " dst_pad " << dst_pad;
+                }
+            }
+        }
+    }
+}
+
+// packed strides take the single swap over the whole plane
+TEST(YuvConvert, Nv12Nv21ChromaMatchesReference)
+{
+    for (size_t pairs = 1; pairs < 100; pairs++) {
+        for (size_t rows : {1, 2, 7, 16}) {
+            for (size_t src_pad : {0, 1, 32}) {
+                for (size_t dst_pad : {0, 3, 32}) {
+                    size_t src_stride = pairs * 2 + src_pad;
+                    size_t dst_stride = pairs * 2 + dst_pad;
+                    Buffer src(src_stride * rows, pairs % 7, 4);
+                    Buffer expected(dst_stride * rows, pairs % 3, 6);
+                    Buffer actual = expected;
+                    swap_rows_c(expected.data(), dst_stride, src.data(),
+                                src_stride, pairs, rows);
+                    yuv_nv12_nv21_chroma(actual.data(), dst_stride,
+                                         src.data(), src_stride, pairs, rows);
+                    ASSERT_EQ(expected.bytes, actual.bytes)
+                            << "pairs " << pairs << " rows " << rows
+                            << " src_pad " << src_pad << " dst_pad " << dst_pad;
+                }
+            }
+        }
+    }
+}
+
+TEST(YuvConvert, CopyPlaneMatchesReference)
+{
+    for (size_t row_bytes : {1, 15, 16, 33, 720, 1921}) {
+        for (size_t src_pad : {0, 1, 64}) {
+            for (size_t dst_pad : {0, 7, 64}) {
+                const size_t rows = 9;
+                size_t src_stride = row_bytes + src_pad;
+                size_t dst_stride = row_bytes + dst_pad;
+                Buffer src(src_stride * rows, src_pad % 13, 7);
+                Buffer expected(dst_stride * rows, dst_pad % 11, 8);
+                Buffer actual = expected;
+                for (size_t r = 0; r < rows; r++)
+                    memcpy(expected.data() + r * dst_stride,
+                           src.data() + r * src_stride, row_bytes);
+                yuv_copy_plane(actual.data(), dst_stride, src.data(),
+                               src_stride, row_bytes, rows);
+                ASSERT_EQ(expected.bytes, actual.bytes)
+                        << "row_bytes " << row_bytes << " src_pad " << src_pad
+                        << " dst_pad " << dst_pad;
+            }
+        }
+    }
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <benchmark/benchmark.h>
+#include <stdint.h>
+#include <algorithm>
+#include <vector>
+#include "yuv_convert.h"
+#include "yuv_executor.h"
+
+// Latency of a striped plane copy against the size of the pool, to pick
+// the default and the cap of vendor.display.copybit_sw_threads.
+
+namespace {
+
+struct Plane {
+    size_t row_bytes;
+    size_t rows;
+    std::vector<uint8_t> src;
+    std::vector<uint8_t> dst;
+
+    Plane(size_t width, size_t height) :
+            row_bytes(width), rows(height),
+            src(width * height, 0x80), dst(width * height) {}
+};
+
+// Same stripes as yuv_copy_plane_striped(), on a pool of the given size
+void BM_CopyPlaneThreads(benchmark::State& state)
+{
+    YuvExecutor executor(state.range(0));
+    Plane plane(state.range(1), state.range(2));
+    const size_t row_bytes = plane.row_bytes;
+    uint8_t *dst = plane.dst.data();
+    const uint8_t *src = plane.src.data();
+    size_t stripe = std::max((size_t)1, YUV_TILE_BYTES / (row_bytes * 2));
+    yuv_stripe_fn copy = [=](size_t first, size_t end) {
+        yuv_copy_plane(dst + first * row_bytes, row_bytes,
+                       src + first * row_bytes, row_bytes,
+                       row_bytes, end - first);
+    };
+
+    for (auto _ : state) {
+        executor.run(plane.rows, stripe, copy);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * plane.dst.size());
+}
+
+void ThreadsAndSizes(benchmark::internal::Benchmark *b)
+{
+    b->ArgNames({"threads", "width", "height"});
+    for (int threads = 1; threads <= 8; threads *= 2) {
+        b->Args({threads, 1280, 720});
+        b->Args({threads, 1920, 1080});
+        b->Args({threads, 3840, 2160});
+    }
+}
+
+} // namespace
+
+BENCHMARK(BM_CopyPlaneThreads)->Apply(ThreadsAndSizes)->UseRealTime();
+
+BENCHMARK_MAIN();
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <string.h>
+#include "yuv_convert.h"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define YUV_NEON 1
+#elif defined(__SSE2__)
+#include <immintrin.h>
+#define YUV_SSE2 1
+#if defined(__GNUC__) || defined(__clang__)
+#define YUV_AVX2 1
+#endif
+#endif
+
+struct yuv_ops {
+    yuv_interleave_fn interleave;
+    yuv_swap_uv_fn swap_uv;
+    const char *name;
+};
+
+void yuv_interleave_c(uint8_t *dst, const uint8_t *first,
+                      const uint8_t *second, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        dst[i*2]   = first[i];
+        dst[i*2+1] = second[i];
+    }
+}
+
+void yuv_swap_uv_c(uint8_t *dst, const uint8_t *src, size_t count)
+{
+    for (size_t i = 0; i < count; i++) {
+        uint8_t u = src[i*2];
+        dst[i*2]   = src[i*2+1];
+        dst[i*2+1] = u;
+    }
+}
+
+#ifdef YUV_NEON
+static void interleave_neon(uint8_t *dst, const uint8_t *first,
+                            const uint8_t *second, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x2_t uv;
+        uv.val[0] = vld1q_u8(first + i);
+        uv.val[1] = vld1q_u8(second + i);
+        vst2q_u8(dst + i*2, uv);
+    }
+    yuv_interleave_c(dst + i*2, first + i, second + i, count - i);
+}
+
+static void swap_uv_neon(uint8_t *dst, const uint8_t *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+        vst1q_u8(dst + i*2, vrev16q_u8(vld1q_u8(src + i*2)));
+    yuv_swap_uv_c(dst + i*2, src + i*2, count - i);
+}
+#endif
+
+#ifdef YUV_SSE2
+static void interleave_sse2(uint8_t *dst, const uint8_t *first,
+                            const uint8_t *second, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m128i u = _mm_loadu_si128((const __m128i *)(first + i));
+        __m128i v = _mm_loadu_si128((const __m128i *)(second + i));
+        _mm_storeu_si128((__m128i *)(dst + i*2), _mm_unpacklo_epi8(u, v));
+        _mm_storeu_si128((__m128i *)(dst + i*2 + 16),
+                         _mm_unpackhi_epi8(u, v));
+    }
+    yuv_interleave_c(dst + i*2, first + i, second + i, count - i);
+}
+
+static void swap_uv_sse2(uint8_t *dst, const uint8_t *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i uv = _mm_loadu_si128((const __m128i *)(src + i*2));
+        _mm_storeu_si128((__m128i *)(dst + i*2),
+                         _mm_or_si128(_mm_slli_epi16(uv, 8),
+                                      _mm_srli_epi16(uv, 8)));
+    }
+    yuv_swap_uv_c(dst + i*2, src + i*2, count - i);
+}
+#endif
+
+#ifdef YUV_AVX2
+__attribute__((target("avx2")))
+static void interleave_avx2(uint8_t *dst, const uint8_t *first,
+                            const uint8_t *second, size_t count)
+{
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        __m256i u = _mm256_loadu_si256((const __m256i *)(first + i));
+        __m256i v = _mm256_loadu_si256((const __m256i *)(second + i));
+        // unpack works per 128 bit lane, put the lanes back in order
+        __m256i lo = _mm256_unpacklo_epi8(u, v);
+        __m256i hi = _mm256_unpackhi_epi8(u, v);
+        _mm256_storeu_si256((__m256i *)(dst + i*2),
+                            _mm256_permute2x128_si256(lo, hi, 0x20));
+        _mm256_storeu_si256((__m256i *)(dst + i*2 + 32),
+                            _mm256_permute2x128_si256(lo, hi, 0x31));
+    }
+    interleave_sse2(dst + i*2, first + i, second + i, count - i);
+}
+
+__attribute__((target("avx2")))
+static void swap_uv_avx2(uint8_t *dst, const uint8_t *src, size_t count)
+{
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i uv = _mm256_loadu_si256((const __m256i *)(src + i*2));
+        _mm256_storeu_si256((__m256i *)(dst + i*2),
+                            _mm256_or_si256(_mm256_slli_epi16(uv, 8),
+                                            _mm256_srli_epi16(uv, 8)));
+    }
+    swap_uv_sse2(dst + i*2, src + i*2, count - i);
+}
+#endif
+
+static yuv_ops select_ops()
+{
+#if defined(YUV_NEON)
+    return {interleave_neon, swap_uv_neon, "neon"};
+#elif defined(YUV_SSE2)
+#ifdef YUV_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return {interleave_avx2, swap_uv_avx2, "avx2"};
+#endif
+    return {interleave_sse2, swap_uv_sse2, "sse2"};
+#else
+    return {yuv_interleave_c, yuv_swap_uv_c, "c"};
+#endif
+}
+
+static const yuv_ops& ops()
+{
+    static const yuv_ops sOps = select_ops();
+    return sOps;
+}
+
+void yuv_interleave(uint8_t *dst, const uint8_t *first,
+                    const uint8_t *second, size_t count)
+{
+    ops().interleave(dst, first, second, count);
+}
+
+void yuv_swap_uv(uint8_t *dst, const uint8_t *src, size_t count)
+{
+    ops().swap_uv(dst, src, count);
+}
+
+const char *yuv_simd_path()
+{
+    return ops().name;
+}
+
+yuv_interleave_fn yuv_interleave_for(const char *path)
+{
+    if (!strcmp(path, "c"))
+        return yuv_interleave_c;
+#ifdef YUV_NEON
+    if (!strcmp(path, "neon"))
+        return interleave_neon;
+#endif
+#ifdef YUV_SSE2
+    if (!strcmp(path, "sse2"))
+        return interleave_sse2;
+#endif
+#ifdef YUV_AVX2
+    if (!strcmp(path, "avx2") && __builtin_cpu_supports("avx2"))
+        return interleave_avx2;
+#endif
+    return NULL;
+}
+
+yuv_swap_uv_fn yuv_swap_uv_for(const char *path)
+{
+    if (!strcmp(path, "c"))
+        return yuv_swap_uv_c;
+#ifdef YUV_NEON
+    if (!strcmp(path, "neon"))
+        return swap_uv_neon;
+#endif
+#ifdef YUV_SSE2
+    if (!strcmp(path, "sse2"))
+        return swap_uv_sse2;
+#endif
+#ifdef YUV_AVX2
+    if (!strcmp(path, "avx2") && __builtin_cpu_supports("avx2"))
+        return swap_uv_avx2;
+#endif
+    return NULL;
+}
+
+void yuv_copy_plane(uint8_t *dst, size_t dst_stride,
+                    const uint8_t *src, size_t src_stride,
+                    size_t row_bytes, size_t rows)
+{
+    // memcpy is already vectorized by libc, only merge contiguous rows
+    if (dst_stride == row_bytes && src_stride == row_bytes) {
+        memcpy(dst, src, row_bytes * rows);
+        return;
+    }
+    for (size_t r = 0; r < rows; r++) {
+        memcpy(dst, src, row_bytes);
+        src += src_stride;
+        dst += dst_stride;
+    }
+}
+
+void yuv_yv12_to_nv21_chroma(uint8_t *dst, size_t dst_stride,
+                             const uint8_t *cr, const uint8_t *cb,
+                             size_t src_stride, size_t pairs, size_t rows)
+{
+    const yuv_ops& o = ops();
+
+    if (src_stride == pairs && dst_stride == pairs * 2) {
+        o.interleave(dst, cr, cb, pairs * rows);
+        return;
+    }
+    for (size_t r = 0; r < rows; r++) {
+        o.interleave(dst, cr, cb, pairs);
+        dst += dst_stride;
+        cr += src_stride;
+        cb += src_stride;
+    }
+}
+
+void yuv_nv12_nv21_chroma(uint8_t *dst, size_t dst_stride,
+                          const uint8_t *src, size_t src_stride,
+                          size_t pairs, size_t rows)
+{
+    const yuv_ops& o = ops();
+
+    if (src_stride == pairs * 2 && dst_stride == pairs * 2) {
+        o.swap_uv(dst, src, pairs * rows);
+        return;
+    }
+    for (size_t r = 0; r < rows; r++) {
+        o.swap_uv(dst, src, pairs);
+        dst += dst_stride;
+        src += src_stride;
+    }
+}
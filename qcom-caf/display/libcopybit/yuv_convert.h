@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __YUV_CONVERT_H__
+#define __YUV_CONVERT_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Chroma plane conversions used by the software converter. Every
+ * function has a scalar reference (the _c variant) and a SIMD path
+ * (NEON on ARM, SSE2 or AVX2 on x86) that produces identical output.
+ * The SIMD path is picked once from the build target and, on x86, the
+ * CPU features.
+ */
+
+/* dst[2i] = first[i], dst[2i + 1] = second[i], for i < count */
+void yuv_interleave(uint8_t *dst, const uint8_t *first,
+                    const uint8_t *second, size_t count);
+void yuv_interleave_c(uint8_t *dst, const uint8_t *first,
+                      const uint8_t *second, size_t count);
+
+/* Swap the two bytes of each of count pairs, NV12 <-> NV21 chroma */
+void yuv_swap_uv(uint8_t *dst, const uint8_t *src, size_t count);
+void yuv_swap_uv_c(uint8_t *dst, const uint8_t *src, size_t count);
+
+/* Name of the SIMD path in use: "neon", "avx2", "sse2" or "c" */
+const char *yuv_simd_path();
+
+/*
+ * yuv_interleave() and yuv_swap_uv() of the named SIMD path, NULL if it
+ * is not built in or the CPU lacks it. Lets tests and benchmarks run
+ * every path.
+ */
+typedef void (*yuv_interleave_fn)(uint8_t *dst, const uint8_t *first,
+                                  const uint8_t *second, size_t count);
+typedef void (*yuv_swap_uv_fn)(uint8_t *dst, const uint8_t *src,
+                               size_t count);
+yuv_interleave_fn yuv_interleave_for(const char *path);
+yuv_swap_uv_fn yuv_swap_uv_for(const char *path);
+
+/* Copy rows of row_bytes between planes of different strides */
+void yuv_copy_plane(uint8_t *dst, size_t dst_stride,
+                    const uint8_t *src, size_t src_stride,
+                    size_t row_bytes, size_t rows);
+
+/*
+ * YV12 -> NV21 chroma: interleave rows of the Cr and Cb planes (stride
+ * src_stride, pairs bytes wide) into VU rows of stride dst_stride.
+ */
+void yuv_yv12_to_nv21_chroma(uint8_t *dst, size_t dst_stride,
+                             const uint8_t *cr, const uint8_t *cb,
+                             size_t src_stride, size_t pairs, size_t rows);
+
+/* NV12 <-> NV21 chroma: swap the pairs of each row */
+void yuv_nv12_nv21_chroma(uint8_t *dst, size_t dst_stride,
+                          const uint8_t *src, size_t src_stride,
+                          size_t pairs, size_t rows);
+
+#endif /* __YUV_CONVERT_H__ */
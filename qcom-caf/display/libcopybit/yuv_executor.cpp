@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <log/log.h>
+#include <cutils/properties.h>
+#include <stdlib.h>
+#include <sys/prctl.h>
+#include <algorithm>
+#include "yuv_convert.h"
+#include "yuv_executor.h"
+
+#define SW_THREADS_PROP "vendor.display.copybit_sw_threads"
+
+YuvExecutor::YuvExecutor(size_t threads)
+{
+    for (size_t i = 1; i < threads; i++)
+        mWorkers.emplace_back(&YuvExecutor::workerLoop, this);
+}
+
+YuvExecutor::~YuvExecutor()
+{
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mExit = true;
+    }
+    mWakeCv.notify_all();
+    for (auto& t : mWorkers)
+        t.join();
+}
+
+YuvExecutor& YuvExecutor::getInstance()
+{
+    static YuvExecutor *sInstance = [] {
+        char value[PROPERTY_VALUE_MAX];
+        size_t threads = std::min((size_t)YUV_MAX_THREADS,
+                (size_t)std::max(1u, std::thread::hardware_concurrency()));
+
+        if (property_get(SW_THREADS_PROP, value, NULL) > 0)
+            threads = (size_t)std::min(YUV_MAX_THREADS,
+                                       std::max(1, atoi(value)));
+        ALOGD("YuvExecutor: %zu software conversion threads", threads);
+        // Never destroyed, workers may still be parked at process exit
+        return new YuvExecutor(threads);
+    }();
+    return *sInstance;
+}
+
+void YuvExecutor::drain(Job *job)
+{
+    size_t stripe;
+
+    while ((stripe = job->next.fetch_add(1, std::memory_order_relaxed)) *
+           job->stripeRows < job->rows) {
+        size_t first = stripe * job->stripeRows;
+        (*job->fn)(first, std::min(first + job->stripeRows, job->rows));
+    }
+}
+
+void YuvExecutor::workerLoop()
+{
+    uint64_t seen = 0;
+
+    prctl(PR_SET_NAME, "copybit_sw", 0, 0, 0);
+    std::unique_lock<std::mutex> lock(mLock);
+    for (;;) {
+        mWakeCv.wait(lock, [&] {
+            return mExit || (mJob && mGeneration != seen);
+        });
+        if (mExit)
+            return;
+        seen = mGeneration;
+        // The job stays alive until mActive drops back to 0
+        Job *job = mJob;
+        mActive++;
+        lock.unlock();
+        drain(job);
+        lock.lock();
+        if (--mActive == 0)
+            mDoneCv.notify_all();
+    }
+}
+
+void YuvExecutor::run(size_t rows, size_t rows_per_stripe,
+                      const yuv_stripe_fn& fn)
+{
+    rows_per_stripe = std::max(rows_per_stripe, (size_t)1);
+    if (mWorkers.empty() || rows <= rows_per_stripe) {
+        fn(0, rows);
+        return;
+    }
+
+    std::lock_guard<std::mutex> runLock(mRunLock);
+    Job job;
+    job.fn = &fn;
+    job.rows = rows;
+    job.stripeRows = rows_per_stripe;
+    job.next.store(0, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(mLock);
+        mJob = &job;
+        mGeneration++;
+    }
+    mWakeCv.notify_all();
+    drain(&job);
+
+    std::unique_lock<std::mutex> lock(mLock);
+    mDoneCv.wait(lock, [&] { return mActive == 0; });
+    mJob = nullptr;
+}
+
+void yuv_copy_plane_striped(uint8_t *dst, size_t dst_stride,
+                            const uint8_t *src, size_t src_stride,
+                            size_t row_bytes, size_t rows)
+{
+    if (row_bytes * rows < YUV_MIN_PARALLEL_BYTES) {
+        yuv_copy_plane(dst, dst_stride, src, src_stride, row_bytes, rows);
+        return;
+    }
+    size_t stripe = std::max((size_t)1, YUV_TILE_BYTES / (row_bytes * 2));
+    YuvExecutor::getInstance().run(rows, stripe,
+            [=](size_t first, size_t end) {
+        yuv_copy_plane(dst + first * dst_stride, dst_stride,
+                       src + first * src_stride, src_stride,
+                       row_bytes, end - first);
+    });
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *     * Neither the name of The Linux Foundation nor the names of its
+ *       contributors may be used to endorse or promote products derived
+ *       from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef __YUV_EXECUTOR_H__
+#define __YUV_EXECUTOR_H__
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/* Rows of a stripe are picked so that a stripe touches about this much
+ * source plus destination data, which stays within a core's L2. */
+#define YUV_TILE_BYTES          (64 * 1024)
+/* Planes smaller than this are converted on the calling thread */
+#define YUV_MIN_PARALLEL_BYTES  (512 * 1024)
+#define YUV_MAX_THREADS         4
+
+typedef std::function<void(size_t first_row, size_t end_row)> yuv_stripe_fn;
+
+/*
+ * Small persistent pool that splits a plane conversion into row
+ * stripes. The calling thread works on stripes as well and run()
+ * returns once every stripe is done. One frame runs at a time.
+ */
+class YuvExecutor {
+public:
+    explicit YuvExecutor(size_t threads);
+    ~YuvExecutor();
+    YuvExecutor(const YuvExecutor&) = delete;
+    YuvExecutor& operator=(const YuvExecutor&) = delete;
+
+    /* Shared pool, sized from vendor.display.copybit_sw_threads */
+    static YuvExecutor& getInstance();
+
+    void run(size_t rows, size_t rows_per_stripe, const yuv_stripe_fn& fn);
+    size_t threads() const { return mWorkers.size() + 1; }
+
+private:
+    struct Job {
+        const yuv_stripe_fn *fn;
+        size_t rows;
+        size_t stripeRows;
+        std::atomic<size_t> next;
+    };
+
+    void workerLoop();
+    static void drain(Job *job);
+
+    std::mutex mRunLock;
+    std::mutex mLock;
+    std::condition_variable mWakeCv;
+    std::condition_variable mDoneCv;
+    std::vector<std::thread> mWorkers;
+    Job *mJob = nullptr;
+    uint64_t mGeneration = 0;
+    size_t mActive = 0;
+    bool mExit = false;
+};
+
+/* yuv_copy_plane() split into cache sized stripes on the shared pool */
+void yuv_copy_plane_striped(uint8_t *dst, size_t dst_stride,
+                            const uint8_t *src, size_t src_stride,
+                            size_t row_bytes, size_t rows);
+
+#endif /* __YUV_EXECUTOR_H__ */
@@ -25,6 +25,10 @@
 #include <utils/constants.h>
 #include <utils/debug.h>
 #include <core/buffer_allocator.h>
+#include <string.h>
+#include <algorithm>
+#include <iterator>
+#include <vector>
 
 #include "comp_manager.h"
 #include "strategy.h"
@@ -66,6 +70,8 @@ DisplayError CompManager::Init(const HWResourceInfo &hw_res_info,
   hw_res_info_ = hw_res_info;
   buffer_allocator_ = buffer_allocator;
   extension_intf_ = extension_intf;
+  // The default strategy is a single GPU attempt, cheaper than a cache lookup
+  strategy_cache_enabled_ = extension_intf && !Debug::IsStrategyCacheDisabled();
 
   return error;
 }
@@ -125,6 +131,8 @@ DisplayError CompManager::RegisterDisplay(DisplayType type,
   }
 
   registered_displays_[type] = 1;
+  strategy_cache_generation_++;
+  display_comp_ctx->strategy_cache_generation = strategy_cache_generation_;
   display_comp_ctx->is_primary_panel = hw_panel_info.is_primary_panel;
   display_comp_ctx->display_type = type;
   display_comp_ctx->fb_config = fb_config;
@@ -162,6 +170,7 @@ DisplayError CompManager::UnregisterDisplay(Handle display_ctx) {
 
   registered_displays_[display_comp_ctx->display_type] = 0;
   configured_displays_[display_comp_ctx->display_type] = 0;
+  strategy_cache_generation_++;
 
   if (display_comp_ctx->display_type == kHDMI) {
     max_layers_ = kMaxSDELayers;
@@ -187,6 +196,7 @@ DisplayError CompManager::ReconfigureDisplay(Handle comp_handle,
   DisplayCompositionContext *display_comp_ctx =
                              reinterpret_cast<DisplayCompositionContext *>(comp_handle);
 
+  ClearStrategyCache(display_comp_ctx);
   error = resource_intf_->ReconfigureDisplay(display_comp_ctx->display_resource_ctx,
                                              display_attributes, hw_panel_info, mixer_attributes);
   if (error != kErrorNone) {
@@ -296,6 +306,7 @@ void CompManager::PrePrepare(Handle display_ctx, HWLayers *hw_layers) {
   display_comp_ctx->strategy->Start(&hw_layers->info, &display_comp_ctx->max_strategies,
                                     display_comp_ctx->pu_constraints);
   display_comp_ctx->remaining_strategies = display_comp_ctx->max_strategies;
+  display_comp_ctx->strategy_pending = false;
 }
 
 DisplayError CompManager::Prepare(Handle display_ctx, HWLayers *hw_layers) {
@@ -312,6 +323,28 @@ DisplayError CompManager::Prepare(Handle display_ctx, HWLayers *hw_layers) {
   // Select a composition strategy, and try to allocate resources for it.
   resource_intf_->Start(display_resource_ctx);
 
+  uint64_t signature = 0;
+  if (strategy_cache_enabled_) {
+    signature = GetStrategySignature(display_comp_ctx, hw_layers->info);
+    if (display_comp_ctx->strategy_pending) {
+      // Validate() rejected the configuration handed out last time for this frame
+      EraseStrategy(display_comp_ctx, display_comp_ctx->pending_signature);
+    } else if (LoadStrategy(display_comp_ctx, signature, hw_layers)) {
+      // Let the resource manager take the pipes of the cached configuration again
+      error = resource_intf_->Prepare(display_resource_ctx, hw_layers);
+      if (error == kErrorNone) {
+        display_comp_ctx->strategy_cache_hits++;
+        display_comp_ctx->strategy_pending = true;
+        display_comp_ctx->pending_signature = signature;
+        return resource_intf_->Stop(display_resource_ctx, hw_layers);
+      }
+      EraseStrategy(display_comp_ctx, signature);
+      display_comp_ctx->strategy_cache_misses++;
+    } else {
+      display_comp_ctx->strategy_cache_misses++;
+    }
+  }
+
   bool exit = false;
   uint32_t &count = display_comp_ctx->remaining_strategies;
   for (; !exit && count > 0; count--) {
@@ -335,6 +368,12 @@ DisplayError CompManager::Prepare(Handle display_ctx, HWLayers *hw_layers) {
     return error;
   }
 
+  if (strategy_cache_enabled_) {
+    StoreStrategy(display_comp_ctx, signature, *hw_layers);
+    display_comp_ctx->strategy_pending = true;
+    display_comp_ctx->pending_signature = signature;
+  }
+
   error = resource_intf_->Stop(display_resource_ctx, hw_layers);
 
   return error;
@@ -353,10 +392,174 @@ DisplayError CompManager::PostPrepare(Handle display_ctx, HWLayers *hw_layers) {
   }
 
   display_comp_ctx->strategy->Stop();
+  display_comp_ctx->strategy_pending = false;
 
   return kErrorNone;
 }
 
+uint64_t CompManager::GetStrategySignature(DisplayCompositionContext *display_comp_ctx,
+                                           const HWLayersInfo &layer_info) {
+  // FNV-1a, one word at a time, over every input that strategy selection and pipe allocation
+  // depend on
+  uint64_t hash = 14695981039346656037ULL;
+  auto mix_value = [&hash](uint64_t value) { hash = (hash ^ value) * 1099511628211ULL; };
+  auto mix_float = [&mix_value](float value) {
+    uint32_t bits = 0;
+    memcpy(&bits, &value, sizeof(bits));
+    mix_value(bits);
+  };
+  auto mix_rect = [&mix_float](const LayerRect &rect) {
+    mix_float(rect.left);
+    mix_float(rect.top);
+    mix_float(rect.right);
+    mix_float(rect.bottom);
+  };
+
+  const StrategyConstraints &constraints = display_comp_ctx->constraints;
+  mix_value(constraints.safe_mode);
+  mix_value(constraints.use_cursor);
+  mix_value(constraints.max_layers);
+  mix_value(display_comp_ctx->pu_constraints.enable);
+  mix_value(display_comp_ctx->pu_constraints.enable_cursor_pu);
+  mix_value(layer_info.app_layer_count);
+  mix_value(layer_info.gpu_target_index);
+  mix_value(layer_info.stack->flags.flags);
+  for (auto &roi : layer_info.left_frame_roi) {
+    mix_rect(roi);
+  }
+  for (auto &roi : layer_info.right_frame_roi) {
+    mix_rect(roi);
+  }
+
+  for (auto layer : layer_info.stack->layers) {
+    const LayerBuffer &buffer = layer->input_buffer;
+    mix_value(buffer.format);
+    mix_value(buffer.width);
+    mix_value(buffer.height);
+    mix_value(buffer.unaligned_width);
+    mix_value(buffer.unaligned_height);
+    mix_value(buffer.flags.flags);
+    mix_value(buffer.s3d_format);
+    mix_value(buffer.color_metadata.colorPrimaries);
+    mix_value(buffer.color_metadata.transfer);
+    mix_value(layer->composition);
+    mix_rect(layer->src_rect);
+    mix_rect(layer->dst_rect);
+    mix_value(layer->blending);
+    mix_float(layer->transform.rotation);
+    mix_value(layer->transform.flip_horizontal);
+    mix_value(layer->transform.flip_vertical);
+    mix_value(layer->plane_alpha);
+    mix_value(layer->frame_rate);
+    mix_value(layer->flags.flags);
+  }
+
+  return hash;
+}
+
+bool CompManager::LoadStrategy(DisplayCompositionContext *display_comp_ctx, uint64_t signature,
+                               HWLayers *hw_layers) {
+  if (display_comp_ctx->strategy_cache_generation != strategy_cache_generation_) {
+    ClearStrategyCache(display_comp_ctx);
+    display_comp_ctx->strategy_cache_generation = strategy_cache_generation_;
+  }
+
+  HWLayersInfo &layer_info = hw_layers->info;
+  std::vector<Layer *> &layers = layer_info.stack->layers;
+  display_comp_ctx->strategy_cache_frame++;
+  for (auto &entry : display_comp_ctx->strategy_cache) {
+    if (entry.signature != signature || entry.composition.size() != layers.size()) {
+      continue;
+    }
+
+    for (size_t i = 0; i < layers.size(); i++) {
+      layers.at(i)->composition = entry.composition.at(i);
+      layers.at(i)->request = entry.request.at(i);
+    }
+
+    // Decision and pipe setup come from the cache, buffers and regions from this frame
+    layer_info.hw_layers = entry.hw_layers;
+    for (size_t i = 0; i < layer_info.hw_layers.size(); i++) {
+      Layer &hw_layer = layer_info.hw_layers.at(i);
+      const Layer *sdm_layer = layers.at(entry.index[i]);
+      hw_layer.input_buffer = sdm_layer->input_buffer;
+      hw_layer.visible_regions = sdm_layer->visible_regions;
+      hw_layer.dirty_regions = sdm_layer->dirty_regions;
+      hw_layers->config[i] = entry.config.at(i);
+    }
+    std::copy(std::begin(entry.index), std::end(entry.index), std::begin(layer_info.index));
+    std::copy(std::begin(entry.roi_index), std::end(entry.roi_index),
+              std::begin(layer_info.roi_index));
+    layer_info.use_hw_cursor = entry.use_hw_cursor;
+    entry.last_use = display_comp_ctx->strategy_cache_frame;
+
+    return true;
+  }
+
+  return false;
+}
+
+void CompManager::StoreStrategy(DisplayCompositionContext *display_comp_ctx, uint64_t signature,
+                                const HWLayers &hw_layers) {
+  const HWLayersInfo &layer_info = hw_layers.info;
+  size_t hw_layer_count = layer_info.hw_layers.size();
+
+  // Rotator sessions own per frame buffers and cannot be replayed
+  for (size_t i = 0; i < hw_layer_count; i++) {
+    if (hw_layers.config[i].hw_rotator_session.hw_block_count) {
+      return;
+    }
+  }
+
+  EraseStrategy(display_comp_ctx, signature);
+  std::vector<StrategyCacheEntry> &cache = display_comp_ctx->strategy_cache;
+  if (cache.size() >= kMaxStrategyCacheEntries) {
+    auto lru = std::min_element(cache.begin(), cache.end(),
+                                [](const StrategyCacheEntry &lhs, const StrategyCacheEntry &rhs) {
+                                  return lhs.last_use < rhs.last_use;
+                                });
+    cache.erase(lru);
+  }
+
+  StrategyCacheEntry entry;
+  entry.signature = signature;
+  entry.last_use = display_comp_ctx->strategy_cache_frame;
+  for (auto layer : layer_info.stack->layers) {
+    entry.composition.push_back(layer->composition);
+    entry.request.push_back(layer->request);
+  }
+  entry.hw_layers = layer_info.hw_layers;
+  entry.config.assign(hw_layers.config, hw_layers.config + hw_layer_count);
+  std::copy(std::begin(layer_info.index), std::end(layer_info.index), std::begin(entry.index));
+  std::copy(std::begin(layer_info.roi_index), std::end(layer_info.roi_index),
+            std::begin(entry.roi_index));
+  entry.use_hw_cursor = layer_info.use_hw_cursor;
+  cache.push_back(std::move(entry));
+}
+
+void CompManager::EraseStrategy(DisplayCompositionContext *display_comp_ctx, uint64_t signature) {
+  std::vector<StrategyCacheEntry> &cache = display_comp_ctx->strategy_cache;
+  cache.erase(std::remove_if(cache.begin(), cache.end(),
+                             [signature](const StrategyCacheEntry &entry) {
+                               return entry.signature == signature;
+                             }), cache.end());
+}
+
+void CompManager::ClearStrategyCache(DisplayCompositionContext *display_comp_ctx) {
+  display_comp_ctx->strategy_cache.clear();
+  display_comp_ctx->strategy_pending = false;
+}
+
+void CompManager::GetStrategyCacheStats(Handle display_ctx, uint64_t *hits, uint64_t *misses) {
+  SCOPE_LOCK(locker_);
+
+  DisplayCompositionContext *display_comp_ctx =
+                             reinterpret_cast<DisplayCompositionContext *>(display_ctx);
+
+  *hits = display_comp_ctx->strategy_cache_hits;
+  *misses = display_comp_ctx->strategy_cache_misses;
+}
+
 DisplayError CompManager::Commit(Handle display_ctx, HWLayers *hw_layers) {
   SCOPE_LOCK(locker_);
 
@@ -423,6 +626,7 @@ void CompManager::Purge(Handle display_ctx) {
   resource_intf_->Purge(display_comp_ctx->display_resource_ctx);
 
   display_comp_ctx->strategy->Purge();
+  ClearStrategyCache(display_comp_ctx);
 }
 
 DisplayError CompManager::SetIdleTimeoutMs(Handle display_ctx, uint32_t active_ms) {
@@ -482,6 +686,7 @@ DisplayError CompManager::SetMaxMixerStages(Handle display_ctx, uint32_t max_mix
   if (display_comp_ctx) {
     error = resource_intf_->SetMaxMixerStages(display_comp_ctx->display_resource_ctx,
                                               max_mixer_stages);
+    ClearStrategyCache(display_comp_ctx);
   }
 
   return error;
@@ -548,6 +753,9 @@ DisplayError CompManager::SetMaxBandwidthMode(HWBwModes mode) {
     return kErrorNotSupported;
   }
 
+  SCOPE_LOCK(locker_);
+  strategy_cache_generation_++;
+
   return resource_intf_->SetMaxBandwidthMode(mode);
 }
 
@@ -562,6 +770,7 @@ DisplayError CompManager::SetDetailEnhancerData(Handle display_ctx,
   DisplayCompositionContext *display_comp_ctx =
                              reinterpret_cast<DisplayCompositionContext *>(display_ctx);
 
+  ClearStrategyCache(display_comp_ctx);
   return resource_intf_->SetDetailEnhancerData(display_comp_ctx->display_resource_ctx, de_data);
 }
 
@@ -572,6 +781,7 @@ DisplayError CompManager::SetCompositionState(Handle display_ctx,
   DisplayCompositionContext *display_comp_ctx =
                              reinterpret_cast<DisplayCompositionContext *>(display_ctx);
 
+  ClearStrategyCache(display_comp_ctx);
   return display_comp_ctx->strategy->SetCompositionState(composition_type, enable);
 }
 
@@ -29,6 +29,7 @@
 #include <private/extension_interface.h>
 #include <utils/locker.h>
 #include <bitset>
+#include <vector>
 
 #include "strategy.h"
 #include "resource_default.h"
@@ -75,10 +76,25 @@ class CompManager {
   DisplayError SetCompositionState(Handle display_ctx, LayerComposition composition_type,
                                    bool enable);
   DisplayError ControlDpps(bool enable);
+  void GetStrategyCacheStats(Handle display_ctx, uint64_t *hits, uint64_t *misses);
 
  private:
   static const int kMaxThermalLevel = 3;
   static const int kSafeModeThreshold = 4;
+  static const uint32_t kMaxStrategyCacheEntries = 4;
+
+  // Composition decision and pipe configuration selected for a layer stack signature
+  struct StrategyCacheEntry {
+    uint64_t signature = 0;
+    uint64_t last_use = 0;
+    std::vector<LayerComposition> composition = {};
+    std::vector<LayerRequest> request = {};
+    std::vector<Layer> hw_layers = {};
+    std::vector<HWLayerConfig> config = {};
+    uint32_t index[kMaxSDELayers] = {};
+    uint32_t roi_index[kMaxSDELayers] = {};
+    bool use_hw_cursor = false;
+  };
 
   void PrepareStrategyConstraints(Handle display_ctx, HWLayers *hw_layers);
 
@@ -98,8 +114,25 @@ class CompManager {
     PUConstraints pu_constraints = {};
     bool scaled_composition = false;
     DisplayConfigVariableInfo fb_config = {};
+    std::vector<StrategyCacheEntry> strategy_cache = {};
+    uint32_t strategy_cache_generation = 0;
+    uint64_t strategy_cache_frame = 0;
+    uint64_t strategy_cache_hits = 0;
+    uint64_t strategy_cache_misses = 0;
+    // Signature handed out by the last Prepare(), dropped if Validate() sends the frame back
+    bool strategy_pending = false;
+    uint64_t pending_signature = 0;
   };
 
+  uint64_t GetStrategySignature(DisplayCompositionContext *display_comp_ctx,
+                                const HWLayersInfo &layer_info);
+  bool LoadStrategy(DisplayCompositionContext *display_comp_ctx, uint64_t signature,
+                    HWLayers *hw_layers);
+  void StoreStrategy(DisplayCompositionContext *display_comp_ctx, uint64_t signature,
+                     const HWLayers &hw_layers);
+  void EraseStrategy(DisplayCompositionContext *display_comp_ctx, uint64_t signature);
+  void ClearStrategyCache(DisplayCompositionContext *display_comp_ctx);
+
   Locker locker_;
   ResourceInterface *resource_intf_ = NULL;
   std::bitset<kDisplayMax> registered_displays_;  // Bit mask of registered displays
@@ -116,6 +149,8 @@ class CompManager {
   uint32_t max_layers_ = kMaxSDELayers;
   uint32_t max_sde_ext_layers_ = 0;
   DppsControlInterface *dpps_ctrl_intf_ = NULL;
+  bool strategy_cache_enabled_ = false;
+  uint32_t strategy_cache_generation_ = 0;  // Bumped when pipe sharing across displays changes
 };
 
 }  // namespace sdm
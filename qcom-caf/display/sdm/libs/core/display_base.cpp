@@ -559,6 +559,11 @@ std::string DisplayBase::Dump() {
     << max_mixer_stages_;
   os << "\nnum configs: " << num_modes << " active config index: " << active_index;
 
+  uint64_t strategy_cache_hits = 0, strategy_cache_misses = 0;
+  comp_manager_->GetStrategyCacheStats(display_comp_ctx_, &strategy_cache_hits,
+                                       &strategy_cache_misses);
+  os << "\nstrategy cache hits: " << strategy_cache_hits << " misses: " << strategy_cache_misses;
+
   DisplayConfigVariableInfo &info = attrib;
 
   uint32_t num_hw_layers = UINT32(hw_layers_.info.hw_layers.size());
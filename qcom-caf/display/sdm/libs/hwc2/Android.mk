@@ -72,4 +72,49 @@ ifeq ($(TARGET_HAS_WIDE_COLOR_DISPLAY), true)
 endif
 
 include $(BUILD_SHARED_LIBRARY)
+
+# Offline replay of HWCDisplay::Dump() captures through the HWC2 composition path
+ifeq ($(TARGET_USES_GRALLOC1), true)
+include $(CLEAR_VARS)
+include $(LOCAL_PATH)/../../../common.mk
+
+LOCAL_MODULE                  := hwc_replay
+LOCAL_VENDOR_MODULE           := true
+LOCAL_MODULE_TAGS             := optional
+LOCAL_C_INCLUDES              := $(common_includes) \
+                                 $(kernel_includes)
+LOCAL_HEADER_LIBRARIES        := display_headers
+LOCAL_ADDITIONAL_DEPENDENCIES := $(TARGET_OUT_INTERMEDIATES)/KERNEL_OBJ/usr
+
+LOCAL_CFLAGS                  := -Wno-missing-field-initializers -Wno-unused-parameter \
+                                 -DLOG_TAG=\"SDM\" $(common_flags) \
+                                 -I $(display_top)/sdm/libs/hwc
+
+ifeq ($(TARGET_EXCLUDES_DISPLAY_PP), true)
+LOCAL_CFLAGS += -DEXCLUDE_DISPLAY_PP
+endif
+
+ifeq ($(TARGET_HAS_WIDE_COLOR_DISPLAY), true)
+    LOCAL_CFLAGS += -DFEATURE_WIDE_COLOR
+endif
+
+LOCAL_CLANG                   := true
+
+LOCAL_SHARED_LIBRARIES        := libsdmcore libqservice libbinder libhardware libutils libcutils \
+                                 libsync libqdutils libqdMetaData libsdmutils libc++ liblog \
+                                 libgrallocutils libdl libui libgpu_tonemapper
+
+LOCAL_SRC_FILES               := hwc_replay.cpp \
+                                 hwc_display.cpp \
+                                 hwc_layers.cpp \
+                                 hwc_callbacks.cpp \
+                                 hwc_replay_allocator.cpp \
+                                 hwc_tonemapper.cpp \
+                                 display_null.cpp \
+                                 ../hwc/hwc_debugger.cpp \
+                                 ../hwc/hwc_buffer_sync_handler.cpp
+
+include $(BUILD_EXECUTABLE)
+endif
+
 endif
@@ -30,6 +30,7 @@
 #include <qd_utils.h>
 
 #include <algorithm>
+#include <chrono>
 #include <iomanip>
 #include <map>
 #include <sstream>
@@ -471,8 +472,34 @@ HWC2::Error HWCDisplay::DestroyLayer(hwc2_layer_t layer_id) {
 }
 
 
+bool HWCDisplay::CanPatchLayerStack() {
+  // The stack must still hold the layer set in Z order followed by the client target, layer
+  // add/remove, Z order changes and SolidFillPrepare() all leave a different list behind
+  if (layer_stack_invalid_ || layer_stack_.layers.size() != layer_set_.size() + 1) {
+    return false;
+  }
+
+  size_t index = 0;
+  for (auto hwc_layer : layer_set_) {
+    if (layer_stack_.layers.at(index++) != hwc_layer->GetSDMLayer()) {
+      return false;
+    }
+  }
+
+  return layer_stack_.layers.back() == client_target_->GetSDMLayer();
+}
+
 void HWCDisplay::BuildLayerStack() {
-  layer_stack_ = LayerStack();
+  auto build_start = std::chrono::steady_clock::now();
+  bool patch = CanPatchLayerStack();
+  if (patch) {
+    // Keep the layer list and only reset the per frame state of the stack
+    layer_stack_.retire_fence_fd = -1;
+    layer_stack_.output_buffer = NULL;
+    layer_stack_.flags = {};
+  } else {
+    layer_stack_ = LayerStack();
+  }
   display_rect_ = LayerRect();
   metadata_refresh_rate_ = 0;
   auto working_primaries = ColorPrimaries_BT709_5;
@@ -561,14 +588,16 @@ void HWCDisplay::BuildLayerStack() {
     }
 
     // TODO(user): Move to a getter if this is needed at other places
-    hwc_rect_t scaled_display_frame = {INT(layer->dst_rect.left), INT(layer->dst_rect.top),
-                                       INT(layer->dst_rect.right), INT(layer->dst_rect.bottom)};
     if (hwc_layer->GetGeometryChanges() & kDisplayFrame) {
+      hwc_rect_t scaled_display_frame = {INT(layer->dst_rect.left), INT(layer->dst_rect.top),
+                                         INT(layer->dst_rect.right), INT(layer->dst_rect.bottom)};
       ApplyScanAdjustment(&scaled_display_frame);
+      hwc_layer->SetLayerDisplayFrame(scaled_display_frame);
     }
-    hwc_layer->SetLayerDisplayFrame(scaled_display_frame);
-    // SDM requires these details even for solid fill
-    if (layer->flags.solid_fill) {
+    // SDM requires these details even for solid fill, they only change with the layer state
+    uint32_t dirty = patch ? hwc_layer->GetDirtyBits() : kDirtyAll;
+    if (layer->flags.solid_fill &&
+        (dirty & (kDirtyGeometry | kDirtyBuffer | kDirtyColor | kDirtyComposition))) {
       LayerBuffer *layer_buffer = &layer->input_buffer;
       layer_buffer->width = UINT32(layer->dst_rect.right - layer->dst_rect.left);
       layer_buffer->height = UINT32(layer->dst_rect.bottom - layer->dst_rect.top);
@@ -595,7 +624,10 @@ void HWCDisplay::BuildLayerStack() {
       layer->flags.updating = IsLayerUpdating(layer);
     }
 
-    layer_stack_.layers.push_back(layer);
+    hwc_layer->ResetDirtyBits();
+    if (!patch) {
+      layer_stack_.layers.push_back(layer);
+    }
   }
 
 
@@ -618,7 +650,9 @@ void HWCDisplay::BuildLayerStack() {
   // Append client target to the layer stack
 
   Layer *sdm_client_target = client_target_->GetSDMLayer();
-  layer_stack_.layers.push_back(sdm_client_target);
+  if (!patch) {
+    layer_stack_.layers.push_back(sdm_client_target);
+  }
   // fall back frame composition to GPU when client target is 10bit
   // TODO(user): clarify the behaviour from Client(SF) and SDM Extn -
   // when handling 10bit FBT, as it would affect blending
@@ -631,6 +665,16 @@ void HWCDisplay::BuildLayerStack() {
   SetSecureDisplay(secure_display_active);
 
   layer_stack_invalid_ = false;
+
+  auto build_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now() - build_start).count();
+  if (patch) {
+    layer_stack_patches_++;
+    layer_stack_patch_ns_ += UINT64(build_ns);
+  } else {
+    layer_stack_builds_++;
+    layer_stack_build_ns_ += UINT64(build_ns);
+  }
 }
 
 void HWCDisplay::BuildSolidFillStack() {
@@ -2031,10 +2075,22 @@ std::string HWCDisplay::Dump() {
        << layer->GetLayerDataspace() << std::dec << std::setfill(' ');
     os << " transform: " << transform.rotation << "/" << transform.flip_horizontal <<
           "/"<< transform.flip_vertical;
-    os << " buffer_id: " << std::hex << "0x" << sdm_layer->input_buffer.buffer_id << std::dec
+    os << " buffer_id: " << std::hex << "0x" << sdm_layer->input_buffer.buffer_id << std::dec;
+    os << " size: " << sdm_layer->input_buffer.unaligned_width << "x"
+       << sdm_layer->input_buffer.unaligned_height;
+    auto &crop = sdm_layer->src_rect;
+    os << " crop: " << crop.left << "," << crop.top << "," << crop.right << "," << crop.bottom;
+    auto &frame = sdm_layer->dst_rect;
+    os << " frame: " << frame.left << "," << frame.top << "," << frame.right << "," << frame.bottom
        << std::endl;
   }
 
+  os << "layer stack: " << layer_stack_builds_ << " full builds avg "
+     << (layer_stack_builds_ ? layer_stack_build_ns_ / layer_stack_builds_ : 0) << " ns, "
+     << layer_stack_patches_ << " patched in place avg "
+     << (layer_stack_patches_ ? layer_stack_patch_ns_ / layer_stack_patches_ : 0)
+     << " ns" << std::endl;
+
   if (layer_stack_invalid_) {
     os << "\n Layers added or removed but not reflected to SDM's layer stack yet\n";
     return os.str();
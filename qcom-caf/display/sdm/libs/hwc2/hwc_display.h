@@ -164,6 +164,7 @@ class HWCDisplay : public DisplayEventHandler {
   void SolidFillCommit();
   DisplayClass GetDisplayClass();
   int GetVisibleDisplayRect(hwc_rect_t *rect);
+  bool CanPatchLayerStack(void);
   void BuildLayerStack(void);
   void BuildSolidFillStack(void);
   HWCLayer *GetHWCLayer(hwc2_layer_t layer);
@@ -325,6 +326,10 @@ class HWCDisplay : public DisplayEventHandler {
   bool fbt_valid_ = false;
   bool is_primary_ = false;
   uint32_t min_enc_level_ = UINT32_MAX;
+  uint64_t layer_stack_builds_ = 0;
+  uint64_t layer_stack_build_ns_ = 0;
+  uint64_t layer_stack_patches_ = 0;
+  uint64_t layer_stack_patch_ns_ = 0;
 };
 
 inline int HWCDisplay::Perform(uint32_t operation, ...) {
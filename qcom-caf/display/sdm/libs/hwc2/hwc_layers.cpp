@@ -259,6 +259,7 @@ HWC2::Error HWCLayer::SetLayerBuffer(buffer_handle_t buffer, int32_t acquire_fen
   layer_buffer->acquire_fence_fd = acquire_fence;
   layer_buffer->size = handle->size;
   layer_buffer->buffer_id = reinterpret_cast<uint64_t>(handle);
+  dirty_bits_ |= kDirtyBuffer;
 
   return HWC2::Error::None;
 }
@@ -305,6 +306,7 @@ HWC2::Error HWCLayer::SetLayerBlendMode(HWC2::BlendMode mode) {
 
   if (layer_->blending != blending) {
     geometry_changes_ |= kBlendMode;
+    dirty_bits_ |= kDirtyBlend;
     layer_->blending = blending;
   }
   return HWC2::Error::None;
@@ -314,7 +316,12 @@ HWC2::Error HWCLayer::SetLayerColor(hwc_color_t color) {
   if (client_requested_ != HWC2::Composition::SolidColor) {
     return HWC2::Error::None;
   }
-  layer_->solid_fill_color = GetUint32Color(color);
+  uint32_t solid_fill_color = GetUint32Color(color);
+  if (layer_->solid_fill_color != solid_fill_color ||
+      layer_->input_buffer.format != kFormatARGB8888) {
+    dirty_bits_ |= kDirtyColor;
+  }
+  layer_->solid_fill_color = solid_fill_color;
   layer_->input_buffer.format = kFormatARGB8888;
   DLOGV_IF(kTagClient, "[%" PRIu64 "][%" PRIu64 "] Layer color set to %x", display_id_, id_,
            layer_->solid_fill_color);
@@ -322,6 +329,9 @@ HWC2::Error HWCLayer::SetLayerColor(hwc_color_t color) {
 }
 
 HWC2::Error HWCLayer::SetLayerCompositionType(HWC2::Composition type) {
+  if (client_requested_ != type) {
+    dirty_bits_ |= kDirtyComposition;
+  }
   client_requested_ = type;
   switch (type) {
     case HWC2::Composition::Client:
@@ -374,6 +384,7 @@ HWC2::Error HWCLayer::SetLayerDataspace(int32_t dataspace) {
   // cache the dataspace, to be used later to update SDM ColorMetaData
   if (dataspace_ != dataspace) {
     geometry_changes_ |= kDataspace;
+    dirty_bits_ |= kDirtyDataspace;
     dataspace_ = dataspace;
   }
   return HWC2::Error::None;
@@ -384,6 +395,7 @@ HWC2::Error HWCLayer::SetLayerDisplayFrame(hwc_rect_t frame) {
   SetRect(frame, &dst_rect);
   if (layer_->dst_rect != dst_rect) {
     geometry_changes_ |= kDisplayFrame;
+    dirty_bits_ |= kDirtyGeometry;
     layer_->dst_rect = dst_rect;
   }
   return HWC2::Error::None;
@@ -405,6 +417,7 @@ HWC2::Error HWCLayer::SetLayerPlaneAlpha(float alpha) {
   uint8_t plane_alpha = static_cast<uint8_t>(std::round(255.0f * alpha));
   if (layer_->plane_alpha != plane_alpha) {
     geometry_changes_ |= kPlaneAlpha;
+    dirty_bits_ |= kDirtyBlend;
     layer_->plane_alpha = plane_alpha;
   }
 
@@ -414,15 +427,20 @@ HWC2::Error HWCLayer::SetLayerPlaneAlpha(float alpha) {
 HWC2::Error HWCLayer::SetLayerSourceCrop(hwc_frect_t crop) {
   LayerRect src_rect = {};
   SetRect(crop, &src_rect);
-  non_integral_source_crop_ = ((crop.left != roundf(crop.left)) ||
-                              (crop.top != roundf(crop.top)) ||
-                              (crop.right != roundf(crop.right)) ||
-                              (crop.bottom != roundf(crop.bottom)));
+  bool non_integral_source_crop = ((crop.left != roundf(crop.left)) ||
+                                   (crop.top != roundf(crop.top)) ||
+                                   (crop.right != roundf(crop.right)) ||
+                                   (crop.bottom != roundf(crop.bottom)));
+  if (non_integral_source_crop_ != non_integral_source_crop) {
+    dirty_bits_ |= kDirtyGeometry;
+    non_integral_source_crop_ = non_integral_source_crop;
+  }
   if (non_integral_source_crop_) {
     DLOGV_IF(kTagClient, "Crop: LRTB %f %f %f %f", crop.left, crop.top, crop.right, crop.bottom);
   }
   if (layer_->src_rect != src_rect) {
     geometry_changes_ |= kSourceCrop;
+    dirty_bits_ |= kDirtyGeometry;
     layer_->src_rect = src_rect;
   }
 
@@ -465,6 +483,7 @@ HWC2::Error HWCLayer::SetLayerTransform(HWC2::Transform transform) {
 
   if (layer_->transform != layer_transform) {
     geometry_changes_ |= kTransform;
+    dirty_bits_ |= kDirtyGeometry;
     layer_->transform = layer_transform;
   }
   return HWC2::Error::None;
@@ -484,6 +503,7 @@ HWC2::Error HWCLayer::SetLayerVisibleRegion(hwc_region_t visible) {
 HWC2::Error HWCLayer::SetLayerZOrder(uint32_t z) {
   if (z_ != z) {
     geometry_changes_ |= kZOrder;
+    dirty_bits_ |= kDirtyGeometry;
     z_ = z;
   }
   return HWC2::Error::None;
@@ -719,6 +739,14 @@ bool HWCLayer::SupportLocalConversion(ColorPrimaries working_primaries) {
 }
 
 bool HWCLayer::ValidateAndSetCSC() {
+  // Color metadata only derives from the buffer, the dataspace and the requested composition
+  if (dirty_bits_ & (kDirtyBuffer | kDirtyDataspace | kDirtyComposition)) {
+    csc_valid_ = UpdateCSC();
+  }
+  return csc_valid_;
+}
+
+bool HWCLayer::UpdateCSC() {
   if (client_requested_ != HWC2::Composition::Device &&
       client_requested_ != HWC2::Composition::Cursor) {
     // Check the layers which are configured to Device
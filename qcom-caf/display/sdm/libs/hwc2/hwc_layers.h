@@ -59,6 +59,19 @@ enum GeometryChanges {
   kBufferGeometry = 0x200,
 };
 
+// Per layer state touched by the client since the last BuildLayerStack, used to patch the
+// SDM layer stack in place instead of deriving every layer attribute again
+enum LayerDirty {
+  kDirtyNone        = 0x00,
+  kDirtyGeometry    = 0x01,
+  kDirtyBuffer      = 0x02,
+  kDirtyBlend       = 0x04,
+  kDirtyColor       = 0x08,
+  kDirtyDataspace   = 0x10,
+  kDirtyComposition = 0x20,
+  kDirtyAll         = 0x3f,
+};
+
 class HWCLayer {
  public:
   explicit HWCLayer(hwc2_display_t display_id, HWCBufferAllocator *buf_allocator);
@@ -82,11 +95,18 @@ class HWCLayer {
   HWC2::Error SetLayerZOrder(uint32_t z);
   void SetComposition(const LayerComposition &sdm_composition);
   HWC2::Composition GetClientRequestedCompositionType() { return client_requested_; }
-  void UpdateClientCompositionType(HWC2::Composition type) { client_requested_ = type; }
+  void UpdateClientCompositionType(HWC2::Composition type) {
+    if (client_requested_ != type) {
+      dirty_bits_ |= kDirtyComposition;
+      client_requested_ = type;
+    }
+  }
   HWC2::Composition GetDeviceSelectedCompositionType() { return device_selected_; }
   int32_t GetLayerDataspace() { return dataspace_; }
   uint32_t GetGeometryChanges() { return geometry_changes_; }
   void ResetGeometryChanges() { geometry_changes_ = GeometryChanges::kNone; }
+  uint32_t GetDirtyBits() { return dirty_bits_; }
+  void ResetDirtyBits() { dirty_bits_ = kDirtyNone; }
   void PushReleaseFence(int32_t fence);
   int32_t PopReleaseFence(void);
   bool ValidateAndSetCSC();
@@ -113,7 +133,11 @@ class HWCLayer {
   // Composition selected by SDM
   HWC2::Composition device_selected_ = HWC2::Composition::Device;
   uint32_t geometry_changes_ = GeometryChanges::kNone;
+  uint32_t dirty_bits_ = kDirtyAll;
+  // Result of the last CSC validation, reused while buffer and dataspace are unchanged
+  bool csc_valid_ = true;
 
+  bool UpdateCSC();
   void SetRect(const hwc_rect_t &source, LayerRect *target);
   void SetRect(const hwc_frect_t &source, LayerRect *target);
   uint32_t GetUint32Color(const hwc_color_t &source);
@@ -0,0 +1,872 @@
+/*
+* Copyright (c) 2019, The Linux Foundation. All rights reserved.
+*
+* Redistribution and use in source and binary forms, with or without
+* modification, are permitted provided that the following conditions are
+* met:
+*     * Redistributions of source code must retain the above copyright
+*       notice, this list of conditions and the following disclaimer.
+*     * Redistributions in binary form must reproduce the above
+*       copyright notice, this list of conditions and the following
+*       disclaimer in the documentation and/or other materials provided
+*       with the distribution.
+*     * Neither the name of The Linux Foundation nor the names of its
+*       contributors may be used to endorse or promote products derived
+*       from this software without specific prior written permission.
+*
+* THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+* WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+* MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+* ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+* BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+* CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+* SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+* BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+* WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+* OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+* IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+/*
+ * hwc_replay drives the HWC2 composition path of HWCDisplay with layer stacks recorded by
+ * HWCDisplay::Dump(), without SurfaceFlinger, gralloc or a display driver behind it. Each
+ * "HWC2 display_id:" section of the capture is one frame; frames are replayed back to back and
+ * the time and heap allocations of every validate/present phase are reported.
+ *
+ * usage: hwc_replay [-l loops] [-w warmup] [-p pipes] [-s WxH] [-i display_id] [-d] <capture>
+ */
+
+#include <getopt.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <core/buffer_allocator.h>
+#include <utils/constants.h>
+#include <utils/debug.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "display_null.h"
+#include "hwc_buffer_allocator.h"
+#include "hwc_display.h"
+
+#define __CLASS__ "HWCReplay"
+
+// Every heap allocation of the process goes through these, the count is sampled around each
+// phase to get the allocations per frame of the composition path
+static std::atomic<uint64_t> g_alloc_count(0);
+
+void *operator new(size_t size) {
+  g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr) {
+    abort();
+  }
+  return ptr;
+}
+
+void *operator new[](size_t size) {
+  return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept {
+  g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+  return malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &tag) noexcept {
+  return operator new(size, tag);
+}
+
+void operator delete(void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+  free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept {
+  free(ptr);
+}
+
+namespace sdm {
+
+enum ReplayPhase {
+  kPhaseSetLayers,
+  kPhaseBuild,
+  kPhasePrepare,
+  kPhaseAccept,
+  kPhaseCommit,
+  kPhasePostCommit,
+  kPhaseFrame,
+  kPhaseMax,
+};
+
+static const char *kPhaseNames[kPhaseMax] = {
+  "set layers", "build", "prepare", "accept", "commit", "post commit", "frame",
+};
+
+struct ReplaySample {
+  uint64_t ns[kPhaseMax] = {};
+  uint64_t allocs[kPhaseMax] = {};
+};
+
+class ScopedPhase {
+ public:
+  ScopedPhase(ReplaySample *sample, ReplayPhase phase)
+    : sample_(sample), phase_(phase), allocs_(g_alloc_count.load(std::memory_order_relaxed)),
+      start_(std::chrono::steady_clock::now()) { }
+  ~ScopedPhase() {
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start_).count();
+    sample_->ns[phase_] += UINT64(ns);
+    sample_->allocs[phase_] += g_alloc_count.load(std::memory_order_relaxed) - allocs_;
+  }
+
+ private:
+  ReplaySample *sample_;
+  ReplayPhase phase_;
+  uint64_t allocs_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+// Stands in for the SDM core display. Every layer the HWC path did not mark as skip gets a pipe,
+// unless there are more layers than pipes, in which case the frame falls back to GPU like the
+// default strategy does.
+class DisplayReplay : public DisplayNull {
+ public:
+  explicit DisplayReplay(uint32_t max_sde_layers) : max_sde_layers_(max_sde_layers) { }
+  virtual DisplayError Prepare(LayerStack *layer_stack);
+  virtual DisplayError Commit(LayerStack *layer_stack);
+
+ private:
+  uint32_t max_sde_layers_ = 0;
+};
+
+DisplayError DisplayReplay::Prepare(LayerStack *layer_stack) {
+  uint32_t app_layers = 0;
+  bool gpu_fallback = layer_stack->flags.skip_present;
+  for (Layer *layer : layer_stack->layers) {
+    if (layer->composition != kCompositionGPUTarget) {
+      app_layers++;
+    }
+  }
+  gpu_fallback |= (app_layers > max_sde_layers_);
+
+  for (Layer *layer : layer_stack->layers) {
+    if (layer->composition != kCompositionGPUTarget) {
+      layer->composition = gpu_fallback ? kCompositionGPU : kCompositionSDE;
+    }
+  }
+
+  return kErrorNone;
+}
+
+DisplayError DisplayReplay::Commit(LayerStack *layer_stack) {
+  for (Layer *layer : layer_stack->layers) {
+    layer->input_buffer.release_fence_fd = -1;
+  }
+  layer_stack->retire_fence_fd = -1;
+
+  return kErrorNone;
+}
+
+class HWCDisplayReplay : public HWCDisplay {
+ public:
+  HWCDisplayReplay(BufferAllocator *buffer_allocator, uint32_t width, uint32_t height,
+                   uint32_t max_sde_layers);
+  virtual int Deinit();
+  virtual HWC2::Error Validate(uint32_t *out_num_types, uint32_t *out_num_requests);
+  virtual HWC2::Error Present(int32_t *out_retire_fence);
+  void SetSample(ReplaySample *sample) { sample_ = sample; }
+
+ private:
+  DisplayReplay display_replay_;
+  ReplaySample *sample_ = nullptr;
+};
+
+HWCDisplayReplay::HWCDisplayReplay(BufferAllocator *buffer_allocator, uint32_t width,
+                                   uint32_t height, uint32_t max_sde_layers)
+  : HWCDisplay(nullptr, nullptr, kPrimary, HWC_DISPLAY_PRIMARY, true, nullptr,
+               DISPLAY_CLASS_NULL, buffer_allocator),
+    display_replay_(max_sde_layers) {
+  DisplayConfigVariableInfo config;
+  config.x_pixels = width;
+  config.y_pixels = height;
+  config.x_dpi = 200.0f;
+  config.y_dpi = 200.0f;
+  config.fps = 60;
+  config.vsync_period_ns = 16600000;
+  display_replay_.SetFrameBufferConfig(config);
+  num_configs_ = 1;
+  display_intf_ = &display_replay_;
+  client_target_ = new HWCLayer(id_, buffer_allocator_);
+  current_refresh_rate_ = max_refresh_rate_ = 60;
+
+  Layer *client_target_layer = client_target_->GetSDMLayer();
+  client_target_layer->composition = kCompositionGPUTarget;
+  client_target_layer->src_rect = LayerRect(0.0f, 0.0f, FLOAT(width), FLOAT(height));
+  client_target_layer->dst_rect = client_target_layer->src_rect;
+}
+
+int HWCDisplayReplay::Deinit() {
+  for (auto hwc_layer : layer_set_) {
+    delete hwc_layer;
+  }
+  layer_set_.clear();
+  layer_map_.clear();
+  delete client_target_;
+  client_target_ = nullptr;
+
+  return 0;
+}
+
+HWC2::Error HWCDisplayReplay::Validate(uint32_t *out_num_types, uint32_t *out_num_requests) {
+  {
+    ScopedPhase phase(sample_, kPhaseBuild);
+    BuildLayerStack();
+  }
+
+  ScopedPhase phase(sample_, kPhasePrepare);
+  return PrepareLayerStack(out_num_types, out_num_requests);
+}
+
+HWC2::Error HWCDisplayReplay::Present(int32_t *out_retire_fence) {
+  auto status = HWC2::Error::None;
+  {
+    ScopedPhase phase(sample_, kPhaseCommit);
+    status = CommitLayerStack();
+  }
+  if (status != HWC2::Error::None) {
+    return status;
+  }
+
+  ScopedPhase phase(sample_, kPhasePostCommit);
+  return PostCommitLayerStack(out_retire_fence);
+}
+
+// One layer line of a HWCDisplay::Dump() capture
+struct ReplayLayer {
+  uint64_t id = 0;
+  uint32_t z = 0;
+  HWC2::Composition composition = HWC2::Composition::Device;
+  float alpha = 1.0f;
+  int32_t format = HAL_PIXEL_FORMAT_RGBA_8888;
+  int flags = 0;
+  int buffer_type = BUFFER_TYPE_UI;
+  int32_t dataspace = HAL_DATASPACE_UNKNOWN;
+  HWC2::Transform transform = HWC2::Transform::None;
+  uint64_t buffer_id = 0;
+  int width = 0;
+  int height = 0;
+  hwc_frect_t crop = {};
+  hwc_rect_t frame = {};
+  bool has_size = false;
+  bool has_crop = false;
+  bool has_frame = false;
+  const private_handle_t *handle = nullptr;
+};
+
+struct ReplayFrame {
+  std::vector<ReplayLayer> layers;
+  bool has_client = false;
+};
+
+// Inverse of GetFormatString() over the formats HWCLayer::GetSDMFormat() produces
+static const struct {
+  const char *name;
+  int32_t format;
+  int flags;
+  int buffer_type;
+} kReplayFormats[] = {
+  {"RGBA_8888", HAL_PIXEL_FORMAT_RGBA_8888, 0, BUFFER_TYPE_UI},
+  {"RGBA_5551", HAL_PIXEL_FORMAT_RGBA_5551, 0, BUFFER_TYPE_UI},
+  {"RGBA_4444", HAL_PIXEL_FORMAT_RGBA_4444, 0, BUFFER_TYPE_UI},
+  {"BGRA_8888", HAL_PIXEL_FORMAT_BGRA_8888, 0, BUFFER_TYPE_UI},
+  {"RGBX_8888", HAL_PIXEL_FORMAT_RGBX_8888, 0, BUFFER_TYPE_UI},
+  {"BGRX_8888", HAL_PIXEL_FORMAT_BGRX_8888, 0, BUFFER_TYPE_UI},
+  {"RGB_888", HAL_PIXEL_FORMAT_RGB_888, 0, BUFFER_TYPE_UI},
+  {"BGR_888", HAL_PIXEL_FORMAT_BGR_888, 0, BUFFER_TYPE_UI},
+  {"RGB_565", HAL_PIXEL_FORMAT_RGB_565, 0, BUFFER_TYPE_UI},
+  {"BGR_565", HAL_PIXEL_FORMAT_BGR_565, 0, BUFFER_TYPE_UI},
+  {"RGBA_1010102", HAL_PIXEL_FORMAT_RGBA_1010102, 0, BUFFER_TYPE_UI},
+  {"ARGB_2101010", HAL_PIXEL_FORMAT_ARGB_2101010, 0, BUFFER_TYPE_UI},
+  {"RGBX_1010102", HAL_PIXEL_FORMAT_RGBX_1010102, 0, BUFFER_TYPE_UI},
+  {"XRGB_2101010", HAL_PIXEL_FORMAT_XRGB_2101010, 0, BUFFER_TYPE_UI},
+  {"BGRA_1010102", HAL_PIXEL_FORMAT_BGRA_1010102, 0, BUFFER_TYPE_UI},
+  {"ABGR_2101010", HAL_PIXEL_FORMAT_ABGR_2101010, 0, BUFFER_TYPE_UI},
+  {"BGRX_1010102", HAL_PIXEL_FORMAT_BGRX_1010102, 0, BUFFER_TYPE_UI},
+  {"XBGR_2101010", HAL_PIXEL_FORMAT_XBGR_2101010, 0, BUFFER_TYPE_UI},
+  {"RGBA_8888_UBWC", HAL_PIXEL_FORMAT_RGBA_8888, private_handle_t::PRIV_FLAGS_UBWC_ALIGNED,
+   BUFFER_TYPE_UI},
+  {"RGBX_8888_UBWC", HAL_PIXEL_FORMAT_RGBX_8888, private_handle_t::PRIV_FLAGS_UBWC_ALIGNED,
+   BUFFER_TYPE_UI},
+  {"BGR_565_UBWC", HAL_PIXEL_FORMAT_BGR_565, private_handle_t::PRIV_FLAGS_UBWC_ALIGNED,
+   BUFFER_TYPE_UI},
+  {"RGBA_1010102_UBWC", HAL_PIXEL_FORMAT_RGBA_1010102, private_handle_t::PRIV_FLAGS_UBWC_ALIGNED,
+   BUFFER_TYPE_UI},
+  {"RGBX_1010102_UBWC", HAL_PIXEL_FORMAT_RGBX_1010102, private_handle_t::PRIV_FLAGS_UBWC_ALIGNED,
+   BUFFER_TYPE_UI},
+  {"Y_CBCR_420_VENUS", HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS, 0, BUFFER_TYPE_VIDEO},
+  {"Y_CRCB_420_VENUS", HAL_PIXEL_FORMAT_YCrCb_420_SP_VENUS, 0, BUFFER_TYPE_VIDEO},
+  {"Y_CBCR_420_VENUS_UBWC", HAL_PIXEL_FORMAT_YCbCr_420_SP_VENUS_UBWC, 0, BUFFER_TYPE_VIDEO},
+  {"Y_CR_CB_420_STRIDE16", HAL_PIXEL_FORMAT_YV12, 0, BUFFER_TYPE_VIDEO},
+  {"Y_CRCB_420", HAL_PIXEL_FORMAT_YCrCb_420_SP, 0, BUFFER_TYPE_VIDEO},
+  {"Y_CBCR_420", HAL_PIXEL_FORMAT_YCbCr_420_SP, 0, BUFFER_TYPE_VIDEO},
+  {"Y_CBCR_422_H2V1", HAL_PIXEL_FORMAT_YCbCr_422_SP, 0, BUFFER_TYPE_VIDEO},
+  {"YCBYCR_422_H2V1", HAL_PIXEL_FORMAT_YCbCr_422_I, 0, BUFFER_TYPE_VIDEO},
+  {"CBYCRY_422_H2V1", HAL_PIXEL_FORMAT_CbYCrY_422_I, 0, BUFFER_TYPE_VIDEO},
+  {"Y_CBCR_420_P010", HAL_PIXEL_FORMAT_YCbCr_420_P010, 0, BUFFER_TYPE_VIDEO},
+  {"Y_CBCR_420_TP10_UBWC", HAL_PIXEL_FORMAT_YCbCr_420_TP10_UBWC,
+   private_handle_t::PRIV_FLAGS_UBWC_ALIGNED, BUFFER_TYPE_VIDEO},
+  {"Y_CBCR_420_P010_UBWC", HAL_PIXEL_FORMAT_YCbCr_420_P010_UBWC,
+   private_handle_t::PRIV_FLAGS_UBWC_ALIGNED, BUFFER_TYPE_VIDEO},
+};
+
+static bool GetReplayFormat(const std::string &name, ReplayLayer *layer) {
+  for (auto &entry : kReplayFormats) {
+    if (name == entry.name) {
+      layer->format = entry.format;
+      layer->flags = entry.flags;
+      layer->buffer_type = entry.buffer_type;
+      return true;
+    }
+  }
+  return false;
+}
+
+static HWC2::Composition GetReplayComposition(const std::string &name) {
+  for (auto composition : {HWC2::Composition::Client, HWC2::Composition::Device,
+                           HWC2::Composition::SolidColor, HWC2::Composition::Cursor,
+                           HWC2::Composition::Sideband}) {
+    if (name == to_string(composition)) {
+      return composition;
+    }
+  }
+  return HWC2::Composition::Device;
+}
+
+// Inverse of HWCLayer::SetLayerTransform()
+static HWC2::Transform GetReplayTransform(float rotation, bool flip_h, bool flip_v) {
+  if (rotation == 90.0f) {
+    if (flip_h && flip_v) {
+      return HWC2::Transform::Rotate270;
+    } else if (flip_h) {
+      return HWC2::Transform::FlipHRotate90;
+    } else if (flip_v) {
+      return HWC2::Transform::FlipVRotate90;
+    }
+    return HWC2::Transform::Rotate90;
+  }
+
+  if (flip_h && flip_v) {
+    return HWC2::Transform::Rotate180;
+  } else if (flip_h) {
+    return HWC2::Transform::FlipH;
+  } else if (flip_v) {
+    return HWC2::Transform::FlipV;
+  }
+  return HWC2::Transform::None;
+}
+
+// Points the stream right after "<key>:" of a dump line, returns false if the field is missing
+static bool SeekField(const std::string &line, const char *key, std::istringstream *is) {
+  std::string tag = std::string(" ") + key + ":";
+  size_t pos = line.find(tag);
+  if (pos == std::string::npos) {
+    return false;
+  }
+
+  is->clear();
+  is->str(line.substr(pos + tag.size()));
+  is->setf(std::ios::dec, std::ios::basefield);
+  return true;
+}
+
+static bool ParseLayer(const std::string &dump_line, ReplayLayer *layer) {
+  std::string line = " " + dump_line;
+  std::istringstream is;
+  std::string name;
+  char sep = 0;
+
+  if (!SeekField(line, "layer", &is) || !(is >> layer->id)) {
+    return false;
+  }
+
+  if (SeekField(line, "z", &is)) {
+    is >> layer->z;
+  }
+
+  if (SeekField(line, "compositon", &is) && (is >> name)) {
+    layer->composition = GetReplayComposition(name.substr(0, name.find('/')));
+  }
+
+  uint32_t alpha = 0;
+  if (SeekField(line, "alpha", &is) && (is >> alpha)) {
+    layer->alpha = FLOAT(alpha) / 255.0f;
+  }
+
+  if (SeekField(line, "format", &is) && (is >> name) && !GetReplayFormat(name, layer)) {
+    DLOGW("Unknown format %s on layer %" PRIu64, name.c_str(), layer->id);
+  }
+
+  uint32_t dataspace = 0;
+  if (SeekField(line, "dataspace", &is) && (is >> std::hex >> dataspace)) {
+    layer->dataspace = INT32(dataspace);
+  }
+
+  float rotation = 0.0f;
+  int flip_h = 0, flip_v = 0;
+  if (SeekField(line, "transform", &is) && (is >> rotation >> sep >> flip_h >> sep >> flip_v)) {
+    layer->transform = GetReplayTransform(rotation, flip_h, flip_v);
+  }
+
+  if (SeekField(line, "buffer_id", &is)) {
+    is >> std::hex >> layer->buffer_id;
+  }
+
+  if (SeekField(line, "size", &is)) {
+    layer->has_size = !!(is >> layer->width >> sep >> layer->height);
+  }
+
+  hwc_frect_t &crop = layer->crop;
+  if (SeekField(line, "crop", &is)) {
+    layer->has_crop = !!(is >> crop.left >> sep >> crop.top >> sep >> crop.right >> sep >>
+                         crop.bottom);
+  }
+
+  hwc_rect_t &frame = layer->frame;
+  if (SeekField(line, "frame", &is)) {
+    layer->has_frame = !!(is >> frame.left >> sep >> frame.top >> sep >> frame.right >> sep >>
+                          frame.bottom);
+  }
+
+  return true;
+}
+
+// Reads the frames of one display out of a capture holding one or more HWCDisplay::Dump()s
+static int ParseCapture(const char *path, int64_t *display_id, std::vector<ReplayFrame> *frames) {
+  std::ifstream capture(path);
+  if (!capture.is_open()) {
+    fprintf(stderr, "Unable to open %s\n", path);
+    return -ENOENT;
+  }
+
+  static const char kDisplayTag[] = "HWC2 display_id:";
+  std::string line;
+  bool in_frame = false;
+  while (std::getline(capture, line)) {
+    size_t pos = line.find(kDisplayTag);
+    if (pos != std::string::npos) {
+      int64_t id = strtoll(line.c_str() + pos + sizeof(kDisplayTag) - 1, nullptr, 10);
+      if (*display_id < 0) {
+        *display_id = id;
+      }
+      in_frame = (id == *display_id);
+      if (in_frame) {
+        frames->emplace_back();
+      }
+      continue;
+    }
+
+    size_t start = line.find_first_not_of(' ');
+    if (!in_frame || start == std::string::npos || line.compare(start, 6, "layer:") != 0) {
+      continue;
+    }
+
+    ReplayLayer layer;
+    if (ParseLayer(line.substr(start), &layer)) {
+      frames->back().has_client |= (layer.composition == HWC2::Composition::Client);
+      frames->back().layers.push_back(layer);
+    }
+  }
+
+  return frames->empty() ? -EINVAL : 0;
+}
+
+// Fake gralloc handles, one per distinct buffer of the capture. Both the buffer and the metadata
+// fd point at /dev/zero, so dup() and the qdMetaData mapping work and read back no metadata.
+class ReplayBuffers {
+ public:
+  ~ReplayBuffers();
+  int Init();
+  const private_handle_t *Get(const ReplayLayer &layer);
+
+ private:
+  typedef std::tuple<uint64_t, int32_t, int, int, int> BufferKey;
+  int fd_ = -1;
+  std::map<BufferKey, std::unique_ptr<private_handle_t>> handles_;
+};
+
+ReplayBuffers::~ReplayBuffers() {
+  for (auto &handle : handles_) {
+    if (handle.second->base_metadata) {
+      munmap(reinterpret_cast<void *>(handle.second->base_metadata), getMetaDataSize());
+    }
+  }
+  handles_.clear();
+
+  if (fd_ >= 0) {
+    close(fd_);
+  }
+}
+
+int ReplayBuffers::Init() {
+  fd_ = open("/dev/zero", O_RDWR);
+  return (fd_ < 0) ? -errno : 0;
+}
+
+const private_handle_t *ReplayBuffers::Get(const ReplayLayer &layer) {
+  BufferKey key(layer.buffer_id, layer.format, layer.flags, layer.width, layer.height);
+  auto &handle = handles_[key];
+  if (!handle) {
+    unsigned int size = UINT32(layer.width) * UINT32(layer.height) * 4;
+    handle.reset(new private_handle_t(fd_, fd_, layer.flags, layer.width, layer.height,
+                                      layer.width, layer.height, layer.format, layer.buffer_type,
+                                      size));
+  }
+
+  return handle.get();
+}
+
+static bool operator!=(const hwc_rect_t &a, const hwc_rect_t &b) {
+  return a.left != b.left || a.top != b.top || a.right != b.right || a.bottom != b.bottom;
+}
+
+static bool operator!=(const hwc_frect_t &a, const hwc_frect_t &b) {
+  return a.left != b.left || a.top != b.top || a.right != b.right || a.bottom != b.bottom;
+}
+
+class HWCReplay {
+ public:
+  int Run(int argc, char **argv);
+
+ private:
+  struct LiveLayer {
+    hwc2_layer_t id = 0;
+    size_t frame = 0;
+    ReplayLayer state;
+  };
+
+  int ParseArgs(int argc, char **argv);
+  void ResolveFrames();
+  void SetLayers(const ReplayFrame &frame, size_t frame_index);
+  void SetLayer(HWCLayer *hwc_layer, const ReplayLayer &layer, const ReplayLayer *last);
+  void ReplayOneFrame(const ReplayFrame &frame, size_t frame_index, ReplaySample *sample);
+  void Report(const std::vector<ReplaySample> &samples);
+
+  const char *capture_ = nullptr;
+  uint32_t loops_ = 100;
+  uint32_t warmup_ = 1;
+  uint32_t max_sde_layers_ = 4;
+  uint32_t width_ = 0;
+  uint32_t height_ = 0;
+  int64_t display_id_ = -1;
+  bool dump_ = false;
+  std::vector<ReplayFrame> frames_;
+  ReplayBuffers buffers_;
+  HWCBufferAllocator buffer_allocator_;
+  std::unique_ptr<HWCDisplayReplay> display_;
+  std::map<uint64_t, LiveLayer> live_layers_;
+  const private_handle_t *client_target_ = nullptr;
+  std::vector<hwc2_layer_t> fence_layers_;
+  std::vector<int32_t> fences_;
+  uint32_t failed_frames_ = 0;
+};
+
+int HWCReplay::ParseArgs(int argc, char **argv) {
+  int opt = 0;
+  while ((opt = getopt(argc, argv, "l:w:p:s:i:d")) != -1) {
+    switch (opt) {
+      case 'l':
+        loops_ = UINT32(strtoul(optarg, nullptr, 10));
+        break;
+      case 'w':
+        warmup_ = UINT32(strtoul(optarg, nullptr, 10));
+        break;
+      case 'p':
+        max_sde_layers_ = UINT32(strtoul(optarg, nullptr, 10));
+        break;
+      case 's':
+        if (sscanf(optarg, "%ux%u", &width_, &height_) != 2) {
+          return -EINVAL;
+        }
+        break;
+      case 'i':
+        display_id_ = strtoll(optarg, nullptr, 10);
+        break;
+      case 'd':
+        dump_ = true;
+        break;
+      default:
+        return -EINVAL;
+    }
+  }
+
+  if (optind != argc - 1 || !loops_) {
+    return -EINVAL;
+  }
+  capture_ = argv[optind];
+
+  return 0;
+}
+
+// Fills in what older captures lack and creates the buffer handles up front, so that neither
+// shows up in the measured phases
+void HWCReplay::ResolveFrames() {
+  bool size_from_capture = !width_ || !height_;
+  for (auto &frame : frames_) {
+    for (auto &layer : frame.layers) {
+      if (size_from_capture && layer.has_frame) {
+        width_ = std::max(width_, UINT32(std::max(layer.frame.right, 0)));
+        height_ = std::max(height_, UINT32(std::max(layer.frame.bottom, 0)));
+      }
+    }
+  }
+  if (!width_ || !height_) {
+    width_ = 1080;
+    height_ = 1920;
+  }
+
+  size_t max_layers = 0;
+  for (auto &frame : frames_) {
+    for (auto &layer : frame.layers) {
+      if (!layer.has_frame) {
+        layer.frame = {0, 0, INT(width_), INT(height_)};
+      }
+      if (!layer.has_crop) {
+        layer.crop = {0.0f, 0.0f, FLOAT(layer.has_size ? layer.width : layer.frame.right),
+                      FLOAT(layer.has_size ? layer.height : layer.frame.bottom)};
+      }
+      if (!layer.has_size) {
+        layer.width = INT(std::ceil(layer.crop.right));
+        layer.height = INT(std::ceil(layer.crop.bottom));
+      }
+      if (layer.buffer_id) {
+        layer.handle = buffers_.Get(layer);
+      }
+    }
+    max_layers = std::max(max_layers, frame.layers.size());
+  }
+
+  ReplayLayer client_target;
+  client_target.buffer_id = UINT64(-1);
+  client_target.width = INT(width_);
+  client_target.height = INT(height_);
+  client_target_ = buffers_.Get(client_target);
+  fence_layers_.resize(max_layers);
+  fences_.resize(max_layers);
+}
+
+void HWCReplay::SetLayer(HWCLayer *hwc_layer, const ReplayLayer &layer, const ReplayLayer *last) {
+  // Like SurfaceFlinger, only send the state that changed since the previous frame
+  if (!last || layer.composition != last->composition) {
+    hwc_layer->SetLayerCompositionType(layer.composition);
+  }
+  if (layer.handle && (!last || layer.handle != last->handle)) {
+    hwc_layer->SetLayerBuffer(layer.handle, -1);
+  }
+  if (!last || layer.crop != last->crop) {
+    hwc_layer->SetLayerSourceCrop(layer.crop);
+  }
+  if (!last || layer.frame != last->frame) {
+    hwc_layer->SetLayerDisplayFrame(layer.frame);
+    hwc_region_t visible = {1, &layer.frame};
+    hwc_layer->SetLayerVisibleRegion(visible);
+  }
+  if (!last || layer.alpha != last->alpha) {
+    hwc_layer->SetLayerPlaneAlpha(layer.alpha);
+  }
+  if (!last || layer.dataspace != last->dataspace) {
+    hwc_layer->SetLayerDataspace(layer.dataspace);
+  }
+  if (!last || layer.transform != last->transform) {
+    hwc_layer->SetLayerTransform(layer.transform);
+  }
+  if (!last) {
+    hwc_layer->SetLayerBlendMode(HWC2::BlendMode::Premultiplied);
+  }
+}
+
+void HWCReplay::SetLayers(const ReplayFrame &frame, size_t frame_index) {
+  for (auto &layer : frame.layers) {
+    auto &live = live_layers_[layer.id];
+    bool created = !live.id;
+    if (created) {
+      display_->CreateLayer(&live.id);
+    }
+
+    HWCLayer *hwc_layer = display_->GetHWCLayer(live.id);
+    if (created || layer.z != live.state.z) {
+      display_->SetLayerZOrder(live.id, layer.z);
+    }
+    SetLayer(hwc_layer, layer, created ? nullptr : &live.state);
+    live.state = layer;
+    live.frame = frame_index;
+  }
+
+  // Layers which are not part of this frame any more went away on the device
+  for (auto it = live_layers_.begin(); it != live_layers_.end();) {
+    if (it->second.frame != frame_index) {
+      display_->DestroyLayer(it->second.id);
+      it = live_layers_.erase(it);
+    } else {
+      it++;
+    }
+  }
+}
+
+void HWCReplay::ReplayOneFrame(const ReplayFrame &frame, size_t frame_index,
+                               ReplaySample *sample) {
+  ScopedPhase frame_phase(sample, kPhaseFrame);
+  display_->SetSample(sample);
+
+  {
+    ScopedPhase phase(sample, kPhaseSetLayers);
+    SetLayers(frame, frame_index);
+  }
+
+  uint32_t num_types = 0, num_requests = 0;
+  auto status = display_->Validate(&num_types, &num_requests);
+  if (status != HWC2::Error::None && status != HWC2::Error::HasChanges) {
+    failed_frames_++;
+    return;
+  }
+
+  {
+    ScopedPhase phase(sample, kPhaseAccept);
+    if (status == HWC2::Error::HasChanges) {
+      display_->AcceptDisplayChanges();
+    }
+    if (status == HWC2::Error::HasChanges || frame.has_client) {
+      hwc_region_t damage = {0, nullptr};
+      display_->SetClientTarget(client_target_, -1, HAL_DATASPACE_UNKNOWN, damage);
+    }
+  }
+
+  int32_t retire_fence = -1;
+  if (display_->Present(&retire_fence) != HWC2::Error::None) {
+    failed_frames_++;
+    return;
+  }
+  if (retire_fence >= 0) {
+    close(retire_fence);
+  }
+
+  uint32_t num_fences = UINT32(fences_.size());
+  display_->GetReleaseFences(&num_fences, fence_layers_.data(), fences_.data());
+  for (uint32_t i = 0; i < num_fences; i++) {
+    if (fences_[i] >= 0) {
+      close(fences_[i]);
+    }
+  }
+}
+
+static double ToMicroSeconds(uint64_t ns) {
+  return static_cast<double>(ns) / 1000.0;
+}
+
+void HWCReplay::Report(const std::vector<ReplaySample> &samples) {
+  printf("%zu trace frames x %u loops (%u warm-up), %ux%u, %u pipes, %u failed frames\n",
+         frames_.size(), loops_, warmup_, width_, height_, max_sde_layers_, failed_frames_);
+  printf("%-12s %9s %9s %9s %9s %9s %13s %11s\n", "phase", "avg us", "p50 us", "p90 us",
+         "p99 us", "max us", "allocs/frame", "max allocs");
+
+  std::vector<uint64_t> ns(samples.size());
+  std::vector<uint64_t> allocs(samples.size());
+  for (int phase = 0; phase < kPhaseMax; phase++) {
+    for (size_t i = 0; i < samples.size(); i++) {
+      ns[i] = samples[i].ns[phase];
+      allocs[i] = samples[i].allocs[phase];
+    }
+    std::sort(ns.begin(), ns.end());
+
+    uint64_t total_ns = 0, total_allocs = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+      total_ns += ns[i];
+      total_allocs += allocs[i];
+    }
+
+    size_t count = samples.size();
+    double frames = static_cast<double>(count);
+    printf("%-12s %9.2f %9.2f %9.2f %9.2f %9.2f %13.2f %11" PRIu64 "\n", kPhaseNames[phase],
+           ToMicroSeconds(total_ns) / frames, ToMicroSeconds(ns[count / 2]),
+           ToMicroSeconds(ns[count * 90 / 100]), ToMicroSeconds(ns[count * 99 / 100]),
+           ToMicroSeconds(ns[count - 1]), static_cast<double>(total_allocs) / frames,
+           *std::max_element(allocs.begin(), allocs.end()));
+  }
+}
+
+int HWCReplay::Run(int argc, char **argv) {
+  if (ParseArgs(argc, argv) != 0) {
+    fprintf(stderr, "usage: %s [-l loops] [-w warmup] [-p pipes] [-s WxH] [-i display_id] [-d] "
+            "<capture>\n", argv[0]);
+    return -EINVAL;
+  }
+
+  int status = ParseCapture(capture_, &display_id_, &frames_);
+  if (status != 0) {
+    fprintf(stderr, "No frames of display %" PRId64 " in %s\n", display_id_, capture_);
+    return status;
+  }
+
+  status = buffers_.Init();
+  if (status != 0) {
+    fprintf(stderr, "Unable to open /dev/zero: %d\n", status);
+    return status;
+  }
+
+  ResolveFrames();
+  display_.reset(new HWCDisplayReplay(&buffer_allocator_, width_, height_, max_sde_layers_));
+
+  // Samples are reserved up front so that recording them stays out of the allocation count
+  std::vector<ReplaySample> samples;
+  samples.reserve(frames_.size() * loops_);
+  size_t frame_index = 0;
+  for (uint32_t loop = 0; loop < warmup_ + loops_; loop++) {
+    if (loop == warmup_) {
+      failed_frames_ = 0;
+    }
+    for (auto &frame : frames_) {
+      ReplaySample sample;
+      ReplayOneFrame(frame, ++frame_index, &sample);
+      if (loop >= warmup_) {
+        samples.push_back(sample);
+      }
+    }
+  }
+
+  Report(samples);
+  if (dump_) {
+    printf("%s", display_->Dump().c_str());
+  }
+
+  display_->Deinit();
+  return 0;
+}
+
+}  // namespace sdm
+
+int main(int argc, char **argv) {
+  sdm::HWCReplay replay;
+  return (replay.Run(argc, argv) == 0) ? 0 : 1;
+}
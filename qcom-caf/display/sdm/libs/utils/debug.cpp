@@ -173,6 +173,13 @@ bool Debug::IsPartialSplitDisabled() {
   return (value == 1);
 }
 
+bool Debug::IsStrategyCacheDisabled() {
+  int value = 0;
+  debug_.debug_handler_->GetProperty(DISABLE_STRATEGY_CACHE_PROP, &value);
+
+  return (value == 1);
+}
+
 DisplayError Debug::GetMixerResolution(uint32_t *width, uint32_t *height) {
   char value[64] = {};
 
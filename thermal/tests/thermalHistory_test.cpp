@@ -0,0 +1,256 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "thermalHistory.h"
+
+using android::hardware::thermal::V2_0::implementation::ThermalHistory;
+using android::hardware::thermal::V2_0::implementation::therm_history_sample;
+using android::hardware::thermal::V2_0::implementation::therm_history_stats;
+
+#define MS	1000000LL
+
+/*
+ * Sample i is recorded at i ms with every field derived from i, so a
+ * sample read back can be checked against its own timestamp.
+ */
+static void recordSample(ThermalHistory& history, uint64_t i)
+{
+	history.record((int64_t)i * MS, 20.0f + (float)(i % 1000) / 8,
+			(uint8_t)(i % 7), (uint8_t)((i >> 3) % 7),
+			(uint16_t)(i * 13));
+}
+
+static bool sampleMatches(const struct therm_history_sample& s)
+{
+	uint64_t i;
+
+	if (s.ts_ns < 0 || s.ts_ns % MS)
+		return false;
+	i = s.ts_ns / MS;
+	return s.temp == 20.0f + (float)(i % 1000) / 8 &&
+		s.severity == (uint8_t)(i % 7) &&
+		s.predicted == (uint8_t)((i >> 3) % 7) &&
+		s.cdev_state == (uint16_t)(i * 13);
+}
+
+TEST(ThermalHistoryTest, Empty)
+{
+	ThermalHistory history;
+	std::vector<struct therm_history_sample> out;
+	struct therm_history_stats stats;
+
+	EXPECT_EQ(0u, history.snapshot(INT64_MIN, INT64_MAX, out));
+	EXPECT_TRUE(out.empty());
+	EXPECT_FALSE(history.query(INT64_MIN, INT64_MAX, stats));
+	EXPECT_EQ(0u, stats.count);
+	EXPECT_EQ(0, history.lastStamp());
+}
+
+TEST(ThermalHistoryTest, FieldsRoundTrip)
+{
+	ThermalHistory history;
+	std::vector<struct therm_history_sample> out;
+
+	history.record(5, -12.25f, 6, 0, 0xffff);
+	history.record(6, 0.0f, 0, 255, 0);
+	history.record(7, 125.5f, 3, 4, 1);
+	ASSERT_EQ(3u, history.snapshot(INT64_MIN, INT64_MAX, out));
+	EXPECT_EQ(5, out[0].ts_ns);
+	EXPECT_EQ(-12.25f, out[0].temp);
+	EXPECT_EQ(6, out[0].severity);
+	EXPECT_EQ(0, out[0].predicted);
+	EXPECT_EQ(0xffff, out[0].cdev_state);
+	EXPECT_EQ(0.0f, out[1].temp);
+	EXPECT_EQ(255, out[1].predicted);
+	EXPECT_EQ(0, out[1].cdev_state);
+	EXPECT_EQ(125.5f, out[2].temp);
+	EXPECT_EQ(7, history.lastStamp());
+}
+
+TEST(ThermalHistoryTest, TimeWindowIsInclusive)
+{
+	ThermalHistory history;
+	std::vector<struct therm_history_sample> out;
+	uint64_t i;
+
+	for (i = 0; i < 100; i++)
+		recordSample(history, i);
+
+	ASSERT_EQ(11u, history.snapshot(40 * MS, 50 * MS, out));
+	EXPECT_EQ(40 * MS, out.front().ts_ns);
+	EXPECT_EQ(50 * MS, out.back().ts_ns);
+
+	/* snapshot() appends */
+	EXPECT_EQ(1u, history.snapshot(99 * MS, INT64_MAX, out));
+	EXPECT_EQ(12u, out.size());
+	EXPECT_EQ(99 * MS, out.back().ts_ns);
+
+	out.clear();
+	EXPECT_EQ(0u, history.snapshot(40 * MS + 1, 41 * MS - 1, out));
+	EXPECT_EQ(0u, history.snapshot(100 * MS, INT64_MAX, out));
+}
+
+TEST(ThermalHistoryTest, WrapKeepsTheNewest)
+{
+	ThermalHistory history;
+	std::vector<struct therm_history_sample> out;
+	uint64_t total = 3 * HISTORY_DEPTH + 77, i;
+
+	for (i = 0; i < total; i++)
+		recordSample(history, i);
+
+	ASSERT_EQ((size_t)HISTORY_DEPTH,
+			history.snapshot(INT64_MIN, INT64_MAX, out));
+	for (i = 0; i < HISTORY_DEPTH; i++) {
+		EXPECT_EQ((int64_t)(total - HISTORY_DEPTH + i) * MS,
+				out[i].ts_ns) << i;
+		EXPECT_TRUE(sampleMatches(out[i])) << i;
+	}
+	EXPECT_EQ((int64_t)(total - 1) * MS, history.lastStamp());
+
+	/* A window across the slot the ring wrapped at */
+	out.clear();
+	i = 3 * HISTORY_DEPTH;
+	ASSERT_EQ(21u, history.snapshot((int64_t)(i - 10) * MS,
+				(int64_t)(i + 10) * MS, out));
+	EXPECT_EQ((int64_t)(i - 10) * MS, out.front().ts_ns);
+	EXPECT_EQ((int64_t)(i + 10) * MS, out.back().ts_ns);
+
+	/* Overwritten samples are gone */
+	out.clear();
+	EXPECT_EQ(0u, history.snapshot(0,
+			(int64_t)(total - HISTORY_DEPTH - 1) * MS, out));
+}
+
+TEST(ThermalHistoryTest, QueryStats)
+{
+	ThermalHistory history;
+	struct therm_history_stats stats;
+	static const float temps[] = {40.0f, 42.5f, 39.0f, 47.0f, 41.5f};
+	static const uint8_t severities[] = {0, 1, 0, 3, 2};
+	size_t i;
+
+	for (i = 0; i < 5; i++)
+		history.record((int64_t)(i + 1) * MS, temps[i], severities[i],
+				0, 0);
+
+	ASSERT_TRUE(history.query(INT64_MIN, INT64_MAX, stats));
+	EXPECT_EQ(5u, stats.count);
+	EXPECT_EQ(39.0f, stats.min);
+	EXPECT_EQ(47.0f, stats.max);
+	EXPECT_FLOAT_EQ(42.0f, stats.avg);
+	EXPECT_EQ(3, stats.max_severity);
+
+	ASSERT_TRUE(history.query(1 * MS, 3 * MS, stats));
+	EXPECT_EQ(3u, stats.count);
+	EXPECT_EQ(39.0f, stats.min);
+	EXPECT_EQ(42.5f, stats.max);
+	EXPECT_FLOAT_EQ(40.5f, stats.avg);
+	EXPECT_EQ(1, stats.max_severity);
+
+	EXPECT_FALSE(history.query(6 * MS, INT64_MAX, stats));
+	EXPECT_EQ(0u, stats.count);
+}
+
+TEST(ThermalHistoryTest, QueryAfterWrap)
+{
+	ThermalHistory history;
+	struct therm_history_stats stats;
+	uint64_t total = 2 * HISTORY_DEPTH + 5, i;
+	double sum = 0;
+
+	for (i = 0; i < total; i++) {
+		history.record((int64_t)i * MS, (float)i, 0, 0, 0);
+		if (i >= total - HISTORY_DEPTH)
+			sum += (double)i;
+	}
+
+	ASSERT_TRUE(history.query(INT64_MIN, INT64_MAX, stats));
+	EXPECT_EQ((size_t)HISTORY_DEPTH, stats.count);
+	EXPECT_EQ((float)(total - HISTORY_DEPTH), stats.min);
+	EXPECT_EQ((float)(total - 1), stats.max);
+	EXPECT_FLOAT_EQ((float)(sum / HISTORY_DEPTH), stats.avg);
+}
+
+/*
+ * Readers snapshot while the writer laps the ring many times over. A
+ * slot overwritten under a reader must be skipped, never returned with
+ * the fields of two different samples.
+ */
+TEST(ThermalHistoryTest, ReadersNeverSeeTornSamples)
+{
+	ThermalHistory history;
+	std::atomic<bool> done(false);
+	std::atomic<int> started(0);
+	std::atomic<uint64_t> torn(0), misordered(0), seen(0);
+	std::vector<std::thread> readers;
+	uint64_t i;
+	int r;
+
+	for (r = 0; r < 3; r++) {
+		readers.emplace_back([&] {
+			std::vector<struct therm_history_sample> out;
+			size_t j;
+
+			started++;
+			while (!done.load(std::memory_order_relaxed)) {
+				out.clear();
+				history.snapshot(INT64_MIN, INT64_MAX, out);
+				for (j = 0; j < out.size(); j++) {
+					if (!sampleMatches(out[j]))
+						torn++;
+					if (j && out[j].ts_ns <= out[j - 1].ts_ns)
+						misordered++;
+				}
+				seen += out.size();
+			}
+		});
+	}
+	while (started.load() < 3)
+		std::this_thread::yield();
+	/* at least 400 laps, and until the readers have checked enough */
+	for (i = 0; i < 400 * HISTORY_DEPTH ||
+			seen.load(std::memory_order_relaxed) < 100 * HISTORY_DEPTH;
+			i++)
+		recordSample(history, i);
+	done = true;
+	for (auto& reader: readers)
+		reader.join();
+
+	EXPECT_EQ(0u, torn.load());
+	EXPECT_EQ(0u, misordered.load());
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "thermalEventLoop.h"
+#include "thermalNotifier.h"
+
+using android::hardware::thermal::V2_0::Temperature;
+using android::hardware::thermal::V2_0::ThrottlingSeverity;
+using android::hardware::thermal::V2_0::implementation::ThermalEventLoop;
+using android::hardware::thermal::V2_0::implementation::ThermalNotifier;
+
+#define INTERVAL_MS	50
+#define MS		1000000LL
+
+static int64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/* A trip event, as a monitor handler reads it off its socket */
+struct TripEvent {
+	int sensor;
+	ThrottlingSeverity severity;
+};
+
+struct Callback {
+	int64_t ns;
+	std::string name;
+	ThrottlingSeverity severity;
+};
+
+/*
+ * Trip events are written to a pipe that a loop handler drains into the
+ * notifier, so both are driven on the loop thread as by the monitors.
+ */
+class ThermalNotifierTest : public ::testing::Test {
+	protected:
+		int pipe_fd[2];
+		std::mutex cb_mutex;
+		std::condition_variable cb_cond;
+		std::vector<Callback> callbacks;
+		ThermalEventLoop loop;
+		std::unique_ptr<ThermalNotifier> notifier;
+
+		void SetUp() override
+		{
+			ASSERT_EQ(0, pipe(pipe_fd));
+			notifier.reset(new ThermalNotifier(loop,
+					[this](Temperature& t) {
+						std::lock_guard<std::mutex> _lock(
+							cb_mutex);
+
+						callbacks.push_back({now_ns(),
+							t.name,
+							t.throttlingStatus});
+						cb_cond.notify_all();
+					}, INTERVAL_MS * MS));
+			ASSERT_LE(0, loop.addFd(pipe_fd[0], [this] {
+				TripEvent ev;
+				Temperature t;
+
+				if (read(pipe_fd[0], &ev, sizeof(ev)) !=
+						sizeof(ev))
+					return;
+				t.name = "sensor" + std::to_string(ev.sensor);
+				t.value = 40.0f + (float)ev.severity;
+				t.throttlingStatus = ev.severity;
+				notifier->queue(t);
+			}));
+			ASSERT_EQ(0, loop.start());
+		}
+
+		void TearDown() override
+		{
+			loop.stop();
+			close(pipe_fd[0]);
+			close(pipe_fd[1]);
+		}
+
+		void trip(int sensor, ThrottlingSeverity severity)
+		{
+			TripEvent ev = {sensor, severity};
+
+			ASSERT_EQ((ssize_t)sizeof(ev),
+					write(pipe_fd[1], &ev, sizeof(ev)));
+		}
+
+		std::vector<Callback> waitCallbacks(size_t count, int64_t wait_ms)
+		{
+			std::unique_lock<std::mutex> _lock(cb_mutex);
+
+			cb_cond.wait_for(_lock,
+				std::chrono::milliseconds(wait_ms), [&] {
+					return callbacks.size() >= count;
+				});
+			return callbacks;
+		}
+
+		/* Long enough for any pending flush to have happened */
+		std::vector<Callback> settle()
+		{
+			std::this_thread::sleep_for(
+				std::chrono::milliseconds(3 * INTERVAL_MS));
+			return waitCallbacks(0, 0);
+		}
+};
+
+TEST_F(ThermalNotifierTest, BurstIsOneCallbackPerSensor)
+{
+	std::vector<Callback> cbs;
+	int i, sensor;
+
+	/* The first trip after a quiet spell is flushed right away, and
+	 * starts an interval that the burst below then falls in */
+	trip(9, ThrottlingSeverity::LIGHT);
+	ASSERT_EQ(1u, waitCallbacks(1, 10 * INTERVAL_MS).size());
+
+	/* 3 sensors climbing through every severity, then settling */
+	for (i = 0; i <= (int)ThrottlingSeverity::SHUTDOWN; i++) {
+		for (sensor = 0; sensor < 3; sensor++)
+			trip(sensor, (ThrottlingSeverity)i);
+	}
+	trip(0, ThrottlingSeverity::SEVERE);
+	trip(1, ThrottlingSeverity::LIGHT);
+
+	cbs = settle();
+	ASSERT_EQ(4u, cbs.size());
+	for (auto& cb: cbs) {
+		if (cb.name == "sensor9")
+			continue;
+		if (cb.name == "sensor0")
+			EXPECT_EQ(ThrottlingSeverity::SEVERE, cb.severity);
+		else if (cb.name == "sensor1")
+			EXPECT_EQ(ThrottlingSeverity::LIGHT, cb.severity);
+		else
+			EXPECT_EQ(ThrottlingSeverity::SHUTDOWN, cb.severity);
+	}
+}
+
+TEST_F(ThermalNotifierTest, AtMostOncePerInterval)
+{
+	std::vector<Callback> cbs;
+	int64_t start = now_ns(), last_ns = 0, end;
+	int i = 0, count = 0;
+
+	/* a trip every 5 ms, alternating severity, for 6 intervals */
+	while (now_ns() - start < 6 * INTERVAL_MS * MS) {
+		trip(7, (i++ & 1) ? ThrottlingSeverity::MODERATE :
+				ThrottlingSeverity::LIGHT);
+		std::this_thread::sleep_for(std::chrono::milliseconds(5));
+	}
+	end = now_ns();
+
+	cbs = settle();
+	ASSERT_FALSE(cbs.empty());
+	for (auto& cb: cbs) {
+		EXPECT_EQ("sensor7", cb.name);
+		/* the flush stamps its interval before the first callback */
+		if (count++)
+			EXPECT_GE(cb.ns - last_ns, INTERVAL_MS * MS - MS);
+		last_ns = cb.ns;
+	}
+	EXPECT_LE(cbs.size(),
+		(size_t)((end - start) / (INTERVAL_MS * MS)) + 2);
+}
+
+TEST_F(ThermalNotifierTest, UpAndBackDownIsNotNotified)
+{
+	std::vector<Callback> cbs;
+
+	trip(1, ThrottlingSeverity::LIGHT);
+	cbs = waitCallbacks(1, 10 * INTERVAL_MS);
+	ASSERT_EQ(1u, cbs.size());
+	EXPECT_EQ(ThrottlingSeverity::LIGHT, cbs[0].severity);
+
+	/* Up and back within one interval */
+	trip(1, ThrottlingSeverity::SEVERE);
+	trip(1, ThrottlingSeverity::LIGHT);
+	cbs = settle();
+	EXPECT_EQ(1u, cbs.size());
+
+	/* A change that holds over the interval is notified */
+	trip(1, ThrottlingSeverity::SEVERE);
+	cbs = waitCallbacks(2, 10 * INTERVAL_MS);
+	ASSERT_EQ(2u, cbs.size());
+	EXPECT_EQ(ThrottlingSeverity::SEVERE, cbs[1].severity);
+
+	/* Back down, and the same severity again, is one callback */
+	trip(1, ThrottlingSeverity::NONE);
+	cbs = waitCallbacks(3, 10 * INTERVAL_MS);
+	trip(1, ThrottlingSeverity::NONE);
+	cbs = settle();
+	ASSERT_EQ(3u, cbs.size());
+	EXPECT_EQ(ThrottlingSeverity::NONE, cbs[2].severity);
+}
+
+TEST_F(ThermalNotifierTest, FirstEventOfAQuietSensorIsNotDelayed)
+{
+	std::vector<Callback> cbs;
+	int64_t start;
+
+	/* Nothing flushed for longer than the interval */
+	std::this_thread::sleep_for(std::chrono::milliseconds(2 * INTERVAL_MS));
+	start = now_ns();
+	trip(2, ThrottlingSeverity::CRITICAL);
+	cbs = waitCallbacks(1, 10 * INTERVAL_MS);
+	ASSERT_EQ(1u, cbs.size());
+	EXPECT_LT(cbs[0].ns - start, INTERVAL_MS * MS);
+}
@@ -0,0 +1,289 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cctype>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <functional>
+#include <signal.h>
+#include <string>
+#include <sys/ptrace.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "thermalReader.h"
+
+using android::hardware::thermal::V2_0::implementation::ThermalReader;
+using android::hardware::thermal::V2_0::implementation::cpu_stat;
+
+/*
+ * The node reads behind one getTemperatures and one getCpuUsages HIDL
+ * call, over stand-in nodes for 16 thermal zones and 8 CPUs: through
+ * ThermalReader with and without its cache, and the way ThermalCommon
+ * read them before, opening and stdio parsing every node on each call.
+ * Besides the time, each run reports the syscalls one call makes, as
+ * counted by a ptrace tracer on a forked copy.
+ */
+
+#define NZONES		16
+#define NCPUS		8
+#define MAX_PATH	256
+
+static std::string root;
+
+static void writeNode(const std::string& node, const std::string& data)
+{
+	std::string path = root + node;
+	size_t pos;
+	FILE *file;
+
+	for (pos = root.size() + 1;
+			(pos = path.find('/', pos)) != std::string::npos; pos++)
+		mkdir(path.substr(0, pos).c_str(), 0755);
+	file = fopen(path.c_str(), "w");
+	if (!file)
+		abort();
+	fputs(data.c_str(), file);
+	fclose(file);
+}
+
+static void makeNodes()
+{
+	const char *tmpdir = getenv("TMPDIR");
+	std::string path = std::string(tmpdir ? tmpdir : "/tmp") +
+		"/thermal_bench.XXXXXX";
+	std::string stat = "cpu  800 80 400 16000 50 0 10 0 0 0\n";
+	int i;
+
+	if (!mkdtemp(&path[0]))
+		abort();
+	root = path;
+	for (i = 0; i < NZONES; i++)
+		writeNode("/sys/class/thermal/thermal_zone" +
+				std::to_string(i) + "/temp",
+				std::to_string(35000 + i * 100) + "\n");
+	for (i = 0; i < NCPUS; i++) {
+		writeNode("/sys/devices/system/cpu/cpu" + std::to_string(i) +
+				"/online", "1\n");
+		stat += "cpu" + std::to_string(i) +
+			" 100 10 50 2000 10 0 3 0 0 0\n";
+	}
+	stat += "intr 123456 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0 0\n"
+		"ctxt 987654\nbtime 1600000000\nprocesses 4321\n"
+		"procs_running 2\nprocs_blocked 0\n"
+		"softirq 54321 0 1 2 3 4 5 6 7 8 9\n";
+	writeNode("/proc/stat", stat);
+}
+
+static void removeNodes()
+{
+	std::string cmd = "rm -rf " + root;
+
+	system(cmd.c_str());
+}
+
+/* Syscalls made by one call of fn, in a forked and traced copy */
+static int countSyscalls(const std::function<void()>& fn)
+{
+	int status, count = 0;
+	bool entry = true;
+	pid_t pid;
+
+	pid = fork();
+	if (pid < 0)
+		return -1;
+	if (pid == 0) {
+		ptrace(PTRACE_TRACEME, 0, nullptr, nullptr);
+		raise(SIGSTOP);
+		fn();
+		_exit(0);
+	}
+	if (waitpid(pid, &status, 0) != pid || !WIFSTOPPED(status)) {
+		kill(pid, SIGKILL);
+		waitpid(pid, &status, 0);
+		return -1;
+	}
+	ptrace(PTRACE_SETOPTIONS, pid, nullptr,
+			(void *)(PTRACE_O_TRACESYSGOOD | PTRACE_O_EXITKILL));
+	for (;;) {
+		if (ptrace(PTRACE_SYSCALL, pid, nullptr, nullptr) < 0 ||
+				waitpid(pid, &status, 0) != pid ||
+				!WIFSTOPPED(status))
+			break;
+		if (WSTOPSIG(status) == (SIGTRAP | 0x80)) {
+			if (entry)
+				count++;
+			entry = !entry;
+		}
+	}
+	/* less the exit_group() of the copy */
+	return count - 1;
+}
+
+static void runHidlCalls(benchmark::State& state,
+		const std::function<void()>& call)
+{
+	/* open the nodes and fill the cache before counting */
+	call();
+	state.counters["syscalls"] = countSyscalls(call);
+	for (auto _ : state)
+		call();
+}
+
+static void getTemperatures(ThermalReader& reader)
+{
+	int64_t stamp;
+	int temp, i;
+
+	for (i = 0; i < NZONES; i++) {
+		reader.readTemperature(i, temp, stamp);
+		benchmark::DoNotOptimize(temp);
+	}
+}
+
+static void getCpuUsages(ThermalReader& reader)
+{
+	std::vector<struct cpu_stat> stats;
+
+	reader.readCpuStats(stats);
+	benchmark::DoNotOptimize(stats.data());
+}
+
+static void BM_GetTemperatures(benchmark::State& state)
+{
+	ThermalReader reader(NCPUS, root);
+
+	reader.setCacheWindow(state.range(0));
+	runHidlCalls(state, [&reader] { getTemperatures(reader); });
+}
+BENCHMARK(BM_GetTemperatures)->Arg(0)->Arg(100);
+
+static void BM_GetCpuUsages(benchmark::State& state)
+{
+	ThermalReader reader(NCPUS, root);
+
+	runHidlCalls(state, [&reader] { getCpuUsages(reader); });
+}
+BENCHMARK(BM_GetCpuUsages);
+
+/* The reads as ThermalCommon made them before ThermalReader */
+static int legacyReadLine(const char *path, std::string& out)
+{
+	char buf[MAX_PATH];
+	FILE *file;
+	int ret;
+
+	out.clear();
+	file = fopen(path, "r");
+	if (!file)
+		return -errno;
+	if (fgets(buf, sizeof(buf), file)) {
+		ret = (int)strlen(buf);
+		out.append(buf, ret);
+	} else {
+		ret = ferror(file);
+	}
+	fclose(file);
+
+	return ret;
+}
+
+static void BM_GetTemperaturesLegacy(benchmark::State& state)
+{
+	runHidlCalls(state, [] {
+		char file_name[MAX_PATH];
+		std::string buf;
+		int i;
+
+		for (i = 0; i < NZONES; i++) {
+			snprintf(file_name, sizeof(file_name),
+				"%s/sys/class/thermal/thermal_zone%d/temp",
+				root.c_str(), i);
+			if (legacyReadLine(file_name, buf) > 0)
+				benchmark::DoNotOptimize(std::stoi(buf, nullptr, 0));
+		}
+	});
+}
+BENCHMARK(BM_GetTemperaturesLegacy);
+
+static void BM_GetCpuUsagesLegacy(benchmark::State& state)
+{
+	runHidlCalls(state, [] {
+		char file_name[MAX_PATH];
+		uint64_t user, nice, system, idle;
+		int cpu_num, online;
+		char *line = NULL;
+		size_t len = 0;
+		FILE *file, *cpu_file;
+
+		file = fopen((root + "/proc/stat").c_str(), "r");
+		if (!file)
+			return;
+		while (getline(&line, &len, file) != -1) {
+			if (strlen(line) < 4 || strncmp(line, "cpu", 3) != 0 ||
+					!isdigit(line[3]))
+				continue;
+			if (sscanf(line, "cpu%d %" SCNu64 " %" SCNu64 " %" SCNu64
+					" %" SCNu64, &cpu_num, &user, &nice,
+					&system, &idle) != 5)
+				break;
+			snprintf(file_name, sizeof(file_name),
+				"%s/sys/devices/system/cpu/cpu%d/online",
+				root.c_str(), cpu_num);
+			cpu_file = fopen(file_name, "r");
+			if (!cpu_file)
+				break;
+			if (fscanf(cpu_file, "%d", &online) == 1)
+				benchmark::DoNotOptimize(online);
+			fclose(cpu_file);
+		}
+		free(line);
+		fclose(file);
+	});
+}
+BENCHMARK(BM_GetCpuUsagesLegacy);
+
+int main(int argc, char **argv)
+{
+	benchmark::Initialize(&argc, argv);
+	makeNodes();
+	benchmark::RunSpecifiedBenchmarks();
+	removeNodes();
+
+	return 0;
+}
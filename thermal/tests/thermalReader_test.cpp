@@ -0,0 +1,261 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "thermalReader.h"
+
+using android::hardware::thermal::V2_0::implementation::ThermalReader;
+using android::hardware::thermal::V2_0::implementation::cpu_stat;
+
+#define NCPUS	4
+
+/*
+ * ThermalReader over a directory of stand-in sysfs and procfs nodes.
+ * Nodes are rewritten in place, so the descriptors the reader keeps open
+ * see the new contents, as they do on a live sysfs node.
+ */
+class ThermalReaderTest : public ::testing::Test {
+	protected:
+		std::string root;
+
+		void SetUp() override
+		{
+			const char *tmpdir = getenv("TMPDIR");
+			std::string path = std::string(tmpdir ? tmpdir : "/tmp") +
+				"/thermal_reader.XXXXXX";
+
+			ASSERT_NE(nullptr, mkdtemp(&path[0]));
+			root = path;
+			for (int cpu = 0; cpu < NCPUS; cpu++)
+				writeNode("/sys/devices/system/cpu/cpu" +
+						std::to_string(cpu) + "/online", "1\n");
+		}
+
+		void TearDown() override
+		{
+			std::string cmd = "rm -rf " + root;
+
+			system(cmd.c_str());
+		}
+
+		void writeNode(const std::string& node, const std::string& data)
+		{
+			std::string path = root + node;
+			size_t pos;
+			int fd;
+
+			for (pos = root.size() + 1;
+					(pos = path.find('/', pos)) != std::string::npos;
+					pos++)
+				mkdir(path.substr(0, pos).c_str(), 0755);
+			fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+			ASSERT_GE(fd, 0) << path;
+			ASSERT_EQ((ssize_t)data.size(),
+					write(fd, data.data(), data.size()));
+			close(fd);
+		}
+
+		void writeTemp(int tzn, int temp)
+		{
+			writeNode("/sys/class/thermal/thermal_zone" +
+					std::to_string(tzn) + "/temp",
+					std::to_string(temp) + "\n");
+		}
+};
+
+TEST_F(ThermalReaderTest, CpuStatsParsedInPlace)
+{
+	ThermalReader reader(NCPUS, root);
+	std::vector<struct cpu_stat> stats;
+
+	writeNode("/sys/devices/system/cpu/cpu2/online", "0\n");
+	writeNode("/proc/stat",
+		"cpu  400 40 200 8000 50 0 10 0 0 0\n"
+		"cpu0 100 10 50 2000 10 0 3 0 0 0\n"
+		"cpu1 101 11 51 2001 11 0 2 0 0 0\n"
+		"cpu2 102 12 52 2002 12 0 3 0 0 0\n"
+		"cpu3 97 7 47 1997 17 0 2 0 0 0\n"
+		"intr 123456 0 0 0\n"
+		"ctxt 987654\n"
+		"cpu9 1 1 1 1\n");
+
+	ASSERT_EQ(NCPUS, reader.readCpuStats(stats));
+	ASSERT_EQ((size_t)NCPUS, stats.size());
+	EXPECT_EQ(0, stats[0].cpu_num);
+	EXPECT_EQ(160u, stats[0].active);
+	EXPECT_EQ(2160u, stats[0].total);
+	EXPECT_TRUE(stats[0].online);
+	EXPECT_EQ(1, stats[1].cpu_num);
+	EXPECT_EQ(163u, stats[1].active);
+	EXPECT_EQ(2164u, stats[1].total);
+	EXPECT_FALSE(stats[2].online);
+	EXPECT_EQ(3, stats[3].cpu_num);
+	EXPECT_EQ(151u, stats[3].active);
+	EXPECT_EQ(2148u, stats[3].total);
+
+	/* The same descriptor reads the updated counters */
+	writeNode("/sys/devices/system/cpu/cpu2/online", "1\n");
+	writeNode("/proc/stat",
+		"cpu  800 80 400 16000 50 0 10 0 0 0\n"
+		"cpu0 18446744073709551000 10 50 2000\n"
+		"cpu1 101 11 51 2001\n"
+		"cpu2 102 12 52 2002\n"
+		"cpu3 97 7 47 1997\n");
+	ASSERT_EQ(NCPUS, reader.readCpuStats(stats));
+	EXPECT_EQ(18446744073709551000u + 60, stats[0].active);
+	EXPECT_TRUE(stats[2].online);
+}
+
+TEST_F(ThermalReaderTest, CpuStatsErrors)
+{
+	std::vector<struct cpu_stat> stats;
+
+	{
+		ThermalReader reader(NCPUS, root);
+
+		/* No /proc/stat */
+		EXPECT_GT(0, reader.readCpuStats(stats));
+		EXPECT_TRUE(stats.empty());
+	}
+	{
+		ThermalReader reader(NCPUS, root);
+
+		writeNode("/proc/stat", "cpu  1 2 3 4\ncpu0 1 2 three 4\n");
+		EXPECT_EQ(-EIO, reader.readCpuStats(stats));
+	}
+	{
+		ThermalReader reader(NCPUS, root);
+
+		/* A CPU without an online node */
+		writeNode("/proc/stat", "cpu  1 2 3 4\ncpu0 1 2 3 4\n"
+				"cpu7 1 2 3 4\n");
+		EXPECT_EQ(-ENOENT, reader.readCpuStats(stats));
+	}
+}
+
+TEST_F(ThermalReaderTest, CachedWithinTheWindow)
+{
+	ThermalReader reader(NCPUS, root);
+	int64_t stamp, cached_stamp;
+	int temp;
+
+	reader.setCacheWindow(60000);
+	writeTemp(1, 41000);
+	ASSERT_LT(0, reader.readTemperature(1, temp, stamp));
+	EXPECT_EQ(41000, temp);
+
+	writeTemp(1, 52000);
+	ASSERT_EQ(0, reader.readTemperature(1, temp, cached_stamp));
+	EXPECT_EQ(41000, temp);
+	EXPECT_EQ(stamp, cached_stamp);
+
+	/* A trip event drops the cached value */
+	reader.invalidateTemperature(1);
+	ASSERT_LT(0, reader.readTemperature(1, temp, stamp));
+	EXPECT_EQ(52000, temp);
+
+	/* A value pushed by a monitor is served without reading the node */
+	cached_stamp = reader.updateTemperature(1, 47000);
+	ASSERT_EQ(0, reader.readTemperature(1, temp, stamp));
+	EXPECT_EQ(47000, temp);
+	EXPECT_EQ(cached_stamp, stamp);
+}
+
+TEST_F(ThermalReaderTest, ReadAgainOnceTheWindowIsOver)
+{
+	ThermalReader reader(NCPUS, root);
+	int64_t stamp, first_stamp;
+	int temp;
+
+	reader.setCacheWindow(20);
+	writeTemp(2, 30000);
+	ASSERT_LT(0, reader.readTemperature(2, temp, first_stamp));
+	writeTemp(2, 31000);
+	std::this_thread::sleep_for(std::chrono::milliseconds(30));
+	ASSERT_LT(0, reader.readTemperature(2, temp, stamp));
+	EXPECT_EQ(31000, temp);
+	EXPECT_GE(stamp - first_stamp, 20000000);
+}
+
+TEST_F(ThermalReaderTest, NoCacheReadsEveryTime)
+{
+	ThermalReader reader(NCPUS, root);
+	int64_t stamp;
+	int temp;
+
+	reader.setCacheWindow(0);
+	writeTemp(3, 25000);
+	ASSERT_LT(0, reader.readTemperature(3, temp, stamp));
+	EXPECT_EQ(25000, temp);
+	writeTemp(3, -5000);
+	ASSERT_LT(0, reader.readTemperature(3, temp, stamp));
+	EXPECT_EQ(-5000, temp);
+	reader.updateTemperature(3, 99000);
+	ASSERT_LT(0, reader.readTemperature(3, temp, stamp));
+	EXPECT_EQ(-5000, temp);
+}
+
+TEST_F(ThermalReaderTest, NodeErrors)
+{
+	ThermalReader reader(NCPUS, root);
+	int64_t stamp;
+	int temp, state;
+
+	reader.setCacheWindow(0);
+	EXPECT_EQ(-ENOENT, reader.readTemperature(5, temp, stamp));
+	/* An empty node is a read error, a garbled one a parse error */
+	writeNode("/sys/class/thermal/thermal_zone5/temp", "");
+	EXPECT_EQ(-EIO, reader.readTemperature(5, temp, stamp));
+	writeNode("/sys/class/thermal/thermal_zone5/temp", "hot\n");
+	EXPECT_EQ(-EINVAL, reader.readTemperature(5, temp, stamp));
+	writeTemp(5, 36000);
+	EXPECT_LT(0, reader.readTemperature(5, temp, stamp));
+	EXPECT_EQ(36000, temp);
+
+	EXPECT_GT(0, reader.readCdevState(0, state));
+	writeNode("/sys/class/thermal/cooling_device0/cur_state", "3\n");
+	EXPECT_LT(0, reader.readCdevState(0, state));
+	EXPECT_EQ(3, state);
+	writeNode("/sys/class/thermal/cooling_device0/cur_state", "0\n");
+	EXPECT_LT(0, reader.readCdevState(0, state));
+	EXPECT_EQ(0, state);
+}
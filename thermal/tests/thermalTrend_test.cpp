@@ -0,0 +1,308 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "thermalTrend.h"
+
+using android::hardware::thermal::V2_0::ThrottlingSeverity;
+using android::hardware::thermal::V2_0::TemperatureThreshold;
+using android::hardware::thermal::V2_0::implementation::ThermalTrend;
+
+struct TraceSample {
+	int64_t ms;
+	float temp;
+};
+
+/*
+ * Recorded (ms, C) traces of one sensor, as the HAL sees them, against
+ * hot thresholds of 45/50/55/60/65/70 C for LIGHT to SHUTDOWN.
+ */
+
+/* 1 Hz, warming by 0.5 C/s while recording video */
+static const TraceSample camera_ramp[] = {
+	{0, 37.9f}, {979, 38.4f}, {1952, 38.7f}, {2956, 39.3f}, {3963, 39.7f},
+	{4965, 40.3f}, {5940, 41.0f}, {6914, 41.3f}, {7919, 42.0f},
+	{8941, 42.5f}, {9971, 42.8f}, {10981, 43.5f}, {11954, 44.0f},
+	{12949, 44.2f}, {13933, 44.7f}, {14957, 45.3f}, {15953, 45.8f},
+	{16930, 46.5f}, {17935, 47.2f}, {18916, 47.3f}, {19922, 48.1f},
+	{20915, 48.3f}, {21930, 48.7f}, {22903, 49.6f}, {23904, 50.1f},
+	{24901, 50.7f}, {25900, 51.1f}, {26899, 51.4f}, {27884, 52.2f},
+	{28898, 52.7f}, {29873, 53.0f}, {30876, 53.5f}, {31867, 54.1f},
+	{32855, 54.6f}, {33829, 54.8f}, {34825, 55.3f}, {35816, 55.8f},
+	{36817, 56.5f}, {37829, 56.7f}, {38834, 57.5f}, {39860, 58.2f},
+	{40851, 58.6f}, {41859, 59.0f}, {42880, 59.5f}, {43903, 59.8f},
+	{44890, 60.5f}, {45902, 60.7f}, {46918, 61.6f}, {47929, 62.0f},
+	{48942, 62.7f},
+};
+
+/* 2 Hz, settled 1.5 C below the SEVERE threshold */
+static const TraceSample game_plateau[] = {
+	{0, 53.6f}, {502, 53.2f}, {1011, 53.4f}, {1530, 53.3f}, {2013, 53.3f},
+	{2511, 53.3f}, {3006, 53.4f}, {3517, 53.2f}, {4025, 53.4f},
+	{4522, 53.7f}, {5029, 53.7f}, {5526, 53.6f}, {6028, 53.6f},
+	{6532, 53.8f}, {7021, 53.2f}, {7510, 53.3f}, {8004, 53.2f},
+	{8521, 53.3f}, {9019, 53.2f}, {9525, 53.5f}, {10044, 53.5f},
+	{10532, 53.6f}, {11044, 53.8f}, {11527, 53.5f}, {12042, 53.4f},
+	{12547, 53.4f}, {13057, 53.6f}, {13540, 53.3f}, {14033, 53.5f},
+	{14520, 53.4f}, {15003, 53.3f}, {15519, 53.3f}, {16005, 53.8f},
+	{16524, 53.2f}, {17017, 53.6f}, {17506, 53.6f}, {18008, 53.6f},
+	{18518, 53.3f}, {19029, 53.8f}, {19538, 53.5f},
+};
+
+/* 1 Hz, warming by 0.6 C/s, then cooling by 0.4 C/s from 20 s */
+static const TraceSample charge_then_cool[] = {
+	{0, 44.8f}, {976, 45.7f}, {1993, 46.1f}, {3016, 46.9f}, {4019, 47.2f},
+	{5049, 48.2f}, {6042, 48.5f}, {7046, 49.4f}, {8064, 49.8f},
+	{9075, 50.5f}, {10089, 51.1f}, {11092, 51.5f}, {12072, 52.1f},
+	{13056, 52.8f}, {14075, 53.4f}, {15085, 53.9f}, {16106, 54.7f},
+	{17124, 55.3f}, {18145, 55.7f}, {19140, 56.5f}, {20124, 55.9f},
+	{21125, 55.5f}, {22096, 55.4f}, {23116, 54.7f}, {24102, 54.3f},
+	{25110, 54.2f}, {26108, 53.7f}, {27124, 53.4f}, {28117, 52.6f},
+	{29093, 52.3f}, {30075, 51.9f}, {31075, 51.6f}, {32102, 51.2f},
+	{33072, 50.8f}, {34083, 50.3f}, {35094, 49.8f}, {36106, 49.4f},
+	{37100, 49.3f}, {38118, 48.7f}, {39144, 48.3f}, {40164, 48.1f},
+	{41139, 47.7f}, {42155, 47.2f}, {43150, 46.9f}, {44125, 46.5f},
+};
+
+/* 2 Hz, warming by 3 C/s, through every threshold */
+static const TraceSample runaway[] = {
+	{0, 55.0f}, {500, 56.5f}, {1000, 58.0f}, {1500, 59.5f}, {2000, 61.0f},
+	{2500, 62.5f}, {3000, 64.0f}, {3500, 65.5f}, {4000, 67.0f},
+	{4500, 68.5f}, {5000, 70.0f}, {5500, 71.5f}, {6000, 73.0f},
+	{6500, 74.5f}, {7000, 76.0f}, {7500, 77.5f}, {8000, 79.0f},
+	{8500, 80.5f}, {9000, 82.0f}, {9500, 83.5f}, {10000, 85.0f},
+	{10500, 86.5f}, {11000, 88.0f}, {11500, 89.5f}, {12000, 91.0f},
+	{12500, 92.5f}, {13000, 94.0f}, {13500, 95.5f}, {14000, 97.0f},
+	{14500, 98.5f},
+};
+
+#define HORIZON_S	10.0f
+
+struct Step {
+	int64_t ms;
+	ThrottlingSeverity measured;
+	ThrottlingSeverity predicted;
+	float time_to_threshold;
+};
+
+static TemperatureThreshold thresholds()
+{
+	TemperatureThreshold thresh;
+	static const float hot[] = {NAN, 45, 50, 55, 60, 65, 70};
+	size_t idx;
+
+	for (idx = 0; idx <= (size_t)ThrottlingSeverity::SHUTDOWN; idx++)
+		thresh.hotThrottlingThresholds[idx] = hot[idx];
+	return thresh;
+}
+
+/* The severity of the temperature itself, as estimateSeverity() does */
+static ThrottlingSeverity measure(const TemperatureThreshold& thresh,
+		float temp)
+{
+	ThrottlingSeverity severity = ThrottlingSeverity::NONE;
+	size_t idx;
+
+	for (idx = (size_t)ThrottlingSeverity::LIGHT;
+			idx <= (size_t)ThrottlingSeverity::SHUTDOWN; idx++) {
+		if (!std::isnan(thresh.hotThrottlingThresholds[idx]) &&
+				temp >= thresh.hotThrottlingThresholds[idx])
+			severity = (ThrottlingSeverity)idx;
+	}
+	return severity;
+}
+
+template <size_t N>
+static std::vector<Step> replay(const TraceSample (&trace)[N])
+{
+	TemperatureThreshold thresh = thresholds();
+	ThermalTrend trend;
+	std::vector<Step> steps;
+	size_t i;
+
+	for (i = 0; i < N; i++) {
+		Step step;
+
+		trend.addSample(trace[i].ms * 1000000LL, trace[i].temp);
+		step.ms = trace[i].ms;
+		step.measured = measure(thresh, trace[i].temp);
+		step.predicted = trend.predict(thresh, step.measured, HORIZON_S,
+				step.time_to_threshold);
+		steps.push_back(step);
+	}
+	return steps;
+}
+
+static int first(const std::vector<Step>& steps, bool predicted,
+		ThrottlingSeverity severity)
+{
+	size_t i;
+
+	for (i = 0; i < steps.size(); i++) {
+		if ((predicted ? steps[i].predicted : steps[i].measured) >= severity)
+			return i;
+	}
+	return -1;
+}
+
+TEST(ThermalTrendTest, NoPredictionUntilTheWindowSpansEnough)
+{
+	std::vector<Step> steps = replay(camera_ramp);
+	size_t i;
+
+	/* 4 samples over at least 3 s */
+	for (i = 0; i < 4; i++) {
+		EXPECT_EQ(ThrottlingSeverity::NONE, steps[i].predicted) << i;
+		EXPECT_TRUE(std::isnan(steps[i].time_to_threshold)) << i;
+	}
+	EXPECT_FALSE(std::isnan(steps[4].time_to_threshold));
+}
+
+TEST(ThermalTrendTest, RampPredictsAheadOfTheCrossing)
+{
+	std::vector<Step> steps = replay(camera_ramp);
+	ThrottlingSeverity severity;
+
+	for (severity = ThrottlingSeverity::LIGHT;
+			severity <= ThrottlingSeverity::CRITICAL;
+			severity = (ThrottlingSeverity)((int)severity + 1)) {
+		int predicted = first(steps, true, severity);
+		int measured = first(steps, false, severity);
+
+		ASSERT_GE(predicted, 0) << (int)severity;
+		ASSERT_GE(measured, 0) << (int)severity;
+		/* early, but no earlier than the horizon allows */
+		EXPECT_GE(steps[measured].ms - steps[predicted].ms, 7000)
+			<< (int)severity;
+		EXPECT_LE(steps[measured].ms - steps[predicted].ms,
+				(int64_t)(HORIZON_S * 1000) + 1500) << (int)severity;
+	}
+	for (const Step& step : steps) {
+		if (step.predicted != ThrottlingSeverity::NONE) {
+			EXPECT_GT(step.predicted, step.measured) << step.ms;
+			EXPECT_GT(step.time_to_threshold, 0) << step.ms;
+		}
+	}
+}
+
+TEST(ThermalTrendTest, PlateauPredictsNothing)
+{
+	std::vector<Step> steps = replay(game_plateau);
+
+	for (const Step& step : steps) {
+		EXPECT_EQ(ThrottlingSeverity::MODERATE, step.measured) << step.ms;
+		EXPECT_EQ(ThrottlingSeverity::NONE, step.predicted) << step.ms;
+	}
+}
+
+TEST(ThermalTrendTest, PredictionReleasesOnceCooling)
+{
+	std::vector<Step> steps = replay(charge_then_cool);
+	int predicted = first(steps, true, ThrottlingSeverity::SEVERE);
+	int measured = first(steps, false, ThrottlingSeverity::SEVERE);
+	size_t i, last = 0, peak = 0;
+
+	ASSERT_GE(predicted, 0);
+	ASSERT_GE(measured, 0);
+	EXPECT_LT(predicted, measured);
+	for (i = 0; i < steps.size(); i++) {
+		if (steps[i].predicted != ThrottlingSeverity::NONE)
+			last = i;
+		if (charge_then_cool[i].temp > charge_then_cool[peak].temp)
+			peak = i;
+	}
+	/* the fit over the window turns within a few samples of the peak */
+	EXPECT_GE(last, peak);
+	EXPECT_LE(steps[last].ms - steps[peak].ms, 8000);
+	/* nothing is predicted from the lagging fit while cooling */
+	for (i = peak + 1; i < steps.size(); i++) {
+		if (steps[i].predicted != ThrottlingSeverity::NONE) {
+			EXPECT_GT(steps[i].time_to_threshold, 0) << steps[i].ms;
+		}
+	}
+	EXPECT_EQ(ThrottlingSeverity::NONE, steps.back().predicted);
+	EXPECT_TRUE(std::isnan(steps.back().time_to_threshold));
+}
+
+TEST(ThermalTrendTest, ShutdownIsNeverPredicted)
+{
+	std::vector<Step> steps = replay(runaway);
+	bool reported = false;
+
+	for (const Step& step : steps) {
+		EXPECT_NE(ThrottlingSeverity::SHUTDOWN, step.predicted) << step.ms;
+		/* the time to shutdown is still reported */
+		if (step.measured == ThrottlingSeverity::EMERGENCY &&
+				!std::isnan(step.time_to_threshold)) {
+			EXPECT_LT(step.time_to_threshold, HORIZON_S);
+			reported = true;
+		}
+	}
+	EXPECT_TRUE(reported);
+}
+
+TEST(ThermalTrendTest, WindowRestarts)
+{
+	TemperatureThreshold thresh = thresholds();
+	ThermalTrend trend;
+	float eta;
+	size_t i;
+
+	for (i = 0; i < 10; i++)
+		trend.addSample(camera_ramp[i + 20].ms * 1000000LL,
+				camera_ramp[i + 20].temp);
+	EXPECT_EQ(10u, trend.sampleCount());
+	EXPECT_NE(ThrottlingSeverity::NONE,
+			trend.predict(thresh, ThrottlingSeverity::LIGHT, HORIZON_S, eta));
+
+	/* a sample at the same time replaces the last one */
+	trend.addSample(camera_ramp[29].ms * 1000000LL, 20.0f);
+	EXPECT_EQ(10u, trend.sampleCount());
+
+	/* going back in time starts over */
+	trend.addSample(0, 50.0f);
+	EXPECT_EQ(1u, trend.sampleCount());
+	EXPECT_EQ(ThrottlingSeverity::NONE,
+			trend.predict(thresh, ThrottlingSeverity::MODERATE, HORIZON_S, eta));
+
+	/* so do samples older than a minute */
+	trend.addSample(1000000000LL, 51.0f);
+	trend.addSample(2000000000LL, 52.0f);
+	trend.addSample(TREND_MAX_AGE_NS + 3000000000LL, 53.0f);
+	EXPECT_EQ(1u, trend.sampleCount());
+
+	/* unreadable sensors add nothing */
+	trend.addSample(TREND_MAX_AGE_NS + 4000000000LL, NAN);
+	EXPECT_EQ(1u, trend.sampleCount());
+}
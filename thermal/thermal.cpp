@@ -33,15 +33,21 @@
 #include <inttypes.h>
 #include <stdlib.h>
 #include <cerrno>
+#include <chrono>
 #include <mutex>
 #include <string>
 
 #include <android-base/file.h>
 #include <android-base/logging.h>
+#include <android-base/stringprintf.h>
 #include <hidl/HidlTransportSupport.h>
 
 #include "thermal.h"
 
+#define HISTORY_DUMP_MAGIC	"THST"
+#define HISTORY_DUMP_VERSION	1
+#define HISTORY_DUMP_WINDOW_NS	(60LL * 1000000000LL)
+
 namespace android {
 namespace hardware {
 namespace thermal {
@@ -273,6 +279,83 @@ Return<void> Thermal::unregisterThermalChangedCallback(
 	return Void();
 }
 
+/*
+ * Binary history dump, little endian:
+ *   "THST" | u16 version | u16 sensor count | i64 now (CLOCK_MONOTONIC ns)
+ *   per sensor: i32 type | u8 name length | name |
+ *               u32 sample count | therm_history_sample[count]
+ */
+static void dumpHistoryBinary(std::vector<struct therm_history>& hist,
+				int64_t now, std::string& out)
+{
+	uint16_t version = HISTORY_DUMP_VERSION, count = hist.size();
+	std::vector<struct therm_history_sample> samples;
+
+	static_assert(sizeof(struct therm_history_sample) == 16,
+			"history dump layout changed");
+	out.append(HISTORY_DUMP_MAGIC, 4);
+	out.append((const char *)&version, sizeof(version));
+	out.append((const char *)&count, sizeof(count));
+	out.append((const char *)&now, sizeof(now));
+	for (struct therm_history& h: hist) {
+		int32_t type = (int32_t)h.type;
+		uint8_t len = std::min(h.name.size(), (size_t)UINT8_MAX);
+		uint32_t nsamples;
+
+		samples.clear();
+		nsamples = h.history->snapshot(0, now, samples);
+		out.append((const char *)&type, sizeof(type));
+		out.append((const char *)&len, sizeof(len));
+		out.append(h.name.data(), len);
+		out.append((const char *)&nsamples, sizeof(nsamples));
+		out.append((const char *)samples.data(),
+				nsamples * sizeof(struct therm_history_sample));
+	}
+}
+
+Return<void> Thermal::debug(const hidl_handle& handle,
+				const hidl_vec<hidl_string>& args)
+{
+	std::vector<struct therm_prediction> pred;
+	std::vector<struct therm_history> hist;
+	struct therm_history_stats stats;
+	int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+	std::string out;
+
+	if (handle == nullptr || handle->numFds < 1)
+		return Void();
+
+	utils.readHistory(false, TemperatureType::UNKNOWN, hist);
+	if (args.size() > 0 && args[0] == "--history") {
+		dumpHistoryBinary(hist, now, out);
+		android::base::WriteStringToFd(out, handle->data[0]);
+		return Void();
+	}
+
+	utils.readPredictions(false, TemperatureType::UNKNOWN, pred);
+	out = "Sensor trends:\n";
+	for (struct therm_prediction& p: pred)
+		out += android::base::StringPrintf(
+			"  %s temp:%.2f slope:%.3f/s status:%d predicted:%d"
+			" time_to_threshold:%.1fs\n", p.t.name.c_str(),
+			p.t.value, p.slope, (int)p.t.throttlingStatus,
+			(int)p.predictedSeverity, p.timeToThreshold);
+	out += "Sensor history, last 60s (--history for binary dump):\n";
+	for (struct therm_history& h: hist) {
+		if (!h.history->query(now - HISTORY_DUMP_WINDOW_NS, now, stats))
+			continue;
+		out += android::base::StringPrintf(
+			"  %s samples:%zu min:%.2f max:%.2f avg:%.2f"
+			" max_severity:%d\n", h.name.c_str(), stats.count,
+			stats.min, stats.max, stats.avg,
+			(int)stats.max_severity);
+	}
+	android::base::WriteStringToFd(out, handle->data[0]);
+
+	return Void();
+}
+
 void Thermal::sendThrottlingChangeCB(const Temperature &t)
 {
 	std::lock_guard<std::mutex> _lock(thermal_cb_mutex);
@@ -102,6 +102,9 @@ class Thermal : public IThermal {
 				CoolingType type,
 				getCurrentCoolingDevices_cb _hidl_cb) override;
 
+		Return<void> debug(const hidl_handle& handle,
+				const hidl_vec<hidl_string>& args) override;
+
 		void sendThrottlingChangeCB(const Temperature &t);
 
 	private:
@@ -36,6 +36,7 @@
 #include <fstream>
 
 #include <android-base/logging.h>
+#include <android-base/properties.h>
 #include "thermalCommon.h"
 
 #define MAX_LENGTH		50
@@ -44,7 +45,6 @@
 #define THERMAL_SYSFS		"/sys/class/thermal/"
 #define TZ_DIR_NAME		"thermal_zone"
 #define TZ_DIR_FMT		"thermal_zone%d"
-#define TEMPERATURE_FILE_FORMAT	"/sys/class/thermal/thermal_zone%d/temp"
 #define POLICY_FILE_FORMAT	"/sys/class/thermal/thermal_zone%d/policy"
 #define TRIP_FILE_FORMAT	"/sys/class/thermal/thermal_zone%d/trip_point_1_temp"
 #define HYST_FILE_FORMAT	"/sys/class/thermal/thermal_zone%d/trip_point_1_hyst"
@@ -52,9 +52,7 @@
 #define TZ_TYPE			"type"
 #define CDEV_DIR_NAME		"cooling_device"
 #define CDEV_DIR_FMT		"cooling_device%d"
-#define CDEV_CUR_STATE_PATH	"/sys/class/thermal/cooling_device%d/cur_state"
-#define CPU_USAGE_FILE		"/proc/stat"
-#define CPU_ONLINE_FILE_FORMAT	"/sys/devices/system/cpu/cpu%d/online"
+#define PREDICT_HORIZON_PROP	"vendor.thermal.predict_horizon_ms"
 
 namespace android {
 namespace hardware {
@@ -110,10 +108,13 @@ static std::unordered_map<std::string, cdevType> cdev_map = {
 	{"fan-max31760", cdevType::FAN},
 };
 
-ThermalCommon::ThermalCommon()
+ThermalCommon::ThermalCommon():
+	ncpus((int)sysconf(_SC_NPROCESSORS_CONF)),
+	reader(ncpus)
 {
 	LOG(DEBUG) << "Entering " << __func__;
-	ncpus = (int)sysconf(_SC_NPROCESSORS_CONF);
+	predict_horizon_s = android::base::GetUintProperty<uint32_t>(
+			PREDICT_HORIZON_PROP, DEFAULT_PREDICT_HORIZON_MS) / 1000.0f;
 	if (ncpus < 1)
 		LOG(ERROR) << "Error retrieving number of cores";
 }
@@ -261,6 +262,11 @@ int ThermalCommon::initialize_sensor(struct target_therm_cfg& cfg, int sens_idx)
 	sensor.positiveThresh = cfg.positive_thresh_ramp;
 	sensor.lastThrottleStatus = sensor.t.throttlingStatus =
 		ThrottlingSeverity::NONE;
+	sensor.predictedSeverity = sensor.reportedSeverity =
+		ThrottlingSeverity::NONE;
+	sensor.timeToThreshold = UNKNOWN_TEMPERATURE;
+	sensor.stamp_ns = 0;
+	sensor.history = std::make_shared<ThermalHistory>();
 	sensor.thresh.type = sensor.t.type = cfg.type;
 	sensor.throt_severity = cfg.throt_severity;
 	sensor.thresh.vrThrottlingThreshold =
@@ -394,32 +400,19 @@ int ThermalCommon::initCdev()
 
 int ThermalCommon::read_cdev_state(struct therm_cdev& cdev)
 {
-	char file_name[MAX_PATH];
-	std::string buf;
-	int ret = 0, ct = 0;
-	bool read_ok = false;
+	int ret = 0, ct = 0, state = 0;
 
-	snprintf(file_name, sizeof(file_name), CDEV_CUR_STATE_PATH,
-			cdev.cdevn);
 	do {
-		ret = readLineFromFile(std::string(file_name), buf);
-		if (ret <= 0) {
+		ret = reader.readCdevState(cdev.cdevn, state);
+		if (ret < 0 && ret != -EINVAL) {
 			LOG(ERROR) << "Cdev state read error:"<< ret <<
 				" for cdev: " << cdev.c.name;
 			return -1;
 		}
-		try {
-			cdev.c.value = std::stoi(buf, nullptr, 0);
-			read_ok = true;
-		}
-		catch (std::exception &err) {
-			LOG(ERROR) << "Cdev read stoi error:" << err.what()
-				<< " cdev:" << cdev.c.name << " ID:"
-				<< cdev.cdevn << " buf:" << buf <<
-				std::endl;
-		}
 		ct++;
-	} while (!read_ok && ct < RETRY_CT);
+	} while (ret < 0 && ct < RETRY_CT);
+	if (ret >= 0)
+		cdev.c.value = state;
 	LOG(DEBUG) << "cdev Name:" << cdev.c.name << ". state:" <<
 		cdev.c.value << std::endl;
 
@@ -474,43 +467,66 @@ int ThermalCommon::estimateSeverity(struct therm_sensor& sensor)
 	return (int)severity;
 }
 
+int ThermalCommon::estimatePredictedSeverity(struct therm_sensor& sensor)
+{
+	ThrottlingSeverity severity = ThrottlingSeverity::NONE;
+	float eta = UNKNOWN_TEMPERATURE;
+
+	if (sensor.positiveThresh && predict_horizon_s > 0)
+		severity = sensor.trend.predict(sensor.thresh,
+				sensor.t.throttlingStatus, predict_horizon_s,
+				eta);
+	sensor.timeToThreshold = eta;
+	if (severity == sensor.predictedSeverity)
+		return -1;
+	LOG(INFO) << "Sensor Name:" << sensor.t.name << "temp: " <<
+		sensor.t.value << ". predicted severity:" << (int)severity <<
+		" in " << eta << "s" << std::endl;
+	sensor.predictedSeverity = severity;
+
+	return (int)severity;
+}
+
 int ThermalCommon::read_temperature(struct therm_sensor& sensor)
 {
-	char file_name[MAX_PATH];
-	float temp;
-	std::string buf;
-	int ret = 0, ct = 0;
-	bool read_ok = false;
+	int ret = 0, ct = 0, temp = 0;
+	int64_t stamp_ns = 0;
 
 	do {
-		snprintf(file_name, sizeof(file_name), TEMPERATURE_FILE_FORMAT,
-			sensor.tzn);
-		ret = readLineFromFile(std::string(file_name), buf);
-		if (ret <= 0) {
+		ret = reader.readTemperature(sensor.tzn, temp, stamp_ns);
+		if (ret < 0 && ret != -EINVAL) {
 			LOG(ERROR) << "Temperature read error:"<< ret <<
 				" for sensor " << sensor.t.name;
 			return -1;
 		}
-		try {
-			sensor.t.value = (float)std::stoi(buf, nullptr, 0) /
-				 (float)sensor.mulFactor;
-			read_ok = true;
-		}
-		catch (std::exception &err) {
-			LOG(ERROR) << "Temperature buf stoi error: "
-				<< err.what()
-				<< " buf:" << buf << " sensor:"
-				<< sensor.t.name << " TZ:" <<
-				sensor.tzn << std::endl;
-		}
 		ct++;
-	} while (!read_ok && ct < RETRY_CT);
+	} while (ret < 0 && ct < RETRY_CT);
+	/* Keep reporting the last value if the node never parsed */
+	if (ret < 0)
+		return 0;
+	sensor.t.value = (float)temp / (float)sensor.mulFactor;
+	sensor.stamp_ns = stamp_ns;
+	sensor.trend.addSample(stamp_ns, sensor.t.value);
 	LOG(DEBUG) << "Sensor Name:" << sensor.t.name << ". Temperature:" <<
 		(float)sensor.t.value << std::endl;
 
 	return ret;
 }
 
+void ThermalCommon::update_temperature(struct therm_sensor& sensor, int temp)
+{
+	int64_t stamp_ns = reader.updateTemperature(sensor.tzn, temp);
+
+	sensor.t.value = (float)temp / (float)sensor.mulFactor;
+	sensor.stamp_ns = stamp_ns;
+	sensor.trend.addSample(stamp_ns, sensor.t.value);
+}
+
+void ThermalCommon::invalidate_temperature(struct therm_sensor& sensor)
+{
+	reader.invalidateTemperature(sensor.tzn);
+}
+
 void ThermalCommon::initThreshold(struct therm_sensor& sensor)
 {
 	char file_name[MAX_PATH] = "";
@@ -577,86 +593,26 @@ void ThermalCommon::initThreshold(struct therm_sensor& sensor)
 }
 
 int ThermalCommon::get_cpu_usages(hidl_vec<CpuUsage>& list) {
-	int vals, cpu_num, online;
-	ssize_t read;
-	uint64_t user, nice, system, idle, active, total;
-	char *line = NULL;
-	size_t len = 0;
+	std::vector<struct cpu_stat> stats;
+	int ret;
 	size_t cpu = 0;
-	char file_name[MAX_LENGTH];
-	FILE *file;
-	FILE *cpu_file;
 
-	list.resize(ncpus);
-	file = fopen(CPU_USAGE_FILE, "r");
-	if (file == NULL) {
-		LOG(ERROR) << "failed to open:" << CPU_USAGE_FILE <<
-			" err:" << strerror(errno);
-		return -errno;
+	ret = reader.readCpuStats(stats);
+	if (ret < 0)
+		return ret;
+	if (stats.size() != (size_t)ncpus) {
+		LOG(ERROR) <<"/proc/stat file has incorrect format.";
+		return -EIO;
 	}
 
-	while ((read = getline(&line, &len, file)) != -1) {
-		if (strnlen(line, read) < 4 || strncmp(line, "cpu", 3) != 0 ||
-				!isdigit(line[3])) {
-			free(line);
-			line = NULL;
-			len = 0;
-			continue;
-		}
-		vals = sscanf(line, \
-			"cpu%d %" SCNu64 " %" SCNu64 " %" SCNu64 " %" SCNu64, \
-			&cpu_num, &user, &nice, &system, &idle);
-
-		free(line);
-		line = NULL;
-		len = 0;
-
-		if (vals != 5 || cpu == ncpus) {
-			if (vals != 5) {
-				LOG(ERROR) <<
-				"failed to read CPU information from file: "
-				<< strerror(errno);
-			} else {
-				LOG(ERROR) <<
-					"/proc/stat file has incorrect format.";
-			}
-			fclose(file);
-			return errno ? -errno : -EIO;
-		}
-
-		active = user + nice + system;
-		total = active + idle;
-
-		// Read online CPU information.
-		snprintf(file_name, MAX_LENGTH, CPU_ONLINE_FILE_FORMAT,
-				cpu_num);
-		cpu_file = fopen(file_name, "r");
-		online = 0;
-		if (cpu_file == NULL) {
-			LOG(ERROR) << "failed to open file:" << file_name <<
-				" err: " << strerror(errno);
-			fclose(file);
-			return -errno;
-		}
-		if (1 != fscanf(cpu_file, "%d", &online)) {
-			LOG(ERROR) << "failed to read CPU online information" << strerror(errno);
-			fclose(file);
-			fclose(cpu_file);
-			return errno ? -errno : -EIO;
-		}
-		fclose(cpu_file);
-
-		list[cpu].name = std::string("CPU") + std::to_string(cpu_num);
-		list[cpu].active = active;
-		list[cpu].total = total;
-		list[cpu].isOnline = online;
+	list.resize(ncpus);
+	for (struct cpu_stat& stat: stats) {
+		list[cpu].name = std::string("CPU") + std::to_string(stat.cpu_num);
+		list[cpu].active = stat.active;
+		list[cpu].total = stat.total;
+		list[cpu].isOnline = stat.online;
 		cpu++;
 	}
-	fclose(file);
-	if (cpu != ncpus) {
-		LOG(ERROR) <<"/proc/stat file has incorrect format.";
-		return -EIO;
-	}
 	return ncpus;
 }
 
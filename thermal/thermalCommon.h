@@ -32,6 +32,7 @@
 #define THERMAL_THERMAL_COMMON_H__
 
 #include "thermalData.h"
+#include "thermalReader.h"
 
 namespace android {
 namespace hardware {
@@ -40,6 +41,9 @@ namespace V2_0 {
 namespace implementation {
 
 #define RETRY_CT 3
+/* Default look-ahead of the trend prediction, overridden by the
+ * vendor.thermal.predict_horizon_ms property. 0 disables it. */
+#define DEFAULT_PREDICT_HORIZON_MS 10000
 
 class ThermalCommon {
 	public:
@@ -53,7 +57,10 @@ class ThermalCommon {
 
 		int read_cdev_state(struct therm_cdev& cdev);
 		int read_temperature(struct therm_sensor& sensor);
+		void update_temperature(struct therm_sensor& sensor, int temp);
+		void invalidate_temperature(struct therm_sensor& sensor);
 		int estimateSeverity(struct therm_sensor& sensor);
+		int estimatePredictedSeverity(struct therm_sensor& sensor);
 		int get_cpu_usages(hidl_vec<CpuUsage>& list);
 
 		std::vector<struct therm_sensor> fetch_sensor_list()
@@ -67,6 +74,8 @@ class ThermalCommon {
 
 	private:
 		int ncpus;
+		float predict_horizon_s;
+		ThermalReader reader;
 		std::vector<struct target_therm_cfg> cfg;
 		std::vector<struct therm_sensor> sens;
 		std::vector<struct therm_cdev> cdev;
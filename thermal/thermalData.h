@@ -35,8 +35,11 @@
 #include <string>
 #include <mutex>
 #include <cmath>
+#include <memory>
 
 #include <android/hardware/thermal/2.0/IThermal.h>
+#include "thermalTrend.h"
+#include "thermalHistory.h"
 
 #define UNKNOWN_TEMPERATURE (NAN)
 
@@ -82,6 +85,25 @@ using ::android::hardware::thermal::V2_0::ThrottlingSeverity;
 		Temperature t;
 		TemperatureThreshold thresh;
 		ThrottlingSeverity throt_severity;
+		ThrottlingSeverity predictedSeverity;
+		ThrottlingSeverity reportedSeverity;
+		float timeToThreshold;
+		ThermalTrend trend;
+		int64_t stamp_ns;
+		std::shared_ptr<ThermalHistory> history;
+	};
+
+	struct therm_prediction {
+		Temperature t;
+		float slope;
+		ThrottlingSeverity predictedSeverity;
+		float timeToThreshold;
+	};
+
+	struct therm_history {
+		std::string name;
+		TemperatureType type;
+		std::shared_ptr<ThermalHistory> history;
 	};
 
 	struct therm_cdev {
@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include <android-base/logging.h>
+#include "thermalEventLoop.h"
+
+#define MAX_EPOLL_EVENTS	8
+#define NSEC_PER_SEC		1000000000LL
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+ThermalEventLoop::ThermalEventLoop():
+	loop_shutdown(false)
+{
+	epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+	if (epoll_fd < 0)
+		LOG(ERROR) << "epoll create error:" << errno << std::endl;
+	wake_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+	if (wake_fd < 0)
+		LOG(ERROR) << "eventfd create error:" << errno << std::endl;
+}
+
+ThermalEventLoop::~ThermalEventLoop()
+{
+	stop();
+	for (auto& h: handlers) {
+		if (h->timer)
+			close(h->fd);
+	}
+	if (wake_fd >= 0)
+		close(wake_fd);
+	if (epoll_fd >= 0)
+		close(epoll_fd);
+}
+
+int ThermalEventLoop::start()
+{
+	struct epoll_event ev;
+
+	if (epoll_fd < 0 || wake_fd < 0)
+		return -1;
+	if (th.joinable())
+		return 0;
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = nullptr;
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, wake_fd, &ev) < 0) {
+		LOG(ERROR) << "epoll add wake fd error:" << errno << std::endl;
+		return -1;
+	}
+	th = std::thread(&ThermalEventLoop::run, this);
+
+	return 0;
+}
+
+void ThermalEventLoop::stop()
+{
+	uint64_t val = 1;
+
+	if (!th.joinable())
+		return;
+	loop_shutdown = true;
+	if (write(wake_fd, &val, sizeof(val)) < 0)
+		LOG(ERROR) << "event loop wake error:" << errno << std::endl;
+	th.join();
+}
+
+int ThermalEventLoop::addHandler(int fd, bool timer, const loopCB& cb)
+{
+	struct epoll_event ev;
+	std::unique_ptr<struct handler> h(new handler{fd, timer, cb});
+
+	if (epoll_fd < 0)
+		return -1;
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.ptr = h.get();
+	std::lock_guard<std::mutex> _lock(handler_mutex);
+	if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+		LOG(ERROR) << "epoll add error:" << errno << " fd:" << fd
+			<< std::endl;
+		return -1;
+	}
+	/* Handlers live until the loop is destroyed, so the pointer
+	 * handed to epoll stays valid while the thread runs. */
+	handlers.push_back(std::move(h));
+
+	return fd;
+}
+
+int ThermalEventLoop::addFd(int fd, const loopCB& cb)
+{
+	return addHandler(fd, false, cb);
+}
+
+int ThermalEventLoop::addTimer(const loopCB& cb)
+{
+	int fd, ret;
+
+	fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+	if (fd < 0) {
+		LOG(ERROR) << "timerfd create error:" << errno << std::endl;
+		return -1;
+	}
+	ret = addHandler(fd, true, cb);
+	if (ret < 0)
+		close(fd);
+
+	return ret;
+}
+
+/* delay_ns of 0 disarms the timer, interval_ns of 0 makes it one shot */
+int ThermalEventLoop::armTimer(int id, int64_t delay_ns, int64_t interval_ns)
+{
+	struct itimerspec spec;
+
+	if (id < 0)
+		return -1;
+	spec.it_value.tv_sec = delay_ns / NSEC_PER_SEC;
+	spec.it_value.tv_nsec = delay_ns % NSEC_PER_SEC;
+	spec.it_interval.tv_sec = interval_ns / NSEC_PER_SEC;
+	spec.it_interval.tv_nsec = interval_ns % NSEC_PER_SEC;
+	if (timerfd_settime(id, 0, &spec, nullptr) < 0) {
+		LOG(ERROR) << "timer arm error:" << errno << std::endl;
+		return -1;
+	}
+
+	return 0;
+}
+
+void ThermalEventLoop::run()
+{
+	struct epoll_event events[MAX_EPOLL_EVENTS];
+	uint64_t val;
+	int n, i;
+
+	LOG(DEBUG) << "Thermal event loop started" << std::endl;
+	while (!loop_shutdown) {
+		n = epoll_wait(epoll_fd, events, MAX_EPOLL_EVENTS, -1);
+		if (n < 0) {
+			if (errno == EINTR)
+				continue;
+			LOG(ERROR) << "epoll wait error:" << errno << std::endl;
+			break;
+		}
+		for (i = 0; i < n && !loop_shutdown; i++) {
+			struct handler *h = (struct handler *)events[i].data.ptr;
+
+			if (!h)
+				continue;
+			/* Drain the expiration count, only the latest matters */
+			if (h->timer && read(h->fd, &val, sizeof(val)) < 0)
+				continue;
+			h->cb();
+		}
+	}
+	LOG(INFO) << "Exiting thermal event loop" << std::endl;
+}
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
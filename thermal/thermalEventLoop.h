@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef THERMAL_THERMAL_EVENT_LOOP_H__
+#define THERMAL_THERMAL_EVENT_LOOP_H__
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+using loopCB = std::function<void()>;
+
+/*
+ * Single epoll thread of the HAL. It serves the uevent socket or the
+ * thermal netlink sockets, the sysfs polling timer and the coalesced
+ * client notifications. Handlers run on the loop thread, one at a time.
+ */
+class ThermalEventLoop {
+	public:
+		ThermalEventLoop();
+		~ThermalEventLoop();
+		ThermalEventLoop(const ThermalEventLoop&) = delete;
+		ThermalEventLoop& operator=(const ThermalEventLoop&) = delete;
+
+		int start();
+		void stop();
+		/* Call cb whenever fd is readable, the handler must read it */
+		int addFd(int fd, const loopCB& cb);
+		/* Returns a timer id for armTimer(), the timer starts disarmed */
+		int addTimer(const loopCB& cb);
+		int armTimer(int id, int64_t delay_ns, int64_t interval_ns);
+
+	private:
+		struct handler {
+			int fd;
+			bool timer;
+			loopCB cb;
+		};
+
+		int epoll_fd;
+		int wake_fd;
+		std::atomic<bool> loop_shutdown;
+		std::thread th;
+		std::mutex handler_mutex;
+		std::vector<std::unique_ptr<struct handler>> handlers;
+
+		int addHandler(int fd, bool timer, const loopCB& cb);
+		void run();
+};
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+
+#endif  // THERMAL_THERMAL_EVENT_LOOP_H__
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cstring>
+#include <limits>
+
+#include "thermalHistory.h"
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+/* data word: temperature float bits | severity << 32 | predicted << 40 |
+ * cdev state << 48 */
+static uint64_t pack(float temp, uint8_t severity, uint8_t predicted,
+		uint16_t cdev_state)
+{
+	uint32_t bits;
+
+	memcpy(&bits, &temp, sizeof(bits));
+	return (uint64_t)bits | (uint64_t)severity << 32 |
+		(uint64_t)predicted << 40 | (uint64_t)cdev_state << 48;
+}
+
+static void unpack(uint64_t data, struct therm_history_sample& s)
+{
+	uint32_t bits = (uint32_t)data;
+
+	memcpy(&s.temp, &bits, sizeof(bits));
+	s.severity = (uint8_t)(data >> 32);
+	s.predicted = (uint8_t)(data >> 40);
+	s.cdev_state = (uint16_t)(data >> 48);
+}
+
+ThermalHistory::ThermalHistory():
+	head(0),
+	last_ts(0)
+{
+	for (slot& s: ring) {
+		s.seq.store(0, std::memory_order_relaxed);
+		s.ts_ns.store(0, std::memory_order_relaxed);
+		s.data.store(0, std::memory_order_relaxed);
+	}
+}
+
+/*
+ * Sample idx lives in ring[idx % HISTORY_DEPTH]. The slot sequence is
+ * 2 * idx + 1 while it is written and 2 * idx + 2 once complete.
+ */
+void ThermalHistory::record(int64_t ts_ns, float temp, uint8_t severity,
+		uint8_t predicted, uint16_t cdev_state)
+{
+	uint64_t idx = head.load(std::memory_order_relaxed);
+	slot& s = ring[idx % HISTORY_DEPTH];
+
+	s.seq.store(2 * idx + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	s.ts_ns.store(ts_ns, std::memory_order_relaxed);
+	s.data.store(pack(temp, severity, predicted, cdev_state),
+			std::memory_order_relaxed);
+	s.seq.store(2 * idx + 2, std::memory_order_release);
+	head.store(idx + 1, std::memory_order_release);
+	last_ts = ts_ns;
+}
+
+bool ThermalHistory::load(uint64_t idx, struct therm_history_sample& out) const
+{
+	const slot& s = ring[idx % HISTORY_DEPTH];
+	uint64_t seq, data;
+
+	seq = s.seq.load(std::memory_order_acquire);
+	if (seq != 2 * idx + 2)
+		return false;
+	out.ts_ns = s.ts_ns.load(std::memory_order_relaxed);
+	data = s.data.load(std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	if (s.seq.load(std::memory_order_relaxed) != seq)
+		return false;
+	unpack(data, out);
+
+	return true;
+}
+
+size_t ThermalHistory::snapshot(int64_t from_ns, int64_t to_ns,
+		std::vector<struct therm_history_sample>& out) const
+{
+	uint64_t end = head.load(std::memory_order_acquire);
+	uint64_t idx = end > HISTORY_DEPTH ? end - HISTORY_DEPTH : 0;
+	struct therm_history_sample s;
+	size_t found = 0;
+
+	for (; idx < end; idx++) {
+		if (!load(idx, s) || s.ts_ns < from_ns || s.ts_ns > to_ns)
+			continue;
+		out.push_back(s);
+		found++;
+	}
+
+	return found;
+}
+
+bool ThermalHistory::query(int64_t from_ns, int64_t to_ns,
+		struct therm_history_stats& stats) const
+{
+	uint64_t end = head.load(std::memory_order_acquire);
+	uint64_t idx = end > HISTORY_DEPTH ? end - HISTORY_DEPTH : 0;
+	struct therm_history_sample s;
+	double sum = 0;
+
+	stats.count = 0;
+	stats.min = std::numeric_limits<float>::max();
+	stats.max = std::numeric_limits<float>::lowest();
+	stats.max_severity = 0;
+	for (; idx < end; idx++) {
+		if (!load(idx, s) || s.ts_ns < from_ns || s.ts_ns > to_ns)
+			continue;
+		if (s.temp < stats.min)
+			stats.min = s.temp;
+		if (s.temp > stats.max)
+			stats.max = s.temp;
+		if (s.severity > stats.max_severity)
+			stats.max_severity = s.severity;
+		sum += s.temp;
+		stats.count++;
+	}
+	if (!stats.count)
+		return false;
+	stats.avg = (float)(sum / stats.count);
+
+	return true;
+}
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
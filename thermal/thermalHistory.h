@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef THERMAL_THERMAL_HISTORY_H__
+#define THERMAL_THERMAL_HISTORY_H__
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+/* Samples kept per sensor, 24 bytes each */
+#define HISTORY_DEPTH		512
+
+struct therm_history_sample {
+	int64_t ts_ns;
+	float temp;
+	uint8_t severity;
+	uint8_t predicted;
+	uint16_t cdev_state;
+};
+
+struct therm_history_stats {
+	size_t count;
+	float min;
+	float max;
+	float avg;
+	uint8_t max_severity;
+};
+
+/*
+ * Fixed size ring of the most recent samples of one sensor. There is a
+ * single writer at a time (the ThermalUtils callers hold sens_cb_mutex)
+ * and any number of lock-free readers. Each slot carries a sequence
+ * number so a reader detects and skips a slot overwritten under it.
+ */
+class ThermalHistory {
+	public:
+		ThermalHistory();
+		ThermalHistory(const ThermalHistory&) = delete;
+		ThermalHistory& operator=(const ThermalHistory&) = delete;
+
+		void record(int64_t ts_ns, float temp, uint8_t severity,
+				uint8_t predicted, uint16_t cdev_state);
+		int64_t lastStamp() const
+		{
+			return last_ts;
+		};
+		size_t snapshot(int64_t from_ns, int64_t to_ns,
+				std::vector<struct therm_history_sample>& out) const;
+		bool query(int64_t from_ns, int64_t to_ns,
+				struct therm_history_stats& stats) const;
+
+	private:
+		struct slot {
+			std::atomic<uint64_t> seq;
+			std::atomic<int64_t> ts_ns;
+			std::atomic<uint64_t> data;
+		};
+
+		slot ring[HISTORY_DEPTH];
+		std::atomic<uint64_t> head;
+		int64_t last_ts;
+
+		bool load(uint64_t idx, struct therm_history_sample& s) const;
+};
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+
+#endif  // THERMAL_THERMAL_HISTORY_H__
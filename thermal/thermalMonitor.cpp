@@ -29,7 +29,6 @@
  */
 
 #include <unistd.h>
-#include <poll.h>
 #include <sys/socket.h>
 #include <linux/types.h>
 #include <linux/netlink.h>
@@ -65,13 +64,9 @@ namespace thermal {
 namespace V2_0 {
 namespace implementation {
 
-using parseCB = std::function<void(char *inp_buf, ssize_t len)>;
-using pollCB = std::function<bool()>;
-
-void thermal_monitor_uevent(const parseCB &parse_cb, const pollCB &stopPollCB)
+static int thermal_monitor_uevent_open()
 {
-	struct pollfd pfd;
-	char buf[UEVENT_BUF] = {0};
+	int fd;
 	int sz = 64*1024;
 	struct sockaddr_nl nls;
 
@@ -80,67 +75,63 @@ void thermal_monitor_uevent(const parseCB &parse_cb, const pollCB &stopPollCB)
 	nls.nl_pid = getpid();
 	nls.nl_groups = 0xffffffff;
 
-	pfd.events = POLLIN;
-	pfd.fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC,
+	fd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
 			NETLINK_KOBJECT_UEVENT);
-	if (pfd.fd < 0) {
+	if (fd < 0) {
 		LOG(ERROR) << "socket creation error:" << errno << std::endl;
-		return;
+		return -1;
 	}
 	LOG(DEBUG) << "socket creation success" << std::endl;
 
-	setsockopt(pfd.fd, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
-	if (bind(pfd.fd, (struct sockaddr *)&nls, sizeof(nls)) < 0) {
-		close(pfd.fd);
+	setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &sz, sizeof(sz));
+	if (bind(fd, (struct sockaddr *)&nls, sizeof(nls)) < 0) {
+		close(fd);
 		LOG(ERROR) << "socket bind failed:" << errno << std::endl;
-		return;
+		return -1;
 	}
 	LOG(DEBUG) << "Listening for uevent" << std::endl;
 
-	while (!stopPollCB()) {
-		ssize_t len;
-		int err;
-
-		err = poll(&pfd, 1, -1);
-		if (err == -1) {
-			LOG(ERROR) << "Error in uevent poll.";
-			break;
-		}
-		if (stopPollCB()) {
-			LOG(INFO) << "Exiting uevent monitor" << std::endl;
-			return;
-		}
-		len = recv(pfd.fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
-		if (len == -1) {
-			LOG(ERROR) << "uevent read failed:" << errno << std::endl;
-			continue;
-		}
-		buf[len] = '\0';
-
-		parse_cb(buf, len);
-	}
-
-	return;
+	return fd;
 }
 
 ThermalMonitor::ThermalMonitor(const ueventMonitorCB &inp_cb):
+	uevent_fd(-1),
 	cb(inp_cb)
 {
-	monitor_shutdown = false;
 }
 
 ThermalMonitor::~ThermalMonitor()
 {
-	monitor_shutdown = true;
-	th.join();
+	if (uevent_fd >= 0)
+		close(uevent_fd);
+}
+
+void ThermalMonitor::start(ThermalEventLoop& loop)
+{
+	uevent_fd = thermal_monitor_uevent_open();
+	if (uevent_fd < 0)
+		return;
+	if (loop.addFd(uevent_fd, std::bind(&ThermalMonitor::read_uevent,
+					this)) < 0) {
+		close(uevent_fd);
+		uevent_fd = -1;
+	}
 }
 
-void ThermalMonitor::start()
+void ThermalMonitor::read_uevent()
 {
-	th = std::thread(thermal_monitor_uevent,
-		std::bind(&ThermalMonitor::parse_and_notify, this,
-			std::placeholders::_1, std::placeholders::_2),
-		std::bind(&ThermalMonitor::stopPolling, this));
+	char buf[UEVENT_BUF] = {0};
+	ssize_t len;
+
+	len = recv(uevent_fd, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+	if (len == -1) {
+		if (errno != EAGAIN)
+			LOG(ERROR) << "uevent read failed:" << errno << std::endl;
+		return;
+	}
+	buf[len] = '\0';
+
+	parse_and_notify(buf, len);
 }
 
 void ThermalMonitor::parse_and_notify(char *inp_buf, ssize_t len)
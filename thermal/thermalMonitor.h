@@ -32,8 +32,8 @@
 #ifndef THERMAL_THERMAL_MONITOR_H__
 #define THERMAL_THERMAL_MONITOR_H__
 
-#include <thread>
 #include <android/hardware/thermal/2.0/IThermal.h>
+#include "thermalEventLoop.h"
 
 namespace android {
 namespace hardware {
@@ -49,15 +49,12 @@ class ThermalMonitor {
 		~ThermalMonitor();
 
 		void parse_and_notify(char *inp_buf, ssize_t len);
-		bool stopPolling()
-		{
-			return monitor_shutdown;
-		}
-		void start();
+		void start(ThermalEventLoop& loop);
 	private:
-		std::thread th;
-		bool monitor_shutdown;
+		int uevent_fd;
 		ueventMonitorCB cb;
+
+		void read_uevent();
 };
 
 }  // namespace implementation
@@ -43,16 +43,16 @@ namespace thermal {
 namespace V2_0 {
 namespace implementation {
 
-using pollCB = std::function<bool()>;
 using familyCB = std::function<int(struct nl_msg *, void *)>;
 
-void thermal_listen(struct nl_sock *soc, const pollCB &stopCB)
+/* Sockets are non blocking, one receive drains what epoll reported */
+static void thermal_listen(struct nl_sock *soc)
 {
-	while (!stopCB())
-		nl_recvmsgs_default(soc);
+	int ret = nl_recvmsgs_default(soc);
 
-	LOG(INFO) << "thermal_listen_event Exit" << std::endl;
-	return;
+	if (ret < 0 && ret != -NLE_AGAIN)
+		LOG(ERROR) << "thermal netlink receive error:" << ret
+			<< std::endl;
 }
 
 int thermal_event_cb(struct nl_msg *n, void *data)
@@ -76,20 +76,18 @@ int thermal_family_cb(struct nl_msg *n, void *data)
 ThermalMonitor::ThermalMonitor(const eventMonitorCB &inp_event_cb,
 				const eventMonitorCB &inp_sample_cb,
 				const eventCreateMonitorCB &inp_event_create_cb):
+	event_soc(nullptr),
+	sample_soc(nullptr),
 	event_group(-1),
 	sample_group(-1),
 	event_cb(inp_event_cb),
 	sample_cb(inp_sample_cb),
 	event_create_cb(inp_event_create_cb)
 {
-	monitor_shutdown = false;
 }
 
 ThermalMonitor::~ThermalMonitor()
 {
-	monitor_shutdown = true;
-	event_th.join();
-	sample_th.join();
 	if (sample_soc)
 		nl_socket_free(sample_soc);
 	if (event_soc)
@@ -254,7 +252,7 @@ int ThermalMonitor::fetch_group_id(void)
 	return 0;
 }
 
-void ThermalMonitor::start()
+void ThermalMonitor::start(ThermalEventLoop& loop)
 {
 	struct nl_msg *msg;
 
@@ -294,11 +292,12 @@ void ThermalMonitor::start()
 	nl_socket_disable_seq_check(event_soc);
 	nl_socket_modify_cb(event_soc, NL_CB_VALID, NL_CB_CUSTOM,
 			thermal_event_cb, this);
-	event_th = std::thread(thermal_listen, event_soc,
-		std::bind(&ThermalMonitor::stopPolling, this));
-
-	sample_th = std::thread(thermal_listen, sample_soc,
-		std::bind(&ThermalMonitor::stopPolling, this));
+	nl_socket_set_nonblocking(sample_soc);
+	nl_socket_set_nonblocking(event_soc);
+	loop.addFd(nl_socket_get_fd(event_soc),
+		std::bind(thermal_listen, event_soc));
+	loop.addFd(nl_socket_get_fd(sample_soc),
+		std::bind(thermal_listen, sample_soc));
 }
 
 }  // namespace implementation
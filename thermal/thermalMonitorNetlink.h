@@ -33,12 +33,12 @@
 #ifndef THERMAL_THERMAL_MONITOR_NETLINK_H__
 #define THERMAL_THERMAL_MONITOR_NETLINK_H__
 
-#include <thread>
 #include <netlink/genl/genl.h>
 #include <netlink/genl/mngt.h>
 #include <netlink/genl/ctrl.h>
 #include <netlink/netlink.h>
 #include <android/hardware/thermal/2.0/IThermal.h>
+#include "thermalEventLoop.h"
 
 namespace android {
 namespace hardware {
@@ -57,19 +57,13 @@ class ThermalMonitor {
 		~ThermalMonitor();
 
 		void parse_and_notify(char *inp_buf, ssize_t len);
-		bool stopPolling()
-		{
-			return monitor_shutdown;
-		}
-		void start();
+		void start(ThermalEventLoop& loop);
 		int family_msg_cb(struct nl_msg *msg, void *data);
 		int event_parse(struct nl_msg *n, void *data);
 		int sample_parse(struct nl_msg *n, void *data);
 	private:
-		std::thread event_th, sample_th;
 		struct nl_sock *event_soc, *sample_soc;
 		int event_group, sample_group;
-		bool monitor_shutdown;
 		eventMonitorCB event_cb, sample_cb;
 		eventCreateMonitorCB event_create_cb;
 
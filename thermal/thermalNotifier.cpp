@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <chrono>
+
+#include "thermalNotifier.h"
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+static int64_t elapsed_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+ThermalNotifier::ThermalNotifier(ThermalEventLoop& loop, const notifyCB& cb,
+		int64_t interval_ns):
+	loop(loop),
+	cb(cb),
+	interval_ns(interval_ns),
+	armed(false),
+	last_flush_ns(0)
+{
+	timer = loop.addTimer(std::bind(&ThermalNotifier::flush, this));
+}
+
+void ThermalNotifier::queue(Temperature& t)
+{
+	int64_t delay;
+
+	if (timer < 0)
+		return cb(t);
+	std::lock_guard<std::mutex> _lock(notify_mutex);
+	pending[t.name] = t;
+	if (armed)
+		return;
+	delay = last_flush_ns + interval_ns - elapsed_ns();
+	if (!loop.armTimer(timer, delay > 0 ? delay : 1, 0))
+		armed = true;
+}
+
+void ThermalNotifier::flush()
+{
+	std::unordered_map<std::string, Temperature> batch;
+
+	{
+		std::lock_guard<std::mutex> _lock(notify_mutex);
+		batch.swap(pending);
+		armed = false;
+		last_flush_ns = elapsed_ns();
+	}
+	for (auto& it: batch) {
+		auto last = sent.find(it.first);
+
+		/* Went up and back down within the interval */
+		if (last != sent.end() &&
+				last->second == it.second.throttlingStatus)
+			continue;
+		sent[it.first] = it.second.throttlingStatus;
+		cb(it.second);
+	}
+}
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
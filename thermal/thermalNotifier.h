@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef THERMAL_THERMAL_NOTIFIER_H__
+#define THERMAL_THERMAL_NOTIFIER_H__
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <android/hardware/thermal/2.0/IThermal.h>
+#include "thermalEventLoop.h"
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+using notifyCB = std::function<void(Temperature &t)>;
+
+/*
+ * Clients are called from the event loop at most once per notify
+ * interval. Within an interval only the latest state of each sensor is
+ * kept, so a burst of trip events ends up as one callback per sensor,
+ * and none for a sensor back at the severity it was last notified with.
+ * Without a loop timer clients are called right away.
+ */
+class ThermalNotifier {
+	public:
+		/* Adds its timer to the loop, before the loop is started */
+		ThermalNotifier(ThermalEventLoop& loop, const notifyCB& cb,
+				int64_t interval_ns);
+		ThermalNotifier(const ThermalNotifier&) = delete;
+		ThermalNotifier& operator=(const ThermalNotifier&) = delete;
+
+		void queue(Temperature& t);
+
+	private:
+		ThermalEventLoop& loop;
+		notifyCB cb;
+		int64_t interval_ns;
+		int timer;
+		std::mutex notify_mutex;
+		std::unordered_map<std::string, Temperature> pending;
+		/* Only used on the loop thread */
+		std::unordered_map<std::string, ThrottlingSeverity> sent;
+		bool armed;
+		int64_t last_flush_ns;
+
+		void flush();
+};
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+
+#endif  // THERMAL_THERMAL_NOTIFIER_H__
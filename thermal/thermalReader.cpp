@@ -0,0 +1,380 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cerrno>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <android-base/logging.h>
+#include <android-base/properties.h>
+#include "thermalReader.h"
+
+#define NODE_BUF		32
+#define NODE_PATH_MAX		256
+#define STAT_LINE_MAX		256
+#define CACHE_WINDOW_PROP	"vendor.thermal.cache_window_ms"
+#define TEMPERATURE_FILE_FORMAT	"%s/sys/class/thermal/thermal_zone%d/temp"
+#define CDEV_CUR_STATE_PATH	"%s/sys/class/thermal/cooling_device%d/cur_state"
+#define CPU_USAGE_FILE		"/proc/stat"
+#define CPU_ONLINE_FILE_FORMAT	"%s/sys/devices/system/cpu/cpu%d/online"
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+static int64_t now_ns()
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int open_node(const char *path)
+{
+	int fd, err;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) {
+		err = errno;
+		LOG(ERROR) << "Path:" << path << " file open error.err:"
+			<< strerror(err) << std::endl;
+		return -err;
+	}
+
+	return fd;
+}
+
+/* sysfs and procfs regenerate the node contents on a read at offset 0,
+ * so the same descriptor can be read again without lseek or reopen. */
+static ssize_t read_node(int fd, char *buf, size_t len)
+{
+	ssize_t ret;
+
+	do {
+		ret = pread(fd, buf, len - 1, 0);
+	} while (ret < 0 && errno == EINTR);
+	if (ret < 0)
+		return -errno;
+	buf[ret] = '\0';
+
+	return ret;
+}
+
+static int parse_int(const char *buf, int& out)
+{
+	char *end;
+	long val;
+
+	errno = 0;
+	val = strtol(buf, &end, 0);
+	if (end == buf || errno || val < INT_MIN || val > INT_MAX)
+		return -EINVAL;
+	out = (int)val;
+
+	return 0;
+}
+
+static bool parse_u64(const char *&p, const char *end, uint64_t& out)
+{
+	uint64_t val = 0;
+
+	while (p < end && *p == ' ')
+		p++;
+	if (p == end || !isdigit(*p))
+		return false;
+	while (p < end && isdigit(*p))
+		val = val * 10 + (*p++ - '0');
+	out = val;
+
+	return true;
+}
+
+ThermalReader::ThermalReader(int ncpus, const std::string& root):
+	ncpus(ncpus > 0 ? ncpus : 1),
+	root(root),
+	stat_fd(-1),
+	stat_buf((this->ncpus + 2) * STAT_LINE_MAX),
+	online_fd(this->ncpus, -1)
+{
+	setCacheWindow(android::base::GetUintProperty<uint32_t>(
+				CACHE_WINDOW_PROP, DEFAULT_CACHE_WINDOW_MS));
+}
+
+ThermalReader::~ThermalReader()
+{
+	for (auto& it: temp_nodes)
+		close(it.second.fd);
+	for (auto& it: cdev_fd)
+		close(it.second);
+	for (int fd: online_fd) {
+		if (fd >= 0)
+			close(fd);
+	}
+	if (stat_fd >= 0)
+		close(stat_fd);
+}
+
+void ThermalReader::setCacheWindow(uint32_t window_ms)
+{
+	std::lock_guard<std::mutex> _lock(reader_mutex);
+	cache_window_ns = (int64_t)window_ms * 1000000;
+	LOG(DEBUG) << "Temperature cache window:" << window_ms << "ms"
+		<< std::endl;
+}
+
+struct ThermalReader::temp_node *ThermalReader::getTempNode(int tzn)
+{
+	char file_name[NODE_PATH_MAX];
+	struct temp_node node;
+	auto it = temp_nodes.find(tzn);
+
+	if (it != temp_nodes.end())
+		return &it->second;
+
+	snprintf(file_name, sizeof(file_name), TEMPERATURE_FILE_FORMAT,
+			root.c_str(), tzn);
+	node.fd = open_node(file_name);
+	if (node.fd < 0)
+		return nullptr;
+	node.value = 0;
+	node.stamp_ns = 0;
+	node.valid = false;
+
+	return &temp_nodes.emplace(tzn, node).first->second;
+}
+
+int ThermalReader::readTemperature(int tzn, int& temp, int64_t& stamp_ns)
+{
+	char buf[NODE_BUF];
+	struct temp_node *node;
+	ssize_t ret;
+	int val;
+
+	std::lock_guard<std::mutex> _lock(reader_mutex);
+	node = getTempNode(tzn);
+	if (!node)
+		return -ENOENT;
+	if (node->valid && now_ns() - node->stamp_ns < cache_window_ns) {
+		temp = node->value;
+		stamp_ns = node->stamp_ns;
+		return 0;
+	}
+
+	ret = read_node(node->fd, buf, sizeof(buf));
+	if (ret <= 0) {
+		LOG(ERROR) << "Temperature read error:" << ret << " TZ:" << tzn
+			<< std::endl;
+		/* The zone may have been removed, reopen on the next read */
+		close(node->fd);
+		temp_nodes.erase(tzn);
+		return ret < 0 ? ret : -EIO;
+	}
+	if (parse_int(buf, val)) {
+		LOG(ERROR) << "Temperature parse error buf:" << buf << " TZ:"
+			<< tzn << std::endl;
+		return -EINVAL;
+	}
+	node->value = temp = val;
+	node->stamp_ns = stamp_ns = now_ns();
+	node->valid = true;
+
+	return ret;
+}
+
+int64_t ThermalReader::updateTemperature(int tzn, int temp)
+{
+	struct temp_node *node;
+	int64_t stamp_ns = now_ns();
+
+	std::lock_guard<std::mutex> _lock(reader_mutex);
+	node = getTempNode(tzn);
+	if (node) {
+		node->value = temp;
+		node->stamp_ns = stamp_ns;
+		node->valid = true;
+	}
+
+	return stamp_ns;
+}
+
+void ThermalReader::invalidateTemperature(int tzn)
+{
+	std::lock_guard<std::mutex> _lock(reader_mutex);
+	auto it = temp_nodes.find(tzn);
+
+	if (it != temp_nodes.end())
+		it->second.valid = false;
+}
+
+int ThermalReader::readCdevState(int cdevn, int& state)
+{
+	char file_name[NODE_PATH_MAX];
+	char buf[NODE_BUF];
+	ssize_t ret;
+	int fd;
+
+	std::lock_guard<std::mutex> _lock(reader_mutex);
+	auto it = cdev_fd.find(cdevn);
+	if (it == cdev_fd.end()) {
+		snprintf(file_name, sizeof(file_name), CDEV_CUR_STATE_PATH,
+				root.c_str(), cdevn);
+		fd = open_node(file_name);
+		if (fd < 0)
+			return fd;
+		it = cdev_fd.emplace(cdevn, fd).first;
+	}
+
+	ret = read_node(it->second, buf, sizeof(buf));
+	if (ret <= 0) {
+		LOG(ERROR) << "Cdev state read error:" << ret << " cdev:"
+			<< cdevn << std::endl;
+		close(it->second);
+		cdev_fd.erase(it);
+		return ret < 0 ? ret : -EIO;
+	}
+	if (parse_int(buf, state)) {
+		LOG(ERROR) << "Cdev state parse error buf:" << buf << " cdev:"
+			<< cdevn << std::endl;
+		return -EINVAL;
+	}
+
+	return ret;
+}
+
+int ThermalReader::getOnlineFd(int cpu_num)
+{
+	char file_name[NODE_PATH_MAX];
+
+	if (cpu_num < 0)
+		return -EINVAL;
+	if ((size_t)cpu_num >= online_fd.size())
+		online_fd.resize(cpu_num + 1, -1);
+	if (online_fd[cpu_num] < 0) {
+		snprintf(file_name, sizeof(file_name), CPU_ONLINE_FILE_FORMAT,
+				root.c_str(), cpu_num);
+		online_fd[cpu_num] = open_node(file_name);
+		if (online_fd[cpu_num] < 0) {
+			int err = online_fd[cpu_num];
+
+			online_fd[cpu_num] = -1;
+			return err;
+		}
+	}
+
+	return online_fd[cpu_num];
+}
+
+/*
+ * Parse the per CPU "cpuN user nice system idle ..." lines of /proc/stat.
+ * They come first and contiguous, so parsing stops at the first line
+ * after them. stat_buf is sized to always hold that block.
+ */
+int ThermalReader::readCpuStats(std::vector<struct cpu_stat>& stats)
+{
+	char buf[NODE_BUF];
+	const char *p, *end, *line_end;
+	ssize_t ret;
+	int fd, online;
+
+	std::lock_guard<std::mutex> _lock(reader_mutex);
+	stats.clear();
+	if (stat_fd < 0) {
+		stat_fd = open_node((root + CPU_USAGE_FILE).c_str());
+		if (stat_fd < 0) {
+			ret = stat_fd;
+			stat_fd = -1;
+			return ret;
+		}
+	}
+	ret = read_node(stat_fd, stat_buf.data(), stat_buf.size());
+	if (ret <= 0) {
+		LOG(ERROR) << "failed to read:" << CPU_USAGE_FILE << " err:"
+			<< ret << std::endl;
+		return ret < 0 ? ret : -EIO;
+	}
+
+	for (p = stat_buf.data(), end = p + ret; p < end; p = line_end + 1) {
+		struct cpu_stat stat;
+		uint64_t cpu_num, user, nice, system, idle;
+
+		line_end = (const char *)memchr(p, '\n', end - p);
+		if (!line_end)
+			line_end = end;
+		if (line_end - p < 4 || strncmp(p, "cpu", 3) != 0 ||
+				!isdigit(p[3])) {
+			if (!stats.empty())
+				break;
+			continue;
+		}
+		p += 3;
+		if (!parse_u64(p, line_end, cpu_num) ||
+				!parse_u64(p, line_end, user) ||
+				!parse_u64(p, line_end, nice) ||
+				!parse_u64(p, line_end, system) ||
+				!parse_u64(p, line_end, idle) ||
+				cpu_num > INT_MAX) {
+			LOG(ERROR) <<
+				"failed to read CPU information from file: "
+				<< CPU_USAGE_FILE << std::endl;
+			return -EIO;
+		}
+
+		fd = getOnlineFd((int)cpu_num);
+		if (fd < 0)
+			return fd;
+		ret = read_node(fd, buf, sizeof(buf));
+		if (ret <= 0 || parse_int(buf, online)) {
+			LOG(ERROR) << "failed to read CPU online information"
+				<< " for cpu:" << cpu_num << std::endl;
+			return ret < 0 ? ret : -EIO;
+		}
+
+		stat.cpu_num = (int)cpu_num;
+		stat.active = user + nice + system;
+		stat.total = stat.active + idle;
+		stat.online = online;
+		stats.push_back(stat);
+	}
+
+	return stats.size();
+}
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef THERMAL_THERMAL_READER_H__
+#define THERMAL_THERMAL_READER_H__
+
+#include <vector>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+/* Default freshness window of a cached temperature, overridden by the
+ * vendor.thermal.cache_window_ms property. 0 disables the cache. */
+#define DEFAULT_CACHE_WINDOW_MS	100
+
+struct cpu_stat {
+	int cpu_num;
+	uint64_t active;
+	uint64_t total;
+	bool online;
+};
+
+/*
+ * Reads thermal zone, cooling device and CPU usage nodes through
+ * file descriptors that stay open for the life of the HAL. Each read
+ * is a single pread() into a fixed buffer. Temperatures are cached per
+ * thermal zone for a freshness window; the uevent/netlink monitors feed
+ * the cache with the values they receive so most HIDL calls are served
+ * without touching sysfs at all.
+ * All node paths are looked up under root, "" for the live sysfs and
+ * procfs, a directory of stand-in nodes in the host tests.
+ */
+class ThermalReader {
+	public:
+		ThermalReader(int ncpus, const std::string& root = "");
+		~ThermalReader();
+		ThermalReader(const ThermalReader&) = delete;
+		ThermalReader& operator=(const ThermalReader&) = delete;
+
+		void setCacheWindow(uint32_t window_ms);
+		int readTemperature(int tzn, int& temp, int64_t& stamp_ns);
+		int64_t updateTemperature(int tzn, int temp);
+		void invalidateTemperature(int tzn);
+		int readCdevState(int cdevn, int& state);
+		int readCpuStats(std::vector<struct cpu_stat>& stats);
+
+	private:
+		struct temp_node {
+			int fd;
+			int value;
+			int64_t stamp_ns;
+			bool valid;
+		};
+
+		int ncpus;
+		std::string root;
+		int64_t cache_window_ns;
+		int stat_fd;
+		std::vector<char> stat_buf;
+		std::vector<int> online_fd;
+		std::unordered_map<int, struct temp_node> temp_nodes;
+		std::unordered_map<int, int> cdev_fd;
+		std::mutex reader_mutex;
+
+		struct temp_node *getTempNode(int tzn);
+		int getOnlineFd(int cpu_num);
+};
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+
+#endif  // THERMAL_THERMAL_READER_H__
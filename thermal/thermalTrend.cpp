@@ -0,0 +1,169 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <cmath>
+
+#include "thermalTrend.h"
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+ThermalTrend::ThermalTrend()
+{
+	reset();
+}
+
+void ThermalTrend::reset()
+{
+	head = 0;
+	count = 0;
+}
+
+void ThermalTrend::addSample(int64_t ts_ns, float value)
+{
+	size_t last = (head + TREND_WINDOW - 1) % TREND_WINDOW;
+
+	if (std::isnan(value))
+		return;
+	if (count) {
+		/* Restarted trace or clock jump, the window is meaningless */
+		if (ts_ns < ts[last]) {
+			reset();
+		} else if (ts_ns == ts[last]) {
+			temp[last] = value;
+			return;
+		}
+	}
+	ts[head] = ts_ns;
+	temp[head] = value;
+	head = (head + 1) % TREND_WINDOW;
+	if (count < TREND_WINDOW)
+		count++;
+	/* Age out samples that no longer describe the current workload */
+	while (count > 1 && ts_ns - ts[(head + TREND_WINDOW - count) %
+			TREND_WINDOW] > TREND_MAX_AGE_NS)
+		count--;
+}
+
+bool ThermalTrend::slope(float& per_sec, float& fitted) const
+{
+	size_t idx, i;
+	size_t last = (head + TREND_WINDOW - 1) % TREND_WINDOW;
+	size_t first = (head + TREND_WINDOW - count) % TREND_WINDOW;
+	double x, mean_x = 0, mean_y = 0, sxx = 0, sxy = 0;
+
+	if (count < TREND_MIN_SAMPLES ||
+			ts[last] - ts[first] < TREND_MIN_SPAN_NS)
+		return false;
+
+	/* Time relative to the newest sample keeps the fit well conditioned */
+	for (i = 0, idx = first; i < count; i++, idx = (idx + 1) % TREND_WINDOW) {
+		mean_x += (ts[idx] - ts[last]) / 1e9;
+		mean_y += temp[idx];
+	}
+	mean_x /= count;
+	mean_y /= count;
+	for (i = 0, idx = first; i < count; i++, idx = (idx + 1) % TREND_WINDOW) {
+		x = (ts[idx] - ts[last]) / 1e9 - mean_x;
+		sxx += x * x;
+		sxy += x * (temp[idx] - mean_y);
+	}
+	per_sec = (float)(sxy / sxx);
+	fitted = (float)(mean_y - sxy / sxx * mean_x);
+
+	return true;
+}
+
+float ThermalTrend::latest() const
+{
+	return temp[(head + TREND_WINDOW - 1) % TREND_WINDOW];
+}
+
+float ThermalTrend::timeToThreshold(float thresh) const
+{
+	float per_sec, fitted;
+
+	if (std::isnan(thresh) || !slope(per_sec, fitted))
+		return NAN;
+	if (latest() >= thresh)
+		return 0;
+	if (per_sec <= 0)
+		return NAN;
+
+	return (thresh - latest()) / per_sec;
+}
+
+/*
+ * Highest severity above the current one whose hot threshold the trend
+ * reaches within horizon_s, going from the newest sample at the fitted
+ * slope. The fitted value itself lags behind a turn, so it is not used
+ * as the start; nor is anything predicted unless the trend is rising.
+ * SHUTDOWN is never predicted, only its time to threshold is reported
+ * when it is the next one.
+ */
+ThrottlingSeverity ThermalTrend::predict(const TemperatureThreshold& thresh,
+		ThrottlingSeverity current, float horizon_s,
+		float& time_to_threshold) const
+{
+	ThrottlingSeverity predicted = ThrottlingSeverity::NONE;
+	float per_sec, fitted, eta;
+	int idx;
+
+	time_to_threshold = NAN;
+	if (!slope(per_sec, fitted) || per_sec <= 0)
+		return predicted;
+
+	for (idx = (int)current + 1; idx <= (int)ThrottlingSeverity::SHUTDOWN;
+			idx++) {
+		if (std::isnan(thresh.hotThrottlingThresholds[idx]))
+			continue;
+		if (latest() >= thresh.hotThrottlingThresholds[idx])
+			eta = 0;
+		else
+			eta = (thresh.hotThrottlingThresholds[idx] - latest()) /
+				per_sec;
+		if (std::isnan(time_to_threshold))
+			time_to_threshold = eta;
+		if (eta > horizon_s || idx == (int)ThrottlingSeverity::SHUTDOWN)
+			break;
+		predicted = (ThrottlingSeverity)idx;
+	}
+
+	return predicted;
+}
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
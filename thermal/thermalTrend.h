@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2021, The Linux Foundation. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *	* Redistributions of source code must retain the above copyright
+ *	  notice, this list of conditions and the following disclaimer.
+ *	* Redistributions in binary form must reproduce the above
+ *	  copyright notice, this list of conditions and the following
+ *	  disclaimer in the documentation and/or other materials provided
+ *	  with the distribution.
+ *	* Neither the name of The Linux Foundation nor the names of its
+ *	  contributors may be used to endorse or promote products derived
+ *	  from this software without specific prior written permission.
+ *
+ *
+ * THIS SOFTWARE IS PROVIDED "AS IS" AND ANY EXPRESS OR IMPLIED
+ * WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT
+ * ARE DISCLAIMED.  IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS
+ * BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+ * SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR
+ * BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE
+ * OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN
+ * IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef THERMAL_THERMAL_TREND_H__
+#define THERMAL_THERMAL_TREND_H__
+
+#include <cstdint>
+#include <cstddef>
+
+#include <android/hardware/thermal/2.0/IThermal.h>
+
+namespace android {
+namespace hardware {
+namespace thermal {
+namespace V2_0 {
+namespace implementation {
+
+#define TREND_WINDOW		16
+#define TREND_MIN_SAMPLES	4
+#define TREND_MIN_SPAN_NS	(3LL * 1000000000LL)
+#define TREND_MAX_AGE_NS	(60LL * 1000000000LL)
+
+/*
+ * Rolling window of temperature samples for one sensor. The slope of a
+ * least squares fit over the window projects when the next hot
+ * threshold will be crossed. Timestamps are supplied by the caller, so
+ * a recorded (timestamp, temperature) trace replays deterministically.
+ */
+class ThermalTrend {
+	public:
+		ThermalTrend();
+
+		void addSample(int64_t ts_ns, float temp);
+		void reset();
+		size_t sampleCount() const
+		{
+			return count;
+		};
+		/* Degrees per second, false if the window is too short */
+		bool slope(float& per_sec, float& fitted) const;
+		/* Seconds until temp reaches thresh, NAN if not heading there */
+		float timeToThreshold(float thresh) const;
+		ThrottlingSeverity predict(const TemperatureThreshold& thresh,
+				ThrottlingSeverity current, float horizon_s,
+				float& time_to_threshold) const;
+
+	private:
+		float latest() const;
+
+		int64_t ts[TREND_WINDOW];
+		float temp[TREND_WINDOW];
+		size_t head;
+		size_t count;
+};
+
+}  // namespace implementation
+}  // namespace V2_0
+}  // namespace thermal
+}  // namespace hardware
+}  // namespace android
+
+#endif  // THERMAL_THERMAL_TREND_H__
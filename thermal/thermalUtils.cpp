@@ -38,6 +38,12 @@
 #include "thermalConfig.h"
 #include "thermalUtils.h"
 
+#define NOTIFY_INTERVAL_PROP		"vendor.thermal.notify_interval_ms"
+#define DEFAULT_NOTIFY_INTERVAL_MS	100
+#define POLL_INTERVAL_PROP		"vendor.thermal.poll_interval_ms"
+/* uevents only arrive on trip crossings, sample sysfs in between */
+#define DEFAULT_POLL_INTERVAL_MS	2000
+
 namespace android {
 namespace hardware {
 namespace thermal {
@@ -50,12 +56,18 @@ ThermalUtils::ThermalUtils(const ueventCB &inp_cb):
 	monitor(std::bind(&ThermalUtils::ueventParse, this,
 				std::placeholders::_1,
 				std::placeholders::_2)),
-	cb(inp_cb)
+	cdev_state(0)
 {
 	int ret = 0;
+	int64_t notify_ns, poll_ns;
 	std::vector<struct therm_sensor> sensorList;
 	std::vector<struct target_therm_cfg> therm_cfg = cfg.fetchConfig();
 
+	notify_ns = (int64_t)android::base::GetUintProperty<uint32_t>(
+			NOTIFY_INTERVAL_PROP, DEFAULT_NOTIFY_INTERVAL_MS) *
+			1000000;
+	notifier.reset(new ThermalNotifier(loop, inp_cb, notify_ns));
+
 	is_sensor_init = false;
 	is_cdev_init = false;
 	ret = cmnInst.initThermalZones(therm_cfg);
@@ -69,26 +81,71 @@ ThermalUtils::ThermalUtils(const ueventCB &inp_cb):
 			cmnInst.estimateSeverity(sens);
 			cmnInst.initThreshold(sens);
 		}
-		monitor.start();
+		monitor.start(loop);
 	}
 	ret = cmnInst.initCdev();
 	if (ret > 0) {
-		is_cdev_init = true;
+		/* The monitor may already be running, publish the list last */
 		cdevList = cmnInst.fetch_cdev_list();
+		is_cdev_init = true;
 	}
+
+	poll_ns = (int64_t)android::base::GetUintProperty<uint32_t>(
+			POLL_INTERVAL_PROP, DEFAULT_POLL_INTERVAL_MS) * 1000000;
+	poll_timer = loop.addTimer(std::bind(&ThermalUtils::pollSensors,
+				this));
+	if (poll_ns > 0)
+		loop.armTimer(poll_timer, poll_ns, poll_ns);
+	loop.start();
 }
 
+/*
+ * Clients are notified with the higher of the measured and the trend
+ * predicted severity, so a steady ramp towards a threshold starts
+ * throttling before the threshold is actually crossed.
+ */
 void ThermalUtils::Notify(struct therm_sensor& sens)
 {
 	int severity = cmnInst.estimateSeverity(sens);
-	if (severity != -1) {
+	int predicted = cmnInst.estimatePredictedSeverity(sens);
+	Temperature t = sens.t;
+
+	if (severity != -1)
 		LOG(INFO) << "sensor: " << sens.sensor_name <<" temperature: "
 			<< sens.t.value << " old: " <<
 			(int)sens.lastThrottleStatus << " new: " <<
 			(int)sens.t.throttlingStatus << std::endl;
-		cb(sens.t);
+	if (sens.predictedSeverity > t.throttlingStatus)
+		t.throttlingStatus = sens.predictedSeverity;
+	if ((severity != -1 || predicted != -1) &&
+			t.throttlingStatus != sens.reportedSeverity) {
+		sens.reportedSeverity = t.throttlingStatus;
+		notifier->queue(t);
+	}
+	if (severity != -1) {
 		cmnInst.initThreshold(sens);
+		updateCdevState();
+	}
+	if (sens.history && sens.stamp_ns != sens.history->lastStamp())
+		sens.history->record(sens.stamp_ns, sens.t.value,
+			(uint8_t)sens.t.throttlingStatus,
+			(uint8_t)sens.predictedSeverity,
+			cdev_state.load(std::memory_order_relaxed));
+}
+
+/* Sum of all cooling device states, recorded with each history sample */
+void ThermalUtils::updateCdevState()
+{
+	uint32_t sum = 0;
+
+	if (!is_cdev_init)
+		return;
+	for (struct therm_cdev cdev: cdevList) {
+		if (cmnInst.read_cdev_state(cdev) >= 0)
+			sum += cdev.c.value;
 	}
+	cdev_state.store(std::min(sum, (uint32_t)UINT16_MAX),
+			std::memory_order_relaxed);
 }
 
 void ThermalUtils::ueventParse(std::string sensor_name, int temp)
@@ -102,10 +159,20 @@ void ThermalUtils::ueventParse(std::string sensor_name, int temp)
 	}
 	std::lock_guard<std::mutex> _lock(sens_cb_mutex);
 	struct therm_sensor& sens = thermalConfig[sensor_name];
-	sens.t.value = (float)temp / (float)sens.mulFactor;
+	cmnInst.update_temperature(sens, temp);
 	return Notify(sens);
 }
 
+/* Periodic sysfs sampling for sensors that only report trip crossings */
+void ThermalUtils::pollSensors()
+{
+	std::lock_guard<std::mutex> _lock(sens_cb_mutex);
+	for (auto& it: thermalConfig) {
+		if (cmnInst.read_temperature(it.second) >= 0)
+			Notify(it.second);
+	}
+}
+
 int ThermalUtils::readTemperatures(hidl_vec<Temperature_1_0>& temp)
 {
 	std::unordered_map<std::string, struct therm_sensor>::iterator it;
@@ -188,6 +255,7 @@ int ThermalUtils::readCdevStates(bool filterType, cdevType type,
                                             hidl_vec<CoolingDevice>& cdev_out)
 {
 	int ret = 0;
+	uint32_t sum = 0;
 	std::vector<CoolingDevice> _cdev;
 
 	for (struct therm_cdev cdev: cdevList) {
@@ -197,14 +265,61 @@ int ThermalUtils::readCdevStates(bool filterType, cdevType type,
 		ret = cmnInst.read_cdev_state(cdev);
 		if (ret < 0)
 			return ret;
+		sum += cdev.c.value;
 		_cdev.push_back(cdev.c);
 	}
 
+	if (!filterType)
+		cdev_state.store(std::min(sum, (uint32_t)UINT16_MAX),
+				std::memory_order_relaxed);
 	cdev_out = _cdev;
 
 	return cdev_out.size();
 }
 
+int ThermalUtils::readPredictions(bool filterType, TemperatureType type,
+				std::vector<struct therm_prediction>& pred)
+{
+	std::unordered_map<std::string, struct therm_sensor>::iterator it;
+	float fitted;
+
+	pred.clear();
+	std::lock_guard<std::mutex> _lock(sens_cb_mutex);
+	for (it = thermalConfig.begin(); it != thermalConfig.end(); it++) {
+		struct therm_sensor& sens = it->second;
+		struct therm_prediction p;
+
+		if (filterType && sens.t.type != type)
+			continue;
+		p.t = sens.t;
+		if (!sens.trend.slope(p.slope, fitted))
+			p.slope = UNKNOWN_TEMPERATURE;
+		p.predictedSeverity = sens.predictedSeverity;
+		p.timeToThreshold = sens.timeToThreshold;
+		pred.push_back(p);
+	}
+
+	return pred.size();
+}
+
+int ThermalUtils::readHistory(bool filterType, TemperatureType type,
+				std::vector<struct therm_history>& hist)
+{
+	std::unordered_map<std::string, struct therm_sensor>::iterator it;
+
+	hist.clear();
+	std::lock_guard<std::mutex> _lock(sens_cb_mutex);
+	for (it = thermalConfig.begin(); it != thermalConfig.end(); it++) {
+		struct therm_sensor& sens = it->second;
+
+		if ((filterType && sens.t.type != type) || !sens.history)
+			continue;
+		hist.push_back({sens.t.name, sens.t.type, sens.history});
+	}
+
+	return hist.size();
+}
+
 int ThermalUtils::fetchCpuUsages(hidl_vec<CpuUsage>& cpu_usages)
 {
 	return cmnInst.get_cpu_usages(cpu_usages);
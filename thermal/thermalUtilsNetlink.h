@@ -33,10 +33,14 @@
 #define THERMAL_THERMAL_UTILS_H__
 
 #include <unordered_map>
+#include <memory>
 #include <mutex>
+#include <atomic>
 #include <android/hardware/thermal/2.0/IThermal.h>
 #include "thermalConfig.h"
 #include "thermalMonitorNetlink.h"
+#include "thermalEventLoop.h"
+#include "thermalNotifier.h"
 #include "thermalCommon.h"
 #include "thermalData.h"
 
@@ -67,6 +71,10 @@ class ThermalUtils {
                                             hidl_vec<TemperatureThreshold>& thresh);
 		int readCdevStates(bool filterType, cdevType type,
                                             hidl_vec<CoolingDevice>& cdev);
+		int readPredictions(bool filterType, TemperatureType type,
+				std::vector<struct therm_prediction>& pred);
+		int readHistory(bool filterType, TemperatureType type,
+				std::vector<struct therm_history>& hist);
 		int fetchCpuUsages(hidl_vec<CpuUsage>& cpu_usages);
 	private:
 		bool is_sensor_init;
@@ -78,12 +86,18 @@ class ThermalUtils {
 			thermalConfig;
 		std::vector<struct therm_cdev> cdevList;
 		std::mutex sens_cb_mutex;
-		ueventCB cb;
+		std::atomic<uint16_t> cdev_state;
+		std::unique_ptr<ThermalNotifier> notifier;
+		int poll_timer;
+		/* Last, so the loop thread stops before anything it uses */
+		ThermalEventLoop loop;
 
 		void eventParse(int tzn, int trip);
 		void sampleParse(int tzn, int temp);
 		void eventCreateParse(int tzn, const char *name);
 		void Notify(struct therm_sensor& sens);
+		void updateCdevState();
+		void pollSensors();
 };
 
 }  // namespace implementation